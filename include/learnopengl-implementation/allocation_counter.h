@@ -0,0 +1,15 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+// counts the calls to the global operator new, compiled in only when NDEBUG is
+// not defined so release builds keep the default allocator untouched
+namespace AllocationCounter
+{
+    bool enabled( );
+    // every thread
+    unsigned long long total( );
+    // the calling thread only ( driver/worker threads do not pollute it )
+    unsigned long long thread( );
+}
+
+#endif
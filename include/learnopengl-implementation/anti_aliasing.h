@@ -0,0 +1,122 @@
+#ifndef ANTI_ALIASING_H
+#define ANTI_ALIASING_H
+
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/gl_helpers.h"
+#include "learnopengl-implementation/shader.h"
+#include "learnopengl-implementation/frame_packet.h"
+#include "learnopengl-implementation/render_graph.h"
+#include "learnopengl-implementation/dynamic_resolution.h"
+
+#include <ostream>
+
+// the anti-aliasing modes of the scene as render graph passes between the scene and
+// the upscale, all at the scene resolution:
+//   MSAA  the forward pass draws into multisampled color and depth transients, which
+//         a blit resolves into the scene target ( the deferred path gets FXAA instead )
+//   FXAA  one full screen pass: where the local luma contrast is high it finds the
+//         edge's direction and ends and samples the scene across it in proportion
+//   SMAA  morphological, in three passes: luma edges with local contrast adaptation
+//         ( RG8 ), blending weights from the length of every edge and the crossing
+//         edges at its ends ( RGBA8, the covered area computed analytically instead
+//         of looked up in an area texture ), then each pixel blended with its neighbors
+//   TAA   declared by TemporalAntiAliasing, which only gets measured here
+// Timestamps at the start of the scene pass, the start of the anti-aliasing passes and
+// the upscale give the GPU time of both per mode, so a mode's cost shows up wherever
+// it lands ( MSAA in the scene pass ). Every function runs on the GL thread
+class AntiAliasing
+{
+public:
+    struct Settings
+    {
+        // samples per pixel of the MSAA targets
+        int samples = 4;
+        // luma step an edge needs ( FXAA scales it with the local luma )
+        float edgeThreshold = 0.1f;
+        // pixels the SMAA weights follow an edge each way
+        int searchSteps = 16;
+    };
+
+    AntiAliasing( GLResources& resources, const Settings& settings );
+
+    AntiAliasing( const AntiAliasing& ) = delete;
+    AntiAliasing& operator=( const AntiAliasing& ) = delete;
+
+    // takes the filter shaders, which share the full screen triangle vertex shader
+    void initialize( const SharedGeometry& geometry, Shader& fxaaShader, Shader& edgeShader, Shader& weightShader, Shader& blendShader );
+    // the mode a frame runs for the one it asked for
+    AntiAliasingMode supportedMode( AntiAliasingMode requested, bool deferred ) const;
+
+    // the multisampled scene targets of MSAA, sized like the scene target
+    RenderGraph::TextureDescription multisampledColor( const DynamicResolution& target ) const;
+    RenderGraph::TextureDescription multisampledDepth( const DynamicResolution& target ) const;
+    // declares the passes of a mode after the scene: resolving multisampled into the scene
+    // color for MSAA, or filtering the scene color into a transient. Returns the version
+    // the upscale reads ( the scene color for TAA, whose passes are declared elsewhere )
+    RenderGraph::Resource addPasses( RenderGraph& graph, AntiAliasingMode mode, RenderGraph::Resource sceneColor,
+                                     RenderGraph::Resource multisampled, const DynamicResolution& target );
+
+    // around the scene pass and the anti-aliasing passes, called by the scene pass and the
+    // upscale; passes declared elsewhere mark their start with beginPost
+    void beginMeasurement( AntiAliasingMode mode );
+    void beginPost( );
+    void endMeasurement( );
+
+    void shutdown( );
+    // GPU time and target memory per mode
+    void report( std::ostream& out ) const;
+
+private:
+    static constexpr unsigned int MODE_COUNT = (unsigned int) AntiAliasingMode::COUNT;
+
+    struct ModeStatistics
+    {
+        unsigned long long frames = 0;
+        unsigned long long measured = 0;
+        double sceneMilliseconds = 0.0;
+        double postMilliseconds = 0.0;
+    };
+
+    static RenderGraph::TextureDescription colorDescription( const DynamicResolution& target, GLenum internalFormat, GLenum format );
+    // bytes per pixel of a mode's targets, on top of the scene target
+    size_t bytesPerPixel( AntiAliasingMode mode ) const;
+
+    void resolve( GLuint multisampled, const DynamicResolution& target );
+    void fxaa( GLuint color, const DynamicResolution& target );
+    void detectEdges( GLuint color, const DynamicResolution& target );
+    void computeWeights( GLuint edges, const DynamicResolution& target );
+    void blend( GLuint color, GLuint weights, const DynamicResolution& target );
+    // draws the full screen triangle with the viewport of the scene resolution
+    void drawFullscreen( const DynamicResolution& target );
+    void collect( );
+
+    GLResources& resources;
+    Settings settings;
+    const Shader* fxaaShader = nullptr;
+    const Shader* edgeShader = nullptr;
+    const Shader* weightShader = nullptr;
+    const Shader* blendShader = nullptr;
+
+    const SharedGeometry* geometry = nullptr;
+    // reads the multisampled color for the resolve blit
+    ScopedFramebuffer resolveFramebuffer;
+
+    int fxaaTexelSizeLocation = -1;
+    int fxaaMaxCoordinateLocation = -1;
+    int edgeRenderSizeLocation = -1;
+    int weightRenderSizeLocation = -1;
+    int blendRenderSizeLocation = -1;
+
+    // timestamps at the scene's start, the anti-aliasing's start and the finish, and the
+    // mode of each measured frame
+    TimerQueryRing timers;
+    AntiAliasingMode measuredModes[TimerQueryRing::SLOT_COUNT] = { };
+    bool postMarked = false;
+
+    ModeStatistics statistics[MODE_COUNT];
+    // size of the scene target the passes were declared for
+    int width = 0;
+    int height = 0;
+};
+
+#endif
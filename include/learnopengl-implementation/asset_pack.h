@@ -0,0 +1,118 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// on disk layout of a pack, written by tools/pack_builder.cpp:
+//   PackHeader
+//   PackEntry[entryCount], sorted by nameHash
+//   names, not null terminated
+//   payloads, each starting on a PACK_ALIGNMENT boundary
+const char PACK_MAGIC[8] = { 'L', 'O', 'G', 'L', 'P', 'A', 'C', 'K' };
+const uint32_t PACK_VERSION = 1;
+const uint64_t PACK_ALIGNMENT = 64;
+
+struct PackHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+};
+
+struct PackEntry
+{
+    uint64_t nameHash;
+    uint64_t contentHash;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+};
+
+// 64 bit FNV-1a, used for both the names and the contents
+inline uint64_t fnv1a( const void* data, size_t size, uint64_t hash = 14695981039346656037ull )
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>( data );
+    for ( size_t i = 0; i < size; i++ )
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// read only bytes of one asset, valid as long as the pack is open
+struct AssetView
+{
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+
+    bool isValid( ) const
+    {
+        return data != nullptr;
+    }
+};
+
+// where the bytes of one asset are on disk, for reading them through an IoService
+struct AssetLocation
+{
+    int file = -1;
+    uint64_t offset = 0;
+    size_t size = 0;
+
+    bool isValid( ) const
+    {
+        return file >= 0;
+    }
+};
+
+// every asset in one file, opened once and mapped into memory so that lookups
+// are a binary search over the table of contents and the contents are never
+// copied. A loose file root can be given for development: files found there
+// shadow the packed ones
+class AssetPack
+{
+public:
+    AssetPack( ) = default;
+    ~AssetPack( );
+
+    AssetPack( const AssetPack& ) = delete;
+    AssetPack& operator=( const AssetPack& ) = delete;
+
+    // either may be empty, returns false if the pack was given but could not be used
+    bool open( const std::string& packPath, const std::string& looseRoot );
+    void close( );
+
+    // name is the path relative to the asset root, e.g. "textures/container.jpg".
+    // Loose files are cached on first use, so with a loose root only one thread may call this
+    AssetView find( const std::string& name ) const;
+    // same lookup, returning the file range instead of a view, the file stays open with the pack
+    AssetLocation locate( const std::string& name ) const;
+    // checks the content hashes of every packed asset, reading all of them
+    bool verify( ) const;
+
+    size_t assetCount( ) const;
+
+private:
+    AssetView findLoose( const std::string& name ) const;
+    const PackEntry* findEntry( const std::string& name ) const;
+
+    int file = -1;
+    // the mapping
+    const unsigned char* base = nullptr;
+    size_t mappedSize = 0;
+    const PackEntry* entries = nullptr;
+    uint32_t entryCount = 0;
+    const char* names = nullptr;
+
+    std::string looseRoot;
+    // loose files read so far, kept so their views stay valid
+    mutable std::map<std::string, std::vector<unsigned char>> looseFiles;
+    mutable std::map<std::string, int> looseDescriptors;
+};
+
+#endif
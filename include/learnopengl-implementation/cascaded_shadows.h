@@ -0,0 +1,119 @@
+#ifndef CASCADED_SHADOWS_H
+#define CASCADED_SHADOWS_H
+
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/gl_helpers.h"
+#include "learnopengl-implementation/shader.h"
+#include "learnopengl-implementation/frame_packet.h"
+
+#include <glm/glm.hpp>
+
+#include <ostream>
+
+// sun shadows from cascaded shadow maps side by side in one depth atlas. The view
+// frustum up to the shadow distance is split between the cascades ( a blend of
+// logarithmic and uniform splits ), each cascade covers the bounding sphere of its
+// part, so its size does not change as the camera turns, and only moves in whole
+// texels of the atlas, so the texels do not crawl over the surfaces as the camera moves.
+// A cascade also covers a margin around the sphere and stays put until the sphere
+// leaves it, because moving it means drawing the static casters again: those live in
+// a persistent atlas that is only redrawn, per cascade, when the cascade moved, the
+// sun turned or the static casters changed. Every frame the static atlas is copied
+// into the shadow atlas and the dynamic casters are drawn on top. Timestamps around
+// the shadow pass give its GPU time for frames that redrew static casters and for
+// frames that only copied them. Every function runs on the GL thread
+class CascadedShadows
+{
+public:
+    static constexpr unsigned int MAX_CASCADES = 4;
+
+    struct Settings
+    {
+        bool enabled = true;
+        unsigned int cascades = 3;
+        // size of each cascade's square in the atlas
+        int resolution = 1024;
+        // view distance the shadows reach
+        float distance = 30.0f;
+        // 0: uniform splits, 1: logarithmic splits
+        float splitBlend = 0.75f;
+        // room around each cascade's sphere, as a fraction of its radius
+        float margin = 0.15f;
+        // how far toward the sun casters outside a cascade's sphere are still drawn
+        float casterDistance = 20.0f;
+        // off: the static casters are drawn every frame as well ( for comparing )
+        bool caching = true;
+        // polygon offset of the casters
+        float slopeBias = 2.0f;
+        float constantBias = 4.0f;
+    };
+
+    CascadedShadows( GLResources& resources, const Settings& settings );
+
+    CascadedShadows( const CascadedShadows& ) = delete;
+    CascadedShadows& operator=( const CascadedShadows& ) = delete;
+
+    // creates the atlases, the casters are drawn with the depth shader ( mvp only )
+    void initialize( Shader& depthShader );
+    bool isEnabled( ) const;
+    // tells a shader ( in use ) which texture unit holds the shadow atlas
+    void setSamplers( Shader& shader ) const;
+
+    // fits the cascades to the packet's camera and draws the casters into the shadow
+    // atlas with the cube vertex array bound by the caller, leaves the atlas bound
+    void render( const FramePacket& packet );
+    // the atlas the shading samples
+    TextureHandle atlasTexture( ) const;
+    // binds the shadow atlas and sets a shader's ( in use ) uniforms, which turn the
+    // shadows off when they are disabled
+    void bind( const Shader& shader ) const;
+
+    void shutdown( );
+    // static redraws and the GPU time, cached and uncached
+    void report( std::ostream& out ) const;
+
+private:
+    struct Cascade
+    {
+        // view depth the cascade ends at
+        float split = 0.0f;
+        // light space box the cascade covers
+        glm::vec3 center = glm::vec3( 0.0f );
+        float halfSize = 0.0f;
+        glm::mat4 viewProjection = glm::mat4( 1.0f );
+        // the static casters in the atlas are out of date
+        bool stale = true;
+    };
+
+    // places the cascades for the camera, marking the ones that moved stale
+    void fit( const FramePacket& packet );
+    void drawCasters( const FrameVector<glm::mat4>& casters, const Cascade& cascade, unsigned int index );
+    void collect( );
+
+    GLResources& resources;
+    Settings settings;
+    Shader* depthShader = nullptr;
+    int mvpLocation = -1;
+
+    ScopedFramebuffer staticFramebuffer, shadowFramebuffer;
+    ScopedTexture staticAtlas, shadowAtlas;
+    Cascade cascades[MAX_CASCADES];
+    glm::mat3 lightRotation = glm::mat3( 0.0f );
+    unsigned int staticCasterVersion = 0;
+    // view space to atlas texture coordinates and depth, per cascade
+    glm::mat4 shadowMatrices[MAX_CASCADES];
+
+    // timestamps around the shadow pass, and whether each measured frame only copied the static casters
+    TimerQueryRing timers;
+    bool measuredCached[TimerQueryRing::SLOT_COUNT] = { };
+
+    unsigned long long frames = 0;
+    unsigned long long staticRedraws = 0;
+    unsigned long long redrawFrames = 0;
+    unsigned long long cachedMeasured = 0;
+    unsigned long long uncachedMeasured = 0;
+    double cachedMilliseconds = 0.0;
+    double uncachedMilliseconds = 0.0;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef CLUSTERED_LIGHTING_H
+#define CLUSTERED_LIGHTING_H
+
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/gl_helpers.h"
+#include "learnopengl-implementation/shader.h"
+#include "learnopengl-implementation/frame_packet.h"
+#include "learnopengl-implementation/job_system.h"
+
+#include <glm/glm.hpp>
+
+#include <ostream>
+#include <vector>
+
+// light culling of the forward path: the view frustum is split into clusters, screen
+// tiles times depth slices that grow exponentially with the distance ( so that every
+// cluster is about as deep as it is wide ), and every light goes into the list of each
+// cluster its bounding sphere touches. The slices are binned in parallel on the job
+// system, each narrowing the lights down to the slice, then to each row of tiles, and
+// testing those four at once against every cluster's view space box of the row, while
+// the GL thread renders the virtual texture feedback. The lists then reach the shader
+// through three buffer textures ( GL 3.3 core has no storage buffers ): the lights,
+// an offset and count per cluster, and the light indices of all clusters one after
+// the other. A fragment finds its cluster from its window position and view depth and
+// only shades the lights listed there. Every function runs on the GL thread
+class ClusteredLighting
+{
+public:
+    struct Settings
+    {
+        // off: the forward path stays unlit
+        bool enabled = true;
+        // clusters across the screen and in depth
+        unsigned int tilesX = 16;
+        unsigned int tilesY = 9;
+        unsigned int slices = 24;
+        // lights past this many are dropped ( the indices are 16 bits )
+        unsigned int maxLights = 4096;
+    };
+
+    ClusteredLighting( JobSystem& jobs, GLResources& resources, const Settings& settings );
+
+    ClusteredLighting( const ClusteredLighting& ) = delete;
+    ClusteredLighting& operator=( const ClusteredLighting& ) = delete;
+
+    // creates the buffer textures
+    void initialize( );
+    bool isEnabled( ) const;
+    // tells the forward shader ( in use ) which texture units hold the buffer textures
+    void setSamplers( Shader& shader ) const;
+
+    // starts binning the packet's lights on the workers, the packet must outlive finish( )
+    void begin( const FramePacket& packet );
+    // waits for the binning and uploads the lists
+    void finish( );
+    // binds the buffer textures and sets the forward shader's ( in use ) uniforms for a
+    // scene rendered at the given size
+    void bind( const Shader& shader, const FramePacket& packet, int width, int height ) const;
+
+    void shutdown( );
+    // lights per cluster and the binning time
+    void report( std::ostream& out ) const;
+
+private:
+    // light bounds in view space, structure of arrays so four go into one register; the
+    // row lists are padded to a multiple of four with spheres that touch nothing
+    struct LightSpheres
+    {
+        std::vector<float> x, y, z, radius;
+    };
+
+    // the lights of one slice, filled by one job
+    struct Slice
+    {
+        // lights reaching the slice, and the row of tiles being binned, with their indices
+        LightSpheres candidates, rowCandidates;
+        std::vector<unsigned short> candidateIndices, rowIndices;
+        // light indices of the slice's clusters, one after the other
+        std::vector<unsigned short> indices;
+        // count per cluster of the slice
+        std::vector<unsigned int> counts;
+        unsigned long long nanoseconds = 0;
+    };
+
+    // per light texels of the light buffer texture
+    struct LightTexels
+    {
+        // view space position, radius
+        glm::vec4 positionRadius;
+        // color, cosine of the inner cone angle
+        glm::vec4 color;
+        // view space cone axis, cosine of the outer cone angle
+        glm::vec4 spot;
+    };
+
+    static void binSlices( void* data, unsigned int begin, unsigned int end );
+    void binSlice( unsigned int slice );
+    // view space boxes of the clusters, rebuilt when the projection changes
+    void buildClusters( const glm::mat4& projection );
+
+    JobSystem& jobs;
+    GLResources& resources;
+    Settings settings;
+
+    unsigned int tileCount;
+    unsigned int clusterCount;
+    glm::mat4 clusterProjection = glm::mat4( 0.0f );
+    float nearPlane = 0.1f;
+    float farPlane = 100.0f;
+    // cluster boxes, tile major within each slice
+    std::vector<glm::vec3> clusterMin, clusterMax;
+
+    LightSpheres spheres;
+    std::vector<LightTexels> lightTexels;
+    std::vector<Slice> slices;
+    std::vector<glm::uvec2> clusterRanges;
+    std::vector<unsigned short> indices;
+    JobCounter binned;
+    bool binning = false;
+
+    // the buffers behind the buffer textures
+    StreamBuffer lightBuffer, clusterBuffer, indexBuffer;
+    ScopedTexture lightTexture, clusterTexture, indexTexture;
+    // texels of the index buffer texture
+    unsigned int maxIndices = 65536;
+
+    unsigned long long frames = 0;
+    unsigned long long droppedLights = 0;
+    unsigned long long totalIndices = 0;
+    unsigned long long truncatedIndices = 0;
+    unsigned int maxClusterLights = 0;
+    unsigned long long binningNanoseconds = 0;
+};
+
+#endif
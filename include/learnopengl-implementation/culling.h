@@ -0,0 +1,27 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+// the six clip planes of a view-projection matrix, normals pointing inwards
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    explicit Frustum( const glm::mat4& viewProjection );
+
+    bool intersectsSphere( const glm::vec3& center, float radius ) const;
+};
+
+// smallest sphere ( xyz = center, w = radius ) around a cone of the given length and half
+// angle cosine, a cosine of -1 or below is a whole sphere around the apex
+glm::vec4 coneBounds( const glm::vec3& apex, const glm::vec3& direction, float length, float cosAngle );
+
+// visible[i] = whether the sphere ( xyz = center, w = radius ) touches the frustum,
+// large batches are split across the job system when one is given
+void cullSpheres( const Frustum& frustum, const glm::vec4* spheres, unsigned char* visible,
+                  unsigned int count, JobSystem* jobs = nullptr );
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef DEFERRED_SHADING_H
+#define DEFERRED_SHADING_H
+
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/gl_helpers.h"
+#include "learnopengl-implementation/shader.h"
+#include "learnopengl-implementation/frame_packet.h"
+#include "learnopengl-implementation/dynamic_resolution.h"
+#include "learnopengl-implementation/cascaded_shadows.h"
+#include "learnopengl-implementation/render_graph.h"
+
+#include <glm/glm.hpp>
+
+#include <ostream>
+#include <vector>
+
+// deferred lighting over a 12 byte per pixel G-buffer: albedo ( RGBA8 ), the view space
+// normal octahedral encoded ( RG16_SNORM ) and the scene target's depth and stencil
+// ( D24S8 ), whose depth gives back the position. The color targets are transients of
+// the render graph, which binds them for the geometry pass, and the scene target's
+// color alone for the lighting passes that follow, so the
+// depth can be sampled without a feedback loop: a full screen pass for the ambient
+// and sun light ( and the background ), then every point and spot light at once as
+// instanced quads over the screen rectangle its bounds project to, added by blending.
+// The lights entirely behind the camera or off screen are dropped on the CPU, the
+// fragments outside the sphere in depth are discarded. Every function runs on the GL thread
+class DeferredShading
+{
+public:
+    struct Settings
+    {
+        // off: the scene is shaded forward without lights
+        bool enabled = true;
+        glm::vec3 background = glm::vec3( 0.2f, 0.3f, 0.3f );
+    };
+
+    DeferredShading( GLResources& resources, const Settings& settings );
+
+    DeferredShading( const DeferredShading& ) = delete;
+    DeferredShading& operator=( const DeferredShading& ) = delete;
+
+    // takes the lighting shaders and creates the light quad mesh over the shared unit quad
+    void initialize( const SharedGeometry& geometry, Shader& ambientShader, Shader& lightShader );
+    bool isEnabled( ) const;
+
+    // the G-buffer color targets, sized like the scene target
+    static RenderGraph::TextureDescription albedoDescription( const DynamicResolution& target );
+    static RenderGraph::TextureDescription normalDescription( const DynamicResolution& target );
+
+    // sets the viewport of the scene resolution and clears the bound G-buffer, the
+    // geometry pass then draws with the G-buffer shader
+    void beginGeometry( const DynamicResolution& target );
+    // the uniforms the G-buffer shader reconstructs the normal with
+    void setGeometryUniforms( const Shader& geometryShader, const FramePacket& packet, const DynamicResolution& target ) const;
+    // lights the G-buffer textures into the bound scene target, the sun through the shadow atlas
+    void shade( const FramePacket& packet, const DynamicResolution& target, const CascadedShadows& shadows,
+                GLuint albedo, GLuint normal );
+
+    void shutdown( );
+    // G-buffer size and the lights drawn
+    void report( std::ostream& out ) const;
+
+private:
+    // per light instance attributes of light.vs
+    struct LightInstance
+    {
+        glm::vec4 rectangle;
+        glm::vec4 positionRadius;
+        // w: cosine of the inner cone angle
+        glm::vec4 color;
+        // view space cone axis, w: cosine of the outer cone angle
+        glm::vec4 spot;
+    };
+
+    // screen rectangle ( normalized device coordinates ) of a view space sphere, false when not on screen
+    static bool projectSphere( const glm::mat4& projection, const glm::vec3& center, float radius, glm::vec4& rectangle );
+
+    GLResources& resources;
+    Settings settings;
+    const Shader* ambientShader = nullptr;
+    const Shader* lightShader = nullptr;
+
+    // size of the last G-buffer shaded
+    int width = 0;
+    int height = 0;
+
+    const SharedGeometry* geometry = nullptr;
+    ScopedVertexArray lightArray;
+    StreamBuffer instanceBuffer;
+    std::vector<LightInstance> instances;
+
+    int ambientLocation = -1;
+    int sunDirectionLocation = -1;
+    int sunColorLocation = -1;
+    int backgroundLocation = -1;
+    int ambientInverseProjectionLocation = -1;
+    int ambientViewportSizeLocation = -1;
+    int lightInverseProjectionLocation = -1;
+    int lightViewportSizeLocation = -1;
+
+    unsigned long long frames = 0;
+    unsigned long long lightsDrawn = 0;
+    unsigned long long lightsCulled = 0;
+};
+
+#endif
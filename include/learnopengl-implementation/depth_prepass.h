@@ -0,0 +1,92 @@
+#ifndef DEPTH_PREPASS_H
+#define DEPTH_PREPASS_H
+
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/gl_helpers.h"
+
+#include <ostream>
+
+// decides per frame whether the scene is first drawn depth only, so that the shading
+// pass ( depth test GL_EQUAL, no depth writes ) runs the fragment shader once per
+// pixel instead of once per overlapping surface. Timestamps around both passes and
+// the samples that pass the shading pass's depth test are read back a few frames
+// later without waiting, they give:
+//   overdraw       shaded fragments without the pre-pass / visible pixels with it
+//   fragment cost  shading pass time per shaded fragment without the pre-pass
+//   pre-pass cost  time of both passes per visible pixel with the pre-pass
+// Without the pre-pass a pixel costs the fragment cost times the overdraw, the
+// cheaper of the two is used. Each mode only measures one side of the overdraw,
+// so the other mode is probed for a frame every now and then.
+// The report prints both per pixel costs and the break-even overdraw, the pre-pass
+// cost over the fragment cost: the pre-pass pays off once the measured overdraw is
+// above it. Only AUTO measures both sides. By hand, run the demo with --depth-prepass
+// off and then on at the same --overdraw-layers: the overdraw is the off run's shaded
+// fragments over the on run's pixels, the break-even the on run's cost per pixel over
+// the off run's cost per fragment. Stepping the layers up finds where they cross.
+// Every function runs on the GL thread
+class DepthPrepass
+{
+public:
+    enum class Mode
+    {
+        OFF,
+        ON,
+        AUTO
+    };
+
+    struct Settings
+    {
+        Mode mode = Mode::AUTO;
+        // frames between probes of the mode not in use
+        unsigned int probeInterval = 120;
+        // one mode must be cheaper than the other by this fraction to switch to it
+        float margin = 0.1f;
+    };
+
+    DepthPrepass( GLResources& resources, const Settings& settings );
+
+    DepthPrepass( const DepthPrepass& ) = delete;
+    DepthPrepass& operator=( const DepthPrepass& ) = delete;
+
+    // collects the measurements of earlier frames and decides for this one. When true
+    // the caller draws the scene with the depth program, color writes are masked off
+    bool begin( );
+    // switches to the shading pass: color writes back on and, after a pre-pass, the
+    // depth test to GL_EQUAL without depth writes
+    void beginShading( );
+    // restores the depth state after the shading pass
+    void end( );
+
+    // releases the queries
+    void shutdown( );
+    // overdraw, costs, the break-even overdraw and how often the pre-pass ran
+    void report( std::ostream& out ) const;
+
+private:
+    void collect( );
+    bool decide( );
+
+    Settings settings;
+
+    // timestamps at the start of both passes and the finish, the samples of the shading
+    // pass, and whether each measured frame drew the pre-pass
+    TimerQueryRing queries;
+    bool measuredPrepass[TimerQueryRing::SLOT_COUNT] = { };
+    bool active = false;
+    bool preferred = false;
+    unsigned long long framesSinceProbe = 0;
+
+    // running averages, negative until measured
+    double shadedFragments = -1.0;
+    double visiblePixels = -1.0;
+    double fragmentNanoseconds = -1.0;
+    double prepassNanoseconds = -1.0;
+
+    unsigned long long frameCount = 0;
+    unsigned long long prepassFrames = 0;
+    unsigned long long probes = 0;
+    unsigned long long switches = 0;
+    unsigned long long unmeasuredFrames = 0;
+};
+
+#endif
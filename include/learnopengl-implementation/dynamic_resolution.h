@@ -0,0 +1,113 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/gl_helpers.h"
+
+#include <ostream>
+
+// renders the scene into an offscreen target at a fraction of the window size and
+// upscales it into the window with a filtered blit. The fraction follows the GPU
+// time of the frames, measured with timer queries that are read a few frames later
+// without waiting: every few measured frames it moves toward the size whose pixel
+// count fits the budget, but only once the time left the band between the lower
+// threshold and the budget, so small fluctuations keep the size. The target is
+// allocated for the largest scale of the window size, a smaller scale only renders
+// into its lower left corner. Its color and depth ( with stencil ) textures are
+// bound by the render graph's passes, alone or with more attachments like the G-buffer.
+// Every function runs on the GL thread
+class DynamicResolution
+{
+public:
+    struct Settings
+    {
+        // off: the scene keeps the window size ( still offscreen ), the GPU time is still measured
+        bool enabled = true;
+        // GPU time a frame may take
+        double budgetMilliseconds = 14.0;
+        // the scale grows again once the frames take less than this part of the budget
+        double lowerThreshold = 0.8;
+        // scale of each side of the window
+        float minScale = 0.5f;
+        float maxScale = 1.0f;
+        // largest scale change at once
+        float maxStep = 0.1f;
+        // measured frames averaged before each decision
+        unsigned int interval = 8;
+    };
+
+    DynamicResolution( GLResources& resources, const Settings& settings );
+
+    DynamicResolution( const DynamicResolution& ) = delete;
+    DynamicResolution& operator=( const DynamicResolution& ) = delete;
+
+    // collects the finished measurements, adjusts the scale, sizes the target for the
+    // window and starts measuring this frame. Call first in the frame; the scale stays
+    // at or below the limit while something else reconstructs the rest of the pixels
+    void beginFrame( int windowWidth, int windowHeight, float scaleLimit = 1.0f );
+    // upscales the scene into the window and stops measuring, the window's back buffer
+    // is bound afterwards. The scene is the target's color, or a texture of the same size
+    // post-processing wrote it into
+    void endFrame( GLuint source );
+    // the same from a texture whose lower left corner of the given size holds the frame,
+    // like one already upsampled to the window size
+    void endFrame( GLuint source, int sourceWidth, int sourceHeight );
+
+    // size the scene is rendered at this frame
+    int renderWidth( ) const;
+    int renderHeight( ) const;
+    float scale( ) const;
+
+    // the target's textures and their allocated size, which only changes with the window
+    TextureHandle colorTexture( ) const;
+    TextureHandle depthTexture( ) const;
+    int targetWidth( ) const;
+    int targetHeight( ) const;
+
+    // releases the target and the queries
+    void shutdown( );
+    // GPU time and the scales used
+    void report( std::ostream& out ) const;
+
+private:
+    void collect( );
+    void adjust( double milliseconds );
+    void createTarget( int width, int height );
+
+    GLResources& resources;
+    Settings settings;
+
+    ScopedFramebuffer framebuffer;
+    ScopedTexture color, depth;
+    // reads a source other than the target's color
+    ScopedFramebuffer sourceFramebuffer;
+    int allocatedWidth = 0;
+    int allocatedHeight = 0;
+
+    int windowWidth = 0;
+    int windowHeight = 0;
+    int width = 0;
+    int height = 0;
+    float currentScale;
+    float scaleLimit = 1.0f;
+
+    // a timer over each measured frame, and its scale: a measurement of another scale says
+    // nothing about this one
+    TimerQueryRing timers;
+    float measuredScales[TimerQueryRing::SLOT_COUNT] = { };
+    // measured frames of the current scale since the last decision
+    double sampledMilliseconds = 0.0;
+    unsigned int samples = 0;
+
+    unsigned long long frames = 0;
+    unsigned long long measuredFrames = 0;
+    unsigned long long unmeasuredFrames = 0;
+    unsigned long long scaleChanges = 0;
+    double totalMilliseconds = 0.0;
+    double maxMilliseconds = 0.0;
+    double totalScale = 0.0;
+    float lowestScale;
+    float highestScale;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// bump allocator for memory that lives for one frame: allocating is a pointer
+// increment and everything is released at once by reset( ). Running out of space
+// chains an overflow block, and the next reset grows the main block to fit, so a
+// steady state frame never touches the heap
+class LinearArena
+{
+public:
+    explicit LinearArena( size_t capacity = 64 * 1024 );
+    ~LinearArena( );
+
+    LinearArena( const LinearArena& ) = delete;
+    LinearArena& operator=( const LinearArena& ) = delete;
+
+    void* allocate( size_t size, size_t alignment = alignof( std::max_align_t ) );
+    // grows an allocation, in place when it is the most recent one in the main block
+    void* reallocate( void* pointer, size_t oldSize, size_t newSize, size_t alignment = alignof( std::max_align_t ) );
+    // invalidates everything allocated since the last reset
+    void reset( );
+
+    template <typename T>
+    T* allocateArray( size_t count )
+    {
+        return static_cast<T*>( allocate( sizeof( T ) * count, alignof( T ) ) );
+    }
+
+    // bytes handed out since the last reset
+    size_t used( ) const;
+    size_t capacity( ) const;
+    // most bytes used by a single frame
+    size_t highWater( ) const;
+
+private:
+    char* block;
+    size_t blockSize;
+    size_t offset = 0;
+    // blocks allocated when the main block ran out, freed on reset
+    std::vector<char*> overflow;
+    size_t overflowUsed = 0;
+    size_t peak = 0;
+};
+
+// STL allocator drawing from a LinearArena, deallocation is a no-op
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    explicit ArenaAllocator( LinearArena* arena ) : arena( arena )
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator( const ArenaAllocator<U>& other ) : arena( other.arena )
+    {
+    }
+
+    T* allocate( size_t count )
+    {
+        return arena->allocateArray<T>( count );
+    }
+
+    void deallocate( T*, size_t )
+    {
+    }
+
+    template <typename U>
+    bool operator==( const ArenaAllocator<U>& other ) const
+    {
+        return arena == other.arena;
+    }
+
+    template <typename U>
+    bool operator!=( const ArenaAllocator<U>& other ) const
+    {
+        return arena != other.arena;
+    }
+
+    LinearArena* arena;
+};
+
+// vector whose storage comes from a frame arena
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include "glad/glad.h"
+
+#include <ostream>
+#include <vector>
+
+// keeps frame times consistent: caps the frames the driver may queue with fences,
+// picks the swap interval, optionally sleeps toward a target frame time and
+// measures present-to-present jitter and input-to-present latency
+class FramePacer
+{
+public:
+    enum class SwapMode
+    {
+        // interval 0, tears but never waits
+        IMMEDIATE,
+        // interval 1
+        VSYNC,
+        // vsync while the frame rate keeps up with the display, tearing when it
+        // does not (GL_EXT_swap_control_tear when available, emulated otherwise)
+        ADAPTIVE
+    };
+
+    struct Settings
+    {
+        // frames submitted to the GPU that may still be unfinished
+        unsigned int maxFramesInFlight = 2;
+        SwapMode swapMode = SwapMode::ADAPTIVE;
+        // seconds per frame to sleep toward, 0 disables the sleep
+        double targetFrameTime = 0.0;
+        // refresh rate of the display in Hz, 0 when unknown; GLFW only reports it on
+        // the main thread, so whoever creates the window fills it in
+        int refreshRate = 0;
+    };
+
+    explicit FramePacer( const Settings& settings );
+
+    // both run on the GL thread
+    void initialize( );
+    void shutdown( );
+
+    // waits for the GPU to drain below the frames in flight cap, then for the target frame time
+    void beginFrame( );
+    // right after the swap, inputTime is when the input of the presented frame was sampled
+    void endFrame( double inputTime );
+
+    void report( std::ostream& out ) const;
+
+private:
+    void applySwapInterval( int interval );
+
+    Settings settings;
+    // fence of the frames in flight, indexed by frame number modulo the cap
+    std::vector<GLsync> fences;
+    unsigned long long frame = 0;
+
+    // display refresh period in seconds, 0 when unknown
+    double refreshPeriod = 0.0;
+    bool nativeAdaptive = false;
+    int swapInterval = -2;
+    // smoothed present interval driving the emulated adaptive mode
+    double smoothedInterval = 0.0;
+
+    double frameStart = 0.0;
+    double lastPresent = 0.0;
+
+    // statistics ( Welford's running mean/variance of the present intervals )
+    unsigned long long intervals = 0;
+    double intervalMean = 0.0;
+    double intervalM2 = 0.0;
+    double intervalMax = 0.0;
+    unsigned long long presents = 0;
+    double latencySum = 0.0;
+    double latencyMax = 0.0;
+    double fenceWaitTime = 0.0;
+    // fence waits given up on after FENCE_RETRIES slices
+    unsigned long long abandonedWaits = 0;
+    double sleepTime = 0.0;
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef FRAME_PACKET_H
+#define FRAME_PACKET_H
+
+#include "learnopengl-implementation/frame_allocator.h"
+
+#include <glm/glm.hpp>
+
+// one draw call of the cube mesh
+struct DrawItem
+{
+    glm::mat4 mvp;
+};
+
+// point or spot light, in world space
+struct Light
+{
+    glm::vec3 position;
+    float radius;
+    glm::vec3 color;
+    // spot lights: the cone's axis and the cosines of the angles where it starts to fade
+    // and where it is gone, the defaults make a point light whose cone covers everything
+    glm::vec3 direction = glm::vec3( 0.0f, 0.0f, -1.0f );
+    float cosInner = -1.0f;
+    float cosOuter = -2.0f;
+};
+
+// camera facing textured quad blended over the opaque scene
+struct TransparentQuad
+{
+    // world space center, w: width and height
+    glm::vec4 positionSize;
+    // multiplies the texture, alpha included
+    glm::vec4 color;
+};
+
+// how the transparent quads are blended: weighted blended order independent
+// transparency in any order, or over each other from the farthest one after a sort
+enum class TransparencyMode
+{
+    WEIGHTED_BLENDED,
+    SORTED,
+    COUNT
+};
+
+// triangle edges the shading pass draws itself: over the shaded cubes, or over a flat
+// fill like a hidden line drawing
+enum class WireframeMode
+{
+    OFF,
+    OVERLAY,
+    HIDDEN_LINE
+};
+
+// how the edges of the scene are smoothed, picked per frame: multisampled targets
+// resolved before the post-processing, a filter over the finished scene, or jittered
+// frames accumulated at the window size from a lower scene resolution
+enum class AntiAliasingMode
+{
+    NONE,
+    MSAA,
+    FXAA,
+    SMAA,
+    TAA,
+    COUNT
+};
+
+// everything the render thread needs to draw a frame, built by the simulation
+// and never modified once published. The variable sized parts live in the
+// packet's own arena, which is only reset when the simulation gets the packet
+// back from the triple buffer, so the render thread can read it without copies
+struct FramePacket
+{
+    FramePacket( )
+        : draws( ArenaAllocator<DrawItem>( &arena ) ), previousMvps( ArenaAllocator<glm::mat4>( &arena ) ),
+          lights( ArenaAllocator<Light>( &arena ) ), staticCasters( ArenaAllocator<glm::mat4>( &arena ) ),
+          dynamicCasters( ArenaAllocator<glm::mat4>( &arena ) ), transparents( ArenaAllocator<TransparentQuad>( &arena ) )
+    {
+    }
+
+    // releases the previous contents, called before filling the packet again
+    void reset( )
+    {
+        arena.reset( );
+        draws = FrameVector<DrawItem>( ArenaAllocator<DrawItem>( &arena ) );
+        previousMvps = FrameVector<glm::mat4>( ArenaAllocator<glm::mat4>( &arena ) );
+        lights = FrameVector<Light>( ArenaAllocator<Light>( &arena ) );
+        staticCasters = FrameVector<glm::mat4>( ArenaAllocator<glm::mat4>( &arena ) );
+        dynamicCasters = FrameVector<glm::mat4>( ArenaAllocator<glm::mat4>( &arena ) );
+        transparents = FrameVector<TransparentQuad>( ArenaAllocator<TransparentQuad>( &arena ) );
+    }
+
+    LinearArena arena;
+
+    unsigned long long frameIndex = 0;
+    // glfwGetTime( ) right after the input of this frame was polled
+    double inputTime = 0.0;
+
+    // camera
+    glm::mat4 view = glm::mat4( 1.0f );
+    glm::mat4 projection = glm::mat4( 1.0f );
+    int viewportWidth = 0;
+    int viewportHeight = 0;
+
+    // visible draw list
+    FrameVector<DrawItem> draws;
+    // the mvp each draw had the frame before ( its previous model and camera ), for the
+    // motion vectors; a draw without one did not move
+    FrameVector<glm::mat4> previousMvps;
+    // lights, shaded deferred or binned into clusters for the forward path
+    FrameVector<Light> lights;
+    glm::vec3 ambientLight = glm::vec3( 0.08f );
+    // world space direction toward the sun
+    glm::vec3 sunDirection = glm::vec3( 0.3f, 1.0f, 0.5f );
+    glm::vec3 sunColor = glm::vec3( 0.35f );
+    // model matrices of every cube casting sun shadows, on screen or not; the static ones
+    // are only drawn again when staticCasterVersion changes
+    FrameVector<glm::mat4> staticCasters;
+    FrameVector<glm::mat4> dynamicCasters;
+    unsigned int staticCasterVersion = 0;
+    // drawn after the opaque scene in no particular order
+    FrameVector<TransparentQuad> transparents;
+
+    // uniforms and state
+    float mixValue = 0.0f;
+    WireframeMode wireframe = WireframeMode::OFF;
+    AntiAliasingMode antiAliasing = AntiAliasingMode::NONE;
+    TransparencyMode transparency = TransparencyMode::WEIGHTED_BLENDED;
+    // writes the frame to disk once it is drawn
+    bool capture = false;
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef FRAMEBUFFER_READBACK_H
+#define FRAMEBUFFER_READBACK_H
+
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/image_encoder.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// screenshots without stalling the GL thread: the back buffer is copied into a
+// pixel pack buffer from a ring, a fence marks when the copy is done, and only
+// then ( a frame or more later ) the buffer is mapped. The mapped pixels go to
+// encoder threads as they are, the GL thread unmaps the buffer once the file is
+// written. A capture finding its ring slot still busy is dropped, not waited for.
+// capture( ), update( ) and shutdown( ) run on the GL thread
+class FramebufferReadback
+{
+public:
+    struct Settings
+    {
+        // captures in flight, waiting for encoding or for their buffer to be unmapped
+        unsigned int ringSize = 4;
+        unsigned int encoderThreads = 2;
+        ImageFormat format = ImageFormat::PNG;
+        // zlib level of PNG files, 1 is the fastest
+        int compressionLevel = 1;
+        // files are written to <prefix><frame index>.<extension>
+        std::string prefix = "frame_";
+    };
+
+    FramebufferReadback( GLResources& resources, const Settings& settings );
+    ~FramebufferReadback( );
+
+    FramebufferReadback( const FramebufferReadback& ) = delete;
+    FramebufferReadback& operator=( const FramebufferReadback& ) = delete;
+
+    // queues a copy of the back buffer, call after drawing and before the swap.
+    // False when the capture was dropped because the ring is full
+    bool capture( int width, int height, unsigned long long frame );
+    // hands finished copies to the encoders and recycles encoded ones, once per frame
+    void update( );
+    // waits for every capture in flight to be written, then releases the buffers
+    void shutdown( );
+
+    // captures, drops, and the GL thread time spent in capture( ) and update( )
+    void report( std::ostream& out ) const;
+
+private:
+    enum SlotState
+    {
+        FREE,
+        READING,
+        ENCODING,
+        ENCODED
+    };
+
+    struct Slot
+    {
+        ScopedBuffer buffer;
+        size_t capacity = 0;
+        GLsync fence = nullptr;
+        int width = 0;
+        int height = 0;
+        const unsigned char* pixels = nullptr;
+        char path[256];
+        // the encoders only ever move a slot from ENCODING to ENCODED
+        std::atomic<int> state{ FREE };
+        bool written = false;
+    };
+
+    void encoderLoop( );
+    void stopEncoders( );
+
+    GLResources& resources;
+    Settings settings;
+    std::unique_ptr<Slot[]> slots;
+    unsigned int next = 0;
+
+    std::vector<std::thread> encoders;
+    std::mutex mutex;
+    std::condition_variable wake;
+    // slots waiting for an encoder, oldest first, guarded by mutex
+    std::vector<Slot*> queue;
+    bool stopping = false;
+
+    unsigned long long captures = 0;
+    unsigned long long dropped = 0;
+    unsigned long long written = 0;
+    unsigned long long failed = 0;
+    unsigned long long glThreadNanoseconds = 0;
+    unsigned long long maxFrameNanoseconds = 0;
+    unsigned long long frameNanoseconds = 0;
+    unsigned long long updates = 0;
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef GL_HELPERS_H
+#define GL_HELPERS_H
+
+#include "learnopengl-implementation/gl_resources.h"
+
+#include <chrono>
+
+// GPU queries of the last few measured frames, read back once their results arrived
+// so the CPU never waits for the GPU. begin( ) gives every measured frame the next of
+// SLOT_COUNT slots of queryCount queries, which the owner issues as it likes ( timestamps,
+// a timer or a samples query ); a frame whose slot is still in flight goes unmeasured.
+// What the owner needs to know about a measured frame it keeps in an array indexed by
+// slot( ). Every function runs on the GL thread
+class TimerQueryRing
+{
+public:
+    static constexpr unsigned int SLOT_COUNT = 4;
+    static constexpr unsigned int MAX_QUERIES = 4;
+
+    // the queries of a slot are created by the first frame that uses it, all with the label
+    TimerQueryRing( GLResources& resources, const char* label, unsigned int queryCount );
+
+    TimerQueryRing( const TimerQueryRing& ) = delete;
+    TimerQueryRing& operator=( const TimerQueryRing& ) = delete;
+
+    // measures the frame in the next slot, false when that slot's queries are still in flight
+    bool begin( );
+    bool isMeasuring( ) const;
+    // the slot of the frame being measured
+    unsigned int slot( ) const;
+    // a query of the frame being measured
+    GLuint query( unsigned int index ) const;
+    // records the GPU time into a query of the frame being measured, if it is measured
+    void timestamp( unsigned int index );
+    // the frame's queries are all issued, its slot waits for their results
+    void end( );
+
+    // calls function( slot, results ) with a result per query for every measured frame
+    // whose results arrived, and frees their slots
+    template <typename Function>
+    void collect( const Function& function )
+    {
+        unsigned int finished;
+        GLuint64 results[MAX_QUERIES];
+        while ( collectNext( finished, results ) )
+            function( finished, results );
+    }
+
+    // releases the queries
+    void reset( );
+
+private:
+    struct Slot
+    {
+        ScopedQuery queries[MAX_QUERIES];
+        bool pending = false;
+    };
+
+    bool collectNext( unsigned int& finished, GLuint64* results );
+
+    GLResources& resources;
+    const char* label;
+    unsigned int queryCount;
+    Slot slots[SLOT_COUNT];
+    unsigned int next = 0;
+    bool measuring = false;
+};
+
+// a buffer whose contents are replaced every frame. Every upload orphans the storage
+// ( glBufferData without data ) before writing it, so the driver hands out fresh memory
+// instead of waiting for the draws still reading last frame's; the capacity only grows,
+// to at least twice the last, so it settles after a few frames
+class StreamBuffer
+{
+public:
+    StreamBuffer( ) = default;
+    StreamBuffer( GLResources& resources, GLenum target, const char* label );
+
+    // fills the buffer with bytes of data, nothing when there are none
+    void upload( const void* data, size_t bytes );
+    GLuint name( ) const;
+    BufferHandle get( ) const;
+    void reset( );
+
+private:
+    GLResources* resources = nullptr;
+    GLenum target = GL_ARRAY_BUFFER;
+    ScopedBuffer buffer;
+    size_t capacity = 0;
+};
+
+// the meshes every full screen and instanced quad pass draws with, created once by
+// the renderer:
+//   full screen triangle  its corners come from gl_VertexID ( fullscreen.vs ), the vertex
+//                         array has no attributes, core profile still wants one bound
+//   unit quad             the corners ( 0, 0 ) to ( 1, 1 ) as a triangle strip, which the
+//                         instanced passes place per instance
+// Every function runs on the GL thread
+class SharedGeometry
+{
+public:
+    void initialize( GLResources& resources );
+    // draws the full screen triangle into the bound target
+    void drawFullscreen( ) const;
+    // points an attribute of the bound vertex array at the unit quad's corners
+    void bindQuadCorners( GLuint attribute ) const;
+    void shutdown( );
+
+private:
+    ScopedVertexArray fullscreenArray;
+    ScopedBuffer cornerBuffer;
+};
+
+// time since start on the steady clock, for the CPU cost of the GL calls after it
+inline unsigned long long nanosecondsSince( std::chrono::steady_clock::time_point start )
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now( ) - start ).count( );
+}
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef GL_RESOURCES_H
+#define GL_RESOURCES_H
+
+#include "glad/glad.h"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+enum class GLResourceType
+{
+    BUFFER,
+    TEXTURE,
+    VERTEX_ARRAY,
+    PROGRAM,
+    FRAMEBUFFER,
+    QUERY,
+    COUNT
+};
+
+// typed reference to a pooled GL object: the low bits index the pool's slot and
+// the high bits hold the slot's generation, so a handle kept past its release
+// no longer matches and resolves to 0 instead of to whatever reused the slot
+template <GLResourceType Type>
+struct GLHandle
+{
+    uint32_t value = 0;
+
+    bool isNull( ) const
+    {
+        return value == 0;
+    }
+};
+
+typedef GLHandle<GLResourceType::BUFFER> BufferHandle;
+typedef GLHandle<GLResourceType::TEXTURE> TextureHandle;
+typedef GLHandle<GLResourceType::VERTEX_ARRAY> VertexArrayHandle;
+typedef GLHandle<GLResourceType::PROGRAM> ProgramHandle;
+typedef GLHandle<GLResourceType::FRAMEBUFFER> FramebufferHandle;
+typedef GLHandle<GLResourceType::QUERY> QueryHandle;
+
+// dense slot pool for one kind of GL object, see GLResources
+class GLResourcePool
+{
+public:
+    explicit GLResourcePool( GLResourceType type );
+
+    uint32_t create( const char* label );
+    uint32_t adopt( GLuint name, const char* label );
+    void release( uint32_t handle );
+
+    GLuint get( uint32_t handle ) const;
+    bool isValid( uint32_t handle ) const;
+    void setSize( uint32_t handle, size_t bytes );
+
+    // deletes the released objects with one glDelete* call
+    void flush( );
+    // reports and deletes every live object, then the unused generated names
+    void shutdown( std::ostream& leaks );
+
+    unsigned int liveCount( ) const;
+    size_t liveBytes( ) const;
+    unsigned int staleCount( ) const;
+
+private:
+    uint32_t allocateSlot( GLuint name, const char* label );
+
+    GLResourceType type;
+
+    // per slot data, indexed by the handle's slot bits
+    std::vector<GLuint> names;
+    std::vector<uint16_t> generations;
+    std::vector<size_t> sizes;
+    std::vector<const char*> labels;
+    std::vector<uint32_t> freeSlots;
+
+    // names generated ahead of time in batches, and names waiting for deletion
+    std::vector<GLuint> spareNames;
+    std::vector<GLuint> pendingDeletes;
+
+    unsigned int live = 0;
+    size_t bytes = 0;
+    // stale handles that were looked up or released
+    mutable unsigned int stale = 0;
+};
+
+// owns every GL object of the renderer through one pool per type, lookups are an
+// index and a generation compare into dense arrays. Everything here must run on
+// the thread that owns the GL context
+class GLResources
+{
+public:
+    GLResources( );
+
+    BufferHandle createBuffer( const char* label );
+    TextureHandle createTexture( const char* label );
+    VertexArrayHandle createVertexArray( const char* label );
+    FramebufferHandle createFramebuffer( const char* label );
+    QueryHandle createQuery( const char* label );
+    // programs come from glCreateProgram, the pool only takes over their lifetime
+    ProgramHandle adoptProgram( GLuint program, const char* label );
+
+    // queues the object for deletion on the next flush( )
+    template <GLResourceType Type>
+    void release( GLHandle<Type> handle )
+    {
+        pool( Type ).release( handle.value );
+    }
+
+    // GL name of the object, 0 for a null or stale handle
+    template <GLResourceType Type>
+    GLuint get( GLHandle<Type> handle ) const
+    {
+        return pool( Type ).get( handle.value );
+    }
+
+    template <GLResourceType Type>
+    bool isValid( GLHandle<Type> handle ) const
+    {
+        return pool( Type ).isValid( handle.value );
+    }
+
+    // GPU memory owned by the object, only used for reporting
+    template <GLResourceType Type>
+    void setSize( GLHandle<Type> handle, size_t bytes )
+    {
+        pool( Type ).setSize( handle.value, bytes );
+    }
+
+    // runs the batched deletes, called once per frame
+    void flush( );
+    // prints the live count and size of each type
+    void report( std::ostream& out ) const;
+    // prints whatever is still alive as a leak and deletes it
+    void shutdown( std::ostream& leaks );
+
+private:
+    GLResourcePool& pool( GLResourceType type )
+    {
+        return pools[(int) type];
+    }
+
+    const GLResourcePool& pool( GLResourceType type ) const
+    {
+        return pools[(int) type];
+    }
+
+    GLResourcePool pools[(int) GLResourceType::COUNT];
+};
+
+// releases its handle when destroyed, move only
+template <GLResourceType Type>
+class ScopedGLHandle
+{
+public:
+    ScopedGLHandle( ) = default;
+
+    ScopedGLHandle( GLResources& resources, GLHandle<Type> handle ) : resources( &resources ), handle( handle )
+    {
+    }
+
+    ScopedGLHandle( ScopedGLHandle&& other ) : resources( other.resources ), handle( other.handle )
+    {
+        other.handle = GLHandle<Type>( );
+    }
+
+    ScopedGLHandle& operator=( ScopedGLHandle&& other )
+    {
+        if ( this != &other )
+        {
+            reset( );
+            resources = other.resources;
+            handle = other.handle;
+            other.handle = GLHandle<Type>( );
+        }
+        return *this;
+    }
+
+    ScopedGLHandle( const ScopedGLHandle& ) = delete;
+    ScopedGLHandle& operator=( const ScopedGLHandle& ) = delete;
+
+    ~ScopedGLHandle( )
+    {
+        reset( );
+    }
+
+    void reset( )
+    {
+        if ( resources && !handle.isNull( ) )
+            resources->release( handle );
+        handle = GLHandle<Type>( );
+    }
+
+    GLHandle<Type> get( ) const
+    {
+        return handle;
+    }
+
+    // GL name of the object
+    GLuint name( ) const
+    {
+        return resources ? resources->get( handle ) : 0;
+    }
+
+private:
+    GLResources* resources = nullptr;
+    GLHandle<Type> handle;
+};
+
+typedef ScopedGLHandle<GLResourceType::BUFFER> ScopedBuffer;
+typedef ScopedGLHandle<GLResourceType::TEXTURE> ScopedTexture;
+typedef ScopedGLHandle<GLResourceType::VERTEX_ARRAY> ScopedVertexArray;
+typedef ScopedGLHandle<GLResourceType::PROGRAM> ScopedProgram;
+typedef ScopedGLHandle<GLResourceType::FRAMEBUFFER> ScopedFramebuffer;
+typedef ScopedGLHandle<GLResourceType::QUERY> ScopedQuery;
+
+#endif
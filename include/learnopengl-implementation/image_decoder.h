@@ -0,0 +1,31 @@
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include <cstddef>
+#include <ostream>
+
+// stb_image wrapper for decoding many images in parallel: while a decode runs,
+// the scratch allocations stb_image makes ( zlib output, JPEG component buffers,
+// format conversions ) come from an arena owned by the calling thread, which is
+// recycled for the next decode. The final pixels, recognized by their size read
+// from the image header beforehand, are allocated on the heap and handed out as is
+namespace ImageDecoder
+{
+    // same contract as stbi_load, the pixels must be given back with release( )
+    unsigned char* load( const char* path, int* width, int* height, int* channels, int desiredChannels );
+    // same, decoding an encoded image that is already in memory ( e.g. a pack view )
+    unsigned char* loadFromMemory( const unsigned char* data, size_t size, int* width, int* height, int* channels, int desiredChannels );
+    void release( unsigned char* pixels );
+    // reason of the last failure on the calling thread
+    const char* failureReason( );
+
+    // applies to every thread ( stb_image keeps it in a global )
+    void setFlipVertically( bool flip );
+    // decoding straight from the heap instead, for comparison
+    void setScratchArena( bool enabled );
+
+    // decoded images, pixel bytes and the time spent decoding, summed over all threads
+    void report( std::ostream& out );
+}
+
+#endif
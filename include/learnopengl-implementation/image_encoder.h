@@ -0,0 +1,32 @@
+#ifndef IMAGE_ENCODER_H
+#define IMAGE_ENCODER_H
+
+#include <ostream>
+
+enum class ImageFormat
+{
+    // 8 bit RGB, deflated with zlib
+    PNG,
+    // uncompressed 24 bit BGR
+    TGA,
+    // headerless 8 bit RGB rows, top row first
+    RAW
+};
+
+// writes framebuffer readbacks to disk: the input is RGBA8 with the bottom row
+// first, as glReadPixels returns it, and the alpha channel is dropped. The
+// working buffers belong to the calling thread and are reused between images,
+// so a thread encoding frames of one size stops allocating after the first
+namespace ImageEncoder
+{
+    // compressionLevel is zlib's ( 1 is the fastest ), only PNG uses it. False when
+    // the file could not be written
+    bool write( const char* path, ImageFormat format, const unsigned char* pixels, int width, int height, int compressionLevel );
+    // file extension without the dot
+    const char* extension( ImageFormat format );
+
+    // encoded images, bytes written and the time spent encoding, summed over all threads
+    void report( std::ostream& out );
+}
+
+#endif
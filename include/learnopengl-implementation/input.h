@@ -0,0 +1,62 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "learnopengl-implementation/spsc_queue.h"
+
+#include <bitset>
+
+struct GLFWwindow;
+
+struct InputEvent
+{
+    // glfwGetTime( ) when GLFW delivered the event
+    double time;
+    int key;
+    // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+    int action;
+};
+
+// collects the GLFW key events of a window into a lock-free queue, so they can be
+// consumed by whichever thread runs the simulation
+class InputQueue
+{
+public:
+    // installs the key callback ( uses the window user pointer )
+    explicit InputQueue( GLFWwindow* window );
+
+    // consumer side
+    bool pop( InputEvent& event );
+    // events lost because the consumer fell behind
+    unsigned long long droppedEvents( ) const;
+
+private:
+    static void keyCallback( GLFWwindow* window, int key, int scancode, int action, int mods );
+
+    SpscQueue<InputEvent, 256> events;
+    std::atomic<unsigned long long> dropped{ 0 };
+};
+
+// key state rebuilt from the timestamped events, owned by the simulation
+class InputState
+{
+public:
+    static constexpr int KEY_COUNT = 512;
+
+    // drains the queue and accounts every event up to now ( the current simulation time )
+    void update( InputQueue& queue, double now );
+
+    bool isDown( int key ) const;
+    // whether the key went down at least once during the last update
+    bool wasPressed( int key ) const;
+    // seconds the key was held during the last update, exact to the event timestamps
+    double heldTime( int key ) const;
+
+private:
+    double lastUpdate = 0.0;
+    std::bitset<KEY_COUNT> down;
+    std::bitset<KEY_COUNT> pressed;
+    double downSince[KEY_COUNT] = { };
+    double held[KEY_COUNT] = { };
+};
+
+#endif
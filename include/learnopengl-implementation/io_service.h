@@ -0,0 +1,117 @@
+#ifndef IO_SERVICE_H
+#define IO_SERVICE_H
+
+#include "learnopengl-implementation/job_system.h"
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+// one read handled by an IoService, owned by the caller until its completion ran
+struct IoRequest
+{
+    // filled by the caller
+    int file = -1;
+    uint64_t offset = 0;
+    size_t size = 0;
+    // memory to read into, or null to read into one of the service's registered
+    // buffers ( size must then fit IoService::Settings::bufferSize )
+    void* destination = nullptr;
+    // runs as a job with data once the read finished
+    JobFunction completion = nullptr;
+    void* data = nullptr;
+
+    // filled by the service before the completion runs
+    // where the bytes are, destination or a registered buffer the completion must release
+    void* buffer = nullptr;
+    // bytes read, or -errno
+    long long result = 0;
+
+    // internal
+    int bufferIndex = -1;
+    size_t done = 0;
+    JobCounter* counter = nullptr;
+    double submitTime = 0.0;
+    iovec vector;
+};
+
+// asynchronous file reads: requests are batched into an io_uring, at most
+// queueDepth at a time, and their completions are handed to the job system as
+// jobs. Without io_uring ( old kernels, seccomp ) a small pool of threads
+// doing blocking preads takes its place behind the same interface
+class IoService
+{
+public:
+    struct Settings
+    {
+        // reads in flight at once, the rest waits in submission order
+        unsigned int queueDepth = 64;
+        // staging buffers registered with the kernel for reads without a destination
+        unsigned int bufferCount = 8;
+        size_t bufferSize = 1024 * 1024;
+        // threads of the pread fallback
+        unsigned int fallbackThreads = 4;
+        // skips io_uring, for comparison
+        bool forceFallback = false;
+    };
+
+    IoService( JobSystem& jobs, const Settings& settings );
+    ~IoService( );
+
+    IoService( const IoService& ) = delete;
+    IoService& operator=( const IoService& ) = delete;
+
+    // queues the read, counter ( optional ) stays above zero until the completion job finished
+    void submit( IoRequest* request, JobCounter* counter );
+    // gives a registered buffer back, call once the completion is done with request->buffer
+    void releaseBuffer( IoRequest* request );
+
+    bool usesIoUring( ) const;
+    // requests, bytes and mean submit-to-completion latency
+    void report( std::ostream& out ) const;
+
+private:
+    struct Ring;
+
+    bool setupRing( );
+    void destroyRing( );
+    // both called with the mutex held
+    void issuePending( );
+    bool issue( IoRequest* request );
+    // called without the mutex, the completion job may run inline and release its buffer
+    void complete( IoRequest* request );
+    void reapLoop( );
+    void fallbackLoop( );
+
+    JobSystem& jobs;
+    Settings settings;
+
+    // staging memory, one block cut into bufferCount buffers
+    unsigned char* buffers = nullptr;
+    std::vector<int> freeBuffers;
+
+    Ring* ring = nullptr;
+    bool registeredBuffers = false;
+
+    std::mutex mutex;
+    std::condition_variable pendingChanged;
+    std::deque<IoRequest*> pending;
+    unsigned int inFlight = 0;
+    bool running = true;
+    std::vector<std::thread> threads;
+    // finished requests of one pass of the reaping thread, completed once the mutex is released
+    std::vector<IoRequest*> reaped;
+
+    std::atomic<unsigned long long> completedRequests{ 0 };
+    std::atomic<unsigned long long> completedBytes{ 0 };
+    std::atomic<unsigned long long> latencyMicroseconds{ 0 };
+};
+
+#endif
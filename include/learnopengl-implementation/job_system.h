@@ -0,0 +1,168 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job;
+
+// counts the unfinished jobs of a group, jobs can also be made to wait on one
+struct JobCounter
+{
+    std::atomic<int> value{ 0 };
+    // threads still inside JobSystem::finish( ) for this counter, waits also wait
+    // for them so a counter on the waiter's stack is not touched after it returned
+    std::atomic<int> finishing{ 0 };
+
+    // jobs waiting for the counter to reach zero, guarded by the lock
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    Job* continuations = nullptr;
+};
+
+// a job works on the index range [begin, end) of whatever data points to
+typedef void ( *JobFunction )( void* data, unsigned int begin, unsigned int end );
+
+struct Job
+{
+    JobFunction function;
+    void* data;
+    unsigned int begin;
+    unsigned int end;
+    // decremented when the job finishes
+    JobCounter* counter;
+    // next job waiting on the same counter
+    Job* next;
+    // pinned jobs only run on the thread that owns the GL context
+    bool pinned;
+};
+
+// fixed size Chase-Lev work-stealing deque, the owner pushes and pops at the
+// bottom while the other workers steal from the top
+class WorkStealingDeque
+{
+public:
+    explicit WorkStealingDeque( unsigned int capacity );
+
+    // owner only
+    bool push( Job* job );
+    Job* pop( );
+    // any thread
+    Job* steal( );
+
+private:
+    std::vector<std::atomic<Job*>> jobs;
+    unsigned int mask;
+    std::atomic<long long> top{ 0 };
+    std::atomic<long long> bottom{ 0 };
+};
+
+class JobSystem
+{
+public:
+    // the constructing thread becomes worker 0 and the owner of the pinned jobs,
+    // 0 worker threads means one less than the hardware concurrency
+    explicit JobSystem( unsigned int workerThreads = 0 );
+    ~JobSystem( );
+
+    // schedules function( data, begin, end ), optionally only after dependency reaches zero
+    void run( JobFunction function, void* data, unsigned int begin, unsigned int end,
+              JobCounter* counter, JobCounter* dependency = nullptr );
+    // same, but the job only runs inside executePinned (used for GL calls)
+    void runPinned( JobFunction function, void* data, JobCounter* counter, JobCounter* dependency = nullptr );
+
+    // counts work running outside of the job system ( e.g. a file read ) into a
+    // counter, so waits and dependencies on it also cover that work
+    void beginExternal( JobCounter* counter );
+    void endExternal( JobCounter* counter );
+
+    // runs other jobs until the counter reaches zero
+    void wait( JobCounter* counter );
+    // true once the counter reached zero and no thread still touches it, never blocks
+    bool isDone( JobCounter* counter ) const;
+    // runs the queued pinned jobs, must be called from the pinned thread
+    void executePinned( );
+    // hands the pinned jobs over to the calling thread (e.g. a render thread)
+    void setPinnedThread( );
+
+    // splits [0, count) into chunks and calls fn( begin, end ) on them in parallel,
+    // a minGrain of 0 lets the system pick the chunk size from the worker count
+    template <typename Function>
+    void parallelFor( unsigned int count, unsigned int minGrain, const Function& fn );
+
+    // number of threads executing jobs, including the constructing one
+    unsigned int threadCount( ) const;
+
+private:
+    // takes a free slot of the ring, running other jobs while every slot is live
+    Job* allocate( );
+    void schedule( Job* job );
+    void submit( Job* job, JobCounter* dependency );
+    void execute( Job* job );
+    // decrements the counter and releases its continuations when it reaches zero
+    void finish( JobCounter* counter );
+    Job* fetch( );
+    void workerLoop( unsigned int index );
+
+    template <typename Function>
+    static void invoke( void* data, unsigned int begin, unsigned int end )
+    {
+        ( *static_cast<const Function*>( data ) )( begin, end );
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<WorkStealingDeque*> deques;
+    std::atomic<bool> running{ true };
+
+    // ring of job slots, a slot is live from allocate( ) until its job ran, so a job
+    // waiting on a dependency or the pinned thread is not overwritten when the ring wraps
+    std::vector<Job> jobPool;
+    std::vector<std::atomic<bool>> jobLive;
+    std::atomic<unsigned int> nextJob{ 0 };
+
+    // jobs submitted from threads that are not workers
+    std::mutex injectedMutex;
+    std::vector<Job*> injected;
+
+    // jobs for the GL thread
+    std::mutex pinnedMutex;
+    std::vector<Job*> pinned;
+    std::vector<Job*> pinnedExecuting;
+    std::thread::id pinnedThread;
+
+    // idle workers sleep here
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<int> sleeping{ 0 };
+};
+
+template <typename Function>
+void JobSystem::parallelFor( unsigned int count, unsigned int minGrain, const Function& fn )
+{
+    if ( count == 0 )
+        return;
+
+    // about four chunks per thread keeps everyone busy without drowning in job overhead
+    unsigned int grain = ( count + threadCount( ) * 4 - 1 ) / ( threadCount( ) * 4 );
+    if ( grain < minGrain )
+        grain = minGrain;
+    if ( grain == 0 )
+        grain = 1;
+    if ( grain >= count )
+    {
+        fn( 0u, count );
+        return;
+    }
+
+    JobCounter counter;
+    for ( unsigned int begin = 0; begin < count; begin += grain )
+    {
+        unsigned int end = begin + grain < count ? begin + grain : count;
+        run( &JobSystem::invoke<Function>, (void*) &fn, begin, end, &counter );
+    }
+    wait( &counter );
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef MATRIX_KERNELS_H
+#define MATRIX_KERNELS_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// batched matrix kernels for the per-instance hot paths, the SSE2, AVX2 or AVX-512
+// variant is picked once at startup from what the CPU reports through CPUID
+namespace MatrixKernels
+{
+    enum class Level
+    {
+        SCALAR,
+        SSE2,
+        AVX2,
+        AVX512
+    };
+
+    // widest level supported by both the build and the running CPU
+    Level detect( );
+    // forces a level (clamped to the detected one), mostly to compare the variants
+    void select( Level level );
+    Level current( );
+    const char* name( Level level );
+
+    // out[i] = viewProjection * models[i]
+    void multiplyMVP( const glm::mat4& viewProjection, const glm::mat4* models, glm::mat4* out, size_t count );
+    // out[i] = m * in[i]
+    void transform( const glm::mat4& m, const glm::vec4* in, glm::vec4* out, size_t count );
+    // out[i] = transpose( inverse( upper 3x3 of models[i] ) ) widened to a mat4, the models must be affine
+    void normalMatrices( const glm::mat4* models, glm::mat4* out, size_t count );
+}
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef NORMAL_ENCODING_H
+#define NORMAL_ENCODING_H
+
+#include <glm/glm.hpp>
+
+// octahedral encoding of unit vectors into two snorm16 components, the layout of the
+// G-buffer's RG16_SNORM normal target: the vector is projected onto the octahedron
+// |x| + |y| + |z| = 1 and the lower half folded over the upper one. gbuffer.fs and
+// the lighting shaders do the same on the GPU, where the snorm conversion is the
+// target's
+namespace NormalEncoding
+{
+    // bound on the angle lost in a round trip, numeric_check measures it with maxErrorDegrees( 4096 )
+    const float MAX_ERROR_DEGREES = 0.003f;
+
+    glm::uint packOctahedral( const glm::vec3& normal );
+    glm::vec3 unpackOctahedral( glm::uint packed );
+
+    // largest angle ( degrees ) between a direction and its round trip, over the directions
+    // at the centers of a resolution x resolution grid on the octahedral square
+    float maxErrorDegrees( unsigned int resolution );
+}
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include "learnopengl-implementation/gl_resources.h"
+
+#include <functional>
+#include <ostream>
+#include <vector>
+
+// the frame as passes that declare the textures they read and write. Every write
+// makes a new version of the texture, so a pass reading a version runs after the
+// pass that wrote it and before the pass that writes the next one. Compiling the
+// declared passes culls the ones nothing needs: starting from the outputs and the
+// passes with side effects, a pass is kept when a kept pass reads what it writes.
+// The rest are ordered by their dependencies, declaration order breaking ties.
+// Transient textures are only created by the graph and live from the first kept
+// pass that touches them to the last one, so two transients whose lifetimes do not
+// overlap share one pooled texture of their description: a transient's content is
+// undefined until a pass writes it. The pooled textures stay between compiles,
+// which only happen when the caller declares a different graph, and the
+// framebuffers of the passes' attachments are cached by their textures. Every
+// function runs on the GL thread
+class RenderGraph
+{
+public:
+    // a version of a texture
+    typedef unsigned int Resource;
+    typedef unsigned int Pass;
+
+    static constexpr unsigned int MAX_COLOR_ATTACHMENTS = 4;
+
+    struct TextureDescription
+    {
+        int width = 0;
+        int height = 0;
+        GLenum internalFormat = GL_RGBA8;
+        GLenum format = GL_RGBA;
+        GLenum type = GL_UNSIGNED_BYTE;
+        GLenum filter = GL_NEAREST;
+        // 0: a plain 2D texture, otherwise a multisampled one with this many samples
+        int samples = 0;
+    };
+
+    explicit RenderGraph( GLResources& resources );
+
+    RenderGraph( const RenderGraph& ) = delete;
+    RenderGraph& operator=( const RenderGraph& ) = delete;
+
+    // forgets the declared passes and resources, the pooled textures stay
+    void clear( );
+
+    // a texture owned by someone else, kept in its state from frame to frame
+    Resource importTexture( const char* name, TextureHandle texture, GLenum internalFormat );
+    // the window's back buffer
+    Resource importBackbuffer( const char* name );
+    // a texture of the graph that only lives within the frame
+    Resource createTexture( const char* name, const TextureDescription& description );
+    // no texture behind it, only orders the passes around other state ( buffers, readbacks )
+    Resource createMarker( const char* name );
+
+    // the pass runs execute with its attachments bound, if it has any
+    Pass addPass( const char* name, std::function<void( )> execute );
+    // the pass samples the version
+    void read( Pass pass, Resource resource );
+    // the pass changes the texture some other way than through its attachments, like
+    // its own framebuffer; returns the new version
+    Resource write( Pass pass, Resource resource );
+    // the texture becomes the pass's next color attachment, or its depth ( and stencil )
+    // attachment, keeping what the earlier version held; returns the new version
+    Resource writeColor( Pass pass, Resource resource );
+    Resource writeDepth( Pass pass, Resource resource );
+    // the pass is kept even when nothing reads what it writes
+    void setSideEffects( Pass pass );
+    // the version must be produced, like the finished back buffer
+    void markOutput( Resource resource );
+
+    // culls and orders the passes and places the transients in the pool
+    void compile( );
+    // runs the kept passes in order
+    void execute( );
+    // GL name of the texture behind a version in the compiled graph, 0 for the back buffer and markers
+    GLuint texture( Resource resource ) const;
+
+    // releases the pooled textures and the framebuffers
+    void shutdown( );
+    // the schedule of the last compile and the transient memory
+    void report( std::ostream& out ) const;
+
+private:
+    static constexpr int NONE = -1;
+
+    enum class Kind
+    {
+        IMPORTED,
+        BACKBUFFER,
+        TRANSIENT,
+        MARKER
+    };
+
+    struct TextureNode
+    {
+        const char* name;
+        Kind kind;
+        TextureDescription description;
+        TextureHandle imported;
+        unsigned int versions = 1;
+        // schedule positions of the first and last kept pass using it, and its pooled texture
+        int firstUse = NONE;
+        int lastUse = NONE;
+        int pooled = NONE;
+    };
+
+    struct ResourceNode
+    {
+        unsigned int texture;
+        int writer = NONE;
+        // the version written over it
+        int next = NONE;
+        std::vector<Pass> readers;
+        bool output = false;
+        // kept passes reading it, while culling
+        unsigned int references = 0;
+    };
+
+    struct PassNode
+    {
+        const char* name;
+        std::function<void( )> execute;
+        // reads include the earlier versions of the textures written
+        std::vector<Resource> reads, writes;
+        Resource colors[MAX_COLOR_ATTACHMENTS];
+        unsigned int colorCount = 0;
+        int depth = NONE;
+        bool sideEffects = false;
+        bool culled = false;
+        // versions it writes that kept passes read, while culling
+        unsigned int references = 0;
+    };
+
+    struct PooledTexture
+    {
+        ScopedTexture texture;
+        TextureDescription description;
+        size_t bytes = 0;
+        // schedule position the current transient stops using it at, while placing
+        int busyUntil = NONE;
+        bool used = false;
+    };
+
+    struct Framebuffer
+    {
+        ScopedFramebuffer framebuffer;
+        GLuint colors[MAX_COLOR_ATTACHMENTS];
+        unsigned int colorCount = 0;
+        GLuint depth = 0;
+    };
+
+    static bool sameDescription( const TextureDescription& a, const TextureDescription& b );
+    static size_t bytesPerPixel( GLenum internalFormat );
+    static bool hasStencil( GLenum internalFormat );
+    GLenum textureTarget( Resource resource ) const;
+
+    Resource addVersion( unsigned int texture );
+    Resource addWrite( Pass pass, Resource resource );
+    void cull( );
+    void order( );
+    void placeTransients( );
+    // binds a pass's attachments, creating their framebuffer the first time
+    void bindAttachments( const PassNode& pass );
+
+    GLResources& resources;
+
+    std::vector<TextureNode> textures;
+    std::vector<ResourceNode> versions;
+    std::vector<PassNode> passes;
+    std::vector<Pass> schedule;
+    bool compiled = false;
+
+    std::vector<PooledTexture> pool;
+    std::vector<Framebuffer> framebuffers;
+
+    unsigned long long compiles = 0;
+    unsigned long long executions = 0;
+    size_t transientBytes = 0;
+    size_t pooledBytes = 0;
+    size_t peakLiveBytes = 0;
+    unsigned int transientCount = 0;
+    unsigned int pooledCount = 0;
+};
+
+#endif
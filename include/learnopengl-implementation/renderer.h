@@ -0,0 +1,151 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "learnopengl-implementation/shader.h"
+#include "learnopengl-implementation/frame_packet.h"
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/gl_helpers.h"
+#include "learnopengl-implementation/asset_pack.h"
+#include "learnopengl-implementation/texture_streamer.h"
+#include "learnopengl-implementation/virtual_texture.h"
+#include "learnopengl-implementation/framebuffer_readback.h"
+#include "learnopengl-implementation/video_capture.h"
+#include "learnopengl-implementation/dynamic_resolution.h"
+#include "learnopengl-implementation/depth_prepass.h"
+#include "learnopengl-implementation/deferred_shading.h"
+#include "learnopengl-implementation/clustered_lighting.h"
+#include "learnopengl-implementation/cascaded_shadows.h"
+#include "learnopengl-implementation/render_graph.h"
+#include "learnopengl-implementation/anti_aliasing.h"
+#include "learnopengl-implementation/temporal_anti_aliasing.h"
+#include "learnopengl-implementation/transparency.h"
+
+#include <memory>
+
+class JobSystem;
+class IoService;
+
+// owns every GL resource of the scene and turns frame packets into GL calls,
+// all of its functions must run on the thread that owns the GL context
+class Renderer
+{
+public:
+    struct Settings
+    {
+        TextureStreamer::Settings streaming;
+        VirtualTexture::Settings virtualTexturing;
+        // frames whose packet asks for it are written to disk
+        FramebufferReadback::Settings capture;
+        // every frame is recorded into a video stream when enabled
+        VideoCapture::Settings video;
+        // the scene resolution follows the GPU frame time
+        DynamicResolution::Settings resolution;
+        // depth only pass ahead of the shading one, always, never or when it pays off
+        DepthPrepass::Settings depthPrepass;
+        // the cubes go into a G-buffer lit by the frame's point lights afterwards
+        DeferredShading::Settings deferred;
+        // without it the forward path lights the cubes through per cluster light lists
+        ClusteredLighting::Settings clustered;
+        // sun shadows, the static casters cached between frames
+        CascadedShadows::Settings shadows;
+        // the MSAA samples and the filters' thresholds, the mode comes with each frame
+        AntiAliasing::Settings antiAliasing;
+        // the render scale and history of the TAA mode
+        TemporalAntiAliasing::Settings temporal;
+        // the frame's transparent quads, the blending mode comes with each frame
+        Transparency::Settings transparency;
+    };
+
+    // the shaders and textures are read from assets through io during initialize( ),
+    // the texture mip levels are then streamed in within the given budget, except for
+    // the first texture's, which are paged in by the virtual texture when it is enabled
+    Renderer( JobSystem& jobs, IoService& io, const AssetPack& assets, const Settings& settings );
+
+    // creates the shader, the cube mesh and the textures
+    void initialize( );
+    // draws one frame (the caller swaps the buffers)
+    void render( const FramePacket& packet );
+    // reports and deletes the GL resources
+    void shutdown( );
+
+private:
+    // what the frame's graph was declared for, another one is declared when it changes
+    struct GraphConfiguration
+    {
+        bool deferred = false;
+        bool clustered = false;
+        bool shadows = false;
+        AntiAliasingMode antiAliasing = AntiAliasingMode::NONE;
+        bool transparency = false;
+        TransparencyMode transparencyMode = TransparencyMode::WEIGHTED_BLENDED;
+        // size of the scene target, and of the transients
+        int width = -1;
+        int height = -1;
+
+        bool operator==( const GraphConfiguration& other ) const
+        {
+            return deferred == other.deferred && clustered == other.clustered && shadows == other.shadows &&
+                   antiAliasing == other.antiAliasing && transparency == other.transparency &&
+                   transparencyMode == other.transparencyMode && width == other.width && height == other.height;
+        }
+    };
+
+    // declares and compiles the passes of the graph configuration
+    void buildGraph( );
+    // the scene's cubes into the bound target, after a depth pre-pass when it pays off
+    void drawScene( );
+    // every cube of the frame with the program in use, jittered for TAA, which also gets
+    // each cube's previous mvp when the program takes one
+    void drawCubes( int mvpLocation, int previousMvpLocation = -1 );
+
+    JobSystem& jobs;
+    IoService& io;
+    const AssetPack& assets;
+    std::unique_ptr<Shader> shader, virtualShader, feedbackShader, depthShader;
+    std::unique_ptr<Shader> gbufferShader, gbufferVirtualShader, ambientShader, lightShader;
+    std::unique_ptr<Shader> fxaaShader, smaaEdgeShader, smaaWeightShader, smaaBlendShader, taaShader;
+    std::unique_ptr<Shader> transparentShader, transparentCompositeShader;
+
+    // declared before the handles so it outlives them
+    GLResources resources;
+    ScopedProgram program, virtualProgram, feedbackProgram, depthProgram;
+    ScopedProgram gbufferProgram, gbufferVirtualProgram, ambientProgram, lightProgram;
+    ScopedProgram fxaaProgram, smaaEdgeProgram, smaaWeightProgram, smaaBlendProgram, taaProgram;
+    ScopedProgram transparentProgram, transparentCompositeProgram;
+    ScopedVertexArray VAO;
+    ScopedBuffer VBO, EBO;
+    ScopedTexture texture1, texture2;
+    // the full screen triangle and the unit quad of the deferred, anti-aliasing and transparency passes
+    SharedGeometry geometry;
+    TextureStreamer streamer;
+    VirtualTexture virtualTexture;
+    FramebufferReadback readback;
+    VideoCapture video;
+    bool recording = false;
+    DynamicResolution resolution;
+    DepthPrepass depthPrepass;
+    DeferredShading deferred;
+    ClusteredLighting clustered;
+    CascadedShadows shadows;
+    AntiAliasing antiAliasing;
+    TemporalAntiAliasing temporal;
+    Transparency transparency;
+    RenderGraph graph;
+    GraphConfiguration graphConfiguration;
+    int mvpLocation = -1;
+    int virtualMvpLocation = -1;
+    int feedbackMvpLocation = -1;
+    int depthMvpLocation = -1;
+    int gbufferMvpLocation = -1;
+    int gbufferVirtualMvpLocation = -1;
+    int previousMvpLocation = -1;
+    int virtualPreviousMvpLocation = -1;
+    int gbufferPreviousMvpLocation = -1;
+    int gbufferVirtualPreviousMvpLocation = -1;
+
+    // the frame the graph's passes are drawing
+    const FramePacket* framePacket = nullptr;
+    bool virtualTexturing = false;
+};
+
+#endif
@@ -7,22 +7,39 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 class Shader
 {
 public:
+    // GLSL several fragment shaders share ( functions, uniforms, constants ), inserted after
+    // their #version line in the order given
+    struct Chunk
+    {
+        const GLchar* source;
+        GLint length;
+    };
+
     // the program ID
     unsigned int ID;
 
     // constructor reads and builds the shader
     Shader( const GLchar* vertexPath, const GLchar* fragmentPath );
+    // builds the shader from sources already in memory, with the chunks the fragment shader uses
+    Shader( const GLchar* vertexSource, GLint vertexLength, const GLchar* fragmentSource, GLint fragmentLength,
+            const Chunk* fragmentChunks = nullptr, int chunkCount = 0 );
 
     // use/activate the shader
     void use( );
-    // utility uniform functions
-    void setBool( const std::string name, bool value ) const;
-    void setInt( const std::string name, int value ) const;
-    void setFloat( const std::string name, float value ) const;
+    // utility uniform functions ( plain C strings, so calls with literals never allocate )
+    void setBool( const char* name, bool value ) const;
+    void setInt( const char* name, int value ) const;
+    void setFloat( const char* name, float value ) const;
+    void setVec2( const char* name, float x, float y ) const;
+
+private:
+    void build( const GLchar* vertexSource, GLint vertexLength, const GLchar* fragmentSource, GLint fragmentLength,
+                const Chunk* fragmentChunks, int chunkCount );
 };
 
 #endif
\ No newline at end of file
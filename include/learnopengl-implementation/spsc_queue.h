@@ -0,0 +1,50 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// bounded lock-free queue for exactly one producer thread and one consumer thread,
+// Capacity must be a power of two
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert( ( Capacity & ( Capacity - 1 ) ) == 0, "SpscQueue capacity must be a power of two" );
+
+public:
+    // producer side, fails when the queue is full
+    bool push( const T& value )
+    {
+        size_t tail = writeIndex.load( std::memory_order_relaxed );
+        if ( tail - readIndex.load( std::memory_order_acquire ) == Capacity )
+            return false;
+        items[tail & ( Capacity - 1 )] = value;
+        writeIndex.store( tail + 1, std::memory_order_release );
+        return true;
+    }
+
+    // consumer side, fails when the queue is empty
+    bool pop( T& value )
+    {
+        size_t head = readIndex.load( std::memory_order_relaxed );
+        if ( head == writeIndex.load( std::memory_order_acquire ) )
+            return false;
+        value = items[head & ( Capacity - 1 )];
+        readIndex.store( head + 1, std::memory_order_release );
+        return true;
+    }
+
+    // approximate when called while the other side is active
+    size_t size( ) const
+    {
+        return writeIndex.load( std::memory_order_acquire ) - readIndex.load( std::memory_order_acquire );
+    }
+
+private:
+    T items[Capacity];
+    // kept on separate cache lines so the two sides do not false share
+    alignas( 64 ) std::atomic<size_t> writeIndex{ 0 };
+    alignas( 64 ) std::atomic<size_t> readIndex{ 0 };
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef TEMPORAL_ANTI_ALIASING_H
+#define TEMPORAL_ANTI_ALIASING_H
+
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/gl_helpers.h"
+#include "learnopengl-implementation/shader.h"
+#include "learnopengl-implementation/render_graph.h"
+#include "learnopengl-implementation/dynamic_resolution.h"
+
+#include <glm/glm.hpp>
+
+#include <ostream>
+
+// temporal anti-aliasing that also upsamples: the scene is rendered below the window
+// size, every frame with its projection shifted by another subpixel offset ( a Halton
+// sequence ), and the frames are accumulated into a history at the window size. The
+// scene pass writes the motion of every pixel since the last frame, from each draw's
+// current and previous mvp, and the resolve pass follows it from the output pixel into
+// the history ( Catmull-Rom filtered ), takes the motion of the closest surface around
+// it so edges do not trail, and clips the history into the spread of the colors around
+// the pixel, which is what drops the history that no longer belongs there. The current
+// samples are reconstructed at the output pixel with a filter as wide as an output
+// pixel, and weigh in more the closer one of them lands to the pixel's center, so a
+// pixel gathers the samples of several frames before it settles. The two history
+// textures take turns being read and written. Every function runs on the GL thread
+class TemporalAntiAliasing
+{
+public:
+    struct Settings
+    {
+        // largest scale of the window the scene is rendered at, the dynamic resolution may go lower
+        float renderScale = 0.67f;
+        // offsets before the sequence repeats, enough to cover the window pixels every render pixel spans
+        unsigned int jitterPhases = 16;
+        // blend weight of a current sample landing on an output pixel's center, the history keeps the rest
+        float currentWeight = 0.2f;
+        // half size of the box the history is clipped into, in standard deviations of the colors around the pixel
+        float clipSigma = 1.25f;
+    };
+
+    TemporalAntiAliasing( GLResources& resources, const Settings& settings );
+
+    TemporalAntiAliasing( const TemporalAntiAliasing& ) = delete;
+    TemporalAntiAliasing& operator=( const TemporalAntiAliasing& ) = delete;
+
+    // takes the resolve shader, which uses the full screen triangle vertex shader
+    void initialize( const SharedGeometry& geometry, Shader& resolveShader );
+    float renderScale( ) const;
+
+    // moves to the next offset for this frame's scene resolution and sizes the history for
+    // the window, after the dynamic resolution's beginFrame
+    void beginFrame( const DynamicResolution& target, int windowWidth, int windowHeight );
+    // this frame's offset in clip space, the scene's mvps ( current and previous ) are multiplied by it
+    const glm::mat4& jitterMatrix( ) const;
+
+    // the motion target the scene pass writes next to its color, sized like the scene target
+    static RenderGraph::TextureDescription velocityDescription( const DynamicResolution& target );
+    // clears the bound framebuffer's motion attachment: nothing moves where nothing was drawn
+    static void clearVelocity( int drawBuffer );
+    // declares the resolve pass reading the scene's color, depth and motion into the history;
+    // returns the version the upscale reads, which copies outputTexture( ) into the window
+    RenderGraph::Resource addPasses( RenderGraph& graph, RenderGraph::Resource sceneColor, RenderGraph::Resource sceneDepth,
+                                     RenderGraph::Resource velocity, const DynamicResolution& target );
+
+    // the history written last, the frame at the window size
+    GLuint outputTexture( ) const;
+    int outputWidth( ) const;
+    int outputHeight( ) const;
+
+    void shutdown( );
+    // frames, history resets and memory
+    void report( std::ostream& out ) const;
+
+private:
+    static constexpr unsigned int HISTORY_COUNT = 2;
+
+    void createHistory( int width, int height );
+    void resolve( GLuint color, GLuint depth, GLuint velocity, const DynamicResolution& target );
+
+    GLResources& resources;
+    Settings settings;
+    const Shader* resolveShader = nullptr;
+    int renderSizeLocation = -1;
+    int outputSizeLocation = -1;
+    int jitterLocation = -1;
+    int historyValidLocation = -1;
+
+    const SharedGeometry* geometry = nullptr;
+    ScopedFramebuffer historyFramebuffers[HISTORY_COUNT];
+    ScopedTexture history[HISTORY_COUNT];
+    // the history written last
+    unsigned int current = 0;
+    int width = 0;
+    int height = 0;
+
+    // offset of this frame's samples from the render pixel centers, in render pixels
+    glm::vec2 jitter = glm::vec2( 0.0f );
+    glm::mat4 jitterOffset = glm::mat4( 1.0f );
+    unsigned long long frames = 0;
+    // frame the history was written in, it only continues into the next one
+    unsigned long long resolvedFrame = 0;
+
+    unsigned long long resolves = 0;
+    unsigned long long historyResets = 0;
+};
+
+#endif
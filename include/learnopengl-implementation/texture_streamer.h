@@ -0,0 +1,88 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include "learnopengl-implementation/gl_resources.h"
+
+#include <ostream>
+#include <vector>
+
+// a decoded image with its whole mip chain ( level 0 first ), built on a worker
+struct MipChain
+{
+    GLenum format = GL_RGB;
+    int channels = 0;
+    std::vector<int> widths;
+    std::vector<int> heights;
+    std::vector<std::vector<unsigned char>> levels;
+};
+
+// box filters pixels down to 1x1, channels is 3 or 4
+MipChain buildMipChain( const unsigned char* pixels, int width, int height, int channels );
+
+// keeps only the mip levels that are on screen in video memory: a texture starts
+// with its small levels, finer ones are uploaded as objects using it get closer
+// and GL_TEXTURE_BASE_LEVEL follows the finest resident level. When the resident
+// levels exceed the budget, the least recently needed ones are dropped again.
+// Every function runs on the GL thread
+class TextureStreamer
+{
+public:
+    struct Settings
+    {
+        // bytes of texture memory the streamed levels may use
+        size_t budget = 64 * 1024 * 1024;
+        // bytes uploaded per frame at most ( one level always goes through )
+        size_t uploadBytesPerFrame = 1024 * 1024;
+        // levels this size and smaller are loaded up front and never evicted
+        int residentTailSize = 64;
+    };
+
+    TextureStreamer( GLResources& resources, const Settings& settings );
+
+    // takes over the chain and uploads its tail, the texture keeps its other parameters
+    void add( TextureHandle texture, const char* label, MipChain&& chain );
+    // an object covering screenSize pixels samples the texture this frame
+    void request( TextureHandle texture, float screenSize );
+    // uploads and evicts levels for the requests of this frame, once per frame
+    void update( );
+
+    size_t residentBytes( ) const;
+    // per texture residency, uploads and evictions
+    void report( std::ostream& out ) const;
+
+private:
+    struct StreamedTexture
+    {
+        TextureHandle handle;
+        const char* label;
+        MipChain chain;
+        // finest resident level, and the first level of the permanent tail
+        int baseLevel;
+        int tailLevel;
+        // finest level requested this frame
+        int wantedLevel;
+        // frame each level was last needed in
+        std::vector<unsigned long long> lastNeeded;
+
+        size_t residentBytes = 0;
+        unsigned long long uploads = 0;
+        unsigned long long evictions = 0;
+        // frames the texture was requested, and how many of them had the wanted level resident
+        unsigned long long requestedFrames = 0;
+        unsigned long long satisfiedFrames = 0;
+    };
+
+    StreamedTexture* find( TextureHandle texture );
+    bool upload( StreamedTexture& texture );
+    void evict( StreamedTexture& texture );
+    // evicts levels needed before the given frame until bytes more fit in the budget
+    bool makeRoom( size_t bytes, unsigned long long neededBefore );
+
+    GLResources& resources;
+    Settings settings;
+    std::vector<StreamedTexture> textures;
+    size_t resident = 0;
+    unsigned long long frame = 0;
+};
+
+#endif
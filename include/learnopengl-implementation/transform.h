@@ -0,0 +1,77 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+
+class JobSystem;
+
+// stores the local translation/rotation/scale of every node in structure-of-arrays
+// form and keeps the nodes sorted by depth, so the world matrices can be computed
+// with a single linear parent-to-child pass that only touches dirty subtrees
+class TransformSystem
+{
+public:
+    // handle value used for "no parent"
+    static constexpr unsigned int NONE = 0xFFFFFFFFu;
+
+    // creates a node with an identity transform, returning its (stable) handle
+    unsigned int create( unsigned int parent = NONE );
+
+    // local transform setters, each one marks the node's subtree as dirty
+    void setPosition( unsigned int node, const glm::vec3& position );
+    void setRotation( unsigned int node, const glm::quat& rotation );
+    void setScale( unsigned int node, const glm::vec3& scale );
+
+    const glm::vec3& getPosition( unsigned int node ) const;
+    const glm::quat& getRotation( unsigned int node ) const;
+    const glm::vec3& getScale( unsigned int node ) const;
+    const glm::mat4& getWorldMatrix( unsigned int node ) const;
+
+    // recomputes the world matrices of the dirty subtrees, wide levels of the
+    // hierarchy are split across the job system when one is given
+    void update( JobSystem* jobs = nullptr );
+
+    // number of nodes
+    unsigned int size( ) const;
+    // number of world matrices recomputed by the last update
+    unsigned int lastUpdateCount( ) const;
+
+private:
+    enum DirtyFlags : unsigned char
+    {
+        LOCAL_DIRTY = 1,
+        WORLD_DIRTY = 2
+    };
+
+    // reorders every array by depth (stable, so siblings keep their creation order)
+    void sortByDepth( );
+    // recomputes the local/world matrices of one slot if needed, returns whether it did
+    bool updateSlot( unsigned int slot );
+
+    // handle -> slot and slot -> handle indirections, the slots move when sorting
+    std::vector<unsigned int> slotOf;
+    std::vector<unsigned int> nodeAt;
+
+    // per slot data
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<unsigned int> parents;
+    std::vector<unsigned int> depths;
+    std::vector<unsigned char> dirty;
+    std::vector<glm::mat4> localMatrices;
+    std::vector<glm::mat4> worldMatrices;
+
+    // first slot of every depth level, the slots of a level only depend on the previous levels
+    std::vector<unsigned int> levelStarts;
+
+    // lowest slot touched since the last update, NONE when everything is clean
+    unsigned int firstDirty = NONE;
+    bool needsSort = false;
+    unsigned int updateCount = 0;
+};
+
+#endif
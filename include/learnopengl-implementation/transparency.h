@@ -0,0 +1,122 @@
+#ifndef TRANSPARENCY_H
+#define TRANSPARENCY_H
+
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/gl_helpers.h"
+#include "learnopengl-implementation/shader.h"
+#include "learnopengl-implementation/frame_packet.h"
+#include "learnopengl-implementation/render_graph.h"
+#include "learnopengl-implementation/dynamic_resolution.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// the frame's transparent quads, drawn with one instanced call after the opaque scene
+// and tested against its depth without writing it, in either mode:
+//   WEIGHTED_BLENDED  order independent ( McGuire and Bavoil ): the quads go in the
+//                     packet's order into an accumulation target ( RGBA16F: the sum of
+//                     the weighted premultiplied colors, and the revealage, the product
+//                     of one minus every alpha, in alpha ) and the sum of the weights
+//                     ( R16F ), then one full screen pass blends their average over the
+//                     scene. GL 3.3 has no blend state per target, so the revealage shares
+//                     the accumulation's: added color, multiplied alpha
+//   SORTED            the quads are radix sorted back to front by view depth on the CPU
+//                     every frame and blended over the scene target directly; exact where
+//                     the quads do not intersect, and what the MSAA targets get, whose
+//                     accumulation would have to be multisampled too
+// The CPU time of the sort and upload and timestamps around the passes give the cost
+// of each mode. Every function runs on the GL thread
+class Transparency
+{
+public:
+    struct Settings
+    {
+        // off: the transparent quads are not drawn
+        bool enabled = true;
+    };
+
+    Transparency( GLResources& resources, const Settings& settings );
+
+    Transparency( const Transparency& ) = delete;
+    Transparency& operator=( const Transparency& ) = delete;
+
+    // takes the quad and composite shaders and creates the quad mesh over the shared unit quad
+    void initialize( const SharedGeometry& geometry, Shader& quadShader, Shader& compositeShader );
+    bool isEnabled( ) const;
+    // the mode a frame runs for the one it asked for
+    TransparencyMode supportedMode( TransparencyMode requested, AntiAliasingMode antiAliasing ) const;
+
+    // sorts the packet's quads when the mode asks for it and uploads them, before the graph
+    // runs; the projection is the one the scene was drawn with ( jittered for TAA )
+    void prepare( const FramePacket& packet, TransparencyMode mode, const glm::mat4& projection, GLuint texture );
+    // declares the passes of a mode over the scene color and depth ( or the multisampled
+    // ones ) and replaces both with the versions the passes write
+    void addPasses( RenderGraph& graph, TransparencyMode mode, RenderGraph::Resource& color, RenderGraph::Resource& depth,
+                    const DynamicResolution& target );
+
+    void shutdown( );
+    // quads drawn, CPU and GPU time per mode and the accumulation targets' memory
+    void report( std::ostream& out ) const;
+
+private:
+    static constexpr unsigned int MODE_COUNT = (unsigned int) TransparencyMode::COUNT;
+
+    struct ModeStatistics
+    {
+        unsigned long long frames = 0;
+        unsigned long long measured = 0;
+        double cpuMilliseconds = 0.0;
+        double gpuMilliseconds = 0.0;
+    };
+
+    static RenderGraph::TextureDescription accumulationDescription( const DynamicResolution& target, GLenum internalFormat,
+                                                                    GLenum format );
+    // fills sorted with the packet's quads, the farthest first
+    void sortBackToFront( const FramePacket& packet );
+
+    // draws the quads instanced with the blend state of the mode, into the bound target
+    void drawQuads( bool weightedBlended, const DynamicResolution& target );
+    void composite( GLuint accumulation, GLuint weights, const DynamicResolution& target );
+    void beginMeasurement( );
+    void endMeasurement( );
+    void collect( );
+
+    GLResources& resources;
+    Settings settings;
+    const Shader* quadShader = nullptr;
+    const Shader* compositeShader = nullptr;
+    int viewLocation = -1;
+    int projectionLocation = -1;
+    int weightedBlendedLocation = -1;
+
+    const SharedGeometry* geometry = nullptr;
+    ScopedVertexArray quadArray;
+    StreamBuffer instanceBuffer;
+
+    // the frame prepare( ) was given
+    glm::mat4 view = glm::mat4( 1.0f );
+    glm::mat4 projection = glm::mat4( 1.0f );
+    GLuint texture = 0;
+    TransparencyMode mode = TransparencyMode::WEIGHTED_BLENDED;
+    size_t quadCount = 0;
+
+    // radix sort keys and quad indices, with their second buffers, and the quads in order
+    std::vector<uint32_t> keys, sortedKeys;
+    std::vector<uint32_t> indices, sortedIndices;
+    std::vector<TransparentQuad> sorted;
+
+    // timestamps at the start and the end of the passes, and the mode of each measured frame
+    TimerQueryRing timers;
+    TransparencyMode measuredModes[TimerQueryRing::SLOT_COUNT] = { };
+
+    ModeStatistics statistics[MODE_COUNT];
+    unsigned long long quadsDrawn = 0;
+    // size of the scene target the passes were declared for
+    int width = 0;
+    int height = 0;
+};
+
+#endif
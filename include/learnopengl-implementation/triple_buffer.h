@@ -0,0 +1,57 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// lock-free single producer/single consumer triple buffer: the writer always has a
+// buffer to fill, the reader always sees the most recently published one, and
+// neither side ever waits for the other
+template <typename T>
+class TripleBuffer
+{
+public:
+    // writer side, fill writeBuffer( ) and then publish it
+    T& writeBuffer( )
+    {
+        return buffers[back];
+    }
+
+    void publish( )
+    {
+        unsigned int previous = middle.exchange( back | FRESH, std::memory_order_acq_rel );
+        back = previous & INDEX_MASK;
+    }
+
+    // reader side, returns whether a newer buffer became the read buffer
+    bool update( )
+    {
+        if ( !( middle.load( std::memory_order_acquire ) & FRESH ) )
+            return false;
+        unsigned int previous = middle.exchange( front, std::memory_order_acq_rel );
+        front = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer( ) const
+    {
+        return buffers[front];
+    }
+
+    // every buffer, e.g. to reserve memory up front
+    T& buffer( unsigned int index )
+    {
+        return buffers[index];
+    }
+
+private:
+    static constexpr unsigned int INDEX_MASK = 3;
+    // set on the middle index while it holds a buffer the reader has not seen
+    static constexpr unsigned int FRESH = 4;
+
+    T buffers[3];
+    unsigned int back = 0;
+    unsigned int front = 2;
+    std::atomic<unsigned int> middle{ 1 };
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef VIDEO_CAPTURE_H
+#define VIDEO_CAPTURE_H
+
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/job_system.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// records every frame of the default framebuffer into a YUV4MPEG2 ( 4:2:0 ) stream:
+// the back buffer is copied into a pixel pack buffer as in FramebufferReadback,
+// the workers convert the mapped pixels to planar YUV, and a writer thread appends
+// the frames to a file or a pipe in order. The queue between the GL thread and the
+// writer is bounded: when it is full a frame is either dropped or the GL thread
+// waits for the oldest one, which makes the recording lossless at the cost of
+// frame time. capture( ), update( ) and shutdown( ) run on the GL thread
+class VideoCapture
+{
+public:
+    enum class Policy
+    {
+        DROP,
+        BLOCK
+    };
+
+    struct Settings
+    {
+        bool enabled = false;
+        // a file, or with a leading '|' a command reading the stream from its stdin
+        // ( e.g. "| ffmpeg -i - -c:v libx264 capture.mp4" )
+        std::string output = "capture.y4m";
+        // frame rate written in the stream header
+        int frameRate = 60;
+        // frames between the GL thread and the writer
+        unsigned int queueLength = 4;
+        Policy policy = Policy::DROP;
+    };
+
+    VideoCapture( JobSystem& jobs, GLResources& resources, const Settings& settings );
+    ~VideoCapture( );
+
+    VideoCapture( const VideoCapture& ) = delete;
+    VideoCapture& operator=( const VideoCapture& ) = delete;
+
+    // queues a copy of the back buffer, call after drawing and before the swap. The
+    // stream keeps the size of its first frame ( rounded down to even ), frames of
+    // another size are dropped. False when the frame was dropped
+    bool capture( int width, int height );
+    // converts finished copies on the workers and hands converted frames to the writer, once per frame
+    void update( );
+    // writes every frame still queued and closes the stream
+    void shutdown( );
+
+    // frames written and dropped, and the GL thread time capturing cost per frame
+    void report( std::ostream& out ) const;
+
+private:
+    enum SlotState
+    {
+        FREE,
+        READING,
+        CONVERTING,
+        WRITING
+    };
+
+    struct Slot
+    {
+        ScopedBuffer buffer;
+        size_t capacity = 0;
+        GLsync fence = nullptr;
+        const unsigned char* pixels = nullptr;
+        // the Y, U and V planes one after the other
+        std::vector<unsigned char> planes;
+        JobCounter converted;
+        const VideoCapture* owner = nullptr;
+        // the writer hands WRITING slots back as FREE
+        std::atomic<int> state{ FREE };
+    };
+
+    static void convertRows( void* data, unsigned int begin, unsigned int end );
+
+    bool open( );
+    // starts conversions of finished copies and hands converted frames to the writer
+    void advance( );
+    void writerLoop( );
+    void stopWriter( );
+
+    JobSystem& jobs;
+    GLResources& resources;
+    Settings settings;
+    std::unique_ptr<Slot[]> slots;
+    // slot the next capture goes to, and the oldest slot not handed to the writer yet
+    unsigned int next = 0;
+    unsigned int nextWrite = 0;
+
+    // stream size, 0 until the first frame
+    int width = 0;
+    int height = 0;
+
+    FILE* stream = nullptr;
+    bool pipe = false;
+    std::atomic<bool> failed{ false };
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    // slots to write, in frame order, guarded by mutex
+    std::vector<Slot*> queue;
+    bool stopping = false;
+
+    unsigned long long captured = 0;
+    unsigned long long droppedFull = 0;
+    unsigned long long droppedSize = 0;
+    std::atomic<unsigned long long> written{ 0 };
+    unsigned long long frames = 0;
+    unsigned long long glThreadNanoseconds = 0;
+    unsigned long long blockedNanoseconds = 0;
+    unsigned long long frameNanoseconds = 0;
+    unsigned long long maxFrameNanoseconds = 0;
+};
+
+#endif
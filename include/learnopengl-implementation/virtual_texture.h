@@ -0,0 +1,157 @@
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/job_system.h"
+#include "learnopengl-implementation/shader.h"
+#include "learnopengl-implementation/texture_streamer.h"
+
+#include <ostream>
+#include <vector>
+
+// software indirected virtual texture: every mip level of the source image is cut
+// into pages, and only the pages on screen sit in a fixed atlas of physical tiles.
+// A page table texture ( one texel per page, one mip level per virtual level ) holds
+// the tile of each page, or of its closest resident ancestor, and the shader goes
+// through it with texelFetch, so no sparse texture support is needed.
+// The pages to load come from a low resolution feedback pass that is read back
+// through pixel pack buffers a few frames later. Sorting the requests and copying
+// the tiles into a mapped upload buffer run on the workers, the GL thread only
+// issues the calls. Every function runs on the GL thread
+class VirtualTexture
+{
+public:
+    struct Settings
+    {
+        // off: the texture goes through the streamer like the others
+        bool enabled = true;
+        // texels per side of a page and of a physical tile
+        int tileSize = 64;
+        // physical tiles per side of the cache
+        int cacheTiles = 8;
+        // the feedback pass renders at 1 / feedbackDivisor of the viewport size
+        int feedbackDivisor = 8;
+        // tiles loaded per batch at most
+        int tilesPerBatch = 8;
+    };
+
+    VirtualTexture( JobSystem& jobs, GLResources& resources, const Settings& settings );
+    ~VirtualTexture( );
+
+    // takes over the chain and creates the textures, the image must be square, a power
+    // of two and at least one tile. Returns false ( and keeps nothing ) otherwise
+    bool initialize( MipChain&& chain );
+    bool isReady( ) const;
+
+    // binds the feedback target for a viewport of the given size, the caller then draws
+    // the scene with the feedback shader. False when every readback is still in flight
+    bool beginFeedback( int viewportWidth, int viewportHeight );
+    // queues the readback of the feedback target and binds the default framebuffer again
+    void endFeedback( );
+    // moves the readbacks, request sorting, tile copies and uploads along as far
+    // as they are ready, never waits. Once per frame
+    void update( );
+
+    // binds the page table and the cache to the given texture units
+    void bind( int pageTableUnit, int cacheUnit ) const;
+    // sets the layout uniforms shared by the feedback and the sampling shaders
+    void setUniforms( const Shader& shader ) const;
+
+    // waits for the jobs in flight and releases the GL objects
+    void shutdown( );
+    // residency, requests and uploads
+    void report( std::ostream& out ) const;
+
+private:
+    enum class Stage
+    {
+        IDLE,
+        SORTING,
+        COPYING
+    };
+
+    struct Readback
+    {
+        ScopedBuffer buffer;
+        GLsync fence = nullptr;
+        int width = 0;
+        int height = 0;
+        unsigned long long frame = 0;
+    };
+
+    // one tile copied into the upload buffer by a worker
+    struct TileCopy
+    {
+        const VirtualTexture* owner;
+        int page;
+        int slot;
+        unsigned char* destination;
+    };
+
+    static void sortRequests( void* data, unsigned int begin, unsigned int end );
+    static void copyTile( void* data, unsigned int begin, unsigned int end );
+
+    void createFeedbackTarget( int width, int height );
+    // collects the newest finished readback and sorts its requests on a worker
+    void collectFeedback( );
+    // assigns tiles to the sorted requests and copies them on the workers
+    void scheduleCopies( );
+    // uploads the copied tiles and rewrites the page table
+    void uploadTiles( );
+    // one slot for the page, a free one or the least recently used of the others
+    int allocateSlot( );
+    void updatePageTable( );
+
+    int pageLevel( int page ) const;
+    int pagesPerSide( int level ) const;
+
+    JobSystem& jobs;
+    GLResources& resources;
+    Settings settings;
+    MipChain source;
+
+    // page indices of level l start at levelOffsets[l], level 0 first
+    int levels = 0;
+    std::vector<int> levelOffsets;
+    int pageCount = 0;
+    int rootPage = -1;
+
+    ScopedTexture pageTable, cache;
+    ScopedTexture feedbackColor, feedbackDepth;
+    ScopedFramebuffer feedbackFramebuffer;
+    ScopedBuffer uploadBuffer;
+    int feedbackWidth = 0;
+    int feedbackHeight = 0;
+    int viewportWidth = 0;
+    int viewportHeight = 0;
+
+    static constexpr int READBACK_COUNT = 3;
+    Readback readbacks[READBACK_COUNT];
+    int nextReadback = 0;
+
+    // the slot of every page ( -1 when not resident ), the page of every slot and when it was last requested
+    std::vector<int> pageSlots;
+    std::vector<int> slotPages;
+    std::vector<unsigned long long> slotLastUsed;
+    // RGBA entries of every page table level, level 0 first
+    std::vector<unsigned char> pageTableData;
+
+    Stage stage = Stage::IDLE;
+    JobCounter sorted, copied;
+    // pixels of the readback being sorted, and its requested pages ( coarse levels first )
+    std::vector<unsigned char> feedback;
+    std::vector<unsigned int> pageHits;
+    std::vector<int> requests;
+    std::vector<TileCopy> copies;
+
+    unsigned long long frame = 0;
+    unsigned long long readbacksIssued = 0;
+    unsigned long long readbacksSkipped = 0;
+    unsigned long long readbacksSorted = 0;
+    unsigned long long pagesRequested = 0;
+    unsigned long long tilesUploaded = 0;
+    unsigned long long tilesEvicted = 0;
+    unsigned long long readbackLatency = 0;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef YUV_CONVERT_H
+#define YUV_CONVERT_H
+
+// RGBA8 to planar 4:2:0 YCbCr ( BT.601, limited range ) for video capture, every
+// chroma sample is the average of a 2x2 block of pixels. The SSE2 variant is used
+// on x86 builds and does 8 pixels of both rows per step
+namespace YuvConvert
+{
+    // converts two rows of width pixels ( width must be even ), writing width luma
+    // samples per row and width / 2 samples of each chroma plane
+    void convertRowPair( const unsigned char* top, const unsigned char* bottom, int width,
+                         unsigned char* yTop, unsigned char* yBottom, unsigned char* u, unsigned char* v );
+    // the same without SIMD, the reference for the other variant
+    void convertRowPairScalar( const unsigned char* top, const unsigned char* bottom, int width,
+                               unsigned char* yTop, unsigned char* yBottom, unsigned char* u, unsigned char* v );
+
+    const char* name( );
+}
+
+#endif
@@ -0,0 +1,147 @@
+#include "learnopengl-implementation/allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifndef NDEBUG
+
+namespace
+{
+    std::atomic<unsigned long long> totalAllocations{ 0 };
+    thread_local unsigned long long threadAllocations = 0;
+
+    void* countedAllocate( std::size_t size )
+    {
+        totalAllocations.fetch_add( 1, std::memory_order_relaxed );
+        threadAllocations++;
+        if ( size == 0 )
+            size = 1;
+        return std::malloc( size );
+    }
+
+    void* countedAllocateAligned( std::size_t size, std::size_t alignment )
+    {
+        totalAllocations.fetch_add( 1, std::memory_order_relaxed );
+        threadAllocations++;
+        // aligned_alloc wants the size to be a multiple of the alignment
+        size = ( size + alignment - 1 ) / alignment * alignment;
+        return std::aligned_alloc( alignment, size ? size : alignment );
+    }
+}
+
+void* operator new( std::size_t size )
+{
+    void* pointer = countedAllocate( size );
+    if ( !pointer )
+        throw std::bad_alloc( );
+    return pointer;
+}
+
+void* operator new[]( std::size_t size )
+{
+    void* pointer = countedAllocate( size );
+    if ( !pointer )
+        throw std::bad_alloc( );
+    return pointer;
+}
+
+void* operator new( std::size_t size, const std::nothrow_t& ) noexcept
+{
+    return countedAllocate( size );
+}
+
+void* operator new[]( std::size_t size, const std::nothrow_t& ) noexcept
+{
+    return countedAllocate( size );
+}
+
+void* operator new( std::size_t size, std::align_val_t alignment )
+{
+    void* pointer = countedAllocateAligned( size, (std::size_t) alignment );
+    if ( !pointer )
+        throw std::bad_alloc( );
+    return pointer;
+}
+
+void* operator new[]( std::size_t size, std::align_val_t alignment )
+{
+    void* pointer = countedAllocateAligned( size, (std::size_t) alignment );
+    if ( !pointer )
+        throw std::bad_alloc( );
+    return pointer;
+}
+
+void operator delete( void* pointer ) noexcept
+{
+    std::free( pointer );
+}
+
+void operator delete[]( void* pointer ) noexcept
+{
+    std::free( pointer );
+}
+
+void operator delete( void* pointer, std::size_t ) noexcept
+{
+    std::free( pointer );
+}
+
+void operator delete[]( void* pointer, std::size_t ) noexcept
+{
+    std::free( pointer );
+}
+
+void operator delete( void* pointer, std::align_val_t ) noexcept
+{
+    std::free( pointer );
+}
+
+void operator delete[]( void* pointer, std::align_val_t ) noexcept
+{
+    std::free( pointer );
+}
+
+void operator delete( void* pointer, std::size_t, std::align_val_t ) noexcept
+{
+    std::free( pointer );
+}
+
+void operator delete[]( void* pointer, std::size_t, std::align_val_t ) noexcept
+{
+    std::free( pointer );
+}
+
+bool AllocationCounter::enabled( )
+{
+    return true;
+}
+
+unsigned long long AllocationCounter::total( )
+{
+    return totalAllocations.load( std::memory_order_relaxed );
+}
+
+unsigned long long AllocationCounter::thread( )
+{
+    return threadAllocations;
+}
+
+#else
+
+bool AllocationCounter::enabled( )
+{
+    return false;
+}
+
+unsigned long long AllocationCounter::total( )
+{
+    return 0;
+}
+
+unsigned long long AllocationCounter::thread( )
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// the first lighting pass: every pixel gets the ambient and sun light or the background,
+// the point lights are added on top
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform vec3 ambient;
+// view space direction toward the sun
+uniform vec3 sunDirection;
+uniform vec3 sunColor;
+uniform vec3 background;
+uniform mat4 inverseProjection;
+uniform vec2 viewportSize;
+// the sun's shadows are sunVisibility( ) of shadows.glsl, shared with the forward path
+
+vec3 decodeNormal( vec2 e )
+{
+    vec3 n = vec3( e, 1.0 - abs( e.x ) - abs( e.y ) );
+    float t = max( -n.z, 0.0 );
+    n.xy += vec2( n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t );
+    return normalize( n );
+}
+
+void main( )
+{
+    ivec2 pixel = ivec2( gl_FragCoord.xy );
+    float depth = texelFetch( gDepth, pixel, 0 ).r;
+    if ( depth == 1.0 )
+    {
+        FragColor = vec4( background, 1.0 );
+        return;
+    }
+    vec4 position = inverseProjection * vec4( gl_FragCoord.xy / viewportSize * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0 );
+    position.xyz /= position.w;
+    vec3 n = decodeNormal( texelFetch( gNormal, pixel, 0 ).rg );
+    vec3 albedo = texelFetch( gAlbedo, pixel, 0 ).rgb;
+    FragColor = vec4( albedo * ( ambient + sunColor * max( dot( n, sunDirection ), 0.0 ) * sunVisibility( position.xyz ) ), 1.0 );
+}
@@ -0,0 +1,317 @@
+#include "learnopengl-implementation/anti_aliasing.h"
+
+#include <algorithm>
+
+namespace
+{
+    // texture units of the filter inputs
+    const int COLOR_UNIT = 0;
+    const int SECOND_UNIT = 1;
+
+    // timestamps of a measured frame
+    const unsigned int START_QUERY = 0;
+    const unsigned int POST_QUERY = 1;
+    const unsigned int FINISH_QUERY = 2;
+
+    const char* modeName( AntiAliasingMode mode )
+    {
+        switch ( mode )
+        {
+        case AntiAliasingMode::MSAA:
+            return "MSAA";
+        case AntiAliasingMode::FXAA:
+            return "FXAA";
+        case AntiAliasingMode::SMAA:
+            return "SMAA";
+        case AntiAliasingMode::TAA:
+            return "TAA";
+        default:
+            return "none";
+        }
+    }
+}
+
+AntiAliasing::AntiAliasing( GLResources& resources, const Settings& settings )
+    : resources( resources ), settings( settings ), timers( resources, "anti-aliasing timestamp", 3 )
+{
+    this->settings.samples = std::max( 2, settings.samples );
+    this->settings.searchSteps = std::max( 1, settings.searchSteps );
+}
+
+void AntiAliasing::initialize( const SharedGeometry& geometry, Shader& fxaaShader, Shader& edgeShader, Shader& weightShader,
+                               Shader& blendShader )
+{
+    this->geometry = &geometry;
+    this->fxaaShader = &fxaaShader;
+    this->edgeShader = &edgeShader;
+    this->weightShader = &weightShader;
+    this->blendShader = &blendShader;
+
+    fxaaShader.use( );
+    fxaaShader.setInt( "color", COLOR_UNIT );
+    fxaaShader.setFloat( "edgeThreshold", settings.edgeThreshold );
+    fxaaTexelSizeLocation = glGetUniformLocation( fxaaShader.ID, "texelSize" );
+    fxaaMaxCoordinateLocation = glGetUniformLocation( fxaaShader.ID, "maxCoordinate" );
+
+    edgeShader.use( );
+    edgeShader.setInt( "color", COLOR_UNIT );
+    edgeShader.setFloat( "edgeThreshold", settings.edgeThreshold );
+    edgeRenderSizeLocation = glGetUniformLocation( edgeShader.ID, "renderSize" );
+
+    weightShader.use( );
+    weightShader.setInt( "edges", SECOND_UNIT );
+    weightShader.setInt( "searchSteps", settings.searchSteps );
+    weightRenderSizeLocation = glGetUniformLocation( weightShader.ID, "renderSize" );
+
+    blendShader.use( );
+    blendShader.setInt( "color", COLOR_UNIT );
+    blendShader.setInt( "weights", SECOND_UNIT );
+    blendRenderSizeLocation = glGetUniformLocation( blendShader.ID, "renderSize" );
+}
+
+AntiAliasingMode AntiAliasing::supportedMode( AntiAliasingMode requested, bool deferred ) const
+{
+    if ( !fxaaShader || requested >= AntiAliasingMode::COUNT )
+        return AntiAliasingMode::NONE;
+    // a multisampled G-buffer would have to be lit per sample
+    if ( requested == AntiAliasingMode::MSAA && deferred )
+        return AntiAliasingMode::FXAA;
+    return requested;
+}
+
+RenderGraph::TextureDescription AntiAliasing::colorDescription( const DynamicResolution& target, GLenum internalFormat, GLenum format )
+{
+    RenderGraph::TextureDescription description;
+    description.width = target.targetWidth( );
+    description.height = target.targetHeight( );
+    description.internalFormat = internalFormat;
+    description.format = format;
+    description.type = GL_UNSIGNED_BYTE;
+    return description;
+}
+
+RenderGraph::TextureDescription AntiAliasing::multisampledColor( const DynamicResolution& target ) const
+{
+    RenderGraph::TextureDescription description = colorDescription( target, GL_RGBA8, GL_RGBA );
+    description.samples = settings.samples;
+    return description;
+}
+
+RenderGraph::TextureDescription AntiAliasing::multisampledDepth( const DynamicResolution& target ) const
+{
+    RenderGraph::TextureDescription description = colorDescription( target, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL );
+    description.type = GL_UNSIGNED_INT_24_8;
+    description.samples = settings.samples;
+    return description;
+}
+
+RenderGraph::Resource AntiAliasing::addPasses( RenderGraph& graph, AntiAliasingMode mode, RenderGraph::Resource sceneColor,
+                                               RenderGraph::Resource multisampled, const DynamicResolution& target )
+{
+    width = target.targetWidth( );
+    height = target.targetHeight( );
+    if ( mode == AntiAliasingMode::MSAA )
+    {
+        RenderGraph::Pass pass = graph.addPass( "MSAA resolve", [this, &graph, multisampled, &target]( )
+        {
+            resolve( graph.texture( multisampled ), target );
+        } );
+        graph.read( pass, multisampled );
+        return graph.writeColor( pass, sceneColor );
+    }
+
+    if ( mode == AntiAliasingMode::FXAA )
+    {
+        RenderGraph::Resource output = graph.createTexture( "FXAA output", colorDescription( target, GL_RGBA8, GL_RGBA ) );
+        RenderGraph::Pass pass = graph.addPass( "FXAA", [this, &graph, sceneColor, &target]( )
+        {
+            fxaa( graph.texture( sceneColor ), target );
+        } );
+        graph.read( pass, sceneColor );
+        return graph.writeColor( pass, output );
+    }
+
+    if ( mode == AntiAliasingMode::SMAA )
+    {
+        RenderGraph::Resource edges = graph.createTexture( "SMAA edges", colorDescription( target, GL_RG8, GL_RG ) );
+        RenderGraph::Resource weights = graph.createTexture( "SMAA weights", colorDescription( target, GL_RGBA8, GL_RGBA ) );
+        RenderGraph::Resource output = graph.createTexture( "SMAA output", colorDescription( target, GL_RGBA8, GL_RGBA ) );
+
+        RenderGraph::Pass edgePass = graph.addPass( "SMAA edges", [this, &graph, sceneColor, &target]( )
+        {
+            detectEdges( graph.texture( sceneColor ), target );
+        } );
+        graph.read( edgePass, sceneColor );
+        edges = graph.writeColor( edgePass, edges );
+
+        RenderGraph::Pass weightPass = graph.addPass( "SMAA weights", [this, &graph, edges, &target]( )
+        {
+            computeWeights( graph.texture( edges ), target );
+        } );
+        graph.read( weightPass, edges );
+        weights = graph.writeColor( weightPass, weights );
+
+        RenderGraph::Pass blendPass = graph.addPass( "SMAA blend", [this, &graph, sceneColor, weights, &target]( )
+        {
+            blend( graph.texture( sceneColor ), graph.texture( weights ), target );
+        } );
+        graph.read( blendPass, sceneColor );
+        graph.read( blendPass, weights );
+        return graph.writeColor( blendPass, output );
+    }
+
+    return sceneColor;
+}
+
+void AntiAliasing::resolve( GLuint multisampled, const DynamicResolution& target )
+{
+    beginPost( );
+    if ( resolveFramebuffer.get( ).isNull( ) )
+        resolveFramebuffer = ScopedFramebuffer( resources, resources.createFramebuffer( "MSAA resolve" ) );
+    // attached every frame, the graph may place the transient in another texture
+    glBindFramebuffer( GL_READ_FRAMEBUFFER, resolveFramebuffer.name( ) );
+    glFramebufferTexture2D( GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, multisampled, 0 );
+    // the graph bound the scene target for drawing, a resolve blit copies the size as is
+    glBlitFramebuffer( 0, 0, target.renderWidth( ), target.renderHeight( ), 0, 0, target.renderWidth( ), target.renderHeight( ),
+                       GL_COLOR_BUFFER_BIT, GL_NEAREST );
+}
+
+void AntiAliasing::fxaa( GLuint color, const DynamicResolution& target )
+{
+    beginPost( );
+    glUseProgram( fxaaShader->ID );
+    glm::vec2 texelSize( 1.0f / target.targetWidth( ), 1.0f / target.targetHeight( ) );
+    glUniform2f( fxaaTexelSizeLocation, texelSize.x, texelSize.y );
+    glUniform2f( fxaaMaxCoordinateLocation, ( target.renderWidth( ) - 0.5f ) * texelSize.x, ( target.renderHeight( ) - 0.5f ) * texelSize.y );
+    glActiveTexture( GL_TEXTURE0 + COLOR_UNIT );
+    glBindTexture( GL_TEXTURE_2D, color );
+    drawFullscreen( target );
+}
+
+void AntiAliasing::detectEdges( GLuint color, const DynamicResolution& target )
+{
+    beginPost( );
+    glUseProgram( edgeShader->ID );
+    glUniform2i( edgeRenderSizeLocation, target.renderWidth( ), target.renderHeight( ) );
+    glActiveTexture( GL_TEXTURE0 + COLOR_UNIT );
+    glBindTexture( GL_TEXTURE_2D, color );
+    drawFullscreen( target );
+}
+
+void AntiAliasing::computeWeights( GLuint edges, const DynamicResolution& target )
+{
+    glUseProgram( weightShader->ID );
+    glUniform2i( weightRenderSizeLocation, target.renderWidth( ), target.renderHeight( ) );
+    glActiveTexture( GL_TEXTURE0 + SECOND_UNIT );
+    glBindTexture( GL_TEXTURE_2D, edges );
+    drawFullscreen( target );
+}
+
+void AntiAliasing::blend( GLuint color, GLuint weights, const DynamicResolution& target )
+{
+    glUseProgram( blendShader->ID );
+    glUniform2i( blendRenderSizeLocation, target.renderWidth( ), target.renderHeight( ) );
+    glActiveTexture( GL_TEXTURE0 + COLOR_UNIT );
+    glBindTexture( GL_TEXTURE_2D, color );
+    glActiveTexture( GL_TEXTURE0 + SECOND_UNIT );
+    glBindTexture( GL_TEXTURE_2D, weights );
+    drawFullscreen( target );
+}
+
+void AntiAliasing::drawFullscreen( const DynamicResolution& target )
+{
+    // every pixel is written, the transients need no clear
+    glViewport( 0, 0, target.renderWidth( ), target.renderHeight( ) );
+    glDisable( GL_DEPTH_TEST );
+    geometry->drawFullscreen( );
+    glActiveTexture( GL_TEXTURE0 );
+    glEnable( GL_DEPTH_TEST );
+}
+
+void AntiAliasing::beginMeasurement( AntiAliasingMode mode )
+{
+    collect( );
+    statistics[(unsigned int) mode].frames++;
+    postMarked = false;
+    if ( !timers.begin( ) )
+        return;
+    measuredModes[timers.slot( )] = mode;
+    timers.timestamp( START_QUERY );
+}
+
+void AntiAliasing::beginPost( )
+{
+    if ( !timers.isMeasuring( ) || postMarked )
+        return;
+    timers.timestamp( POST_QUERY );
+    postMarked = true;
+}
+
+void AntiAliasing::endMeasurement( )
+{
+    if ( !timers.isMeasuring( ) )
+        return;
+    // without anti-aliasing passes they took no time
+    beginPost( );
+    timers.timestamp( FINISH_QUERY );
+    timers.end( );
+}
+
+void AntiAliasing::collect( )
+{
+    timers.collect( [this]( unsigned int slot, const GLuint64* results )
+    {
+        GLuint64 start = results[START_QUERY], post = results[POST_QUERY], finish = results[FINISH_QUERY];
+        if ( post < start || finish < post )
+            return;
+        ModeStatistics& mode = statistics[(unsigned int) measuredModes[slot]];
+        mode.measured++;
+        mode.sceneMilliseconds += ( post - start ) / 1.0e6;
+        mode.postMilliseconds += ( finish - post ) / 1.0e6;
+    } );
+}
+
+size_t AntiAliasing::bytesPerPixel( AntiAliasingMode mode ) const
+{
+    switch ( mode )
+    {
+    case AntiAliasingMode::MSAA:
+        // multisampled RGBA8 color and D24S8 depth
+        return (size_t) settings.samples * ( 4 + 4 );
+    case AntiAliasingMode::FXAA:
+        // RGBA8 output
+        return 4;
+    case AntiAliasingMode::SMAA:
+        // RG8 edges, RGBA8 weights and output
+        return 2 + 4 + 4;
+    case AntiAliasingMode::TAA:
+        // RG16F motion, the history at the window size is in the temporal report
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+void AntiAliasing::shutdown( )
+{
+    timers.reset( );
+    resolveFramebuffer.reset( );
+}
+
+void AntiAliasing::report( std::ostream& out ) const
+{
+    if ( width == 0 )
+        return;
+    out << "Anti-aliasing:";
+    for ( unsigned int index = 0; index < MODE_COUNT; index++ )
+    {
+        const ModeStatistics& mode = statistics[index];
+        size_t bytes = (size_t) width * height * bytesPerPixel( (AntiAliasingMode) index );
+        out << ( index == 0 ? " " : ", " ) << modeName( (AntiAliasingMode) index ) << " " << mode.frames << " frames";
+        if ( mode.measured > 0 )
+            out << " ( scene " << mode.sceneMilliseconds / mode.measured << " ms, anti-aliasing "
+                << mode.postMilliseconds / mode.measured << " ms GPU )";
+        out << " " << (double) bytes / ( 1024 * 1024 ) << " MB";
+    }
+    out << " at " << width << "x" << height << ", MSAA " << settings.samples << "x" << std::endl;
+}
@@ -0,0 +1,194 @@
+#include "learnopengl-implementation/asset_pack.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+AssetPack::~AssetPack( )
+{
+    close( );
+}
+
+bool AssetPack::open( const std::string& packPath, const std::string& looseRoot )
+{
+    close( );
+    this->looseRoot = looseRoot;
+    if ( packPath.empty( ) )
+        return true;
+
+    file = ::open( packPath.c_str( ), O_RDONLY );
+    if ( file < 0 )
+    {
+        std::cerr << "ERROR::ASSET_PACK::OPEN_FAILED " << packPath << std::endl;
+        return false;
+    }
+
+    struct stat status;
+    void* mapping = MAP_FAILED;
+    if ( fstat( file, &status ) == 0 && (size_t) status.st_size >= sizeof( PackHeader ) )
+        mapping = mmap( nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0 );
+    if ( mapping == MAP_FAILED )
+    {
+        std::cerr << "ERROR::ASSET_PACK::MAP_FAILED " << packPath << std::endl;
+        close( );
+        this->looseRoot = looseRoot;
+        return false;
+    }
+
+    base = static_cast<const unsigned char*>( mapping );
+    mappedSize = status.st_size;
+
+    const PackHeader* header = reinterpret_cast<const PackHeader*>( base );
+    size_t tableEnd = sizeof( PackHeader ) + (size_t) header->entryCount * sizeof( PackEntry );
+    if ( memcmp( header->magic, PACK_MAGIC, sizeof( PACK_MAGIC ) ) != 0 || header->version != PACK_VERSION ||
+         tableEnd > mappedSize )
+    {
+        std::cerr << "ERROR::ASSET_PACK::INVALID_HEADER " << packPath << std::endl;
+        close( );
+        this->looseRoot = looseRoot;
+        return false;
+    }
+
+    entries = reinterpret_cast<const PackEntry*>( base + sizeof( PackHeader ) );
+    entryCount = header->entryCount;
+    names = reinterpret_cast<const char*>( base + tableEnd );
+
+    // the table of contents is read on every lookup, the payloads only when used
+    madvise( const_cast<unsigned char*>( base ), tableEnd, MADV_WILLNEED );
+    return true;
+}
+
+void AssetPack::close( )
+{
+    if ( base )
+        munmap( const_cast<unsigned char*>( base ), mappedSize );
+    if ( file >= 0 )
+        ::close( file );
+    for ( std::map<std::string, int>::value_type& loose : looseDescriptors )
+        ::close( loose.second );
+    looseDescriptors.clear( );
+    file = -1;
+    base = nullptr;
+    mappedSize = 0;
+    entries = nullptr;
+    entryCount = 0;
+    names = nullptr;
+    looseRoot.clear( );
+    looseFiles.clear( );
+}
+
+AssetView AssetPack::find( const std::string& name ) const
+{
+    if ( !looseRoot.empty( ) )
+    {
+        AssetView loose = findLoose( name );
+        if ( loose.isValid( ) )
+            return loose;
+    }
+
+    AssetView view;
+    const PackEntry* entry = findEntry( name );
+    if ( entry )
+    {
+        view.data = base + entry->offset;
+        view.size = entry->size;
+    }
+    return view;
+}
+
+AssetLocation AssetPack::locate( const std::string& name ) const
+{
+    AssetLocation location;
+    if ( !looseRoot.empty( ) )
+    {
+        std::map<std::string, int>::iterator cached = looseDescriptors.find( name );
+        if ( cached == looseDescriptors.end( ) )
+        {
+            int descriptor = ::open( ( looseRoot + "/" + name ).c_str( ), O_RDONLY );
+            if ( descriptor >= 0 )
+                cached = looseDescriptors.insert( std::make_pair( name, descriptor ) ).first;
+        }
+        struct stat status;
+        if ( cached != looseDescriptors.end( ) && fstat( cached->second, &status ) == 0 )
+        {
+            location.file = cached->second;
+            location.size = status.st_size;
+            return location;
+        }
+    }
+
+    const PackEntry* entry = findEntry( name );
+    if ( entry )
+    {
+        location.file = file;
+        location.offset = entry->offset;
+        location.size = entry->size;
+    }
+    return location;
+}
+
+const PackEntry* AssetPack::findEntry( const std::string& name ) const
+{
+    uint64_t hash = fnv1a( name.data( ), name.size( ) );
+    const PackEntry* end = entries + entryCount;
+    const PackEntry* entry = std::lower_bound( entries, end, hash,
+                                               []( const PackEntry& entry, uint64_t hash ) { return entry.nameHash < hash; } );
+
+    // names sharing a hash sit next to each other, the stored name settles it
+    for ( ; entry != end && entry->nameHash == hash; entry++ )
+    {
+        if ( entry->nameLength == name.size( ) && memcmp( names + entry->nameOffset, name.data( ), name.size( ) ) == 0 )
+            return entry;
+    }
+    std::cerr << "ERROR::ASSET_PACK::NOT_FOUND " << name << std::endl;
+    return nullptr;
+}
+
+AssetView AssetPack::findLoose( const std::string& name ) const
+{
+    AssetView view;
+    std::map<std::string, std::vector<unsigned char>>::iterator cached = looseFiles.find( name );
+    if ( cached == looseFiles.end( ) )
+    {
+        std::ifstream file( looseRoot + "/" + name, std::ios::binary | std::ios::ate );
+        if ( !file )
+            return view;
+
+        std::vector<unsigned char> contents( (size_t) file.tellg( ) );
+        file.seekg( 0 );
+        file.read( reinterpret_cast<char*>( contents.data( ) ), contents.size( ) );
+        cached = looseFiles.insert( std::make_pair( name, std::move( contents ) ) ).first;
+    }
+
+    // a view of an empty vector still has to be valid
+    static const unsigned char empty = 0;
+    view.data = cached->second.empty( ) ? &empty : cached->second.data( );
+    view.size = cached->second.size( );
+    return view;
+}
+
+bool AssetPack::verify( ) const
+{
+    bool valid = true;
+    for ( uint32_t i = 0; i < entryCount; i++ )
+    {
+        const PackEntry& entry = entries[i];
+        if ( entry.offset + entry.size > mappedSize || fnv1a( base + entry.offset, entry.size ) != entry.contentHash )
+        {
+            std::cerr << "ERROR::ASSET_PACK::CORRUPT_ASSET " << std::string( names + entry.nameOffset, entry.nameLength ) << std::endl;
+            valid = false;
+        }
+    }
+    return valid;
+}
+
+size_t AssetPack::assetCount( ) const
+{
+    return entryCount;
+}
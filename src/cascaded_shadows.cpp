@@ -0,0 +1,285 @@
+#include "learnopengl-implementation/cascaded_shadows.h"
+#include "learnopengl-implementation/culling.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    // texture unit of the shadow atlas in the shaders that receive shadows
+    const int SHADOW_UNIT = 6;
+
+    // the casters are unit cubes
+    const float CASTER_RADIUS = 0.8660254f;
+
+    // timestamps of a measured frame
+    const unsigned int START_QUERY = 0;
+    const unsigned int FINISH_QUERY = 1;
+}
+
+CascadedShadows::CascadedShadows( GLResources& resources, const Settings& settings )
+    : resources( resources ), settings( settings ), timers( resources, "shadow pass timestamp", 2 )
+{
+    this->settings.cascades = std::min( MAX_CASCADES, std::max( 1u, settings.cascades ) );
+    this->settings.resolution = std::max( 16, settings.resolution );
+    this->settings.margin = std::max( 0.0f, settings.margin );
+}
+
+void CascadedShadows::initialize( Shader& depthShader )
+{
+    if ( !settings.enabled )
+        return;
+    this->depthShader = &depthShader;
+    mvpLocation = glGetUniformLocation( depthShader.ID, "mvp" );
+
+    int width = settings.resolution * (int) settings.cascades;
+    int height = settings.resolution;
+    staticFramebuffer = ScopedFramebuffer( resources, resources.createFramebuffer( "static shadow casters" ) );
+    shadowFramebuffer = ScopedFramebuffer( resources, resources.createFramebuffer( "shadow atlas" ) );
+    staticAtlas = ScopedTexture( resources, resources.createTexture( "static shadow atlas" ) );
+    shadowAtlas = ScopedTexture( resources, resources.createTexture( "shadow atlas" ) );
+
+    // the same format for both, the static one is copied into the other every frame
+    glBindTexture( GL_TEXTURE_2D, staticAtlas.name( ) );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    resources.setSize( staticAtlas.get( ), (size_t) width * height * 4 );
+
+    // compared in the sampler, bilinearly, and lit outside the atlas
+    float border[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glBindTexture( GL_TEXTURE_2D, shadowAtlas.name( ) );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER );
+    glTexParameterfv( GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL );
+    resources.setSize( shadowAtlas.get( ), (size_t) width * height * 4 );
+    glBindTexture( GL_TEXTURE_2D, 0 );
+
+    bool complete = true;
+    ScopedFramebuffer* framebuffers[] = { &staticFramebuffer, &shadowFramebuffer };
+    ScopedTexture* atlases[] = { &staticAtlas, &shadowAtlas };
+    for ( int i = 0; i < 2; i++ )
+    {
+        glBindFramebuffer( GL_FRAMEBUFFER, framebuffers[i]->name( ) );
+        glFramebufferTexture2D( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, atlases[i]->name( ), 0 );
+        glDrawBuffer( GL_NONE );
+        glReadBuffer( GL_NONE );
+        complete = complete && glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE;
+    }
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    if ( !complete )
+    {
+        std::cerr << "ERROR::CASCADED_SHADOWS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        settings.enabled = false;
+    }
+}
+
+bool CascadedShadows::isEnabled( ) const
+{
+    return settings.enabled && depthShader;
+}
+
+TextureHandle CascadedShadows::atlasTexture( ) const
+{
+    return shadowAtlas.get( );
+}
+
+void CascadedShadows::setSamplers( Shader& shader ) const
+{
+    shader.setInt( "shadowMap", SHADOW_UNIT );
+}
+
+void CascadedShadows::fit( const FramePacket& packet )
+{
+    // the sun's rotation, looking from the sun at the scene
+    glm::vec3 toSun = glm::normalize( packet.sunDirection );
+    glm::vec3 up = std::fabs( toSun.y ) > 0.99f ? glm::vec3( 1.0f, 0.0f, 0.0f ) : glm::vec3( 0.0f, 1.0f, 0.0f );
+    glm::mat3 rotation = glm::mat3( glm::lookAt( glm::vec3( 0.0f ), -toSun, up ) );
+    bool allStale = !settings.caching || rotation != lightRotation || packet.staticCasterVersion != staticCasterVersion;
+    lightRotation = rotation;
+    staticCasterVersion = packet.staticCasterVersion;
+
+    // the frustum's near plane and side slopes from the perspective matrix
+    const glm::mat4& projection = packet.projection;
+    float nearPlane = projection[3][2] / ( projection[2][2] - 1.0f );
+    float farPlane = std::min( settings.distance, projection[3][2] / ( projection[2][2] + 1.0f ) );
+    float slopes = 1.0f / ( projection[0][0] * projection[0][0] ) + 1.0f / ( projection[1][1] * projection[1][1] );
+    glm::mat4 inverseView = glm::inverse( packet.view );
+
+    float sliceNear = nearPlane;
+    for ( unsigned int i = 0; i < settings.cascades; i++ )
+    {
+        Cascade& cascade = cascades[i];
+        float part = (float) ( i + 1 ) / settings.cascades;
+        float logarithmic = nearPlane * std::pow( farPlane / nearPlane, part );
+        float uniform = nearPlane + ( farPlane - nearPlane ) * part;
+        float sliceFar = settings.splitBlend * logarithmic + ( 1.0f - settings.splitBlend ) * uniform;
+        cascade.split = sliceFar;
+
+        // the sphere through the corners of the slice, its center on the view axis
+        float depth = std::min( sliceFar, ( sliceNear + sliceFar ) * 0.5f * ( 1.0f + slopes ) );
+        float radius = std::max( std::sqrt( ( sliceFar - depth ) * ( sliceFar - depth ) + sliceFar * sliceFar * slopes ),
+                                 std::sqrt( ( depth - sliceNear ) * ( depth - sliceNear ) + sliceNear * sliceNear * slopes ) );
+        glm::vec3 center = lightRotation * glm::vec3( inverseView * glm::vec4( 0.0f, 0.0f, -depth, 1.0f ) );
+        sliceNear = sliceFar;
+
+        // moving the cascade only once the sphere leaves it, and then in whole texels
+        float halfSize = radius * ( 1.0f + settings.margin );
+        float slack = radius * settings.margin;
+        glm::vec3 offset = glm::abs( center - cascade.center );
+        if ( allStale || cascade.stale || std::fabs( halfSize - cascade.halfSize ) > halfSize * 0.0001f
+             || offset.x > slack || offset.y > slack || offset.z > slack )
+        {
+            float texel = 2.0f * halfSize / settings.resolution;
+            cascade.center = glm::vec3( glm::floor( glm::vec2( center ) / texel + 0.5f ) * texel, center.z );
+            cascade.halfSize = halfSize;
+            cascade.stale = true;
+        }
+
+        // light space looks down -z, the casters toward the sun have the larger z
+        const glm::vec3& box = cascade.center;
+        glm::mat4 ortho = glm::ortho( box.x - cascade.halfSize, box.x + cascade.halfSize, box.y - cascade.halfSize, box.y + cascade.halfSize,
+                                      -( box.z + cascade.halfSize + settings.casterDistance ), -( box.z - cascade.halfSize ) );
+        cascade.viewProjection = ortho * glm::mat4( lightRotation );
+
+        // clip space to the cascade's square of the atlas
+        glm::mat4 atlas = glm::translate( glm::mat4( 1.0f ), glm::vec3( ( i + 0.5f ) / settings.cascades, 0.5f, 0.5f ) )
+                          * glm::scale( glm::mat4( 1.0f ), glm::vec3( 0.5f / settings.cascades, 0.5f, 0.5f ) );
+        shadowMatrices[i] = atlas * cascade.viewProjection * inverseView;
+    }
+}
+
+void CascadedShadows::drawCasters( const FrameVector<glm::mat4>& casters, const Cascade& cascade, unsigned int index )
+{
+    glViewport( index * settings.resolution, 0, settings.resolution, settings.resolution );
+    Frustum frustum( cascade.viewProjection );
+    for ( const glm::mat4& model : casters )
+    {
+        if ( !frustum.intersectsSphere( glm::vec3( model[3] ), CASTER_RADIUS ) )
+            continue;
+        glm::mat4 mvp = cascade.viewProjection * model;
+        glUniformMatrix4fv( mvpLocation, 1, GL_FALSE, glm::value_ptr( mvp ) );
+        glDrawArrays( GL_TRIANGLES, 0, 36 );
+    }
+}
+
+void CascadedShadows::render( const FramePacket& packet )
+{
+    if ( !isEnabled( ) )
+        return;
+    frames++;
+    collect( );
+    fit( packet );
+
+    timers.begin( );
+    timers.timestamp( START_QUERY );
+
+    glEnable( GL_POLYGON_OFFSET_FILL );
+    glPolygonOffset( settings.slopeBias, settings.constantBias );
+    depthShader->use( );
+
+    // the static casters of the cascades that moved, each cleared alone
+    bool redrawn = false;
+    glBindFramebuffer( GL_FRAMEBUFFER, staticFramebuffer.name( ) );
+    glEnable( GL_SCISSOR_TEST );
+    for ( unsigned int i = 0; i < settings.cascades; i++ )
+    {
+        if ( !cascades[i].stale )
+            continue;
+        glScissor( i * settings.resolution, 0, settings.resolution, settings.resolution );
+        glClear( GL_DEPTH_BUFFER_BIT );
+        drawCasters( packet.staticCasters, cascades[i], i );
+        cascades[i].stale = false;
+        staticRedraws++;
+        redrawn = true;
+    }
+    glDisable( GL_SCISSOR_TEST );
+    if ( redrawn )
+        redrawFrames++;
+
+    // the dynamic casters on top of a copy of the static ones
+    int width = settings.resolution * (int) settings.cascades;
+    glBindFramebuffer( GL_READ_FRAMEBUFFER, staticFramebuffer.name( ) );
+    glBindFramebuffer( GL_DRAW_FRAMEBUFFER, shadowFramebuffer.name( ) );
+    glBlitFramebuffer( 0, 0, width, settings.resolution, 0, 0, width, settings.resolution, GL_DEPTH_BUFFER_BIT, GL_NEAREST );
+    glBindFramebuffer( GL_FRAMEBUFFER, shadowFramebuffer.name( ) );
+    for ( unsigned int i = 0; i < settings.cascades; i++ )
+        drawCasters( packet.dynamicCasters, cascades[i], i );
+
+    glDisable( GL_POLYGON_OFFSET_FILL );
+
+    if ( timers.isMeasuring( ) )
+        measuredCached[timers.slot( )] = !redrawn;
+    timers.timestamp( FINISH_QUERY );
+    timers.end( );
+}
+
+void CascadedShadows::collect( )
+{
+    timers.collect( [this]( unsigned int slot, const GLuint64* results )
+    {
+        GLuint64 start = results[START_QUERY], finish = results[FINISH_QUERY];
+        if ( finish < start )
+            return;
+
+        double milliseconds = ( finish - start ) / 1000000.0;
+        if ( measuredCached[slot] )
+        {
+            cachedMeasured++;
+            cachedMilliseconds += milliseconds;
+        }
+        else
+        {
+            uncachedMeasured++;
+            uncachedMilliseconds += milliseconds;
+        }
+    } );
+}
+
+void CascadedShadows::bind( const Shader& shader ) const
+{
+    shader.setBool( "shadows", isEnabled( ) );
+    if ( !isEnabled( ) )
+        return;
+    glActiveTexture( GL_TEXTURE0 + SHADOW_UNIT );
+    glBindTexture( GL_TEXTURE_2D, shadowAtlas.name( ) );
+    glActiveTexture( GL_TEXTURE0 );
+
+    float splits[MAX_CASCADES] = { 0.0f };
+    for ( unsigned int i = 0; i < settings.cascades; i++ )
+        splits[i] = cascades[i].split;
+    glUniformMatrix4fv( glGetUniformLocation( shader.ID, "shadowMatrices" ), settings.cascades, GL_FALSE, glm::value_ptr( shadowMatrices[0] ) );
+    glUniform4fv( glGetUniformLocation( shader.ID, "cascadeSplits" ), 1, splits );
+    shader.setInt( "cascadeCount", settings.cascades );
+}
+
+void CascadedShadows::shutdown( )
+{
+    timers.reset( );
+    staticFramebuffer.reset( );
+    shadowFramebuffer.reset( );
+    staticAtlas.reset( );
+    shadowAtlas.reset( );
+}
+
+void CascadedShadows::report( std::ostream& out ) const
+{
+    if ( frames == 0 )
+        return;
+    out << "Cascaded shadows: " << settings.cascades << " cascades of " << settings.resolution << "x" << settings.resolution
+        << ", static casters redrawn in " << redrawFrames << " of " << frames << " frames ( " << staticRedraws << " cascades" << ( settings.caching ? "" : ", caching off" ) << " )";
+    if ( cachedMeasured > 0 )
+        out << ", GPU " << cachedMilliseconds / cachedMeasured << " ms per cached frame";
+    if ( uncachedMeasured > 0 )
+        out << ( cachedMeasured > 0 ? " against " : ", GPU " ) << uncachedMilliseconds / uncachedMeasured << " ms redrawing the static casters";
+    out << std::endl;
+}
@@ -0,0 +1,355 @@
+#include "learnopengl-implementation/clustered_lighting.h"
+#include "learnopengl-implementation/culling.h"
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) ) && defined( __SSE2__ )
+#define CLUSTERED_LIGHTING_SSE2 1
+#include <emmintrin.h>
+#else
+#define CLUSTERED_LIGHTING_SSE2 0
+#endif
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    // texture units of the buffer textures, after the ones the cube shaders sample
+    const int LIGHT_UNIT = 3;
+    const int CLUSTER_UNIT = 4;
+    const int INDEX_UNIT = 5;
+
+    // the padding of the light arrays sits behind the camera with no radius, so it touches no cluster
+    void appendSphere( std::vector<float>& x, std::vector<float>& y, std::vector<float>& z, std::vector<float>& radius,
+                       float sx, float sy, float sz, float sr )
+    {
+        x.push_back( sx );
+        y.push_back( sy );
+        z.push_back( sz );
+        radius.push_back( sr );
+    }
+}
+
+ClusteredLighting::ClusteredLighting( JobSystem& jobs, GLResources& resources, const Settings& settings )
+    : jobs( jobs ), resources( resources ), settings( settings )
+{
+    this->settings.tilesX = std::max( 1u, settings.tilesX );
+    this->settings.tilesY = std::max( 1u, settings.tilesY );
+    this->settings.slices = std::max( 1u, settings.slices );
+    this->settings.maxLights = std::min( 65535u, settings.maxLights );
+    tileCount = this->settings.tilesX * this->settings.tilesY;
+    clusterCount = tileCount * this->settings.slices;
+    clusterMin.resize( clusterCount );
+    clusterMax.resize( clusterCount );
+    clusterRanges.resize( clusterCount );
+    slices.resize( this->settings.slices );
+    for ( Slice& slice : slices )
+        slice.counts.resize( tileCount );
+}
+
+void ClusteredLighting::initialize( )
+{
+    if ( !settings.enabled )
+        return;
+
+    // the spec only promises 65536 texels, the index list is cut there if it has to be
+    GLint maxTexels = 0;
+    glGetIntegerv( GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels );
+    maxIndices = std::max( 65536, maxTexels );
+
+    StreamBuffer* buffers[] = { &lightBuffer, &clusterBuffer, &indexBuffer };
+    ScopedTexture* textures[] = { &lightTexture, &clusterTexture, &indexTexture };
+    const char* labels[] = { "cluster lights", "cluster ranges", "cluster light indices" };
+    const GLenum formats[] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+    for ( int i = 0; i < 3; i++ )
+    {
+        *buffers[i] = StreamBuffer( resources, GL_TEXTURE_BUFFER, labels[i] );
+        *textures[i] = ScopedTexture( resources, resources.createTexture( labels[i] ) );
+        glBindTexture( GL_TEXTURE_BUFFER, textures[i]->name( ) );
+        glTexBuffer( GL_TEXTURE_BUFFER, formats[i], buffers[i]->name( ) );
+    }
+    glBindTexture( GL_TEXTURE_BUFFER, 0 );
+}
+
+bool ClusteredLighting::isEnabled( ) const
+{
+    return settings.enabled && !lightTexture.get( ).isNull( );
+}
+
+void ClusteredLighting::setSamplers( Shader& shader ) const
+{
+    shader.setInt( "lightData", LIGHT_UNIT );
+    shader.setInt( "clusters", CLUSTER_UNIT );
+    shader.setInt( "lightIndices", INDEX_UNIT );
+}
+
+void ClusteredLighting::buildClusters( const glm::mat4& projection )
+{
+    clusterProjection = projection;
+    nearPlane = projection[3][2] / ( projection[2][2] - 1.0f );
+    farPlane = projection[3][2] / ( projection[2][2] + 1.0f );
+
+    // the ray through every tile corner, scaled to a view depth of one
+    glm::mat4 inverseProjection = glm::inverse( projection );
+    std::vector<glm::vec3> rays( ( settings.tilesX + 1 ) * ( settings.tilesY + 1 ) );
+    for ( unsigned int y = 0; y <= settings.tilesY; y++ )
+    {
+        for ( unsigned int x = 0; x <= settings.tilesX; x++ )
+        {
+            glm::vec4 corner = inverseProjection * glm::vec4( 2.0f * x / settings.tilesX - 1.0f, 2.0f * y / settings.tilesY - 1.0f, -1.0f, 1.0f );
+            glm::vec3 point = glm::vec3( corner ) / corner.w;
+            rays[y * ( settings.tilesX + 1 ) + x] = point / -point.z;
+        }
+    }
+
+    float ratio = farPlane / nearPlane;
+    for ( unsigned int slice = 0; slice < settings.slices; slice++ )
+    {
+        float nearDepth = nearPlane * std::pow( ratio, (float) slice / settings.slices );
+        float farDepth = nearPlane * std::pow( ratio, (float) ( slice + 1 ) / settings.slices );
+        for ( unsigned int y = 0; y < settings.tilesY; y++ )
+        {
+            for ( unsigned int x = 0; x < settings.tilesX; x++ )
+            {
+                glm::vec3 lower( 1e30f ), upper( -1e30f );
+                for ( unsigned int corner = 0; corner < 4; corner++ )
+                {
+                    const glm::vec3& ray = rays[( y + ( corner >> 1 ) ) * ( settings.tilesX + 1 ) + x + ( corner & 1 )];
+                    lower = glm::min( lower, glm::min( ray * nearDepth, ray * farDepth ) );
+                    upper = glm::max( upper, glm::max( ray * nearDepth, ray * farDepth ) );
+                }
+                unsigned int cluster = slice * tileCount + y * settings.tilesX + x;
+                clusterMin[cluster] = lower;
+                clusterMax[cluster] = upper;
+            }
+        }
+    }
+}
+
+void ClusteredLighting::begin( const FramePacket& packet )
+{
+    if ( !isEnabled( ) )
+        return;
+    frames++;
+    if ( packet.projection != clusterProjection )
+        buildClusters( packet.projection );
+
+    unsigned int count = (unsigned int) std::min<size_t>( packet.lights.size( ), settings.maxLights );
+    droppedLights += packet.lights.size( ) - count;
+    lightTexels.resize( count );
+    spheres.x.clear( );
+    spheres.y.clear( );
+    spheres.z.clear( );
+    spheres.radius.clear( );
+    glm::mat3 rotation( packet.view );
+    for ( unsigned int i = 0; i < count; i++ )
+    {
+        const Light& light = packet.lights[i];
+        LightTexels& texels = lightTexels[i];
+        texels.positionRadius = glm::vec4( glm::vec3( packet.view * glm::vec4( light.position, 1.0f ) ), light.radius );
+        texels.color = glm::vec4( light.color, light.cosInner );
+        texels.spot = glm::vec4( rotation * light.direction, light.cosOuter );
+
+        // a spot light only goes where its cone reaches
+        glm::vec4 bounds = coneBounds( light.position, light.direction, light.radius, light.cosOuter );
+        glm::vec3 center = glm::vec3( packet.view * glm::vec4( glm::vec3( bounds ), 1.0f ) );
+        appendSphere( spheres.x, spheres.y, spheres.z, spheres.radius, center.x, center.y, center.z, bounds.w );
+    }
+
+    // one job per slice, the slices share nothing until finish( ) puts them together
+    for ( unsigned int slice = 0; slice < settings.slices; slice++ )
+        jobs.run( &ClusteredLighting::binSlices, this, slice, slice + 1, &binned );
+    binning = true;
+}
+
+void ClusteredLighting::binSlices( void* data, unsigned int begin, unsigned int end )
+{
+    ClusteredLighting* lighting = (ClusteredLighting*) data;
+    for ( unsigned int slice = begin; slice < end; slice++ )
+        lighting->binSlice( slice );
+}
+
+void ClusteredLighting::binSlice( unsigned int sliceIndex )
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now( );
+    Slice& slice = slices[sliceIndex];
+    const unsigned int firstCluster = sliceIndex * tileCount;
+
+    // the lights reaching the slice's depth range first
+    LightSpheres& candidates = slice.candidates;
+    candidates.x.clear( );
+    candidates.y.clear( );
+    candidates.z.clear( );
+    candidates.radius.clear( );
+    slice.candidateIndices.clear( );
+    float sliceNear = clusterMax[firstCluster].z;
+    float sliceFar = clusterMin[firstCluster].z;
+    for ( unsigned int i = 0; i < spheres.x.size( ); i++ )
+    {
+        if ( spheres.z[i] - spheres.radius[i] > sliceNear || spheres.z[i] + spheres.radius[i] < sliceFar )
+            continue;
+        appendSphere( candidates.x, candidates.y, candidates.z, candidates.radius, spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i] );
+        slice.candidateIndices.push_back( (unsigned short) i );
+    }
+    unsigned int candidateCount = (unsigned int) candidates.x.size( );
+
+    slice.indices.clear( );
+    LightSpheres& row = slice.rowCandidates;
+    for ( unsigned int y = 0; y < settings.tilesY; y++ )
+    {
+        // then the lights reaching the row, out of the slice's
+        unsigned int firstTile = y * settings.tilesX;
+        glm::vec3 rowMin = clusterMin[firstCluster + firstTile];
+        glm::vec3 rowMax = clusterMax[firstCluster + firstTile];
+        for ( unsigned int x = 1; x < settings.tilesX; x++ )
+        {
+            rowMin = glm::min( rowMin, clusterMin[firstCluster + firstTile + x] );
+            rowMax = glm::max( rowMax, clusterMax[firstCluster + firstTile + x] );
+        }
+        row.x.clear( );
+        row.y.clear( );
+        row.z.clear( );
+        row.radius.clear( );
+        slice.rowIndices.clear( );
+        for ( unsigned int i = 0; i < candidateCount; i++ )
+        {
+            glm::vec3 center( candidates.x[i], candidates.y[i], candidates.z[i] );
+            glm::vec3 offset = glm::clamp( center, rowMin, rowMax ) - center;
+            if ( glm::dot( offset, offset ) > candidates.radius[i] * candidates.radius[i] )
+                continue;
+            appendSphere( row.x, row.y, row.z, row.radius, center.x, center.y, center.z, candidates.radius[i] );
+            slice.rowIndices.push_back( slice.candidateIndices[i] );
+        }
+        while ( row.x.size( ) % 4 != 0 )
+            appendSphere( row.x, row.y, row.z, row.radius, 0.0f, 0.0f, 1.0f, 0.0f );
+
+        for ( unsigned int tile = firstTile; tile < firstTile + settings.tilesX; tile++ )
+        {
+            size_t before = slice.indices.size( );
+            const glm::vec3& lower = clusterMin[firstCluster + tile];
+            const glm::vec3& upper = clusterMax[firstCluster + tile];
+            // a sphere touches the box when the distance from its center to the closest point
+            // of the box is within the radius
+#if CLUSTERED_LIGHTING_SSE2
+            const __m128 zero = _mm_setzero_ps( );
+            const __m128 minX = _mm_set1_ps( lower.x ), maxX = _mm_set1_ps( upper.x );
+            const __m128 minY = _mm_set1_ps( lower.y ), maxY = _mm_set1_ps( upper.y );
+            const __m128 minZ = _mm_set1_ps( lower.z ), maxZ = _mm_set1_ps( upper.z );
+            for ( unsigned int i = 0; i < row.x.size( ); i += 4 )
+            {
+                __m128 x = _mm_loadu_ps( &row.x[i] );
+                __m128 y = _mm_loadu_ps( &row.y[i] );
+                __m128 z = _mm_loadu_ps( &row.z[i] );
+                __m128 radius = _mm_loadu_ps( &row.radius[i] );
+                __m128 dx = _mm_max_ps( _mm_max_ps( _mm_sub_ps( minX, x ), _mm_sub_ps( x, maxX ) ), zero );
+                __m128 dy = _mm_max_ps( _mm_max_ps( _mm_sub_ps( minY, y ), _mm_sub_ps( y, maxY ) ), zero );
+                __m128 dz = _mm_max_ps( _mm_max_ps( _mm_sub_ps( minZ, z ), _mm_sub_ps( z, maxZ ) ), zero );
+                __m128 distance = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, dx ), _mm_mul_ps( dy, dy ) ), _mm_mul_ps( dz, dz ) );
+                int hits = _mm_movemask_ps( _mm_cmple_ps( distance, _mm_mul_ps( radius, radius ) ) );
+                while ( hits )
+                {
+                    slice.indices.push_back( slice.rowIndices[i + __builtin_ctz( hits )] );
+                    hits &= hits - 1;
+                }
+            }
+#else
+            for ( unsigned int i = 0; i < row.x.size( ); i++ )
+            {
+                float dx = std::max( std::max( lower.x - row.x[i], row.x[i] - upper.x ), 0.0f );
+                float dy = std::max( std::max( lower.y - row.y[i], row.y[i] - upper.y ), 0.0f );
+                float dz = std::max( std::max( lower.z - row.z[i], row.z[i] - upper.z ), 0.0f );
+                if ( dx * dx + dy * dy + dz * dz <= row.radius[i] * row.radius[i] )
+                    slice.indices.push_back( slice.rowIndices[i] );
+            }
+#endif
+            slice.counts[tile] = (unsigned int) ( slice.indices.size( ) - before );
+        }
+    }
+    slice.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now( ) - start ).count( );
+}
+
+void ClusteredLighting::finish( )
+{
+    if ( !binning )
+        return;
+    jobs.wait( &binned );
+    binning = false;
+
+    // the slices' lists one after the other, cut where the buffer texture ends
+    indices.clear( );
+    for ( unsigned int sliceIndex = 0; sliceIndex < settings.slices; sliceIndex++ )
+    {
+        Slice& slice = slices[sliceIndex];
+        binningNanoseconds += slice.nanoseconds;
+        unsigned int read = 0;
+        for ( unsigned int tile = 0; tile < tileCount; tile++ )
+        {
+            unsigned int offset = (unsigned int) indices.size( );
+            unsigned int count = std::min( slice.counts[tile], (unsigned int) ( maxIndices - offset ) );
+            indices.insert( indices.end( ), slice.indices.begin( ) + read, slice.indices.begin( ) + read + count );
+            truncatedIndices += slice.counts[tile] - count;
+            read += slice.counts[tile];
+            maxClusterLights = std::max( maxClusterLights, count );
+            clusterRanges[sliceIndex * tileCount + tile] = glm::uvec2( offset, count );
+        }
+    }
+    totalIndices += indices.size( );
+
+    lightBuffer.upload( lightTexels.data( ), lightTexels.size( ) * sizeof( LightTexels ) );
+    clusterBuffer.upload( clusterRanges.data( ), clusterRanges.size( ) * sizeof( glm::uvec2 ) );
+    indexBuffer.upload( indices.data( ), indices.size( ) * sizeof( unsigned short ) );
+}
+
+void ClusteredLighting::bind( const Shader& shader, const FramePacket& packet, int width, int height ) const
+{
+    glActiveTexture( GL_TEXTURE0 + LIGHT_UNIT );
+    glBindTexture( GL_TEXTURE_BUFFER, lightTexture.name( ) );
+    glActiveTexture( GL_TEXTURE0 + CLUSTER_UNIT );
+    glBindTexture( GL_TEXTURE_BUFFER, clusterTexture.name( ) );
+    glActiveTexture( GL_TEXTURE0 + INDEX_UNIT );
+    glBindTexture( GL_TEXTURE_BUFFER, indexTexture.name( ) );
+    glActiveTexture( GL_TEXTURE0 );
+
+    // the slice of a view depth is log( depth / near ) * slices / log( far / near )
+    glm::mat4 inverseProjection = glm::inverse( packet.projection );
+    glm::vec3 sunDirection = glm::normalize( glm::mat3( packet.view ) * packet.sunDirection );
+    glUniform3i( glGetUniformLocation( shader.ID, "clusterGrid" ), settings.tilesX, settings.tilesY, settings.slices );
+    shader.setVec2( "clusterDepth", nearPlane, settings.slices / std::log( farPlane / nearPlane ) );
+    glUniformMatrix4fv( glGetUniformLocation( shader.ID, "inverseProjection" ), 1, GL_FALSE, glm::value_ptr( inverseProjection ) );
+    shader.setVec2( "viewportSize", (float) width, (float) height );
+    glUniform3fv( glGetUniformLocation( shader.ID, "ambient" ), 1, glm::value_ptr( packet.ambientLight ) );
+    glUniform3fv( glGetUniformLocation( shader.ID, "sunDirection" ), 1, glm::value_ptr( sunDirection ) );
+    glUniform3fv( glGetUniformLocation( shader.ID, "sunColor" ), 1, glm::value_ptr( packet.sunColor ) );
+}
+
+void ClusteredLighting::shutdown( )
+{
+    if ( binning )
+    {
+        jobs.wait( &binned );
+        binning = false;
+    }
+    lightTexture.reset( );
+    clusterTexture.reset( );
+    indexTexture.reset( );
+    lightBuffer.reset( );
+    clusterBuffer.reset( );
+    indexBuffer.reset( );
+}
+
+void ClusteredLighting::report( std::ostream& out ) const
+{
+    if ( frames == 0 )
+        return;
+    out << "Clustered lighting: " << settings.tilesX << "x" << settings.tilesY << "x" << settings.slices << " clusters, "
+        << (double) totalIndices / frames / clusterCount << " lights per cluster on average ( " << maxClusterLights << " max ), binning "
+        << binningNanoseconds / frames / 1000.0 << " us of CPU per frame ( " << ( CLUSTERED_LIGHTING_SSE2 ? "SSE2" : "scalar" ) << " )";
+    if ( droppedLights > 0 )
+        out << ", " << droppedLights << " lights dropped";
+    if ( truncatedIndices > 0 )
+        out << ", " << truncatedIndices << " cluster entries cut";
+    out << std::endl;
+}
@@ -0,0 +1,69 @@
+#include "learnopengl-implementation/culling.h"
+#include "learnopengl-implementation/job_system.h"
+
+#include <cmath>
+
+namespace
+{
+    // spheres per job, the test is a handful of dot products so chunks must be big
+    const unsigned int CULL_GRAIN = 1024;
+}
+
+Frustum::Frustum( const glm::mat4& viewProjection )
+{
+    // Gribb/Hartmann: each plane is the last row plus or minus one of the other rows
+    glm::vec4 rows[4];
+    for ( int i = 0; i < 4; i++ )
+        rows[i] = glm::vec4( viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i] );
+
+    planes[0] = rows[3] + rows[0]; // left
+    planes[1] = rows[3] - rows[0]; // right
+    planes[2] = rows[3] + rows[1]; // bottom
+    planes[3] = rows[3] - rows[1]; // top
+    planes[4] = rows[3] + rows[2]; // near
+    planes[5] = rows[3] - rows[2]; // far
+
+    for ( glm::vec4& plane : planes )
+        plane /= glm::length( glm::vec3( plane ) );
+}
+
+bool Frustum::intersectsSphere( const glm::vec3& center, float radius ) const
+{
+    for ( const glm::vec4& plane : planes )
+    {
+        if ( glm::dot( glm::vec3( plane ), center ) + plane.w < -radius )
+            return false;
+    }
+    return true;
+}
+
+glm::vec4 coneBounds( const glm::vec3& apex, const glm::vec3& direction, float length, float cosAngle )
+{
+    // wider than 90 degrees the cone is about as big as the whole sphere
+    if ( cosAngle <= 0.0f )
+        return glm::vec4( apex, length );
+    // up to 45 degrees the sphere through the apex and the rim of the cap, wider the
+    // rim's own circle ( the cap itself then fits inside )
+    if ( cosAngle >= 0.70710678f )
+    {
+        float radius = length / ( 2.0f * cosAngle );
+        return glm::vec4( apex + direction * radius, radius );
+    }
+    float sinAngle = std::sqrt( 1.0f - cosAngle * cosAngle );
+    return glm::vec4( apex + direction * ( length * cosAngle ), length * sinAngle );
+}
+
+void cullSpheres( const Frustum& frustum, const glm::vec4* spheres, unsigned char* visible,
+                  unsigned int count, JobSystem* jobs )
+{
+    auto cullRange = [&frustum, spheres, visible]( unsigned int begin, unsigned int end )
+    {
+        for ( unsigned int i = begin; i < end; i++ )
+            visible[i] = frustum.intersectsSphere( glm::vec3( spheres[i] ), spheres[i].w );
+    };
+
+    if ( jobs && count > CULL_GRAIN )
+        jobs->parallelFor( count, CULL_GRAIN, cullRange );
+    else
+        cullRange( 0, count );
+}
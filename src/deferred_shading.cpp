@@ -0,0 +1,221 @@
+#include "learnopengl-implementation/deferred_shading.h"
+#include "learnopengl-implementation/normal_encoding.h"
+#include "learnopengl-implementation/culling.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstddef>
+
+namespace
+{
+    // albedo RGBA8 + normal RG16_SNORM + depth and stencil D24S8
+    const size_t BYTES_PER_PIXEL = 4 + 4 + 4;
+
+    // texture units of the G-buffer in the lighting shaders
+    const int ALBEDO_UNIT = 0;
+    const int NORMAL_UNIT = 1;
+    const int DEPTH_UNIT = 2;
+}
+
+DeferredShading::DeferredShading( GLResources& resources, const Settings& settings )
+    : resources( resources ), settings( settings )
+{
+}
+
+void DeferredShading::initialize( const SharedGeometry& geometry, Shader& ambientShader, Shader& lightShader )
+{
+    this->geometry = &geometry;
+    this->ambientShader = &ambientShader;
+    this->lightShader = &lightShader;
+
+    ambientShader.use( );
+    ambientShader.setInt( "gAlbedo", ALBEDO_UNIT );
+    ambientShader.setInt( "gNormal", NORMAL_UNIT );
+    ambientShader.setInt( "gDepth", DEPTH_UNIT );
+    ambientLocation = glGetUniformLocation( ambientShader.ID, "ambient" );
+    sunDirectionLocation = glGetUniformLocation( ambientShader.ID, "sunDirection" );
+    sunColorLocation = glGetUniformLocation( ambientShader.ID, "sunColor" );
+    backgroundLocation = glGetUniformLocation( ambientShader.ID, "background" );
+    ambientInverseProjectionLocation = glGetUniformLocation( ambientShader.ID, "inverseProjection" );
+    ambientViewportSizeLocation = glGetUniformLocation( ambientShader.ID, "viewportSize" );
+
+    lightShader.use( );
+    lightShader.setInt( "gAlbedo", ALBEDO_UNIT );
+    lightShader.setInt( "gNormal", NORMAL_UNIT );
+    lightShader.setInt( "gDepth", DEPTH_UNIT );
+    lightInverseProjectionLocation = glGetUniformLocation( lightShader.ID, "inverseProjection" );
+    lightViewportSizeLocation = glGetUniformLocation( lightShader.ID, "viewportSize" );
+
+    // the unit quad shared by the lights, the rest comes per instance
+    lightArray = ScopedVertexArray( resources, resources.createVertexArray( "light quads" ) );
+    instanceBuffer = StreamBuffer( resources, GL_ARRAY_BUFFER, "light instances" );
+    glBindVertexArray( lightArray.name( ) );
+    geometry.bindQuadCorners( 0 );
+
+    glBindBuffer( GL_ARRAY_BUFFER, instanceBuffer.name( ) );
+    glVertexAttribPointer( 1, 4, GL_FLOAT, GL_FALSE, sizeof( LightInstance ), (void*) offsetof( LightInstance, rectangle ) );
+    glVertexAttribPointer( 2, 4, GL_FLOAT, GL_FALSE, sizeof( LightInstance ), (void*) offsetof( LightInstance, positionRadius ) );
+    glVertexAttribPointer( 3, 4, GL_FLOAT, GL_FALSE, sizeof( LightInstance ), (void*) offsetof( LightInstance, color ) );
+    glVertexAttribPointer( 4, 4, GL_FLOAT, GL_FALSE, sizeof( LightInstance ), (void*) offsetof( LightInstance, spot ) );
+    for ( GLuint attribute = 1; attribute <= 4; attribute++ )
+    {
+        glEnableVertexAttribArray( attribute );
+        glVertexAttribDivisor( attribute, 1 );
+    }
+    glBindVertexArray( 0 );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+bool DeferredShading::isEnabled( ) const
+{
+    return settings.enabled && lightShader;
+}
+
+RenderGraph::TextureDescription DeferredShading::albedoDescription( const DynamicResolution& target )
+{
+    RenderGraph::TextureDescription description;
+    description.width = target.targetWidth( );
+    description.height = target.targetHeight( );
+    description.internalFormat = GL_RGBA8;
+    description.format = GL_RGBA;
+    description.type = GL_UNSIGNED_BYTE;
+    return description;
+}
+
+RenderGraph::TextureDescription DeferredShading::normalDescription( const DynamicResolution& target )
+{
+    RenderGraph::TextureDescription description;
+    description.width = target.targetWidth( );
+    description.height = target.targetHeight( );
+    description.internalFormat = GL_RG16_SNORM;
+    description.format = GL_RG;
+    description.type = GL_SHORT;
+    return description;
+}
+
+void DeferredShading::beginGeometry( const DynamicResolution& target )
+{
+    glViewport( 0, 0, target.renderWidth( ), target.renderHeight( ) );
+    glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
+    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT );
+}
+
+void DeferredShading::setGeometryUniforms( const Shader& geometryShader, const FramePacket& packet, const DynamicResolution& target ) const
+{
+    glm::mat4 inverseProjection = glm::inverse( packet.projection );
+    glUniformMatrix4fv( glGetUniformLocation( geometryShader.ID, "inverseProjection" ), 1, GL_FALSE, glm::value_ptr( inverseProjection ) );
+    geometryShader.setVec2( "viewportSize", (float) target.renderWidth( ), (float) target.renderHeight( ) );
+}
+
+bool DeferredShading::projectSphere( const glm::mat4& projection, const glm::vec3& center, float radius, glm::vec4& rectangle )
+{
+    // the camera looks down -z, a sphere crossing the near plane can cover any part of the screen
+    float nearPlane = projection[3][2] / ( projection[2][2] - 1.0f );
+    if ( center.z - radius > -nearPlane )
+        return false;
+    if ( center.z + radius > -nearPlane )
+    {
+        rectangle = glm::vec4( -1.0f, -1.0f, 1.0f, 1.0f );
+        return true;
+    }
+
+    // the corners of the sphere's bounding box, all in front of the camera
+    glm::vec2 lower( 1.0f ), upper( -1.0f );
+    for ( int corner = 0; corner < 8; corner++ )
+    {
+        glm::vec3 offset( corner & 1 ? radius : -radius, corner & 2 ? radius : -radius, corner & 4 ? radius : -radius );
+        glm::vec4 clip = projection * glm::vec4( center + offset, 1.0f );
+        glm::vec2 ndc = glm::vec2( clip ) / clip.w;
+        lower = glm::min( lower, ndc );
+        upper = glm::max( upper, ndc );
+    }
+    lower = glm::max( lower, glm::vec2( -1.0f ) );
+    upper = glm::min( upper, glm::vec2( 1.0f ) );
+    if ( lower.x >= upper.x || lower.y >= upper.y )
+        return false;
+    rectangle = glm::vec4( lower, upper );
+    return true;
+}
+
+void DeferredShading::shade( const FramePacket& packet, const DynamicResolution& target, const CascadedShadows& shadows,
+                             GLuint albedo, GLuint normal )
+{
+    frames++;
+    width = target.targetWidth( );
+    height = target.targetHeight( );
+    instances.clear( );
+    for ( const Light& light : packet.lights )
+    {
+        // a spot light only covers the rectangle of its cone
+        LightInstance instance;
+        glm::vec4 bounds = coneBounds( light.position, light.direction, light.radius, light.cosOuter );
+        glm::vec3 center = glm::vec3( packet.view * glm::vec4( glm::vec3( bounds ), 1.0f ) );
+        if ( !projectSphere( packet.projection, center, bounds.w, instance.rectangle ) )
+        {
+            lightsCulled++;
+            continue;
+        }
+        instance.positionRadius = glm::vec4( glm::vec3( packet.view * glm::vec4( light.position, 1.0f ) ), light.radius );
+        instance.color = glm::vec4( light.color, light.cosInner );
+        instance.spot = glm::vec4( glm::mat3( packet.view ) * light.direction, light.cosOuter );
+        instances.push_back( instance );
+    }
+    lightsDrawn += instances.size( );
+
+    instanceBuffer.upload( instances.data( ), instances.size( ) * sizeof( LightInstance ) );
+
+    // the lighting only reads the depth, the target's color is written alone
+    glViewport( 0, 0, target.renderWidth( ), target.renderHeight( ) );
+    glDisable( GL_DEPTH_TEST );
+    glActiveTexture( GL_TEXTURE0 + ALBEDO_UNIT );
+    glBindTexture( GL_TEXTURE_2D, albedo );
+    glActiveTexture( GL_TEXTURE0 + NORMAL_UNIT );
+    glBindTexture( GL_TEXTURE_2D, normal );
+    glActiveTexture( GL_TEXTURE0 + DEPTH_UNIT );
+    glBindTexture( GL_TEXTURE_2D, resources.get( target.depthTexture( ) ) );
+
+    // ambient, sun and background cover every pixel, so the target needs no clear
+    glm::mat4 inverseProjection = glm::inverse( packet.projection );
+    glm::vec3 sunDirection = glm::normalize( glm::mat3( packet.view ) * packet.sunDirection );
+    glUseProgram( ambientShader->ID );
+    glUniform3fv( ambientLocation, 1, glm::value_ptr( packet.ambientLight ) );
+    glUniform3fv( sunDirectionLocation, 1, glm::value_ptr( sunDirection ) );
+    glUniform3fv( sunColorLocation, 1, glm::value_ptr( packet.sunColor ) );
+    glUniform3fv( backgroundLocation, 1, glm::value_ptr( settings.background ) );
+    glUniformMatrix4fv( ambientInverseProjectionLocation, 1, GL_FALSE, glm::value_ptr( inverseProjection ) );
+    glUniform2f( ambientViewportSizeLocation, (float) target.renderWidth( ), (float) target.renderHeight( ) );
+    shadows.bind( *ambientShader );
+    geometry->drawFullscreen( );
+
+    if ( !instances.empty( ) )
+    {
+        glEnable( GL_BLEND );
+        glBlendFunc( GL_ONE, GL_ONE );
+        glUseProgram( lightShader->ID );
+        glUniformMatrix4fv( lightInverseProjectionLocation, 1, GL_FALSE, glm::value_ptr( inverseProjection ) );
+        glUniform2f( lightViewportSizeLocation, (float) target.renderWidth( ), (float) target.renderHeight( ) );
+        glBindVertexArray( lightArray.name( ) );
+        glDrawArraysInstanced( GL_TRIANGLE_STRIP, 0, 4, (GLsizei) instances.size( ) );
+        glBindVertexArray( 0 );
+        glDisable( GL_BLEND );
+    }
+
+    glActiveTexture( GL_TEXTURE0 );
+    glEnable( GL_DEPTH_TEST );
+}
+
+void DeferredShading::shutdown( )
+{
+    lightArray.reset( );
+    instanceBuffer.reset( );
+}
+
+void DeferredShading::report( std::ostream& out ) const
+{
+    if ( frames == 0 )
+        return;
+    out << "Deferred shading: G-buffer " << BYTES_PER_PIXEL << " bytes per pixel ( " << (size_t) width * height * BYTES_PER_PIXEL / ( 1024 * 1024 )
+        << " MB at " << width << "x" << height << ", " << (size_t) 3840 * 2160 * BYTES_PER_PIXEL / ( 1024 * 1024 ) << " MB at 4K ), "
+        << (double) lightsDrawn / frames << " lights drawn and " << (double) lightsCulled / frames << " culled per frame, normal encoding error "
+        << NormalEncoding::MAX_ERROR_DEGREES << " degrees max" << std::endl;
+}
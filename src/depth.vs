@@ -0,0 +1,13 @@
+#version 330 core
+
+layout ( location = 0 ) in vec3 aPos;
+
+// must match shader.vs bit for bit, the main pass tests its depth for equality
+invariant gl_Position;
+
+uniform mat4 mvp;
+
+void main( )
+{
+    gl_Position = mvp * vec4( aPos, 1.0f );
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "learnopengl-implementation/depth_prepass.h"
+
+#include <algorithm>
+
+namespace
+{
+    // weight of a new measurement in the running averages
+    const double SMOOTHING = 0.2;
+
+    // queries of a measured frame
+    const unsigned int START_QUERY = 0;
+    const unsigned int SHADING_QUERY = 1;
+    const unsigned int FINISH_QUERY = 2;
+    const unsigned int SAMPLES_QUERY = 3;
+
+    void accumulate( double& average, double value )
+    {
+        average = average < 0.0 ? value : average + SMOOTHING * ( value - average );
+    }
+
+    const char* modeName( DepthPrepass::Mode mode )
+    {
+        switch ( mode )
+        {
+        case DepthPrepass::Mode::OFF:
+            return "off";
+        case DepthPrepass::Mode::ON:
+            return "on";
+        default:
+            return "auto";
+        }
+    }
+}
+
+DepthPrepass::DepthPrepass( GLResources& resources, const Settings& settings )
+    : settings( settings ), queries( resources, "depth pre-pass query", 4 )
+{
+    this->settings.probeInterval = std::max( 2u, settings.probeInterval );
+}
+
+bool DepthPrepass::begin( )
+{
+    frameCount++;
+    collect( );
+    active = decide( );
+    if ( active )
+        prepassFrames++;
+
+    if ( queries.begin( ) )
+    {
+        measuredPrepass[queries.slot( )] = active;
+        queries.timestamp( START_QUERY );
+    }
+    else
+    {
+        unmeasuredFrames++;
+    }
+
+    if ( active )
+        glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+    return active;
+}
+
+void DepthPrepass::beginShading( )
+{
+    if ( active )
+    {
+        // only the front surface matches the depth laid down by the pre-pass
+        glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+        glDepthFunc( GL_EQUAL );
+        glDepthMask( GL_FALSE );
+    }
+    if ( queries.isMeasuring( ) )
+    {
+        queries.timestamp( SHADING_QUERY );
+        glBeginQuery( GL_SAMPLES_PASSED, queries.query( SAMPLES_QUERY ) );
+    }
+}
+
+void DepthPrepass::end( )
+{
+    if ( queries.isMeasuring( ) )
+    {
+        glEndQuery( GL_SAMPLES_PASSED );
+        queries.timestamp( FINISH_QUERY );
+        queries.end( );
+    }
+    if ( active )
+    {
+        glDepthFunc( GL_LESS );
+        glDepthMask( GL_TRUE );
+        active = false;
+    }
+}
+
+void DepthPrepass::collect( )
+{
+    queries.collect( [this]( unsigned int slot, const GLuint64* results )
+    {
+        GLuint64 start = results[START_QUERY], shadingStart = results[SHADING_QUERY], finish = results[FINISH_QUERY];
+        GLuint64 samples = results[SAMPLES_QUERY];
+        if ( samples == 0 || finish < shadingStart || shadingStart < start )
+            return;
+
+        // after a pre-pass only the visible surface passes the test, without one every
+        // surface drawn in front of what was there before it does
+        if ( measuredPrepass[slot] )
+        {
+            accumulate( visiblePixels, (double) samples );
+            accumulate( prepassNanoseconds, (double) ( finish - start ) / samples );
+        }
+        else
+        {
+            accumulate( shadedFragments, (double) samples );
+            accumulate( fragmentNanoseconds, (double) ( finish - shadingStart ) / samples );
+        }
+    } );
+}
+
+bool DepthPrepass::decide( )
+{
+    if ( settings.mode != Mode::AUTO )
+        return settings.mode == Mode::ON;
+
+    // measuring both modes once before deciding anything
+    if ( prepassNanoseconds < 0.0 )
+        return true;
+    if ( shadedFragments < 0.0 )
+        return false;
+
+    // per visible pixel, so that a scene that changed since the other mode was measured still compares
+    double overdraw = std::max( 1.0, shadedFragments / visiblePixels );
+    double withoutPrepass = fragmentNanoseconds * overdraw;
+    if ( !preferred && prepassNanoseconds < withoutPrepass * ( 1.0 - settings.margin ) )
+    {
+        preferred = true;
+        switches++;
+    }
+    else if ( preferred && withoutPrepass < prepassNanoseconds * ( 1.0 - settings.margin ) )
+    {
+        preferred = false;
+        switches++;
+    }
+
+    // the mode in use only refreshes its own side of the overdraw
+    if ( ++framesSinceProbe >= settings.probeInterval )
+    {
+        framesSinceProbe = 0;
+        probes++;
+        return !preferred;
+    }
+    return preferred;
+}
+
+void DepthPrepass::shutdown( )
+{
+    queries.reset( );
+}
+
+void DepthPrepass::report( std::ostream& out ) const
+{
+    if ( frameCount == 0 )
+        return;
+    out << "Depth pre-pass ( " << modeName( settings.mode ) << " ): on in " << prepassFrames << " of " << frameCount << " frames";
+    if ( shadedFragments > 0.0 && visiblePixels > 0.0 )
+    {
+        double overdraw = std::max( 1.0, shadedFragments / visiblePixels );
+        out << ", overdraw " << overdraw << ", shading " << fragmentNanoseconds << " ns per fragment, per pixel "
+            << prepassNanoseconds << " ns with the pre-pass against " << fragmentNanoseconds * overdraw << " ns without";
+        // the overdraw above which the pre-pass is the cheaper side
+        if ( fragmentNanoseconds > 0.0 )
+            out << ", break-even at overdraw " << prepassNanoseconds / fragmentNanoseconds;
+    }
+    else if ( fragmentNanoseconds > 0.0 )
+    {
+        out << ", shading " << fragmentNanoseconds << " ns per fragment over " << shadedFragments << " fragments";
+    }
+    else if ( prepassNanoseconds > 0.0 )
+    {
+        out << ", " << prepassNanoseconds << " ns per pixel with the pre-pass over " << visiblePixels << " pixels";
+    }
+    if ( settings.mode == Mode::AUTO )
+        out << ", " << switches << " switches, " << probes << " probes";
+    if ( unmeasuredFrames > 0 )
+        out << ", " << unmeasuredFrames << " frames unmeasured";
+    out << std::endl;
+}
@@ -0,0 +1,228 @@
+#include "learnopengl-implementation/dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+DynamicResolution::DynamicResolution( GLResources& resources, const Settings& settings )
+    : resources( resources ), settings( settings ), timers( resources, "dynamic resolution timer", 1 )
+{
+    this->settings.minScale = std::max( 0.05f, settings.minScale );
+    this->settings.maxScale = std::max( this->settings.minScale, settings.maxScale );
+    this->settings.interval = std::max( 1u, settings.interval );
+    currentScale = this->settings.enabled ? this->settings.maxScale : 1.0f;
+    lowestScale = highestScale = currentScale;
+}
+
+void DynamicResolution::beginFrame( int windowWidth, int windowHeight, float scaleLimit )
+{
+    frames++;
+    collect( );
+
+    // a lower limit takes effect at once, the scale grows back toward a higher one only
+    // as the budget allows ( without dynamic resolution the limit is the scale )
+    this->scaleLimit = std::max( settings.enabled ? settings.minScale : 0.05f, std::min( 1.0f, scaleLimit ) );
+    float wanted = settings.enabled ? std::min( currentScale, this->scaleLimit ) : this->scaleLimit;
+    if ( wanted != currentScale )
+    {
+        currentScale = wanted;
+        sampledMilliseconds = 0.0;
+        samples = 0;
+        if ( settings.enabled )
+            scaleChanges++;
+    }
+
+    this->windowWidth = std::max( 0, windowWidth );
+    this->windowHeight = std::max( 0, windowHeight );
+    if ( this->windowWidth > 0 && this->windowHeight > 0 )
+    {
+        // the target only follows the window, scale changes reuse it
+        float maxScale = settings.enabled ? settings.maxScale : 1.0f;
+        int maxWidth = (int) std::ceil( this->windowWidth * maxScale );
+        int maxHeight = (int) std::ceil( this->windowHeight * maxScale );
+        if ( maxWidth != allocatedWidth || maxHeight != allocatedHeight )
+            createTarget( maxWidth, maxHeight );
+    }
+    width = std::min( allocatedWidth, std::max( 1, (int) std::lround( this->windowWidth * currentScale ) ) );
+    height = std::min( allocatedHeight, std::max( 1, (int) std::lround( this->windowHeight * currentScale ) ) );
+    totalScale += currentScale;
+    lowestScale = std::min( lowestScale, currentScale );
+    highestScale = std::max( highestScale, currentScale );
+
+    if ( !timers.begin( ) )
+    {
+        unmeasuredFrames++;
+        return;
+    }
+    measuredScales[timers.slot( )] = currentScale;
+    glBeginQuery( GL_TIME_ELAPSED, timers.query( 0 ) );
+}
+
+void DynamicResolution::endFrame( GLuint source )
+{
+    endFrame( source, width, height );
+}
+
+void DynamicResolution::endFrame( GLuint source, int sourceWidth, int sourceHeight )
+{
+    if ( !framebuffer.get( ).isNull( ) )
+    {
+        GLuint readFramebuffer = framebuffer.name( );
+        if ( source != 0 && source != color.name( ) )
+        {
+            if ( sourceFramebuffer.get( ).isNull( ) )
+                sourceFramebuffer = ScopedFramebuffer( resources, resources.createFramebuffer( "dynamic resolution source" ) );
+            // attached every frame, a name the graph released may come back as another texture
+            readFramebuffer = sourceFramebuffer.name( );
+            glBindFramebuffer( GL_READ_FRAMEBUFFER, readFramebuffer );
+            glFramebufferTexture2D( GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source, 0 );
+        }
+
+        // bilinear when it actually scales, a plain copy otherwise
+        bool scaled = sourceWidth != windowWidth || sourceHeight != windowHeight;
+        glBindFramebuffer( GL_READ_FRAMEBUFFER, readFramebuffer );
+        glBindFramebuffer( GL_DRAW_FRAMEBUFFER, 0 );
+        glBlitFramebuffer( 0, 0, sourceWidth, sourceHeight, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT,
+                           scaled ? GL_LINEAR : GL_NEAREST );
+        glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+        glViewport( 0, 0, windowWidth, windowHeight );
+    }
+
+    if ( timers.isMeasuring( ) )
+    {
+        glEndQuery( GL_TIME_ELAPSED );
+        timers.end( );
+    }
+}
+
+void DynamicResolution::collect( )
+{
+    timers.collect( [this]( unsigned int slot, const GLuint64* results )
+    {
+        double milliseconds = results[0] / 1000000.0;
+        measuredFrames++;
+        totalMilliseconds += milliseconds;
+        maxMilliseconds = std::max( maxMilliseconds, milliseconds );
+        if ( !settings.enabled || measuredScales[slot] != currentScale )
+            return;
+        sampledMilliseconds += milliseconds;
+        if ( ++samples >= settings.interval )
+        {
+            adjust( sampledMilliseconds / samples );
+            sampledMilliseconds = 0.0;
+            samples = 0;
+        }
+    } );
+}
+
+void DynamicResolution::adjust( double milliseconds )
+{
+    double lower = settings.budgetMilliseconds * settings.lowerThreshold;
+    if ( milliseconds >= lower && milliseconds <= settings.budgetMilliseconds )
+        return;
+
+    // the time goes with the pixel count, so with the square of the scale; aiming at
+    // the middle of the band leaves room for the next fluctuation either way
+    double target = ( lower + settings.budgetMilliseconds ) * 0.5;
+    float wanted = currentScale * (float) std::sqrt( target / std::max( milliseconds, 0.001 ) );
+    wanted = std::min( currentScale + settings.maxStep, std::max( currentScale - settings.maxStep, wanted ) );
+    wanted = std::min( std::min( settings.maxScale, scaleLimit ), std::max( settings.minScale, wanted ) );
+    if ( std::fabs( wanted - currentScale ) < 0.01f )
+        return;
+    currentScale = wanted;
+    scaleChanges++;
+}
+
+void DynamicResolution::createTarget( int width, int height )
+{
+    if ( framebuffer.get( ).isNull( ) )
+    {
+        framebuffer = ScopedFramebuffer( resources, resources.createFramebuffer( "dynamic resolution target" ) );
+        color = ScopedTexture( resources, resources.createTexture( "dynamic resolution color" ) );
+        depth = ScopedTexture( resources, resources.createTexture( "dynamic resolution depth" ) );
+    }
+    allocatedWidth = width;
+    allocatedHeight = height;
+
+    glBindTexture( GL_TEXTURE_2D, color.name( ) );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+    resources.setSize( color.get( ), (size_t) width * height * 4 );
+
+    glBindTexture( GL_TEXTURE_2D, depth.name( ) );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    resources.setSize( depth.get( ), (size_t) width * height * 4 );
+    glBindTexture( GL_TEXTURE_2D, 0 );
+
+    glBindFramebuffer( GL_FRAMEBUFFER, framebuffer.name( ) );
+    glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color.name( ), 0 );
+    glFramebufferTexture2D( GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth.name( ), 0 );
+    if ( glCheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE )
+        std::cerr << "ERROR::DYNAMIC_RESOLUTION::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+}
+
+int DynamicResolution::renderWidth( ) const
+{
+    return width;
+}
+
+int DynamicResolution::renderHeight( ) const
+{
+    return height;
+}
+
+float DynamicResolution::scale( ) const
+{
+    return currentScale;
+}
+
+TextureHandle DynamicResolution::colorTexture( ) const
+{
+    return color.get( );
+}
+
+TextureHandle DynamicResolution::depthTexture( ) const
+{
+    return depth.get( );
+}
+
+int DynamicResolution::targetWidth( ) const
+{
+    return allocatedWidth;
+}
+
+int DynamicResolution::targetHeight( ) const
+{
+    return allocatedHeight;
+}
+
+void DynamicResolution::shutdown( )
+{
+    timers.reset( );
+    framebuffer.reset( );
+    sourceFramebuffer.reset( );
+    color.reset( );
+    depth.reset( );
+}
+
+void DynamicResolution::report( std::ostream& out ) const
+{
+    if ( frames == 0 )
+        return;
+    out << "Dynamic resolution: ";
+    if ( measuredFrames > 0 )
+        out << "GPU " << totalMilliseconds / measuredFrames << " ms per frame ( " << maxMilliseconds << " ms max, budget "
+            << settings.budgetMilliseconds << " ms ) over " << measuredFrames << " measured frames, ";
+    if ( settings.enabled )
+        out << "scale " << totalScale / frames << " on average ( " << lowestScale << " to " << highestScale << " ), "
+            << scaleChanges << " changes";
+    else
+        out << "off";
+    if ( unmeasuredFrames > 0 )
+        out << ", " << unmeasuredFrames << " frames unmeasured";
+    out << std::endl;
+}
@@ -0,0 +1,24 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 texCoord;
+
+// writes the virtual texture page this fragment would sample ( x, y, level ),
+// the alpha tells the covered texels from the cleared ones
+uniform float virtualSize;
+uniform float tileSize;
+uniform float maxLevel;
+// log2 of how much smaller the feedback target is than the screen
+uniform float feedbackBias;
+
+void main( )
+{
+    vec2 uv = clamp( texCoord, 0.0, 1.0 - 0.5 / virtualSize );
+    vec2 texels = uv * virtualSize;
+    float footprint = max( length( dFdx( texels ) ), length( dFdy( texels ) ) );
+    float level = clamp( floor( log2( max( footprint, 1e-6 ) ) - feedbackBias ), 0.0, maxLevel );
+
+    vec2 page = floor( texels / ( tileSize * exp2( level ) ) );
+    FragColor = vec4( page, level, 255.0 ) / 255.0;
+}
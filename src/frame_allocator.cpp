@@ -0,0 +1,97 @@
+#include "learnopengl-implementation/frame_allocator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace
+{
+    size_t alignUp( size_t value, size_t alignment )
+    {
+        return ( value + alignment - 1 ) & ~( alignment - 1 );
+    }
+}
+
+LinearArena::LinearArena( size_t capacity ) : block( new char[capacity] ), blockSize( capacity )
+{
+}
+
+LinearArena::~LinearArena( )
+{
+    delete[] block;
+    for ( char* extra : overflow )
+        delete[] extra;
+}
+
+void* LinearArena::allocate( size_t size, size_t alignment )
+{
+    // the aligned offset is computed on the address, the block itself is only max_align_t aligned
+    uintptr_t base = reinterpret_cast<uintptr_t>( block );
+    size_t aligned = alignUp( base + offset, alignment ) - base;
+    if ( aligned + size <= blockSize )
+    {
+        offset = aligned + size;
+        peak = std::max( peak, offset + overflowUsed );
+        return block + aligned;
+    }
+
+    // out of space for this frame, the block is grown on the next reset
+    char* extra = new char[size + alignment];
+    overflow.push_back( extra );
+    overflowUsed += size + alignment;
+    peak = std::max( peak, offset + overflowUsed );
+    return reinterpret_cast<void*>( alignUp( reinterpret_cast<uintptr_t>( extra ), alignment ) );
+}
+
+void* LinearArena::reallocate( void* pointer, size_t oldSize, size_t newSize, size_t alignment )
+{
+    if ( !pointer )
+        return allocate( newSize, alignment );
+
+    uintptr_t address = reinterpret_cast<uintptr_t>( pointer );
+    uintptr_t base = reinterpret_cast<uintptr_t>( block );
+    if ( address >= base && address + oldSize == base + offset && address - base + newSize <= blockSize )
+    {
+        offset = address - base + newSize;
+        peak = std::max( peak, offset + overflowUsed );
+        return pointer;
+    }
+
+    void* moved = allocate( newSize, alignment );
+    memcpy( moved, pointer, std::min( oldSize, newSize ) );
+    return moved;
+}
+
+void LinearArena::reset( )
+{
+    if ( !overflow.empty( ) )
+    {
+        for ( char* extra : overflow )
+            delete[] extra;
+        overflow.clear( );
+
+        // growing to the peak ( plus some slack ) so the same frame fits next time
+        size_t newSize = std::max( blockSize * 2, peak + peak / 4 );
+        delete[] block;
+        block = new char[newSize];
+        blockSize = newSize;
+    }
+    offset = 0;
+    overflowUsed = 0;
+}
+
+size_t LinearArena::used( ) const
+{
+    return offset + overflowUsed;
+}
+
+size_t LinearArena::capacity( ) const
+{
+    return blockSize;
+}
+
+size_t LinearArena::highWater( ) const
+{
+    return peak;
+}
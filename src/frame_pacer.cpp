@@ -0,0 +1,164 @@
+#include "learnopengl-implementation/frame_pacer.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+    // the last stretch before the target time is spun, sleeps overshoot by about this much
+    const double SPIN_MARGIN = 0.002;
+    // fence waits are retried in slices and given up on after a second, so a lost
+    // context cannot hang the thread forever
+    const GLuint64 FENCE_TIMEOUT = 100000000; // 100 ms in ns
+    const int FENCE_RETRIES = 10;
+    // weight of a new present interval in the smoothed one
+    const double SMOOTHING = 0.1;
+}
+
+FramePacer::FramePacer( const Settings& settings ) : settings( settings )
+{
+    if ( this->settings.maxFramesInFlight == 0 )
+        this->settings.maxFramesInFlight = 1;
+}
+
+void FramePacer::initialize( )
+{
+    fences.assign( settings.maxFramesInFlight, (GLsync) 0 );
+
+    if ( settings.refreshRate > 0 )
+        refreshPeriod = 1.0 / settings.refreshRate;
+
+    nativeAdaptive = glfwExtensionSupported( "WGL_EXT_swap_control_tear" ) ||
+                     glfwExtensionSupported( "GLX_EXT_swap_control_tear" );
+
+    switch ( settings.swapMode )
+    {
+    case SwapMode::IMMEDIATE:
+        applySwapInterval( 0 );
+        break;
+    case SwapMode::VSYNC:
+        applySwapInterval( 1 );
+        break;
+    case SwapMode::ADAPTIVE:
+        applySwapInterval( nativeAdaptive ? -1 : 1 );
+        break;
+    }
+
+    frameStart = lastPresent = glfwGetTime( );
+}
+
+void FramePacer::shutdown( )
+{
+    for ( GLsync& fence : fences )
+    {
+        if ( fence )
+            glDeleteSync( fence );
+        fence = 0;
+    }
+}
+
+void FramePacer::beginFrame( )
+{
+    // the fence of the frame that used this slot maxFramesInFlight frames ago
+    GLsync& fence = fences[frame % fences.size( )];
+    if ( fence )
+    {
+        double start = glfwGetTime( );
+        GLenum result = GL_TIMEOUT_EXPIRED;
+        for ( int retry = 0; retry < FENCE_RETRIES && result == GL_TIMEOUT_EXPIRED; retry++ )
+            result = glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT );
+        if ( result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED )
+            abandonedWaits++;
+        glDeleteSync( fence );
+        fence = 0;
+        fenceWaitTime += glfwGetTime( ) - start;
+    }
+
+    // sleeping the coarse part and spinning the rest toward the target frame time
+    if ( settings.targetFrameTime > 0.0 )
+    {
+        double target = frameStart + settings.targetFrameTime;
+        double now = glfwGetTime( );
+        double start = now;
+        if ( target - now > SPIN_MARGIN )
+            std::this_thread::sleep_for( std::chrono::duration<double>( target - now - SPIN_MARGIN ) );
+        while ( glfwGetTime( ) < target )
+            std::this_thread::yield( );
+        sleepTime += glfwGetTime( ) - start;
+
+        // a frame that overran the target does not make the next ones shorter
+        now = glfwGetTime( );
+        frameStart = now - target > settings.targetFrameTime ? now : target;
+    }
+    else
+    {
+        frameStart = glfwGetTime( );
+    }
+}
+
+void FramePacer::endFrame( double inputTime )
+{
+    fences[frame % fences.size( )] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+    frame++;
+
+    double now = glfwGetTime( );
+    double interval = now - lastPresent;
+    lastPresent = now;
+
+    // the very first interval includes the startup
+    if ( presents > 0 )
+    {
+        intervals++;
+        double delta = interval - intervalMean;
+        intervalMean += delta / intervals;
+        intervalM2 += delta * ( interval - intervalMean );
+        intervalMax = std::max( intervalMax, interval );
+        smoothedInterval = smoothedInterval == 0.0 ? interval : smoothedInterval + SMOOTHING * ( interval - smoothedInterval );
+    }
+
+    double latency = now - inputTime;
+    latencySum += latency;
+    latencyMax = std::max( latencyMax, latency );
+    presents++;
+
+    // emulated adaptive vsync: missing the refresh with vsync on halves the frame
+    // rate, so tear instead until the frames are comfortably fast again
+    if ( settings.swapMode == SwapMode::ADAPTIVE && !nativeAdaptive && refreshPeriod > 0.0 )
+    {
+        if ( swapInterval == 1 && smoothedInterval > 1.5 * refreshPeriod )
+            applySwapInterval( 0 );
+        else if ( swapInterval == 0 && smoothedInterval < 0.9 * refreshPeriod )
+            applySwapInterval( 1 );
+    }
+}
+
+void FramePacer::applySwapInterval( int interval )
+{
+    if ( interval == swapInterval )
+        return;
+    glfwSwapInterval( interval );
+    swapInterval = interval;
+}
+
+void FramePacer::report( std::ostream& out ) const
+{
+    if ( intervals == 0 )
+        return;
+
+    double jitter = std::sqrt( intervalM2 / intervals );
+    out << "Frame pacing: " << presents << " frames, "
+        << 1000.0 * intervalMean << " ms mean present interval, "
+        << 1000.0 * jitter << " ms jitter (std dev), "
+        << 1000.0 * intervalMax << " ms worst" << std::endl;
+    out << "Frame pacing: " << 1000.0 * latencySum / presents << " ms mean input-to-present latency, "
+        << 1000.0 * latencyMax << " ms worst, "
+        << 1000.0 * fenceWaitTime / presents << " ms/frame waiting on fences, "
+        << 1000.0 * sleepTime / presents << " ms/frame sleeping, swap interval " << swapInterval << std::endl;
+    if ( abandonedWaits > 0 )
+        out << "Frame pacing: " << abandonedWaits << " fence waits abandoned after "
+            << FENCE_RETRIES * FENCE_TIMEOUT / 1000000 << " ms" << std::endl;
+}
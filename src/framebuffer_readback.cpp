@@ -0,0 +1,188 @@
+#include "learnopengl-implementation/framebuffer_readback.h"
+#include "learnopengl-implementation/gl_helpers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+FramebufferReadback::FramebufferReadback( GLResources& resources, const Settings& settings )
+    : resources( resources ), settings( settings )
+{
+    this->settings.ringSize = std::max( 1u, settings.ringSize );
+    slots.reset( new Slot[this->settings.ringSize] );
+    queue.reserve( this->settings.ringSize );
+    for ( unsigned int i = 0; i < std::max( 1u, settings.encoderThreads ); i++ )
+        encoders.push_back( std::thread( &FramebufferReadback::encoderLoop, this ) );
+}
+
+FramebufferReadback::~FramebufferReadback( )
+{
+    stopEncoders( );
+}
+
+bool FramebufferReadback::capture( int width, int height, unsigned long long frame )
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now( );
+    Slot& slot = slots[next];
+    if ( slot.state.load( std::memory_order_acquire ) != FREE || width <= 0 || height <= 0 )
+    {
+        dropped++;
+        return false;
+    }
+
+    // buffers only grow, so a steady capture size stops respecifying them
+    size_t size = (size_t) width * height * 4;
+    if ( slot.buffer.get( ).isNull( ) )
+        slot.buffer = ScopedBuffer( resources, resources.createBuffer( "framebuffer readback" ) );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, slot.buffer.name( ) );
+    if ( slot.capacity < size )
+    {
+        glBufferData( GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ );
+        slot.capacity = size;
+        resources.setSize( slot.buffer.get( ), size );
+    }
+
+    // the copy into the buffer is queued like a draw, nothing waits for it here
+    glBindFramebuffer( GL_READ_FRAMEBUFFER, 0 );
+    glReadBuffer( GL_BACK );
+    glPixelStorei( GL_PACK_ALIGNMENT, 4 );
+    glReadPixels( 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+    slot.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+    slot.width = width;
+    slot.height = height;
+    snprintf( slot.path, sizeof( slot.path ), "%s%06llu.%s", settings.prefix.c_str( ), frame, ImageEncoder::extension( settings.format ) );
+    slot.state.store( READING, std::memory_order_relaxed );
+    next = ( next + 1 ) % settings.ringSize;
+    captures++;
+
+    unsigned long long elapsed = nanosecondsSince( start );
+    glThreadNanoseconds += elapsed;
+    frameNanoseconds += elapsed;
+    return true;
+}
+
+void FramebufferReadback::update( )
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now( );
+    // the previous frame's capture( ) and update( ) together
+    maxFrameNanoseconds = std::max( maxFrameNanoseconds, frameNanoseconds );
+    frameNanoseconds = 0;
+    updates++;
+
+    for ( unsigned int i = 0; i < settings.ringSize; i++ )
+    {
+        Slot& slot = slots[i];
+        int state = slot.state.load( std::memory_order_acquire );
+        if ( state == READING )
+        {
+            GLenum status = glClientWaitSync( slot.fence, 0, 0 );
+            if ( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED )
+                continue;
+            glDeleteSync( slot.fence );
+            slot.fence = nullptr;
+
+            // the mapping stays valid while other GL calls go on, the encoder reads it in place
+            glBindBuffer( GL_PIXEL_PACK_BUFFER, slot.buffer.name( ) );
+            slot.pixels = (const unsigned char*) glMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, (size_t) slot.width * slot.height * 4, GL_MAP_READ_BIT );
+            glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+            if ( !slot.pixels )
+            {
+                failed++;
+                slot.state.store( FREE, std::memory_order_relaxed );
+                continue;
+            }
+            slot.state.store( ENCODING, std::memory_order_relaxed );
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                queue.push_back( &slot );
+            }
+            wake.notify_one( );
+        }
+        else if ( state == ENCODED )
+        {
+            glBindBuffer( GL_PIXEL_PACK_BUFFER, slot.buffer.name( ) );
+            glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+            glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+            slot.pixels = nullptr;
+            if ( slot.written )
+                written++;
+            else
+                failed++;
+            slot.state.store( FREE, std::memory_order_relaxed );
+        }
+    }
+
+    unsigned long long elapsed = nanosecondsSince( start );
+    glThreadNanoseconds += elapsed;
+    frameNanoseconds += elapsed;
+}
+
+void FramebufferReadback::encoderLoop( )
+{
+    while ( true )
+    {
+        Slot* slot;
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            wake.wait( lock, [this]( ) { return stopping || !queue.empty( ); } );
+            if ( queue.empty( ) )
+                return;
+            slot = queue.front( );
+            queue.erase( queue.begin( ) );
+        }
+
+        slot->written = ImageEncoder::write( slot->path, settings.format, slot->pixels, slot->width, slot->height, settings.compressionLevel );
+        slot->state.store( ENCODED, std::memory_order_release );
+    }
+}
+
+void FramebufferReadback::shutdown( )
+{
+    // flushing so the fences of the last frames can signal, then draining the ring
+    glFlush( );
+    bool busy = true;
+    while ( busy )
+    {
+        busy = false;
+        for ( unsigned int i = 0; i < settings.ringSize; i++ )
+        {
+            Slot& slot = slots[i];
+            int state = slot.state.load( std::memory_order_acquire );
+            if ( state == READING )
+                glClientWaitSync( slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000 );
+            busy = busy || state != FREE;
+        }
+        update( );
+        if ( busy )
+            std::this_thread::yield( );
+    }
+
+    stopEncoders( );
+    for ( unsigned int i = 0; i < settings.ringSize; i++ )
+        slots[i].buffer.reset( );
+}
+
+void FramebufferReadback::stopEncoders( )
+{
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        stopping = true;
+    }
+    wake.notify_all( );
+    for ( std::thread& encoder : encoders )
+        encoder.join( );
+    encoders.clear( );
+}
+
+void FramebufferReadback::report( std::ostream& out ) const
+{
+    if ( captures == 0 && dropped == 0 )
+        return;
+    out << "Framebuffer readback: " << captures << " captures, " << written << " written, " << dropped << " dropped with the ring full";
+    if ( failed > 0 )
+        out << ", " << failed << " failed";
+    if ( updates > 0 )
+        out << ", GL thread " << glThreadNanoseconds / 1000.0 / updates << " us per frame ( " << maxFrameNanoseconds / 1000.0 << " us max )";
+    out << std::endl;
+}
@@ -0,0 +1,133 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// FXAA over the scene color ( see AntiAliasing ): pixels whose neighborhood's luma
+// range is small are copied, on the others the edge's direction comes from the
+// second derivatives of the luma, its ends from walking along it until the luma
+// changes, and the pixel samples across the edge in proportion to how close it is
+// to the nearer end; single pixel features are blended by their contrast instead
+uniform sampler2D color;
+uniform float edgeThreshold;
+// 1 / size of the scene target, and the texture coordinates of the last rendered texel
+uniform vec2 texelSize;
+uniform vec2 maxCoordinate;
+
+const int SEARCH_STEPS = 12;
+const float SEARCH_STRIDES[SEARCH_STEPS] = float[]( 1.0, 1.0, 1.0, 1.0, 1.0, 1.5, 2.0, 2.0, 2.0, 2.0, 4.0, 8.0 );
+// darker edges than this are left alone
+const float MIN_THRESHOLD = 0.0312;
+const float SUBPIXEL_AMOUNT = 0.75;
+
+vec3 colorAt( vec2 coordinate )
+{
+    return textureLod( color, clamp( coordinate, 0.5 * texelSize, maxCoordinate ), 0.0 ).rgb;
+}
+
+float lumaAt( vec2 coordinate )
+{
+    return dot( colorAt( coordinate ), vec3( 0.299, 0.587, 0.114 ) );
+}
+
+void main( )
+{
+    vec2 coordinate = gl_FragCoord.xy * texelSize;
+    vec3 center = colorAt( coordinate );
+    float lumaCenter = dot( center, vec3( 0.299, 0.587, 0.114 ) );
+    float lumaDown = lumaAt( coordinate + vec2( 0.0, -texelSize.y ) );
+    float lumaUp = lumaAt( coordinate + vec2( 0.0, texelSize.y ) );
+    float lumaLeft = lumaAt( coordinate + vec2( -texelSize.x, 0.0 ) );
+    float lumaRight = lumaAt( coordinate + vec2( texelSize.x, 0.0 ) );
+
+    float lumaMin = min( lumaCenter, min( min( lumaDown, lumaUp ), min( lumaLeft, lumaRight ) ) );
+    float lumaMax = max( lumaCenter, max( max( lumaDown, lumaUp ), max( lumaLeft, lumaRight ) ) );
+    float range = lumaMax - lumaMin;
+    if ( range < max( MIN_THRESHOLD, lumaMax * edgeThreshold ) )
+    {
+        FragColor = vec4( center, 1.0 );
+        return;
+    }
+
+    float lumaDownLeft = lumaAt( coordinate - texelSize );
+    float lumaUpRight = lumaAt( coordinate + texelSize );
+    float lumaUpLeft = lumaAt( coordinate + vec2( -texelSize.x, texelSize.y ) );
+    float lumaDownRight = lumaAt( coordinate + vec2( texelSize.x, -texelSize.y ) );
+    float lumaDownUp = lumaDown + lumaUp;
+    float lumaLeftRight = lumaLeft + lumaRight;
+    float lumaLeftCorners = lumaDownLeft + lumaUpLeft;
+    float lumaDownCorners = lumaDownLeft + lumaDownRight;
+    float lumaRightCorners = lumaDownRight + lumaUpRight;
+    float lumaUpCorners = lumaUpRight + lumaUpLeft;
+
+    // the luma changes most across the edge
+    float horizontal = abs( -2.0 * lumaLeft + lumaLeftCorners ) + 2.0 * abs( -2.0 * lumaCenter + lumaDownUp ) +
+                       abs( -2.0 * lumaRight + lumaRightCorners );
+    float vertical = abs( -2.0 * lumaUp + lumaUpCorners ) + 2.0 * abs( -2.0 * lumaCenter + lumaLeftRight ) +
+                     abs( -2.0 * lumaDown + lumaDownCorners );
+    bool isHorizontal = horizontal >= vertical;
+
+    // the side of the pixel the edge runs along
+    float luma1 = isHorizontal ? lumaDown : lumaLeft;
+    float luma2 = isHorizontal ? lumaUp : lumaRight;
+    float gradient1 = luma1 - lumaCenter;
+    float gradient2 = luma2 - lumaCenter;
+    bool steeper1 = abs( gradient1 ) >= abs( gradient2 );
+    float gradientScaled = 0.25 * max( abs( gradient1 ), abs( gradient2 ) );
+    float stepLength = isHorizontal ? texelSize.y : texelSize.x;
+    float lumaLocalAverage = 0.5 * ( ( steeper1 ? luma1 : luma2 ) + lumaCenter );
+    if ( steeper1 )
+        stepLength = -stepLength;
+
+    // walking both ways along the edge, half a pixel toward it, until the luma leaves the edge's
+    vec2 edgeCoordinate = coordinate;
+    if ( isHorizontal )
+        edgeCoordinate.y += 0.5 * stepLength;
+    else
+        edgeCoordinate.x += 0.5 * stepLength;
+    vec2 offset = isHorizontal ? vec2( texelSize.x, 0.0 ) : vec2( 0.0, texelSize.y );
+    vec2 end1 = edgeCoordinate - offset;
+    vec2 end2 = edgeCoordinate + offset;
+    float lumaEnd1 = 0.0;
+    float lumaEnd2 = 0.0;
+    bool reached1 = false;
+    bool reached2 = false;
+    for ( int i = 0; i < SEARCH_STEPS && !( reached1 && reached2 ); i++ )
+    {
+        if ( !reached1 )
+        {
+            lumaEnd1 = lumaAt( end1 ) - lumaLocalAverage;
+            reached1 = abs( lumaEnd1 ) >= gradientScaled;
+            if ( !reached1 )
+                end1 -= offset * SEARCH_STRIDES[i];
+        }
+        if ( !reached2 )
+        {
+            lumaEnd2 = lumaAt( end2 ) - lumaLocalAverage;
+            reached2 = abs( lumaEnd2 ) >= gradientScaled;
+            if ( !reached2 )
+                end2 += offset * SEARCH_STRIDES[i];
+        }
+    }
+
+    // the nearer end decides, when the luma changes there the way it does at the pixel
+    float distance1 = isHorizontal ? coordinate.x - end1.x : coordinate.y - end1.y;
+    float distance2 = isHorizontal ? end2.x - coordinate.x : end2.y - coordinate.y;
+    bool nearer1 = distance1 < distance2;
+    float pixelOffset = 0.5 - min( distance1, distance2 ) / ( distance1 + distance2 );
+    bool centerSmaller = lumaCenter < lumaLocalAverage;
+    bool matches = ( ( nearer1 ? lumaEnd1 : lumaEnd2 ) < 0.0 ) != centerSmaller;
+    float edgeOffset = matches ? pixelOffset : 0.0;
+
+    // single pixel features: the contrast with the neighborhood's average
+    float lumaAverage = ( 2.0 * ( lumaDownUp + lumaLeftRight ) + lumaLeftCorners + lumaRightCorners ) / 12.0;
+    float subpixel = clamp( abs( lumaAverage - lumaCenter ) / range, 0.0, 1.0 );
+    subpixel = ( -2.0 * subpixel + 3.0 ) * subpixel * subpixel;
+    float finalOffset = max( edgeOffset, subpixel * subpixel * SUBPIXEL_AMOUNT );
+
+    vec2 finalCoordinate = coordinate;
+    if ( isHorizontal )
+        finalCoordinate.y += finalOffset * stepLength;
+    else
+        finalCoordinate.x += finalOffset * stepLength;
+    FragColor = vec4( colorAt( finalCoordinate ), 1.0 );
+}
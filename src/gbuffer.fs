@@ -0,0 +1,40 @@
+#version 330 core
+
+// thin G-buffer: albedo in RGBA8 and the view space normal octahedral encoded in RG16
+// snorm, the position is reconstructed from the depth buffer by the lighting passes
+layout ( location = 0 ) out vec4 gAlbedo;
+layout ( location = 1 ) out vec2 gNormal;
+// screen space motion since the last frame in texture coordinates, only kept by TAA
+layout ( location = 2 ) out vec2 velocity;
+
+in vec2 texCoord;
+in vec4 currentPosition;
+in vec4 previousPosition;
+
+uniform sampler2D texture1;
+uniform sampler2D texture2;
+uniform float mixValue;
+uniform mat4 inverseProjection;
+uniform vec2 viewportSize;
+// applyWireframe( ) comes from wireframe.glsl
+
+// the same mapping as NormalEncoding::packOctahedral( )
+vec2 encodeNormal( vec3 n )
+{
+    n /= abs( n.x ) + abs( n.y ) + abs( n.z );
+    vec2 signs = vec2( n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0 );
+    return n.z >= 0.0 ? n.xy : ( 1.0 - abs( n.yx ) ) * signs;
+}
+
+void main( )
+{
+    gAlbedo = mix( texture( texture1, texCoord ), texture( texture2, texCoord ), mixValue );
+    gAlbedo.rgb = applyWireframe( gAlbedo.rgb );
+
+    // the mesh has no normals, the faces are flat so the slope of the position gives them
+    vec4 position = inverseProjection * vec4( gl_FragCoord.xy / viewportSize * 2.0 - 1.0, gl_FragCoord.z * 2.0 - 1.0, 1.0 );
+    position.xyz /= position.w;
+    gNormal = encodeNormal( normalize( cross( dFdx( position.xyz ), dFdy( position.xyz ) ) ) );
+    // both positions carry this frame's jitter, which cancels out
+    velocity = ( currentPosition.xy / currentPosition.w - previousPosition.xy / previousPosition.w ) * 0.5;
+}
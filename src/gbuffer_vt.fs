@@ -0,0 +1,59 @@
+#version 330 core
+
+// gbuffer.fs with the first texture sampled through the virtual texture ( see shader_vt.fs )
+layout ( location = 0 ) out vec4 gAlbedo;
+layout ( location = 1 ) out vec2 gNormal;
+// screen space motion since the last frame in texture coordinates, only kept by TAA
+layout ( location = 2 ) out vec2 velocity;
+
+in vec2 texCoord;
+in vec4 currentPosition;
+in vec4 previousPosition;
+
+uniform sampler2D pageTable;
+uniform sampler2D physicalCache;
+uniform float virtualSize;
+uniform float tileSize;
+uniform float maxLevel;
+uniform sampler2D texture2;
+uniform float mixValue;
+uniform mat4 inverseProjection;
+uniform vec2 viewportSize;
+// applyWireframe( ) comes from wireframe.glsl
+
+vec4 sampleVirtual( vec2 uv )
+{
+    uv = clamp( uv, 0.0, 1.0 - 0.5 / virtualSize );
+    vec2 texels = uv * virtualSize;
+    float footprint = max( length( dFdx( texels ) ), length( dFdy( texels ) ) );
+    int level = int( clamp( floor( log2( max( footprint, 1.0 ) ) ), 0.0, maxLevel ) );
+
+    vec2 pages = vec2( virtualSize / tileSize ) / exp2( float( level ) );
+    vec4 entry = texelFetch( pageTable, ivec2( uv * pages ), level ) * 255.0;
+    ivec2 tile = ivec2( entry.rg + 0.5 );
+    float residentLevel = floor( entry.b + 0.5 );
+
+    vec2 inPage = fract( texels / ( tileSize * exp2( residentLevel ) ) ) * tileSize;
+    return texelFetch( physicalCache, tile * int( tileSize ) + ivec2( inPage ), 0 );
+}
+
+// the same mapping as NormalEncoding::packOctahedral( )
+vec2 encodeNormal( vec3 n )
+{
+    n /= abs( n.x ) + abs( n.y ) + abs( n.z );
+    vec2 signs = vec2( n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0 );
+    return n.z >= 0.0 ? n.xy : ( 1.0 - abs( n.yx ) ) * signs;
+}
+
+void main( )
+{
+    gAlbedo = mix( sampleVirtual( texCoord ), texture( texture2, texCoord ), mixValue );
+    gAlbedo.rgb = applyWireframe( gAlbedo.rgb );
+
+    // the mesh has no normals, the faces are flat so the slope of the position gives them
+    vec4 position = inverseProjection * vec4( gl_FragCoord.xy / viewportSize * 2.0 - 1.0, gl_FragCoord.z * 2.0 - 1.0, 1.0 );
+    position.xyz /= position.w;
+    gNormal = encodeNormal( normalize( cross( dFdx( position.xyz ), dFdy( position.xyz ) ) ) );
+    // both positions carry this frame's jitter, which cancels out
+    velocity = ( currentPosition.xy / currentPosition.w - previousPosition.xy / previousPosition.w ) * 0.5;
+}
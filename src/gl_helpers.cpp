@@ -0,0 +1,162 @@
+#include "learnopengl-implementation/gl_helpers.h"
+
+#include <algorithm>
+
+namespace
+{
+    const float corners[] = {
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+        0.0f, 1.0f,
+        1.0f, 1.0f
+    };
+}
+
+TimerQueryRing::TimerQueryRing( GLResources& resources, const char* label, unsigned int queryCount )
+    : resources( resources ), label( label ), queryCount( std::min( std::max( 1u, queryCount ), MAX_QUERIES ) )
+{
+}
+
+bool TimerQueryRing::begin( )
+{
+    Slot& current = slots[next];
+    measuring = !current.pending;
+    if ( measuring && current.queries[0].get( ).isNull( ) )
+        for ( unsigned int i = 0; i < queryCount; i++ )
+            current.queries[i] = ScopedQuery( resources, resources.createQuery( label ) );
+    return measuring;
+}
+
+bool TimerQueryRing::isMeasuring( ) const
+{
+    return measuring;
+}
+
+unsigned int TimerQueryRing::slot( ) const
+{
+    return next;
+}
+
+GLuint TimerQueryRing::query( unsigned int index ) const
+{
+    return slots[next].queries[index].name( );
+}
+
+void TimerQueryRing::timestamp( unsigned int index )
+{
+    if ( measuring )
+        glQueryCounter( query( index ), GL_TIMESTAMP );
+}
+
+void TimerQueryRing::end( )
+{
+    if ( !measuring )
+        return;
+    slots[next].pending = true;
+    next = ( next + 1 ) % SLOT_COUNT;
+    measuring = false;
+}
+
+bool TimerQueryRing::collectNext( unsigned int& finished, GLuint64* results )
+{
+    // oldest first, the results arrive in submission order, so the first slot still in
+    // flight means the ones after it are too
+    for ( unsigned int i = 0; i < SLOT_COUNT; i++ )
+    {
+        unsigned int index = ( next + i ) % SLOT_COUNT;
+        Slot& current = slots[index];
+        if ( !current.pending )
+            continue;
+        for ( unsigned int j = 0; j < queryCount; j++ )
+        {
+            GLint available = 0;
+            glGetQueryObjectiv( current.queries[j].name( ), GL_QUERY_RESULT_AVAILABLE, &available );
+            if ( !available )
+                return false;
+        }
+        for ( unsigned int j = 0; j < queryCount; j++ )
+            glGetQueryObjectui64v( current.queries[j].name( ), GL_QUERY_RESULT, &results[j] );
+        current.pending = false;
+        finished = index;
+        return true;
+    }
+    return false;
+}
+
+void TimerQueryRing::reset( )
+{
+    for ( Slot& current : slots )
+    {
+        for ( ScopedQuery& query : current.queries )
+            query.reset( );
+        current.pending = false;
+    }
+    measuring = false;
+}
+
+StreamBuffer::StreamBuffer( GLResources& resources, GLenum target, const char* label )
+    : resources( &resources ), target( target ), buffer( resources, resources.createBuffer( label ) )
+{
+}
+
+void StreamBuffer::upload( const void* data, size_t bytes )
+{
+    if ( bytes == 0 )
+        return;
+    glBindBuffer( target, buffer.name( ) );
+    if ( bytes > capacity )
+    {
+        capacity = std::max( bytes, capacity * 2 );
+        resources->setSize( buffer.get( ), capacity );
+    }
+    glBufferData( target, capacity, nullptr, GL_STREAM_DRAW );
+    glBufferSubData( target, 0, bytes, data );
+    glBindBuffer( target, 0 );
+}
+
+GLuint StreamBuffer::name( ) const
+{
+    return buffer.name( );
+}
+
+BufferHandle StreamBuffer::get( ) const
+{
+    return buffer.get( );
+}
+
+void StreamBuffer::reset( )
+{
+    buffer.reset( );
+    capacity = 0;
+}
+
+void SharedGeometry::initialize( GLResources& resources )
+{
+    fullscreenArray = ScopedVertexArray( resources, resources.createVertexArray( "full screen triangle" ) );
+    cornerBuffer = ScopedBuffer( resources, resources.createBuffer( "unit quad corners" ) );
+    glBindBuffer( GL_ARRAY_BUFFER, cornerBuffer.name( ) );
+    glBufferData( GL_ARRAY_BUFFER, sizeof( corners ), corners, GL_STATIC_DRAW );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    resources.setSize( cornerBuffer.get( ), sizeof( corners ) );
+}
+
+void SharedGeometry::drawFullscreen( ) const
+{
+    glBindVertexArray( fullscreenArray.name( ) );
+    glDrawArrays( GL_TRIANGLES, 0, 3 );
+    glBindVertexArray( 0 );
+}
+
+void SharedGeometry::bindQuadCorners( GLuint attribute ) const
+{
+    glBindBuffer( GL_ARRAY_BUFFER, cornerBuffer.name( ) );
+    glVertexAttribPointer( attribute, 2, GL_FLOAT, GL_FALSE, 2 * sizeof( float ), (void*) 0 );
+    glEnableVertexAttribArray( attribute );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+void SharedGeometry::shutdown( )
+{
+    fullscreenArray.reset( );
+    cornerBuffer.reset( );
+}
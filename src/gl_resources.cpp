@@ -0,0 +1,310 @@
+#include "learnopengl-implementation/gl_resources.h"
+
+namespace
+{
+    // slot index in the low bits of a handle, generation in the rest
+    const uint32_t SLOT_BITS = 20;
+    const uint32_t SLOT_MASK = ( 1u << SLOT_BITS ) - 1;
+    const uint32_t GENERATION_MASK = ( 1u << ( 32 - SLOT_BITS ) ) - 1;
+    // names generated per glGen* call
+    const unsigned int GENERATE_BATCH = 16;
+
+    const char* typeName( GLResourceType type )
+    {
+        switch ( type )
+        {
+        case GLResourceType::BUFFER:
+            return "buffers";
+        case GLResourceType::TEXTURE:
+            return "textures";
+        case GLResourceType::VERTEX_ARRAY:
+            return "vertex arrays";
+        case GLResourceType::PROGRAM:
+            return "programs";
+        case GLResourceType::FRAMEBUFFER:
+            return "framebuffers";
+        case GLResourceType::QUERY:
+            return "queries";
+        default:
+            return "unknown";
+        }
+    }
+
+    void generateNames( GLResourceType type, GLsizei count, GLuint* names )
+    {
+        switch ( type )
+        {
+        case GLResourceType::BUFFER:
+            glGenBuffers( count, names );
+            break;
+        case GLResourceType::TEXTURE:
+            glGenTextures( count, names );
+            break;
+        case GLResourceType::VERTEX_ARRAY:
+            glGenVertexArrays( count, names );
+            break;
+        case GLResourceType::FRAMEBUFFER:
+            glGenFramebuffers( count, names );
+            break;
+        case GLResourceType::QUERY:
+            glGenQueries( count, names );
+            break;
+        default:
+            break;
+        }
+    }
+
+    void deleteNames( GLResourceType type, GLsizei count, const GLuint* names )
+    {
+        switch ( type )
+        {
+        case GLResourceType::BUFFER:
+            glDeleteBuffers( count, names );
+            break;
+        case GLResourceType::TEXTURE:
+            glDeleteTextures( count, names );
+            break;
+        case GLResourceType::VERTEX_ARRAY:
+            glDeleteVertexArrays( count, names );
+            break;
+        case GLResourceType::FRAMEBUFFER:
+            glDeleteFramebuffers( count, names );
+            break;
+        case GLResourceType::QUERY:
+            glDeleteQueries( count, names );
+            break;
+        case GLResourceType::PROGRAM:
+            // there is no batched delete for programs
+            for ( GLsizei i = 0; i < count; i++ )
+                glDeleteProgram( names[i] );
+            break;
+        default:
+            break;
+        }
+    }
+
+    uint32_t slotOf( uint32_t handle )
+    {
+        return handle & SLOT_MASK;
+    }
+
+    uint32_t generationOf( uint32_t handle )
+    {
+        return handle >> SLOT_BITS;
+    }
+}
+
+GLResourcePool::GLResourcePool( GLResourceType type ) : type( type )
+{
+}
+
+uint32_t GLResourcePool::create( const char* label )
+{
+    if ( spareNames.empty( ) )
+    {
+        spareNames.resize( GENERATE_BATCH );
+        generateNames( type, GENERATE_BATCH, spareNames.data( ) );
+    }
+    GLuint name = spareNames.back( );
+    spareNames.pop_back( );
+    return allocateSlot( name, label );
+}
+
+uint32_t GLResourcePool::adopt( GLuint name, const char* label )
+{
+    return allocateSlot( name, label );
+}
+
+uint32_t GLResourcePool::allocateSlot( GLuint name, const char* label )
+{
+    uint32_t slot;
+    if ( !freeSlots.empty( ) )
+    {
+        slot = freeSlots.back( );
+        freeSlots.pop_back( );
+    }
+    else
+    {
+        slot = (uint32_t) names.size( );
+        names.push_back( 0 );
+        // generation 0 is never used so that a zero handle is always null
+        generations.push_back( 1 );
+        sizes.push_back( 0 );
+        labels.push_back( nullptr );
+    }
+
+    names[slot] = name;
+    sizes[slot] = 0;
+    labels[slot] = label;
+    live++;
+    return ( (uint32_t) generations[slot] << SLOT_BITS ) | slot;
+}
+
+void GLResourcePool::release( uint32_t handle )
+{
+    if ( !isValid( handle ) )
+    {
+        if ( handle != 0 )
+            stale++;
+        return;
+    }
+
+    uint32_t slot = slotOf( handle );
+    pendingDeletes.push_back( names[slot] );
+    live--;
+    bytes -= sizes[slot];
+
+    names[slot] = 0;
+    sizes[slot] = 0;
+    labels[slot] = nullptr;
+    generations[slot] = ( generations[slot] + 1 ) & GENERATION_MASK;
+    if ( generations[slot] == 0 )
+        generations[slot] = 1;
+    freeSlots.push_back( slot );
+}
+
+GLuint GLResourcePool::get( uint32_t handle ) const
+{
+    if ( !isValid( handle ) )
+    {
+        if ( handle != 0 )
+            stale++;
+        return 0;
+    }
+    return names[slotOf( handle )];
+}
+
+bool GLResourcePool::isValid( uint32_t handle ) const
+{
+    uint32_t slot = slotOf( handle );
+    return handle != 0 && slot < generations.size( ) && generations[slot] == generationOf( handle );
+}
+
+void GLResourcePool::setSize( uint32_t handle, size_t size )
+{
+    if ( !isValid( handle ) )
+    {
+        stale++;
+        return;
+    }
+    uint32_t slot = slotOf( handle );
+    bytes = bytes - sizes[slot] + size;
+    sizes[slot] = size;
+}
+
+void GLResourcePool::flush( )
+{
+    if ( pendingDeletes.empty( ) )
+        return;
+    deleteNames( type, (GLsizei) pendingDeletes.size( ), pendingDeletes.data( ) );
+    pendingDeletes.clear( );
+}
+
+void GLResourcePool::shutdown( std::ostream& leaks )
+{
+    for ( uint32_t slot = 0; slot < names.size( ); slot++ )
+    {
+        if ( names[slot] == 0 )
+            continue;
+        leaks << "Leaked GL " << typeName( type ) << ": " << ( labels[slot] ? labels[slot] : "unnamed" )
+              << " (" << sizes[slot] << " bytes)" << std::endl;
+        release( ( (uint32_t) generations[slot] << SLOT_BITS ) | slot );
+    }
+    flush( );
+
+    if ( !spareNames.empty( ) )
+        deleteNames( type, (GLsizei) spareNames.size( ), spareNames.data( ) );
+    spareNames.clear( );
+}
+
+unsigned int GLResourcePool::liveCount( ) const
+{
+    return live;
+}
+
+size_t GLResourcePool::liveBytes( ) const
+{
+    return bytes;
+}
+
+unsigned int GLResourcePool::staleCount( ) const
+{
+    return stale;
+}
+
+GLResources::GLResources( ) : pools{ GLResourcePool( GLResourceType::BUFFER ),
+                                     GLResourcePool( GLResourceType::TEXTURE ),
+                                     GLResourcePool( GLResourceType::VERTEX_ARRAY ),
+                                     GLResourcePool( GLResourceType::PROGRAM ),
+                                     GLResourcePool( GLResourceType::FRAMEBUFFER ),
+                                     GLResourcePool( GLResourceType::QUERY ) }
+{
+}
+
+BufferHandle GLResources::createBuffer( const char* label )
+{
+    BufferHandle handle;
+    handle.value = pool( GLResourceType::BUFFER ).create( label );
+    return handle;
+}
+
+TextureHandle GLResources::createTexture( const char* label )
+{
+    TextureHandle handle;
+    handle.value = pool( GLResourceType::TEXTURE ).create( label );
+    return handle;
+}
+
+VertexArrayHandle GLResources::createVertexArray( const char* label )
+{
+    VertexArrayHandle handle;
+    handle.value = pool( GLResourceType::VERTEX_ARRAY ).create( label );
+    return handle;
+}
+
+FramebufferHandle GLResources::createFramebuffer( const char* label )
+{
+    FramebufferHandle handle;
+    handle.value = pool( GLResourceType::FRAMEBUFFER ).create( label );
+    return handle;
+}
+
+QueryHandle GLResources::createQuery( const char* label )
+{
+    QueryHandle handle;
+    handle.value = pool( GLResourceType::QUERY ).create( label );
+    return handle;
+}
+
+ProgramHandle GLResources::adoptProgram( GLuint program, const char* label )
+{
+    ProgramHandle handle;
+    handle.value = pool( GLResourceType::PROGRAM ).adopt( program, label );
+    return handle;
+}
+
+void GLResources::flush( )
+{
+    for ( GLResourcePool& pool : pools )
+        pool.flush( );
+}
+
+void GLResources::report( std::ostream& out ) const
+{
+    out << "GL resources:";
+    for ( int i = 0; i < (int) GLResourceType::COUNT; i++ )
+    {
+        const GLResourcePool& pool = pools[i];
+        out << ( i > 0 ? "," : "" ) << " " << pool.liveCount( ) << " " << typeName( (GLResourceType) i )
+            << " (" << pool.liveBytes( ) / 1024 << " KB)";
+        if ( pool.staleCount( ) > 0 )
+            out << " [" << pool.staleCount( ) << " stale handle uses]";
+    }
+    out << std::endl;
+}
+
+void GLResources::shutdown( std::ostream& leaks )
+{
+    for ( GLResourcePool& pool : pools )
+        pool.shutdown( leaks );
+}
@@ -0,0 +1,216 @@
+#include "learnopengl-implementation/image_decoder.h"
+#include "learnopengl-implementation/frame_allocator.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+    // scratch arena of a decode running on this thread, null outside of one
+    thread_local LinearArena* activeArena = nullptr;
+    // size of the decode's result, allocations of this size ( or one byte more, the JPEG
+    // decoder pads its output ) go to the heap so the result can be handed out as it is;
+    // 0 when unknown
+    thread_local size_t resultSize = 0;
+
+    // every allocation is prefixed with its size and where it came from, so plain
+    // STBI_REALLOC works too and frees can tell heap blocks from arena ones
+    struct Header
+    {
+        size_t size;
+        size_t heap;
+    };
+    const size_t HEADER_SIZE = 16;
+    static_assert( sizeof( Header ) <= HEADER_SIZE, "the header must fit in front of the allocation" );
+
+    Header* headerOf( void* pointer )
+    {
+        return reinterpret_cast<Header*>( static_cast<char*>( pointer ) - HEADER_SIZE );
+    }
+
+    void* heapMalloc( size_t size )
+    {
+        char* memory = static_cast<char*>( malloc( size + HEADER_SIZE ) );
+        if ( !memory )
+            return nullptr;
+        *reinterpret_cast<Header*>( memory ) = Header{ size, 1 };
+        return memory + HEADER_SIZE;
+    }
+
+    void* scratchMalloc( size_t size )
+    {
+        if ( !activeArena || ( resultSize > 0 && ( size == resultSize || size == resultSize + 1 ) ) )
+            return heapMalloc( size );
+        char* memory = static_cast<char*>( activeArena->allocate( size + HEADER_SIZE, HEADER_SIZE ) );
+        *reinterpret_cast<Header*>( memory ) = Header{ size, 0 };
+        return memory + HEADER_SIZE;
+    }
+
+    void* scratchRealloc( void* pointer, size_t newSize )
+    {
+        if ( !pointer )
+            return scratchMalloc( newSize );
+
+        Header* header = headerOf( pointer );
+        char* memory;
+        if ( header->heap )
+            memory = static_cast<char*>( realloc( header, newSize + HEADER_SIZE ) );
+        else
+            memory = static_cast<char*>( activeArena->reallocate( header, header->size + HEADER_SIZE, newSize + HEADER_SIZE, HEADER_SIZE ) );
+        if ( !memory )
+            return nullptr;
+        reinterpret_cast<Header*>( memory )->size = newSize;
+        return memory + HEADER_SIZE;
+    }
+
+    void scratchFree( void* pointer )
+    {
+        // arena memory goes away with the next reset
+        if ( pointer && headerOf( pointer )->heap )
+            free( headerOf( pointer ) );
+    }
+}
+
+#define STBI_MALLOC( size ) scratchMalloc( size )
+#define STBI_REALLOC( pointer, newSize ) scratchRealloc( pointer, newSize )
+#define STBI_REALLOC_SIZED( pointer, oldSize, newSize ) scratchRealloc( pointer, newSize )
+#define STBI_FREE( pointer ) scratchFree( pointer )
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+namespace
+{
+    // starting size of each thread's arena, it grows to the largest decode seen
+    const size_t SCRATCH_CAPACITY = 4 * 1024 * 1024;
+
+    std::atomic<bool> useScratchArena{ true };
+
+    std::atomic<unsigned long long> decodedImages{ 0 };
+    std::atomic<unsigned long long> decodedBytes{ 0 };
+    std::atomic<unsigned long long> decodeNanoseconds{ 0 };
+    // results that had to be copied out of the arena
+    std::atomic<unsigned long long> copiedResults{ 0 };
+
+    LinearArena& threadArena( )
+    {
+        thread_local std::unique_ptr<LinearArena> arena( new LinearArena( SCRATCH_CAPACITY ) );
+        return *arena;
+    }
+
+    // a file path or an encoded image in memory
+    struct Source
+    {
+        const char* path;
+        const unsigned char* data;
+        size_t size;
+    };
+
+    // the result's size from the image header, 0 when it cannot be read
+    size_t stbiResultSize( const Source& source, int desiredChannels )
+    {
+        int width, height, channels;
+        int known = source.path ? stbi_info( source.path, &width, &height, &channels )
+                                : stbi_info_from_memory( source.data, (int) source.size, &width, &height, &channels );
+        if ( !known )
+            return 0;
+        return (size_t) width * height * ( desiredChannels ? desiredChannels : channels );
+    }
+
+    unsigned char* stbiLoad( const Source& source, int* width, int* height, int* channels, int desiredChannels )
+    {
+        if ( source.path )
+            return stbi_load( source.path, width, height, channels, desiredChannels );
+        return stbi_load_from_memory( source.data, (int) source.size, width, height, channels, desiredChannels );
+    }
+
+    unsigned char* decode( const Source& source, int* width, int* height, int* channels, int desiredChannels )
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now( );
+
+        unsigned char* pixels;
+        if ( useScratchArena.load( std::memory_order_relaxed ) )
+        {
+            LinearArena& arena = threadArena( );
+            activeArena = &arena;
+            resultSize = stbiResultSize( source, desiredChannels );
+            pixels = stbiLoad( source, width, height, channels, desiredChannels );
+            resultSize = 0;
+            activeArena = nullptr;
+
+            // only the result is handed out, the rest of the scratch memory is recycled; a
+            // format that built its result in the arena after all has it copied out
+            if ( pixels && !headerOf( pixels )->heap )
+            {
+                size_t size = (size_t) *width * *height * ( desiredChannels ? desiredChannels : *channels );
+                unsigned char* copy = static_cast<unsigned char*>( heapMalloc( size ) );
+                if ( copy )
+                    memcpy( copy, pixels, size );
+                pixels = copy;
+                copiedResults.fetch_add( 1, std::memory_order_relaxed );
+            }
+            arena.reset( );
+        }
+        else
+        {
+            pixels = stbiLoad( source, width, height, channels, desiredChannels );
+        }
+
+        if ( pixels )
+        {
+            decodedImages.fetch_add( 1, std::memory_order_relaxed );
+            decodedBytes.fetch_add( (unsigned long long) *width * *height * ( desiredChannels ? desiredChannels : *channels ),
+                                    std::memory_order_relaxed );
+        }
+        decodeNanoseconds.fetch_add( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now( ) - start ).count( ),
+                                     std::memory_order_relaxed );
+        return pixels;
+    }
+}
+
+namespace ImageDecoder
+{
+    unsigned char* load( const char* path, int* width, int* height, int* channels, int desiredChannels )
+    {
+        Source source = { path, nullptr, 0 };
+        return decode( source, width, height, channels, desiredChannels );
+    }
+
+    unsigned char* loadFromMemory( const unsigned char* data, size_t size, int* width, int* height, int* channels, int desiredChannels )
+    {
+        Source source = { nullptr, data, size };
+        return decode( source, width, height, channels, desiredChannels );
+    }
+
+    void release( unsigned char* pixels )
+    {
+        scratchFree( pixels );
+    }
+
+    const char* failureReason( )
+    {
+        return stbi_failure_reason( );
+    }
+
+    void setFlipVertically( bool flip )
+    {
+        stbi_set_flip_vertically_on_load( flip );
+    }
+
+    void setScratchArena( bool enabled )
+    {
+        useScratchArena.store( enabled, std::memory_order_relaxed );
+    }
+
+    void report( std::ostream& out )
+    {
+        unsigned long long images = decodedImages.load( );
+        if ( images == 0 )
+            return;
+        out << "Image decoding: " << images << " images, " << decodedBytes.load( ) / 1024 << " KB of pixels, "
+            << decodeNanoseconds.load( ) / 1000000.0 << " ms decoding (all threads), scratch arena "
+            << ( useScratchArena.load( ) ? "on" : "off" ) << ", " << copiedResults.load( ) << " results copied out of it" << std::endl;
+    }
+}
@@ -0,0 +1,249 @@
+#include "learnopengl-implementation/image_encoder.h"
+
+#include <zlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    std::atomic<unsigned long long> encodedImages{ 0 };
+    std::atomic<unsigned long long> encodedBytes{ 0 };
+    std::atomic<unsigned long long> encodeNanoseconds{ 0 };
+
+    // zlib stream of the calling thread, reset instead of reinitialized between images
+    struct Deflater
+    {
+        z_stream stream;
+        bool initialized = false;
+        int level = 0;
+
+        ~Deflater( )
+        {
+            if ( initialized )
+                deflateEnd( &stream );
+        }
+
+        bool reset( int compressionLevel )
+        {
+            if ( !initialized )
+            {
+                memset( &stream, 0, sizeof( stream ) );
+                if ( deflateInit( &stream, compressionLevel ) != Z_OK )
+                    return false;
+                initialized = true;
+                level = compressionLevel;
+                return true;
+            }
+            deflateReset( &stream );
+            if ( level != compressionLevel )
+            {
+                deflateParams( &stream, compressionLevel, Z_DEFAULT_STRATEGY );
+                level = compressionLevel;
+            }
+            return true;
+        }
+    };
+
+    struct ThreadBuffers
+    {
+        std::vector<unsigned char> rows;
+        std::vector<unsigned char> compressed;
+        Deflater deflater;
+    };
+
+    ThreadBuffers& threadBuffers( )
+    {
+        thread_local ThreadBuffers buffers;
+        return buffers;
+    }
+
+    void putBigEndian( unsigned char* destination, uint32_t value )
+    {
+        destination[0] = (unsigned char) ( value >> 24 );
+        destination[1] = (unsigned char) ( value >> 16 );
+        destination[2] = (unsigned char) ( value >> 8 );
+        destination[3] = (unsigned char) value;
+    }
+
+    bool writeChunk( FILE* file, const char* type, const unsigned char* data, uint32_t size )
+    {
+        unsigned char header[8];
+        putBigEndian( header, size );
+        memcpy( header + 4, type, 4 );
+        unsigned char footer[4];
+        uLong crc = crc32( 0, header + 4, 4 );
+        // a null buffer would restart the CRC instead of leaving it unchanged
+        if ( size > 0 )
+            crc = crc32( crc, data, size );
+        putBigEndian( footer, (uint32_t) crc );
+        return fwrite( header, 1, 8, file ) == 8 && fwrite( data, 1, size, file ) == size && fwrite( footer, 1, 4, file ) == 4;
+    }
+
+    // RGB scanlines top row first, each behind the PNG "up" filter byte: the difference
+    // to the row above is cheap to compute and deflates far better than the raw rows
+    void filterRows( const unsigned char* pixels, int width, int height, std::vector<unsigned char>& rows )
+    {
+        size_t stride = (size_t) width * 3 + 1;
+        rows.resize( stride * height );
+        for ( int y = 0; y < height; y++ )
+        {
+            const unsigned char* source = pixels + (size_t) ( height - 1 - y ) * width * 4;
+            const unsigned char* above = y > 0 ? source + (size_t) width * 4 : nullptr;
+            unsigned char* row = &rows[stride * y];
+            *row++ = 2;
+            for ( int x = 0; x < width; x++ )
+            {
+                for ( int c = 0; c < 3; c++ )
+                    row[c] = (unsigned char) ( source[c] - ( above ? above[c] : 0 ) );
+                row += 3;
+                source += 4;
+                if ( above )
+                    above += 4;
+            }
+        }
+    }
+
+    bool writePng( FILE* file, const unsigned char* pixels, int width, int height, int compressionLevel, size_t& written )
+    {
+        ThreadBuffers& buffers = threadBuffers( );
+        filterRows( pixels, width, height, buffers.rows );
+
+        if ( !buffers.deflater.reset( compressionLevel ) )
+            return false;
+        z_stream& stream = buffers.deflater.stream;
+        buffers.compressed.resize( deflateBound( &stream, buffers.rows.size( ) ) );
+        stream.next_in = buffers.rows.data( );
+        stream.avail_in = (uInt) buffers.rows.size( );
+        stream.next_out = buffers.compressed.data( );
+        stream.avail_out = (uInt) buffers.compressed.size( );
+        if ( deflate( &stream, Z_FINISH ) != Z_STREAM_END )
+            return false;
+        uint32_t compressedSize = (uint32_t) stream.total_out;
+
+        static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        unsigned char header[13];
+        putBigEndian( header, (uint32_t) width );
+        putBigEndian( header + 4, (uint32_t) height );
+        // 8 bit truecolor, deflate, adaptive filtering, no interlacing
+        header[8] = 8;
+        header[9] = 2;
+        header[10] = 0;
+        header[11] = 0;
+        header[12] = 0;
+        written = sizeof( signature ) + 25 + 12 + compressedSize + 12;
+        return fwrite( signature, 1, sizeof( signature ), file ) == sizeof( signature ) && writeChunk( file, "IHDR", header, sizeof( header ) ) &&
+               writeChunk( file, "IDAT", buffers.compressed.data( ), compressedSize ) && writeChunk( file, "IEND", nullptr, 0 );
+    }
+
+    // TGA keeps the bottom row first, only the channels are swapped
+    bool writeTga( FILE* file, const unsigned char* pixels, int width, int height, size_t& written )
+    {
+        unsigned char header[18] = { };
+        // uncompressed truecolor, 24 bits per pixel, origin in the lower left corner
+        header[2] = 2;
+        header[12] = (unsigned char) width;
+        header[13] = (unsigned char) ( width >> 8 );
+        header[14] = (unsigned char) height;
+        header[15] = (unsigned char) ( height >> 8 );
+        header[16] = 24;
+
+        std::vector<unsigned char>& rows = threadBuffers( ).rows;
+        size_t count = (size_t) width * height;
+        rows.resize( count * 3 );
+        for ( size_t i = 0; i < count; i++ )
+        {
+            rows[i * 3] = pixels[i * 4 + 2];
+            rows[i * 3 + 1] = pixels[i * 4 + 1];
+            rows[i * 3 + 2] = pixels[i * 4];
+        }
+        written = sizeof( header ) + rows.size( );
+        return fwrite( header, 1, sizeof( header ), file ) == sizeof( header ) && fwrite( rows.data( ), 1, rows.size( ), file ) == rows.size( );
+    }
+
+    bool writeRaw( FILE* file, const unsigned char* pixels, int width, int height, size_t& written )
+    {
+        std::vector<unsigned char>& rows = threadBuffers( ).rows;
+        rows.resize( (size_t) width * height * 3 );
+        unsigned char* destination = rows.data( );
+        for ( int y = height - 1; y >= 0; y-- )
+        {
+            const unsigned char* source = pixels + (size_t) y * width * 4;
+            for ( int x = 0; x < width; x++ )
+            {
+                destination[0] = source[0];
+                destination[1] = source[1];
+                destination[2] = source[2];
+                destination += 3;
+                source += 4;
+            }
+        }
+        written = rows.size( );
+        return fwrite( rows.data( ), 1, rows.size( ), file ) == rows.size( );
+    }
+}
+
+namespace ImageEncoder
+{
+    bool write( const char* path, ImageFormat format, const unsigned char* pixels, int width, int height, int compressionLevel )
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now( );
+        if ( width <= 0 || height <= 0 || ( format == ImageFormat::TGA && ( width > 0xffff || height > 0xffff ) ) )
+            return false;
+
+        FILE* file = fopen( path, "wb" );
+        if ( !file )
+            return false;
+
+        size_t written = 0;
+        bool success;
+        switch ( format )
+        {
+        case ImageFormat::PNG:
+            success = writePng( file, pixels, width, height, compressionLevel, written );
+            break;
+        case ImageFormat::TGA:
+            success = writeTga( file, pixels, width, height, written );
+            break;
+        default:
+            success = writeRaw( file, pixels, width, height, written );
+            break;
+        }
+        success = fclose( file ) == 0 && success;
+
+        if ( success )
+        {
+            encodedImages.fetch_add( 1, std::memory_order_relaxed );
+            encodedBytes.fetch_add( written, std::memory_order_relaxed );
+        }
+        encodeNanoseconds.fetch_add( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now( ) - start ).count( ),
+                                     std::memory_order_relaxed );
+        return success;
+    }
+
+    const char* extension( ImageFormat format )
+    {
+        switch ( format )
+        {
+        case ImageFormat::PNG:
+            return "png";
+        case ImageFormat::TGA:
+            return "tga";
+        default:
+            return "rgb";
+        }
+    }
+
+    void report( std::ostream& out )
+    {
+        unsigned long long images = encodedImages.load( );
+        if ( images == 0 )
+            return;
+        out << "Image encoding: " << images << " images, " << encodedBytes.load( ) / 1024 << " KB written, "
+            << encodeNanoseconds.load( ) / 1000000.0 / images << " ms per image (all threads)" << std::endl;
+    }
+}
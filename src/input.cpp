@@ -0,0 +1,79 @@
+#include "learnopengl-implementation/input.h"
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+
+InputQueue::InputQueue( GLFWwindow* window )
+{
+    glfwSetWindowUserPointer( window, this );
+    glfwSetKeyCallback( window, keyCallback );
+}
+
+bool InputQueue::pop( InputEvent& event )
+{
+    return events.pop( event );
+}
+
+unsigned long long InputQueue::droppedEvents( ) const
+{
+    return dropped.load( std::memory_order_relaxed );
+}
+
+// runs inside glfwPollEvents, on the thread that polls
+void InputQueue::keyCallback( GLFWwindow* window, int key, int, int action, int )
+{
+    InputQueue* queue = (InputQueue*) glfwGetWindowUserPointer( window );
+    if ( !queue->events.push( InputEvent{ glfwGetTime( ), key, action } ) )
+        queue->dropped.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void InputState::update( InputQueue& queue, double now )
+{
+    pressed.reset( );
+    std::fill( held, held + KEY_COUNT, 0.0 );
+
+    InputEvent event;
+    while ( queue.pop( event ) )
+    {
+        if ( event.key < 0 || event.key >= KEY_COUNT )
+            continue;
+
+        // an event is never accounted outside the interval being simulated
+        double time = std::min( std::max( event.time, lastUpdate ), now );
+        if ( event.action == GLFW_PRESS && !down[event.key] )
+        {
+            down[event.key] = true;
+            pressed[event.key] = true;
+            downSince[event.key] = time;
+        }
+        else if ( event.action == GLFW_RELEASE && down[event.key] )
+        {
+            down[event.key] = false;
+            held[event.key] += time - std::max( downSince[event.key], lastUpdate );
+        }
+    }
+
+    // keys still held count up to now
+    for ( int key = 0; key < KEY_COUNT; key++ )
+    {
+        if ( down[key] )
+            held[key] += now - std::max( downSince[key], lastUpdate );
+    }
+    lastUpdate = now;
+}
+
+bool InputState::isDown( int key ) const
+{
+    return key >= 0 && key < KEY_COUNT && down[key];
+}
+
+bool InputState::wasPressed( int key ) const
+{
+    return key >= 0 && key < KEY_COUNT && pressed[key];
+}
+
+double InputState::heldTime( int key ) const
+{
+    return key >= 0 && key < KEY_COUNT ? held[key] : 0.0;
+}
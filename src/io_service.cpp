@@ -0,0 +1,408 @@
+#include "learnopengl-implementation/io_service.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+// the raw interface, liburing is not needed for the handful of calls used here
+struct IoService::Ring
+{
+    int fd = -1;
+    unsigned int entries = 0;
+
+    void* sqMap = MAP_FAILED;
+    size_t sqMapSize = 0;
+    void* cqMap = MAP_FAILED;
+    size_t cqMapSize = 0;
+    io_uring_sqe* sqes = (io_uring_sqe*) MAP_FAILED;
+    size_t sqesSize = 0;
+
+    unsigned int* sqHead;
+    unsigned int* sqTail;
+    unsigned int* sqMask;
+    unsigned int* sqArray;
+    unsigned int* cqHead;
+    unsigned int* cqTail;
+    unsigned int* cqMask;
+    io_uring_cqe* cqes;
+};
+
+namespace
+{
+    double now( )
+    {
+        return std::chrono::duration<double>( std::chrono::steady_clock::now( ).time_since_epoch( ) ).count( );
+    }
+
+    // completion of requests that did not ask for one, keeps the counter semantics
+    void noCompletion( void*, unsigned int, unsigned int )
+    {
+    }
+
+    int ringEnter( int fd, unsigned int submit, unsigned int wait, unsigned int flags )
+    {
+        int result;
+        do
+        {
+            result = (int) syscall( __NR_io_uring_enter, fd, submit, wait, flags, nullptr, 0 );
+        } while ( result < 0 && errno == EINTR );
+        return result;
+    }
+}
+
+IoService::IoService( JobSystem& jobs, const Settings& settings ) : jobs( jobs ), settings( settings )
+{
+    if ( this->settings.queueDepth == 0 )
+        this->settings.queueDepth = 1;
+    if ( this->settings.fallbackThreads == 0 )
+        this->settings.fallbackThreads = 1;
+
+    // page aligned so the kernel can pin them
+    size_t bufferBytes = ( this->settings.bufferCount * this->settings.bufferSize + 4095 ) & ~(size_t) 4095;
+    if ( bufferBytes > 0 )
+        buffers = static_cast<unsigned char*>( aligned_alloc( 4096, bufferBytes ) );
+    for ( int i = (int) this->settings.bufferCount - 1; buffers && i >= 0; i-- )
+        freeBuffers.push_back( i );
+
+    if ( !this->settings.forceFallback && setupRing( ) )
+    {
+        reaped.reserve( 2 * ring->entries );
+        threads.emplace_back( &IoService::reapLoop, this );
+    }
+    else
+    {
+        for ( unsigned int i = 0; i < this->settings.fallbackThreads; i++ )
+            threads.emplace_back( &IoService::fallbackLoop, this );
+    }
+}
+
+IoService::~IoService( )
+{
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        running = false;
+
+        // an empty completion wakes the reaping thread up
+        if ( ring )
+        {
+            unsigned int tail = *ring->sqTail;
+            unsigned int index = tail & *ring->sqMask;
+            io_uring_sqe* sqe = &ring->sqes[index];
+            memset( sqe, 0, sizeof( *sqe ) );
+            sqe->opcode = IORING_OP_NOP;
+            sqe->user_data = 0;
+            ring->sqArray[index] = index;
+            __atomic_store_n( ring->sqTail, tail + 1, __ATOMIC_RELEASE );
+            ringEnter( ring->fd, 1, 0, 0 );
+        }
+    }
+    pendingChanged.notify_all( );
+    for ( std::thread& thread : threads )
+        thread.join( );
+
+    destroyRing( );
+    free( buffers );
+}
+
+void IoService::destroyRing( )
+{
+    if ( !ring )
+        return;
+    if ( ring->sqes != MAP_FAILED )
+        munmap( ring->sqes, ring->sqesSize );
+    if ( ring->cqMap != MAP_FAILED && ring->cqMap != ring->sqMap )
+        munmap( ring->cqMap, ring->cqMapSize );
+    if ( ring->sqMap != MAP_FAILED )
+        munmap( ring->sqMap, ring->sqMapSize );
+    if ( ring->fd >= 0 )
+        close( ring->fd );
+    delete ring;
+    ring = nullptr;
+}
+
+bool IoService::setupRing( )
+{
+    io_uring_params params;
+    memset( &params, 0, sizeof( params ) );
+    int fd = (int) syscall( __NR_io_uring_setup, settings.queueDepth, &params );
+    if ( fd < 0 )
+        return false;
+
+    ring = new Ring;
+    ring->fd = fd;
+    ring->entries = params.sq_entries;
+    ring->sqMapSize = params.sq_off.array + params.sq_entries * sizeof( unsigned int );
+    ring->cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+    if ( params.features & IORING_FEAT_SINGLE_MMAP )
+        ring->sqMapSize = ring->cqMapSize = ring->sqMapSize > ring->cqMapSize ? ring->sqMapSize : ring->cqMapSize;
+
+    ring->sqMap = mmap( nullptr, ring->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+    if ( params.features & IORING_FEAT_SINGLE_MMAP )
+        ring->cqMap = ring->sqMap;
+    else
+        ring->cqMap = mmap( nullptr, ring->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+    ring->sqesSize = params.sq_entries * sizeof( io_uring_sqe );
+    ring->sqes = (io_uring_sqe*) mmap( nullptr, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if ( ring->sqMap == MAP_FAILED || ring->cqMap == MAP_FAILED || ring->sqes == MAP_FAILED )
+    {
+        destroyRing( );
+        return false;
+    }
+
+    unsigned char* sq = static_cast<unsigned char*>( ring->sqMap );
+    unsigned char* cq = static_cast<unsigned char*>( ring->cqMap );
+    ring->sqHead = (unsigned int*) ( sq + params.sq_off.head );
+    ring->sqTail = (unsigned int*) ( sq + params.sq_off.tail );
+    ring->sqMask = (unsigned int*) ( sq + params.sq_off.ring_mask );
+    ring->sqArray = (unsigned int*) ( sq + params.sq_off.array );
+    ring->cqHead = (unsigned int*) ( cq + params.cq_off.head );
+    ring->cqTail = (unsigned int*) ( cq + params.cq_off.tail );
+    ring->cqMask = (unsigned int*) ( cq + params.cq_off.ring_mask );
+    ring->cqes = (io_uring_cqe*) ( cq + params.cq_off.cqes );
+
+    // never more reads in flight than submission slots
+    if ( settings.queueDepth > ring->entries )
+        settings.queueDepth = ring->entries;
+
+    // registered buffers skip the page pinning of every read, failing to register
+    // them ( e.g. over RLIMIT_MEMLOCK ) only means the plain reads are used
+    if ( buffers )
+    {
+        std::vector<iovec> vectors( settings.bufferCount );
+        for ( unsigned int i = 0; i < settings.bufferCount; i++ )
+        {
+            vectors[i].iov_base = buffers + i * settings.bufferSize;
+            vectors[i].iov_len = settings.bufferSize;
+        }
+        registeredBuffers = syscall( __NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, vectors.data( ), settings.bufferCount ) == 0;
+    }
+    return true;
+}
+
+void IoService::submit( IoRequest* request, JobCounter* counter )
+{
+    request->buffer = nullptr;
+    request->result = 0;
+    request->bufferIndex = -1;
+    request->done = 0;
+    request->counter = counter;
+    request->submitTime = now( );
+    if ( counter )
+        jobs.beginExternal( counter );
+
+    if ( !request->destination && request->size > settings.bufferSize )
+    {
+        // could never get a buffer, failing it instead of blocking the queue
+        request->result = -EINVAL;
+        complete( request );
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        pending.push_back( request );
+        if ( ring )
+            issuePending( );
+    }
+    if ( !ring )
+        pendingChanged.notify_one( );
+}
+
+void IoService::releaseBuffer( IoRequest* request )
+{
+    if ( request->bufferIndex < 0 )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        freeBuffers.push_back( request->bufferIndex );
+        request->bufferIndex = -1;
+        request->buffer = nullptr;
+        if ( ring )
+            issuePending( );
+    }
+    if ( !ring )
+        pendingChanged.notify_all( );
+}
+
+bool IoService::usesIoUring( ) const
+{
+    return ring != nullptr;
+}
+
+void IoService::issuePending( )
+{
+    unsigned int issued = 0;
+    while ( !pending.empty( ) && inFlight < settings.queueDepth )
+    {
+        // keeping the submission order, a request waiting for a buffer holds back the rest
+        if ( !issue( pending.front( ) ) )
+            break;
+        pending.pop_front( );
+        inFlight++;
+        issued++;
+    }
+
+    // one system call for the whole batch
+    if ( issued > 0 )
+        ringEnter( ring->fd, issued, 0, 0 );
+}
+
+bool IoService::issue( IoRequest* request )
+{
+    if ( !request->destination && request->bufferIndex < 0 )
+    {
+        if ( freeBuffers.empty( ) )
+            return false;
+        request->bufferIndex = freeBuffers.back( );
+        freeBuffers.pop_back( );
+    }
+    unsigned char* target = request->destination ? static_cast<unsigned char*>( request->destination )
+                                                  : buffers + request->bufferIndex * settings.bufferSize;
+    request->buffer = target;
+
+    if ( !ring )
+        return true;
+
+    unsigned int tail = *ring->sqTail;
+    unsigned int index = tail & *ring->sqMask;
+    io_uring_sqe* sqe = &ring->sqes[index];
+    memset( sqe, 0, sizeof( *sqe ) );
+    sqe->fd = request->file;
+    sqe->off = request->offset + request->done;
+    sqe->user_data = (unsigned long long) (uintptr_t) request;
+    if ( request->bufferIndex >= 0 && registeredBuffers )
+    {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->addr = (unsigned long long) (uintptr_t) ( target + request->done );
+        sqe->len = (unsigned int) ( request->size - request->done );
+        sqe->buf_index = (unsigned short) request->bufferIndex;
+    }
+    else
+    {
+        request->vector.iov_base = target + request->done;
+        request->vector.iov_len = request->size - request->done;
+        sqe->opcode = IORING_OP_READV;
+        sqe->addr = (unsigned long long) (uintptr_t) &request->vector;
+        sqe->len = 1;
+    }
+    ring->sqArray[index] = index;
+    __atomic_store_n( ring->sqTail, tail + 1, __ATOMIC_RELEASE );
+    return true;
+}
+
+void IoService::complete( IoRequest* request )
+{
+    // counted here, the request may be gone as soon as its completion ran
+    completedRequests.fetch_add( 1, std::memory_order_relaxed );
+    if ( request->result > 0 )
+        completedBytes.fetch_add( request->result, std::memory_order_relaxed );
+    latencyMicroseconds.fetch_add( (unsigned long long) ( ( now( ) - request->submitTime ) * 1000000.0 ), std::memory_order_relaxed );
+
+    JobCounter* counter = request->counter;
+    jobs.run( request->completion ? request->completion : noCompletion, request->data, 0, 0, counter );
+    if ( counter )
+        jobs.endExternal( counter );
+}
+
+void IoService::reapLoop( )
+{
+    std::unique_lock<std::mutex> lock( mutex );
+    while ( running || inFlight > 0 || !pending.empty( ) )
+    {
+        lock.unlock( );
+        ringEnter( ring->fd, 0, 1, IORING_ENTER_GETEVENTS );
+        lock.lock( );
+
+        unsigned int head = *ring->cqHead;
+        unsigned int tail = __atomic_load_n( ring->cqTail, __ATOMIC_ACQUIRE );
+        for ( ; head != tail; head++ )
+        {
+            io_uring_cqe* cqe = &ring->cqes[head & *ring->cqMask];
+            IoRequest* request = (IoRequest*) (uintptr_t) cqe->user_data;
+            if ( !request )
+                continue;
+            inFlight--;
+
+            if ( cqe->res > 0 && request->done + cqe->res < request->size )
+            {
+                // short read, the rest goes back to the front of the queue
+                request->done += cqe->res;
+                pending.push_front( request );
+                continue;
+            }
+            request->result = cqe->res < 0 ? cqe->res : (long long) ( request->done + cqe->res );
+            reaped.push_back( request );
+        }
+        __atomic_store_n( ring->cqHead, head, __ATOMIC_RELEASE );
+
+        issuePending( );
+
+        if ( !reaped.empty( ) )
+        {
+            lock.unlock( );
+            for ( IoRequest* request : reaped )
+                complete( request );
+            reaped.clear( );
+            lock.lock( );
+        }
+    }
+}
+
+void IoService::fallbackLoop( )
+{
+    std::unique_lock<std::mutex> lock( mutex );
+    while ( true )
+    {
+        pendingChanged.wait( lock, [this]( ) {
+            return ( !pending.empty( ) && ( pending.front( )->destination || !freeBuffers.empty( ) ) ) ||
+                   ( !running && pending.empty( ) );
+        } );
+        if ( pending.empty( ) )
+            break;
+
+        IoRequest* request = pending.front( );
+        pending.pop_front( );
+        issue( request );
+        inFlight++;
+        lock.unlock( );
+
+        // blocking reads until everything arrived, the end of the file or an error
+        unsigned char* target = static_cast<unsigned char*>( request->buffer );
+        while ( request->done < request->size )
+        {
+            ssize_t count = pread( request->file, target + request->done, request->size - request->done, request->offset + request->done );
+            if ( count < 0 && errno == EINTR )
+                continue;
+            if ( count <= 0 )
+            {
+                if ( count < 0 )
+                    request->result = -errno;
+                break;
+            }
+            request->done += count;
+        }
+        if ( request->result == 0 )
+            request->result = request->done;
+
+        complete( request );
+        lock.lock( );
+        inFlight--;
+    }
+}
+
+void IoService::report( std::ostream& out ) const
+{
+    unsigned long long requests = completedRequests.load( );
+    if ( requests == 0 )
+        return;
+    out << "File I/O (" << ( ring ? ( registeredBuffers ? "io_uring, registered buffers" : "io_uring" ) : "pread threads" ) << "): "
+        << requests << " reads, " << completedBytes.load( ) / 1024 << " KB, "
+        << latencyMicroseconds.load( ) / 1000.0 / requests << " ms mean latency" << std::endl;
+}
@@ -0,0 +1,401 @@
+#include "learnopengl-implementation/job_system.h"
+
+#include <chrono>
+
+namespace
+{
+    // every deque and the job pool hold this many jobs per thread
+    const unsigned int JOBS_PER_THREAD = 4096;
+    // failed fetches before an idle worker goes to sleep
+    const unsigned int IDLE_SPINS = 64;
+
+    // worker index of the calling thread, only valid when currentSystem matches
+    thread_local const JobSystem* currentSystem = nullptr;
+    thread_local unsigned int currentIndex = 0;
+    // xorshift state for picking the first victim to steal from, never zero
+    thread_local unsigned int stealState = 0x9e3779b9u;
+
+    unsigned int nextRandom( )
+    {
+        stealState ^= stealState << 13;
+        stealState ^= stealState >> 17;
+        stealState ^= stealState << 5;
+        return stealState;
+    }
+
+    void lockCounter( JobCounter* counter )
+    {
+        while ( counter->lock.test_and_set( std::memory_order_acquire ) )
+            std::this_thread::yield( );
+    }
+
+    void unlockCounter( JobCounter* counter )
+    {
+        counter->lock.clear( std::memory_order_release );
+    }
+}
+
+WorkStealingDeque::WorkStealingDeque( unsigned int capacity ) : jobs( capacity ), mask( capacity - 1 )
+{
+}
+
+bool WorkStealingDeque::push( Job* job )
+{
+    long long b = bottom.load( std::memory_order_relaxed );
+    long long t = top.load( std::memory_order_acquire );
+    if ( b - t > (long long) mask )
+        return false;
+
+    jobs[b & mask].store( job, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    bottom.store( b + 1, std::memory_order_relaxed );
+    return true;
+}
+
+Job* WorkStealingDeque::pop( )
+{
+    long long b = bottom.load( std::memory_order_relaxed ) - 1;
+    bottom.store( b, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    long long t = top.load( std::memory_order_relaxed );
+
+    if ( t > b )
+    {
+        // empty
+        bottom.store( b + 1, std::memory_order_relaxed );
+        return nullptr;
+    }
+
+    Job* job = jobs[b & mask].load( std::memory_order_relaxed );
+    if ( t == b )
+    {
+        // last job, race the thieves for it
+        if ( !top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+            job = nullptr;
+        bottom.store( b + 1, std::memory_order_relaxed );
+    }
+    return job;
+}
+
+Job* WorkStealingDeque::steal( )
+{
+    long long t = top.load( std::memory_order_acquire );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    long long b = bottom.load( std::memory_order_acquire );
+    if ( t >= b )
+        return nullptr;
+
+    Job* job = jobs[t & mask].load( std::memory_order_relaxed );
+    if ( !top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+        return nullptr;
+    return job;
+}
+
+JobSystem::JobSystem( unsigned int workerThreads )
+{
+    if ( workerThreads == 0 )
+    {
+        unsigned int hardware = std::thread::hardware_concurrency( );
+        workerThreads = hardware > 1 ? hardware - 1 : 0;
+    }
+
+    unsigned int count = workerThreads + 1;
+    jobPool.resize( JOBS_PER_THREAD * count );
+    jobLive = std::vector<std::atomic<bool>>( jobPool.size( ) );
+    injected.reserve( JOBS_PER_THREAD );
+    pinned.reserve( JOBS_PER_THREAD );
+    pinnedExecuting.reserve( JOBS_PER_THREAD );
+    for ( unsigned int i = 0; i < count; i++ )
+        deques.push_back( new WorkStealingDeque( JOBS_PER_THREAD ) );
+
+    // the constructing thread is worker 0
+    currentSystem = this;
+    currentIndex = 0;
+    pinnedThread = std::this_thread::get_id( );
+
+    for ( unsigned int i = 1; i < count; i++ )
+        threads.emplace_back( &JobSystem::workerLoop, this, i );
+}
+
+JobSystem::~JobSystem( )
+{
+    running = false;
+    wakeUp.notify_all( );
+    for ( std::thread& thread : threads )
+        thread.join( );
+    for ( WorkStealingDeque* deque : deques )
+        delete deque;
+    if ( currentSystem == this )
+        currentSystem = nullptr;
+}
+
+unsigned int JobSystem::threadCount( ) const
+{
+    return (unsigned int) deques.size( );
+}
+
+void JobSystem::run( JobFunction function, void* data, unsigned int begin, unsigned int end,
+                     JobCounter* counter, JobCounter* dependency )
+{
+    Job* job = allocate( );
+    job->function = function;
+    job->data = data;
+    job->begin = begin;
+    job->end = end;
+    job->counter = counter;
+    job->next = nullptr;
+    job->pinned = false;
+    if ( counter )
+        counter->value.fetch_add( 1, std::memory_order_relaxed );
+    submit( job, dependency );
+}
+
+void JobSystem::runPinned( JobFunction function, void* data, JobCounter* counter, JobCounter* dependency )
+{
+    Job* job = allocate( );
+    job->function = function;
+    job->data = data;
+    job->begin = 0;
+    job->end = 0;
+    job->counter = counter;
+    job->next = nullptr;
+    job->pinned = true;
+    if ( counter )
+        counter->value.fetch_add( 1, std::memory_order_relaxed );
+    submit( job, dependency );
+}
+
+void JobSystem::beginExternal( JobCounter* counter )
+{
+    counter->value.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void JobSystem::endExternal( JobCounter* counter )
+{
+    finish( counter );
+}
+
+void JobSystem::wait( JobCounter* counter )
+{
+    bool isPinnedThread;
+    {
+        std::lock_guard<std::mutex> lock( pinnedMutex );
+        isPinnedThread = std::this_thread::get_id( ) == pinnedThread;
+    }
+    while ( counter->value.load( std::memory_order_acquire ) > 0 || counter->finishing.load( std::memory_order_acquire ) > 0 )
+    {
+        if ( isPinnedThread )
+            executePinned( );
+
+        Job* job = fetch( );
+        if ( job )
+            execute( job );
+        else
+            std::this_thread::yield( );
+    }
+}
+
+bool JobSystem::isDone( JobCounter* counter ) const
+{
+    return counter->value.load( std::memory_order_acquire ) == 0 && counter->finishing.load( std::memory_order_acquire ) == 0;
+}
+
+void JobSystem::executePinned( )
+{
+    {
+        std::lock_guard<std::mutex> lock( pinnedMutex );
+        if ( pinned.empty( ) )
+            return;
+        pinnedExecuting.swap( pinned );
+    }
+
+    for ( Job* job : pinnedExecuting )
+        execute( job );
+    pinnedExecuting.clear( );
+}
+
+void JobSystem::setPinnedThread( )
+{
+    std::lock_guard<std::mutex> lock( pinnedMutex );
+    pinnedThread = std::this_thread::get_id( );
+}
+
+Job* JobSystem::allocate( )
+{
+    unsigned int size = (unsigned int) jobPool.size( );
+    for ( ;; )
+    {
+        for ( unsigned int attempt = 0; attempt < size; attempt++ )
+        {
+            unsigned int index = nextJob.fetch_add( 1, std::memory_order_relaxed ) % size;
+            bool live = false;
+            if ( jobLive[index].compare_exchange_strong( live, true, std::memory_order_acquire, std::memory_order_relaxed ) )
+                return &jobPool[index];
+        }
+
+        // every slot holds a job that has not run yet, help until one frees up
+        bool isPinnedThread;
+        {
+            std::lock_guard<std::mutex> lock( pinnedMutex );
+            isPinnedThread = std::this_thread::get_id( ) == pinnedThread;
+        }
+        if ( isPinnedThread )
+            executePinned( );
+
+        Job* job = fetch( );
+        if ( job )
+            execute( job );
+        else
+            std::this_thread::yield( );
+    }
+}
+
+void JobSystem::submit( Job* job, JobCounter* dependency )
+{
+    if ( dependency )
+    {
+        lockCounter( dependency );
+        if ( dependency->value.load( std::memory_order_acquire ) > 0 )
+        {
+            // released by execute( ) when the last job of the dependency finishes
+            job->next = dependency->continuations;
+            dependency->continuations = job;
+            unlockCounter( dependency );
+            return;
+        }
+        unlockCounter( dependency );
+    }
+    schedule( job );
+}
+
+void JobSystem::schedule( Job* job )
+{
+    if ( job->pinned )
+    {
+        std::lock_guard<std::mutex> lock( pinnedMutex );
+        pinned.push_back( job );
+        return;
+    }
+
+    if ( currentSystem == this )
+    {
+        // a full deque just means the job runs right away
+        if ( !deques[currentIndex]->push( job ) )
+        {
+            execute( job );
+            return;
+        }
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock( injectedMutex );
+        injected.push_back( job );
+    }
+
+    if ( sleeping.load( std::memory_order_relaxed ) > 0 )
+        wakeUp.notify_one( );
+}
+
+void JobSystem::execute( Job* job )
+{
+    JobCounter* counter = job->counter;
+    job->function( job->data, job->begin, job->end );
+    // the slot can be reused from here on, only the counter is still needed
+    jobLive[job - jobPool.data( )].store( false, std::memory_order_release );
+    if ( counter )
+        finish( counter );
+}
+
+void JobSystem::finish( JobCounter* counter )
+{
+    counter->finishing.fetch_add( 1, std::memory_order_relaxed );
+    if ( counter->value.fetch_sub( 1, std::memory_order_acq_rel ) != 1 )
+    {
+        counter->finishing.fetch_sub( 1, std::memory_order_release );
+        return;
+    }
+
+    // last job of the group, release whatever was waiting on it
+    lockCounter( counter );
+    Job* continuation = counter->continuations;
+    counter->continuations = nullptr;
+    unlockCounter( counter );
+    counter->finishing.fetch_sub( 1, std::memory_order_release );
+
+    while ( continuation )
+    {
+        Job* next = continuation->next;
+        schedule( continuation );
+        continuation = next;
+    }
+}
+
+Job* JobSystem::fetch( )
+{
+    unsigned int count = threadCount( );
+    unsigned int self = currentSystem == this ? currentIndex : 0;
+
+    if ( currentSystem == this )
+    {
+        Job* job = deques[self]->pop( );
+        if ( job )
+            return job;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock( injectedMutex, std::try_to_lock );
+        if ( lock.owns_lock( ) && !injected.empty( ) )
+        {
+            Job* job = injected.back( );
+            injected.pop_back( );
+            return job;
+        }
+    }
+
+    // steal, starting at a random victim so the thieves spread out
+    unsigned int first = nextRandom( ) % count;
+    for ( unsigned int i = 0; i < count; i++ )
+    {
+        unsigned int victim = ( first + i ) % count;
+        if ( currentSystem == this && victim == self )
+            continue;
+        Job* job = deques[victim]->steal( );
+        if ( job )
+            return job;
+    }
+    return nullptr;
+}
+
+void JobSystem::workerLoop( unsigned int index )
+{
+    currentSystem = this;
+    currentIndex = index;
+    stealState = 0x9e3779b9u * ( index + 1 );
+
+    unsigned int idle = 0;
+    while ( running.load( std::memory_order_relaxed ) )
+    {
+        Job* job = fetch( );
+        if ( job )
+        {
+            execute( job );
+            idle = 0;
+            continue;
+        }
+
+        if ( ++idle < IDLE_SPINS )
+        {
+            std::this_thread::yield( );
+            continue;
+        }
+
+        // the timeout covers a wake up racing with the sleeping counter
+        sleeping.fetch_add( 1 );
+        {
+            std::unique_lock<std::mutex> lock( sleepMutex );
+            wakeUp.wait_for( lock, std::chrono::milliseconds( 1 ) );
+        }
+        sleeping.fetch_sub( 1 );
+        idle = 0;
+    }
+}
@@ -0,0 +1,53 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// view space position and radius of the light, its color with the cosine of the inner
+// cone angle, and the cone's axis with the cosine of the outer angle
+flat in vec4 positionRadius;
+flat in vec4 color;
+flat in vec4 spot;
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+uniform vec2 viewportSize;
+
+vec3 decodeNormal( vec2 e )
+{
+    vec3 n = vec3( e, 1.0 - abs( e.x ) - abs( e.y ) );
+    float t = max( -n.z, 0.0 );
+    n.xy += vec2( n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t );
+    return normalize( n );
+}
+
+void main( )
+{
+    ivec2 pixel = ivec2( gl_FragCoord.xy );
+    float depth = texelFetch( gDepth, pixel, 0 ).r;
+    if ( depth == 1.0 )
+        discard;
+    vec4 position = inverseProjection * vec4( gl_FragCoord.xy / viewportSize * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0 );
+    position.xyz /= position.w;
+
+    // the rectangle bounds the light on screen only, the depth range and the cone are checked here
+    vec3 toLight = positionRadius.xyz - position.xyz;
+    float distance = length( toLight );
+    if ( distance >= positionRadius.w )
+        discard;
+    vec3 n = decodeNormal( texelFetch( gNormal, pixel, 0 ).rg );
+    vec3 l = toLight / distance;
+    float diffuse = dot( n, l );
+    float cone = clamp( ( dot( -l, spot.xyz ) - spot.w ) / max( color.w - spot.w, 0.0001 ), 0.0, 1.0 );
+    if ( diffuse <= 0.0 || cone <= 0.0 )
+        discard;
+
+    // inverse square falloff windowed to reach zero at the radius
+    float window = clamp( 1.0 - pow( distance / positionRadius.w, 4.0 ), 0.0, 1.0 );
+    float falloff = window * window / ( distance * distance + 1.0 ) * cone;
+    vec3 h = normalize( l + normalize( -position.xyz ) );
+    float specular = pow( max( dot( n, h ), 0.0 ), 32.0 ) * 0.25;
+    vec3 albedo = texelFetch( gAlbedo, pixel, 0 ).rgb;
+    FragColor = vec4( ( albedo + specular ) * diffuse * falloff * color.rgb, 0.0 );
+}
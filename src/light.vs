@@ -0,0 +1,20 @@
+#version 330 core
+
+// one quad per light over the screen rectangle its bounds project to
+layout ( location = 0 ) in vec2 aCorner;
+layout ( location = 1 ) in vec4 aRectangle;
+layout ( location = 2 ) in vec4 aPositionRadius;
+layout ( location = 3 ) in vec4 aColor;
+layout ( location = 4 ) in vec4 aSpot;
+
+flat out vec4 positionRadius;
+flat out vec4 color;
+flat out vec4 spot;
+
+void main( )
+{
+    gl_Position = vec4( mix( aRectangle.xy, aRectangle.zw, aCorner ), 0.0f, 1.0f );
+    positionRadius = aPositionRadius;
+    color = aColor;
+    spot = aSpot;
+}
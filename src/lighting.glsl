@@ -0,0 +1,54 @@
+// the forward path's lighting of a fragment: ambient, the sun with its shadows ( shadows.glsl
+// comes first ) and the clustered point and spot lights
+
+// clustered lighting ( see ClusteredLighting ), off leaves the cubes unlit
+uniform bool lighting;
+// three texels per light: view space position and radius, color and the cosine of the
+// inner cone angle, cone axis and the cosine of the outer cone angle
+uniform samplerBuffer lightData;
+// offset and count of each cluster's list in lightIndices
+uniform usamplerBuffer clusters;
+uniform usamplerBuffer lightIndices;
+uniform ivec3 clusterGrid;
+// near plane, slices / log( far / near )
+uniform vec2 clusterDepth;
+uniform mat4 inverseProjection;
+uniform vec2 viewportSize;
+uniform vec3 ambient;
+// view space direction toward the sun
+uniform vec3 sunDirection;
+uniform vec3 sunColor;
+
+vec3 shade( vec3 albedo )
+{
+    // the mesh has no normals, the faces are flat so the slope of the position gives them
+    vec4 position = inverseProjection * vec4( gl_FragCoord.xy / viewportSize * 2.0 - 1.0, gl_FragCoord.z * 2.0 - 1.0, 1.0 );
+    position.xyz /= position.w;
+    vec3 n = normalize( cross( dFdx( position.xyz ), dFdy( position.xyz ) ) );
+    vec3 v = normalize( -position.xyz );
+    vec3 result = albedo * ( ambient + sunColor * max( dot( n, sunDirection ), 0.0 ) * sunVisibility( position.xyz ) );
+
+    ivec2 tile = ivec2( gl_FragCoord.xy / viewportSize * vec2( clusterGrid.xy ) );
+    int slice = int( log( -position.z / clusterDepth.x ) * clusterDepth.y );
+    ivec3 cluster = clamp( ivec3( tile, slice ), ivec3( 0 ), clusterGrid - 1 );
+    uvec2 range = texelFetch( clusters, ( cluster.z * clusterGrid.y + cluster.y ) * clusterGrid.x + cluster.x ).rg;
+    for ( uint i = 0u; i < range.y; i++ )
+    {
+        int index = int( texelFetch( lightIndices, int( range.x + i ) ).r ) * 3;
+        vec4 positionRadius = texelFetch( lightData, index );
+        vec4 color = texelFetch( lightData, index + 1 );
+        vec4 spot = texelFetch( lightData, index + 2 );
+
+        // the same light as light.fs of the deferred path
+        vec3 toLight = positionRadius.xyz - position.xyz;
+        float distance = length( toLight );
+        vec3 l = toLight / max( distance, 0.0001 );
+        float diffuse = max( dot( n, l ), 0.0 );
+        float cone = clamp( ( dot( -l, spot.xyz ) - spot.w ) / max( color.w - spot.w, 0.0001 ), 0.0, 1.0 );
+        float window = clamp( 1.0 - pow( distance / positionRadius.w, 4.0 ), 0.0, 1.0 );
+        float falloff = window * window / ( distance * distance + 1.0 ) * cone;
+        float specular = pow( max( dot( n, normalize( l + v ) ), 0.0 ), 32.0 ) * 0.25;
+        result += ( albedo + specular ) * diffuse * falloff * color.rgb;
+    }
+    return result;
+}
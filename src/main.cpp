@@ -1,28 +1,159 @@
 #include <iostream>
 #include <cmath>
+#include <cstdlib>
+#include <cassert>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
-#include "learnopengl-implementation/shader.h"
-
-void processInput( GLFWwindow* );
+#include "learnopengl-implementation/transform.h"
+#include "learnopengl-implementation/matrix_kernels.h"
+#include "learnopengl-implementation/job_system.h"
+#include "learnopengl-implementation/culling.h"
+#include "learnopengl-implementation/triple_buffer.h"
+#include "learnopengl-implementation/frame_packet.h"
+#include "learnopengl-implementation/renderer.h"
+#include "learnopengl-implementation/frame_pacer.h"
+#include "learnopengl-implementation/input.h"
+#include "learnopengl-implementation/frame_allocator.h"
+#include "learnopengl-implementation/allocation_counter.h"
+#include "learnopengl-implementation/image_decoder.h"
+#include "learnopengl-implementation/asset_pack.h"
+#include "learnopengl-implementation/io_service.h"
+#include "learnopengl-implementation/image_encoder.h"
+
+// both set by the build, the pack is built next to the binary
+#ifndef ASSET_PACK_PATH
+#define ASSET_PACK_PATH "assets.pack"
+#endif
+#ifndef ASSET_ROOT
+#define ASSET_ROOT "."
+#endif
+
+// state shared between the simulation (main) thread and the render thread
+struct RenderContext
+{
+    GLFWwindow* window;
+    Renderer* renderer;
+    FramePacer* pacer;
+    TripleBuffer<FramePacket> packets;
+
+    // frameIndex of the last packet published/picked up by the render thread
+    std::mutex mutex;
+    std::condition_variable consumed;
+    std::condition_variable published;
+    unsigned long long consumedFrame = 0;
+    unsigned long long publishedFrame = 0;
+    std::atomic<bool> quit{ false };
+    std::atomic<bool> ready{ false };
+
+    // heap allocations made by the presenting thread after the warm up frames
+    unsigned long long presentedFrames = 0;
+    unsigned long long presentAllocations = 0;
+};
+
+void processInput( GLFWwindow*, const InputState& );
 void framebuffer_size_callback( GLFWwindow*, int, int );
+void presentFrame( RenderContext&, const FramePacket& );
+void renderThread( RenderContext*, JobSystem* );
+bool parseArguments( int, char**, DepthPrepass::Mode&, unsigned int& );
 
 // settings
 const int SCREEN_WIDTH = 800;
 const int SCREEN_HEIGHT = 600;
+// submitting GL on its own thread lets the simulation of the next frame overlap the current one
+const bool USE_RENDER_THREAD = true;
+// files under ASSET_ROOT override the packed ones, for editing assets without rebuilding the pack
+const bool LOOSE_ASSETS = false;
+// hashes every packed asset against the table of contents at startup, reading the whole pack
+const bool VERIFY_ASSET_PACK = false;
+// frame pacing: GPU frames that may be queued, swap interval policy and frame time to sleep toward ( 0 = off )
+const unsigned int MAX_FRAMES_IN_FLIGHT = 2;
+const FramePacer::SwapMode SWAP_MODE = FramePacer::SwapMode::ADAPTIVE;
+const double TARGET_FRAME_TIME = 0.0;
+// texture memory the streamed mip levels may use
+const size_t TEXTURE_BUDGET = 64 * 1024 * 1024;
+// pages the container texture in through the feedback pass instead of streaming whole levels
+const bool USE_VIRTUAL_TEXTURING = true;
+// the scene is rendered at the resolution whose GPU time fits the budget, down to half the window size
+const bool DYNAMIC_RESOLUTION = true;
+const double GPU_BUDGET_MILLISECONDS = 14.0;
+// depth only pass ahead of the shading pass: OFF, ON, or AUTO to decide from the measured overdraw;
+// --depth-prepass off|on|auto overrides it
+const DepthPrepass::Mode DEPTH_PREPASS = DepthPrepass::Mode::AUTO;
+// benchmark scene for the pre-pass: walls of 9x7 cubes stacked behind the scene and drawn back
+// to front, every layer shades each covered pixel once more; --overdraw-layers <count> overrides
+// it. Stepping it up from 0 with the pre-pass off and on shows the break-even, which AUTO should
+// find on its own ( depth_prepass.h explains how to read it from the shutdown report )
+const unsigned int OVERDRAW_LAYERS = 0;
+// G-buffer pass lit afterwards by the lights orbiting the cubes, when off the forward pass is lit
+// through the clusters ( CLUSTERED_LIGHTING ) or stays unlit
+const bool DEFERRED_SHADING = false;
+const bool CLUSTERED_LIGHTING = true;
+const unsigned int POINT_LIGHTS = 32;
+const float POINT_LIGHT_RADIUS = 3.0f;
+// spot lights sweeping over the cubes from above
+const unsigned int SPOT_LIGHTS = 4;
+const float SPOT_LIGHT_RANGE = 8.0f;
+// sun shadows from cascaded shadow maps, the static cubes are only drawn into them again
+// when something invalidates them; off redraws them every frame for comparison
+const bool SUN_SHADOWS = true;
+const bool CACHE_STATIC_SHADOWS = true;
+// anti-aliasing the frames start with, 4 cycles through none, MSAA, FXAA, SMAA and TAA; the
+// shutdown report lists each mode's GPU time and memory for picking one per machine
+const AntiAliasingMode ANTI_ALIASING = AntiAliasingMode::FXAA;
+const int MSAA_SAMPLES = 4;
+// TAA renders the scene at this scale of the window at most and reconstructs the rest from
+// the jittered frames before, 0.5 to 0.75 stays close to the window resolution
+const float TAA_RENDER_SCALE = 0.67f;
+// camera facing textured quads floating around the cubes, blended over the scene without sorting
+// by weighted blended order independent transparency, or sorted back to front every frame; 5
+// switches between the two and the shutdown report compares them; transparency_benchmark runs
+// both over 100000 of them
+const unsigned int TRANSPARENT_QUADS = 2000;
+const TransparencyMode TRANSPARENCY = TransparencyMode::WEIGHTED_BLENDED;
+// F12 writes the next frame to disk, this writes every frame ( golden images, soak runs )
+const bool CAPTURE_EVERY_FRAME = false;
+const ImageFormat CAPTURE_FORMAT = ImageFormat::PNG;
+// records every frame into a Y4M stream, a file or "| <command>" ( e.g. "| ffmpeg -i - capture.mp4" );
+// with the queue full DROP skips frames and BLOCK stalls the frame loop until the oldest is written
+const bool RECORD_VIDEO = false;
+const char* const RECORD_OUTPUT = "capture.y4m";
+const VideoCapture::Policy RECORD_POLICY = VideoCapture::Policy::DROP;
+// frames allowed to allocate ( arena growth, first-use driver state ) before the steady state is enforced
+const unsigned long long ALLOCATION_WARMUP_FRAMES = 120;
+// mixValue change per second while UP/DOWN is held
+const float MIX_RATE = 0.5f;
 float mixValue = 0.2f;
+WireframeMode wireframe = WireframeMode::OFF;
+AntiAliasingMode antiAliasing = ANTI_ALIASING;
+TransparencyMode transparency = TRANSPARENCY;
+bool captureRequested = false;
+std::atomic<int> framebufferWidth{ SCREEN_WIDTH };
+std::atomic<int> framebufferHeight{ SCREEN_HEIGHT };
+
+int main( int argc, char** argv )
+{
+    DepthPrepass::Mode depthPrepass = DEPTH_PREPASS;
+    unsigned int overdrawLayers = OVERDRAW_LAYERS;
+    if ( !parseArguments( argc, argv, depthPrepass, overdrawLayers ) )
+    {
+        std::cout << "usage: " << argv[0] << " [--depth-prepass off|on|auto] [--overdraw-layers <count>]" << std::endl;
+        return -1;
+    }
 
-int main( )
-{    
     // initialize GLFW
     glfwInit( );
     // configure OpenGL's minor and major versions to be 3.3
@@ -40,305 +171,445 @@ int main( )
         return -1;
     }
 
-    // make the newly created window the main context of the current thread
-    glfwMakeContextCurrent( window );
     // passing to GLFW the window resize callback function
     glfwSetFramebufferSizeCallback( window, framebuffer_size_callback );
+    // key events are queued with their timestamps by the GLFW callbacks
+    InputQueue inputQueue( window );
+    InputState input;
 
-    // initializing GLAD
-    if ( !gladLoadGLLoader( (GLADloadproc)glfwGetProcAddress ) )
-    {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
-    }
+    // worker threads for transforms, culling and asset decoding
+    JobSystem jobs;
+    std::cout << "Job system: " << jobs.threadCount( ) << " threads" << std::endl;
 
-    // enabling depth test
-    glEnable( GL_DEPTH_TEST );
-
-    // creating a shader object
-    Shader ourShader( "/home/ryuugami/Projects/C++/learnopengl-implementation/src/shader.vs", 
-                      "/home/ryuugami/Projects/C++/learnopengl-implementation/src/shader.fs" );
-
-    // triangle vertices in normalized device coordinates
-    // float vertices[] = {
-    //     // positions          // texture coords
-    //      0.5f,  0.5f, 0.0f,   1.0f, 1.0f,   // top right
-    //      0.5f, -0.5f, 0.0f,   1.0f, 0.0f,   // bottom right
-    //     -0.5f, -0.5f, 0.0f,   0.0f, 0.0f,   // bottom left 
-    //     -0.5f,  0.5f, 0.0f,   0.0f, 1.0f    // top left
-    // };
-
-    float vertices[] = {
-        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-        0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
-        0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
-
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-        0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-        0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-
-        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        -0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-        0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-        0.5f, -0.5f, -0.5f,  1.0f, 1.0f,
-        0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-        0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
-
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
-        0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
-        0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 0.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f
-    };
+    std::cout << "Matrix kernels: " << MatrixKernels::name( MatrixKernels::current( ) ) << std::endl;
 
     glm::vec3 cubePositions[] = {
-        glm::vec3( 0.0f,  0.0f,  0.0f), 
-        glm::vec3( 2.0f,  5.0f, -15.0f), 
-        glm::vec3(-1.5f, -2.2f, -2.5f),  
-        glm::vec3(-3.8f, -2.0f, -12.3f),  
-        glm::vec3( 2.4f, -0.4f, -3.5f),  
-        glm::vec3(-1.7f,  3.0f, -7.5f),  
-        glm::vec3( 1.3f, -2.0f, -2.5f),  
-        glm::vec3( 1.5f,  2.0f, -2.5f), 
-        glm::vec3( 1.5f,  0.2f, -1.5f), 
-        glm::vec3(-1.3f,  1.0f, -1.5f)  
+        glm::vec3( 0.0f,  0.0f,  0.0f),
+        glm::vec3( 2.0f,  5.0f, -15.0f),
+        glm::vec3(-1.5f, -2.2f, -2.5f),
+        glm::vec3(-3.8f, -2.0f, -12.3f),
+        glm::vec3( 2.4f, -0.4f, -3.5f),
+        glm::vec3(-1.7f,  3.0f, -7.5f),
+        glm::vec3( 1.3f, -2.0f, -2.5f),
+        glm::vec3( 1.5f,  2.0f, -2.5f),
+        glm::vec3( 1.5f,  0.2f, -1.5f),
+        glm::vec3(-1.3f,  1.0f, -1.5f)
     };
 
-    unsigned int indices[] = {
-        0, 1, 3,    // first triangle
-        1, 2, 3     // second triangle
-    };
+    // creating one transform node per cube, only the animated ones get touched every frame
+    TransformSystem transforms;
+    const unsigned int cubeCount = 10 + overdrawLayers * 9 * 7;
+    std::vector<unsigned int> cubeNodes( cubeCount );
+    const glm::vec3 cubeAxis = glm::normalize( glm::vec3( 1.0f, 0.3f, 0.5f ) );
+    for ( unsigned int i = 0; i < 10; i++ )
+    {
+        cubeNodes[i] = transforms.create( );
+        transforms.setPosition( cubeNodes[i], cubePositions[i] );
+        transforms.setRotation( cubeNodes[i], glm::angleAxis( glm::radians( 20.0f * i ), cubeAxis ) );
+    }
+    // the farthest wall first, so that without a pre-pass every layer is shaded
+    for ( unsigned int i = 10; i < cubeCount; i++ )
+    {
+        unsigned int cube = i - 10;
+        unsigned int layer = overdrawLayers - 1 - cube / ( 9 * 7 );
+        cubeNodes[i] = transforms.create( );
+        transforms.setPosition( cubeNodes[i], glm::vec3( (float)( cube % 9 ) - 4.0f, (float)( cube / 9 % 7 ) - 3.0f, -1.0f - (float)layer ) );
+    }
 
-    // generating a Vertex Array Object to store the states that were set
-    unsigned int VAO;
-    glGenVertexArrays( 1, &VAO );
-    // generating a Vertex Buffer Object to be able to send the vertices data do the GPU
-    unsigned int VBO;
-    glGenBuffers( 1, &VBO );
-    // generating a Element Buffer Object to store the vertex indices to be part of a specified triangle
-    unsigned int EBO;
-    glGenBuffers( 1, &EBO );
-
-    // biding the Vertex Array Object (first)
-    glBindVertexArray( VAO );
-
-    // binding the newly generated Vertex Buffer Object with the GL_ARRAY_BUFFER of OpenGL (second)
-    glBindBuffer( GL_ARRAY_BUFFER, VBO );
-    // copying the previourly defined vertex data into the buffer's memory (third)
-    glBufferData( GL_ARRAY_BUFFER, sizeof( vertices ), vertices, GL_STATIC_DRAW );
-
-    // binding the newly generated Element Buffer Object with the GL_ELEMENT_ARRAY_BUFFER of OpenGL
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, EBO );
-    // copying the previously defined index data into the buffer's memory
-    glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( indices ), indices, GL_STATIC_DRAW );
-    
-    // teaching OpenGL how it should interpret the Vertex Data (fourth)
-    glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, 5*sizeof(float), (void*)0 );
-    glEnableVertexAttribArray( 0 );
-    glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, 5*sizeof(float), (void*)(3*sizeof(float)) );
-    glEnableVertexAttribArray( 1 );
-    // unbiding the current Vertex Buffer Object
-    glBindBuffer( GL_ARRAY_BUFFER, 0 );
-
-    // creating and biding multiple textures
-    unsigned int texture1, texture2;
-    glGenTextures( 1, &texture1 );
-    glGenTextures( 1, &texture2 );
-
-    // activating the first texture unit to bind to it
-    glBindTexture( GL_TEXTURE_2D, texture1 );
-    // setting texture wrap
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
-    // setting texture scaling
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-    // setting mipmap filtering method
-    // glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-    // glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-
-    // setting texture border color
-    float borderColor[] = { 1.0f, 1.0f, 0.0f, 1.0f };
-    glTexParameterfv( GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor );
-
-    // loading image
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load( true );
-    unsigned char *data = stbi_load( "/home/ryuugami/Projects/C++/learnopengl-implementation/textures/container.jpg", 
-                                    &width, &height, &nrChannels, 0 );
-
-    if ( data )
+    // the transparent quads fill a box around the cubes, tinted and faded by a random amount
+    std::vector<TransparentQuad> transparentQuads( TRANSPARENT_QUADS );
+    std::minstd_rand random( 7 );
+    std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+    for ( TransparentQuad& quad : transparentQuads )
     {
-        glTexImage2D( GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data );
-        glGenerateMipmap( GL_TEXTURE_2D );
+        quad.positionSize = glm::vec4( -4.0f + 8.0f * unit( random ), -3.0f + 6.0f * unit( random ), -14.0f + 15.0f * unit( random ),
+                                       0.15f + 0.35f * unit( random ) );
+        quad.color = glm::vec4( 0.4f + 0.6f * unit( random ), 0.4f + 0.6f * unit( random ), 0.4f + 0.6f * unit( random ),
+                                0.35f + 0.4f * unit( random ) );
     }
-    else
+
+    // every asset comes from one mapped pack, the loose files are the fallback when it is missing
+    AssetPack assets;
+    if ( !assets.open( ASSET_PACK_PATH, LOOSE_ASSETS ? ASSET_ROOT : "" ) )
     {
-        std::cerr << "Failed to load texture" << std::endl;
+        std::cerr << "Falling back to the loose assets in " << ASSET_ROOT << std::endl;
+        assets.open( "", ASSET_ROOT );
     }
-    stbi_image_free( data );
-
-    // activating the second texture unit to bind to it
-    glBindTexture( GL_TEXTURE_2D, texture2 );
-    // setting texture wrap
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT );
-    // setting texture scaling
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
-    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-    // setting mipmap filtering method
-    // glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-    // glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-
-    // setting texture border color
-    glTexParameterfv( GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor );
-
-    // loading image
-    data = stbi_load( "/home/ryuugami/Projects/C++/learnopengl-implementation/textures/awesomeface.png", 
-                        &width, &height, &nrChannels, 0 );
-
-    if ( data )
+    if ( VERIFY_ASSET_PACK && !assets.verify( ) )
+        return -1;
+
+    // asset reads are batched through io_uring ( or a pread thread pool ) and completed on the workers
+    IoService io( jobs, IoService::Settings( ) );
+
+    // the renderer and its GL context live on the render thread (or on this one)
+    Renderer::Settings rendering;
+    rendering.streaming.budget = TEXTURE_BUDGET;
+    rendering.virtualTexturing.enabled = USE_VIRTUAL_TEXTURING;
+    rendering.resolution.enabled = DYNAMIC_RESOLUTION;
+    rendering.resolution.budgetMilliseconds = GPU_BUDGET_MILLISECONDS;
+    rendering.depthPrepass.mode = depthPrepass;
+    rendering.deferred.enabled = DEFERRED_SHADING;
+    rendering.clustered.enabled = CLUSTERED_LIGHTING;
+    rendering.shadows.enabled = SUN_SHADOWS;
+    rendering.shadows.caching = CACHE_STATIC_SHADOWS;
+    rendering.antiAliasing.samples = MSAA_SAMPLES;
+    rendering.temporal.renderScale = TAA_RENDER_SCALE;
+    rendering.transparency.enabled = TRANSPARENT_QUADS > 0;
+    rendering.capture.format = CAPTURE_FORMAT;
+    rendering.video.enabled = RECORD_VIDEO;
+    rendering.video.output = RECORD_OUTPUT;
+    rendering.video.policy = RECORD_POLICY;
+    Renderer renderer( jobs, io, assets, rendering );
+    FramePacer::Settings pacing;
+    pacing.maxFramesInFlight = MAX_FRAMES_IN_FLIGHT;
+    pacing.swapMode = SWAP_MODE;
+    pacing.targetFrameTime = TARGET_FRAME_TIME;
+    // the refresh period drives the emulated adaptive vsync
+    const GLFWvidmode* videoMode = glfwGetVideoMode( glfwGetPrimaryMonitor( ) );
+    if ( videoMode )
+        pacing.refreshRate = videoMode->refreshRate;
+    FramePacer pacer( pacing );
+    RenderContext context;
+    context.window = window;
+    context.renderer = &renderer;
+    context.pacer = &pacer;
+
+    // scratch memory of the simulation, reset every frame
+    LinearArena frameArena;
+    // every cube's model matrix and the camera of the last frame, for the motion vectors
+    std::vector<glm::mat4> previousModels( cubeCount );
+    glm::mat4 previousViewProjection = glm::mat4( 1.0f );
+
+    std::thread renderingThread;
+    if ( USE_RENDER_THREAD )
     {
-        glTexImage2D( GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data );
-        glGenerateMipmap( GL_TEXTURE_2D );
+        renderingThread = std::thread( renderThread, &context, &jobs );
     }
     else
     {
-        std::cerr << "Failed to load texture" << std::endl;
+        // make the newly created window the main context of the current thread
+        glfwMakeContextCurrent( window );
+
+        // initializing GLAD
+        if ( !gladLoadGLLoader( (GLADloadproc)glfwGetProcAddress ) )
+        {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
+        renderer.initialize( );
+        pacer.initialize( );
+        context.ready = true;
     }
-    stbi_image_free( data );
-
-    // telling to which texture unit each shader sampler belongs to
-    ourShader.use( );
-    glUniform1i( glGetUniformLocation( ourShader.ID, "texture1" ), 0 );
-    ourShader.setInt( "texture2", 1 );
 
     // initializing render loop
-    while ( !glfwWindowShouldClose( window ) )
+    unsigned long long frameIndex = 0;
+    while ( !glfwWindowShouldClose( window ) && !context.quit )
     {
-        // input processing
-        processInput( window );
-
-        // rendering commands
-        glClearColor( 0.2f, 0.3f, 0.3f, 1.0f );
-        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);        
-
-        // activating the Shader Program
-        ourShader.use( );
-        ourShader.setFloat( "mixValue", mixValue );
+        unsigned long long allocationsBefore = AllocationCounter::thread( );
+        frameArena.reset( );
 
-        // activating and binding each texture unit
-        glActiveTexture( GL_TEXTURE0 );
-        glBindTexture( GL_TEXTURE_2D, texture1 );
-        glActiveTexture( GL_TEXTURE1 );
-        glBindTexture( GL_TEXTURE_2D, texture2 );
+        // input processing
+        glfwPollEvents( );
+        double inputTime = glfwGetTime( );
+        input.update( inputQueue, inputTime );
+        processInput( window, input );
 
-        // model matrix
-        glm::mat4 model = glm::mat4( 1.0f );
-        model = glm::rotate( model, (float)glfwGetTime( ) * glm::radians( 50.0f ), glm::vec3( 0.5f, 1.0f, 0.0f ) );
         // view matrix
         glm::mat4 view = glm::mat4( 1.0f );
         view = glm::translate( view, glm::vec3( 0.0f, 0.0f, -3.0f ) );
-        // projection matrix
+        // projection matrix, with the aspect of the window ( the scene resolution scales both sides alike )
+        int width = framebufferWidth;
+        int height = framebufferHeight;
         glm::mat4 projection;
-        projection = glm::perspective( glm::radians( 45.0f ), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f );
-
-        // sending matrices to the shader
-        unsigned int modelLoc = glGetUniformLocation( ourShader.ID, "model" );
-        glUniformMatrix4fv( modelLoc, 1, GL_FALSE, glm::value_ptr( model ) );
-        unsigned int viewLoc = glGetUniformLocation( ourShader.ID, "view" );
-        glUniformMatrix4fv( viewLoc, 1, GL_FALSE, glm::value_ptr( view ) );
-        unsigned int projectionLoc = glGetUniformLocation( ourShader.ID, "projection" );
-        glUniformMatrix4fv( projectionLoc, 1, GL_FALSE, glm::value_ptr( projection ) );
-
-        // rendering triangle
-        glBindVertexArray( VAO );
-        for ( unsigned int i = 0; i < 10; i++ ) {
-            glm::mat4 model1 = glm::mat4( 1.0f );
-            model1 = glm::translate( model1, cubePositions[i] );
-            float angle = 20.0f * i;
-            if ( i % 3 == 0 )
-                angle = 20.0f * (i+1) * (float)glfwGetTime( );
-            model1 = glm::rotate( model1, glm::radians( angle ), glm::vec3( 1.0f, 0.3f, 0.5f ) );            
-            glUniformMatrix4fv( glGetUniformLocation( ourShader.ID, "model" ), 1, GL_FALSE, glm::value_ptr( model1 ) );
-
-            glDrawArrays( GL_TRIANGLES, 0, 36 );
+        projection = glm::perspective( glm::radians( 45.0f ), height > 0 ? (float)width / (float)height : 1.0f, 0.1f, 100.0f );
+
+        // animating every third cube, the others stay static and are never recomputed
+        float time = (float)inputTime;
+        for ( unsigned int i = 0; i < 10; i += 3 )
+        {
+            float angle = 20.0f * (i+1) * time;
+            transforms.setRotation( cubeNodes[i], glm::angleAxis( glm::radians( angle ), cubeAxis ) );
+        }
+        transforms.update( &jobs );
+
+        // culling the cubes against the view frustum ( the unit cube fits in a sphere of radius sqrt(3)/2 )
+        glm::mat4 viewProjection = projection * view;
+        if ( frameIndex == 0 )
+        {
+            // nothing moved before the first frame
+            for ( unsigned int i = 0; i < cubeCount; i++ )
+                previousModels[i] = transforms.getWorldMatrix( cubeNodes[i] );
+            previousViewProjection = viewProjection;
+        }
+        glm::vec4* bounds = frameArena.allocateArray<glm::vec4>( cubeCount );
+        unsigned char* visible = frameArena.allocateArray<unsigned char>( cubeCount );
+        for ( unsigned int i = 0; i < cubeCount; i++ )
+            bounds[i] = glm::vec4( transforms.getPosition( cubeNodes[i] ), 0.8660254f );
+        cullSpheres( Frustum( viewProjection ), bounds, visible, cubeCount, &jobs );
+
+        // combining every visible model matrix with the view and projection matrices in one batch
+        FrameVector<glm::mat4> models{ ArenaAllocator<glm::mat4>( &frameArena ) };
+        FrameVector<glm::mat4> previous{ ArenaAllocator<glm::mat4>( &frameArena ) };
+        models.reserve( cubeCount );
+        previous.reserve( cubeCount );
+        for ( unsigned int i = 0; i < cubeCount; i++ )
+        {
+            if ( visible[i] )
+            {
+                models.push_back( transforms.getWorldMatrix( cubeNodes[i] ) );
+                previous.push_back( previousModels[i] );
+            }
+        }
+
+        // filling the frame packet, it becomes immutable once published
+        FramePacket& packet = context.packets.writeBuffer( );
+        packet.reset( );
+        packet.frameIndex = ++frameIndex;
+        packet.inputTime = inputTime;
+        packet.view = view;
+        packet.projection = projection;
+        packet.viewportWidth = width;
+        packet.viewportHeight = height;
+        packet.mixValue = mixValue;
+        packet.wireframe = wireframe;
+        packet.antiAliasing = antiAliasing;
+        packet.transparency = transparency;
+        packet.capture = CAPTURE_EVERY_FRAME || captureRequested;
+        captureRequested = false;
+        // the kernel writes the draws as a plain array of matrices
+        static_assert( sizeof( DrawItem ) == sizeof( glm::mat4 ), "DrawItem must be exactly its MVP" );
+        packet.draws.resize( models.size( ) );
+        packet.previousMvps.resize( previous.size( ) );
+        if ( !models.empty( ) )
+        {
+            MatrixKernels::multiplyMVP( viewProjection, models.data( ), reinterpret_cast<glm::mat4*>( packet.draws.data( ) ), models.size( ) );
+            MatrixKernels::multiplyMVP( previousViewProjection, previous.data( ), packet.previousMvps.data( ), previous.size( ) );
+        }
+        for ( unsigned int i = 0; i < cubeCount; i++ )
+            previousModels[i] = transforms.getWorldMatrix( cubeNodes[i] );
+        previousViewProjection = viewProjection;
+
+        // every cube casts a shadow, the animated ones are redrawn into the shadow maps every
+        // frame; the others never move, so their version never changes
+        packet.staticCasterVersion = 1;
+        packet.staticCasters.reserve( cubeCount );
+        packet.dynamicCasters.reserve( 4 );
+        for ( unsigned int i = 0; i < cubeCount; i++ )
+        {
+            if ( i < 10 && i % 3 == 0 )
+                packet.dynamicCasters.push_back( transforms.getWorldMatrix( cubeNodes[i] ) );
+            else
+                packet.staticCasters.push_back( transforms.getWorldMatrix( cubeNodes[i] ) );
+        }
+
+        // the lights circle the cubes on rings of their own height and speed
+        packet.lights.resize( POINT_LIGHTS + SPOT_LIGHTS );
+        for ( unsigned int i = 0; i < POINT_LIGHTS; i++ )
+        {
+            float phase = 6.2831853f * i / POINT_LIGHTS;
+            float angle = phase + time * ( 0.3f + 0.05f * ( i % 5 ) );
+            float ring = 2.0f + 1.5f * ( i % 3 );
+            Light& light = packet.lights[i];
+            light.position = glm::vec3( ring * std::cos( angle ), 2.5f * std::sin( 3.0f * phase ), -2.0f + ring * std::sin( angle ) );
+            light.radius = POINT_LIGHT_RADIUS;
+            light.color = glm::vec3( 0.5f ) + 0.5f * glm::vec3( std::cos( phase ), std::cos( phase + 2.0943951f ), std::cos( phase + 4.1887902f ) );
+        }
+        for ( unsigned int i = 0; i < SPOT_LIGHTS; i++ )
+        {
+            float angle = 6.2831853f * i / SPOT_LIGHTS + time * 0.7f;
+            Light& light = packet.lights[POINT_LIGHTS + i];
+            light.position = glm::vec3( 3.0f * std::cos( angle ), 4.0f, -2.0f + 3.0f * std::sin( angle ) );
+            light.radius = SPOT_LIGHT_RANGE;
+            light.color = glm::vec3( 2.0f );
+            light.direction = glm::normalize( glm::vec3( 0.0f, 0.0f, -2.0f ) - light.position );
+            light.cosInner = std::cos( glm::radians( 15.0f ) );
+            light.cosOuter = std::cos( glm::radians( 20.0f ) );
+        }
+
+        // the transparent quads bob up and down, each with a phase of its own, and reach the
+        // renderer in no particular order
+        packet.transparents.resize( TRANSPARENT_QUADS );
+        for ( unsigned int i = 0; i < TRANSPARENT_QUADS; i++ )
+        {
+            TransparentQuad& quad = packet.transparents[i];
+            quad = transparentQuads[i];
+            quad.positionSize.y += 0.2f * std::sin( 0.8f * time + 2.3999632f * i );
+        }
+
+        // nothing above may touch the heap once the arenas have grown to their working size
+        assert( frameIndex <= ALLOCATION_WARMUP_FRAMES || AllocationCounter::thread( ) == allocationsBefore );
+        (void) allocationsBefore;
+
+        if ( USE_RENDER_THREAD )
+        {
+            // the packet itself goes through the lock-free triple buffer, the mutex
+            // only lets the two threads sleep instead of spinning
+            context.packets.publish( );
+            {
+                std::lock_guard<std::mutex> lock( context.mutex );
+                context.publishedFrame = frameIndex;
+            }
+            context.published.notify_one( );
+
+            // staying at most one frame ahead of the render thread: frame N+1 is
+            // simulated while frame N is submitted
+            std::unique_lock<std::mutex> lock( context.mutex );
+            context.consumed.wait( lock, [&context, frameIndex]( )
+            {
+                return context.consumedFrame + 1 >= frameIndex || context.quit;
+            } );
+        }
+        else
+        {
+            context.packets.publish( );
+            context.packets.update( );
+            presentFrame( context, context.packets.readBuffer( ) );
         }
-        // glDrawElements( GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0 );
-        // glDrawArrays( GL_TRIANGLES, 0, 36 );
-        
-        // check call events and swap buffer
-        glfwSwapBuffers( window );
-        glfwPollEvents( );
     }
 
-    // deallocating all the used resources
-    glDeleteVertexArrays( 1, &VAO );
-    glDeleteBuffers( 1, &VBO );
-    glDeleteBuffers( 1, &EBO );
-  
+    if ( USE_RENDER_THREAD )
+    {
+        {
+            std::lock_guard<std::mutex> lock( context.mutex );
+            context.quit = true;
+        }
+        context.published.notify_one( );
+        renderingThread.join( );
+    }
+    else if ( context.ready )
+    {
+        pacer.shutdown( );
+        renderer.shutdown( );
+    }
+
+    std::cout << ( USE_RENDER_THREAD ? "Render thread mode" : "Single thread mode" ) << std::endl;
+    pacer.report( std::cout );
+    ImageDecoder::report( std::cout );
+    ImageEncoder::report( std::cout );
+    io.report( std::cout );
+    if ( AllocationCounter::enabled( ) )
+        std::cout << "Steady state heap allocations while presenting: " << context.presentAllocations << std::endl;
+
     // clean up GLFW's allocated resources
     glfwTerminate( );
     return 0;
 }
 
-// window resize callback function implementation
-void framebuffer_size_callback( GLFWwindow* window, int width, int height )
+// draws a packet and presents it, paced by the frame pacer
+void presentFrame( RenderContext& context, const FramePacket& packet )
 {
-    // setting the size of the rendering window
-    glViewport( 0, 0, width, height );
+    unsigned long long allocationsBefore = AllocationCounter::thread( );
+    context.pacer->beginFrame( );
+    context.renderer->render( packet );
+
+    // check call events and swap buffer
+    glfwSwapBuffers( context.window );
+    context.pacer->endFrame( packet.inputTime );
+
+    // driver code runs on this thread too, so this is reported rather than asserted
+    if ( ++context.presentedFrames > ALLOCATION_WARMUP_FRAMES )
+        context.presentAllocations += AllocationCounter::thread( ) - allocationsBefore;
 }
 
-// processes the given inputs
-void processInput( GLFWwindow* window )
+// owns the GL context and consumes the frame packets published by the main thread
+void renderThread( RenderContext* context, JobSystem* jobs )
 {
-    if ( glfwGetKey( window, GLFW_KEY_ESCAPE ) == GLFW_PRESS )
-    {
-        glfwSetWindowShouldClose( window, true );
-    }
-    else if ( glfwGetKey( window, GLFW_KEY_1 ) == GLFW_PRESS )
-    {
-        glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
-    }
-    else if ( glfwGetKey( window, GLFW_KEY_2 ) == GLFW_PRESS )
-    {
-        glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
-    } 
-    else if ( glfwGetKey( window, GLFW_KEY_3 ) == GLFW_PRESS )
+    // make the window the main context of the render thread
+    glfwMakeContextCurrent( context->window );
+
+    // initializing GLAD
+    if ( !gladLoadGLLoader( (GLADloadproc)glfwGetProcAddress ) )
     {
-        glPolygonMode( GL_FRONT_AND_BACK, GL_POINT );
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        std::lock_guard<std::mutex> lock( context->mutex );
+        context->quit = true;
+        context->consumed.notify_one( );
+        return;
     }
-    else if ( glfwGetKey( window, GLFW_KEY_UP ) == GLFW_PRESS )
+
+    // the GL jobs (texture uploads) now have to run here
+    jobs->setPinnedThread( );
+    context->renderer->initialize( );
+    context->pacer->initialize( );
+    context->ready = true;
+
+    while ( true )
     {
-        mixValue += 0.0001f;
-        if ( mixValue >= 1.0f )
-            mixValue = 1.0f;
+        {
+            std::unique_lock<std::mutex> lock( context->mutex );
+            context->published.wait( lock, [context]( )
+            {
+                return context->publishedFrame > context->consumedFrame || context->quit;
+            } );
+            if ( context->quit )
+                break;
+        }
+
+        context->packets.update( );
+        {
+            std::lock_guard<std::mutex> lock( context->mutex );
+            context->consumedFrame = context->packets.readBuffer( ).frameIndex;
+        }
+        context->consumed.notify_one( );
+
+        presentFrame( *context, context->packets.readBuffer( ) );
     }
-    else if ( glfwGetKey( window, GLFW_KEY_DOWN ) == GLFW_PRESS )
+
+    context->pacer->shutdown( );
+    context->renderer->shutdown( );
+    glfwMakeContextCurrent( NULL );
+}
+
+// window resize callback function implementation
+// reads the options of the pre-pass benchmark, false for anything it does not know
+bool parseArguments( int argc, char** argv, DepthPrepass::Mode& depthPrepass, unsigned int& overdrawLayers )
+{
+    for ( int i = 1; i < argc; i += 2 )
     {
-        mixValue -= 0.0001f;
-        if ( mixValue <= 0.0f )
-            mixValue = 0.0f;
+        if ( i + 1 >= argc )
+            return false;
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if ( option == "--depth-prepass" && value == "off" )
+            depthPrepass = DepthPrepass::Mode::OFF;
+        else if ( option == "--depth-prepass" && value == "on" )
+            depthPrepass = DepthPrepass::Mode::ON;
+        else if ( option == "--depth-prepass" && value == "auto" )
+            depthPrepass = DepthPrepass::Mode::AUTO;
+        else if ( option == "--overdraw-layers" && !value.empty( ) && value.find_first_not_of( "0123456789" ) == std::string::npos )
+            overdrawLayers = (unsigned int) std::strtoul( value.c_str( ), nullptr, 10 );
+        else
+            return false;
     }
-}
\ No newline at end of file
+    return true;
+}
+
+void framebuffer_size_callback( GLFWwindow* window, int width, int height )
+{
+    // the render thread picks the new size up through the next frame packet
+    framebufferWidth = width;
+    framebufferHeight = height;
+}
+
+// processes the input events since the last frame
+void processInput( GLFWwindow* window, const InputState& input )
+{
+    if ( input.wasPressed( GLFW_KEY_ESCAPE ) )
+        glfwSetWindowShouldClose( window, true );
+    if ( input.wasPressed( GLFW_KEY_1 ) )
+        wireframe = WireframeMode::OVERLAY;
+    if ( input.wasPressed( GLFW_KEY_2 ) )
+        wireframe = WireframeMode::OFF;
+    if ( input.wasPressed( GLFW_KEY_3 ) )
+        wireframe = WireframeMode::HIDDEN_LINE;
+    if ( input.wasPressed( GLFW_KEY_4 ) )
+        antiAliasing = (AntiAliasingMode) ( ( (int) antiAliasing + 1 ) % (int) AntiAliasingMode::COUNT );
+    if ( input.wasPressed( GLFW_KEY_5 ) )
+        transparency = (TransparencyMode) ( ( (int) transparency + 1 ) % (int) TransparencyMode::COUNT );
+    if ( input.wasPressed( GLFW_KEY_F12 ) )
+        captureRequested = true;
+
+    // the change follows how long the keys were actually held, not the frame count
+    float delta = MIX_RATE * (float)( input.heldTime( GLFW_KEY_UP ) - input.heldTime( GLFW_KEY_DOWN ) );
+    mixValue = glm::clamp( mixValue + delta, 0.0f, 1.0f );
+}
@@ -0,0 +1,411 @@
+#include "learnopengl-implementation/matrix_kernels.h"
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define MATRIX_KERNELS_X86 1
+#include <immintrin.h>
+#else
+#define MATRIX_KERNELS_X86 0
+#endif
+
+namespace
+{
+    typedef void ( *MultiplyMVPFunc )( const glm::mat4&, const glm::mat4*, glm::mat4*, size_t );
+    typedef void ( *TransformFunc )( const glm::mat4&, const glm::vec4*, glm::vec4*, size_t );
+    typedef void ( *NormalMatricesFunc )( const glm::mat4*, glm::mat4*, size_t );
+
+    struct KernelTable
+    {
+        MatrixKernels::Level level;
+        MultiplyMVPFunc multiplyMVP;
+        TransformFunc transform;
+        NormalMatricesFunc normalMatrices;
+    };
+
+    // scalar reference versions, also used on non-x86 builds
+
+    void multiplyMVPScalar( const glm::mat4& viewProjection, const glm::mat4* models, glm::mat4* out, size_t count )
+    {
+        for ( size_t i = 0; i < count; i++ )
+            out[i] = viewProjection * models[i];
+    }
+
+    void transformScalar( const glm::mat4& m, const glm::vec4* in, glm::vec4* out, size_t count )
+    {
+        for ( size_t i = 0; i < count; i++ )
+            out[i] = m * in[i];
+    }
+
+    void normalMatricesScalar( const glm::mat4* models, glm::mat4* out, size_t count )
+    {
+        for ( size_t i = 0; i < count; i++ )
+            out[i] = glm::mat4( glm::transpose( glm::inverse( glm::mat3( models[i] ) ) ) );
+    }
+
+#if MATRIX_KERNELS_X86
+
+    // SSE2, always available on x86-64
+
+    inline __m128 mulColumnSSE( const __m128 m[4], __m128 v )
+    {
+        __m128 r = _mm_mul_ps( m[0], _mm_shuffle_ps( v, v, _MM_SHUFFLE( 0, 0, 0, 0 ) ) );
+        r = _mm_add_ps( r, _mm_mul_ps( m[1], _mm_shuffle_ps( v, v, _MM_SHUFFLE( 1, 1, 1, 1 ) ) ) );
+        r = _mm_add_ps( r, _mm_mul_ps( m[2], _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 2, 2, 2 ) ) ) );
+        r = _mm_add_ps( r, _mm_mul_ps( m[3], _mm_shuffle_ps( v, v, _MM_SHUFFLE( 3, 3, 3, 3 ) ) ) );
+        return r;
+    }
+
+    inline void loadMatrixSSE( const glm::mat4& m, __m128 out[4] )
+    {
+        for ( int i = 0; i < 4; i++ )
+            out[i] = _mm_loadu_ps( &m[i][0] );
+    }
+
+    // a.yzx * b.zxy - a.zxy * b.yzx, a zero w stays zero
+    inline __m128 crossSSE( __m128 a, __m128 b )
+    {
+        __m128 aYZX = _mm_shuffle_ps( a, a, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+        __m128 bYZX = _mm_shuffle_ps( b, b, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+        __m128 c = _mm_sub_ps( _mm_mul_ps( a, bYZX ), _mm_mul_ps( aYZX, b ) );
+        return _mm_shuffle_ps( c, c, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+    }
+
+    // dot product broadcast to every lane
+    inline __m128 dotSSE( __m128 a, __m128 b )
+    {
+        __m128 m = _mm_mul_ps( a, b );
+        m = _mm_add_ps( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+        return _mm_add_ps( m, _mm_shuffle_ps( m, m, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    }
+
+    void multiplyMVPSSE2( const glm::mat4& viewProjection, const glm::mat4* models, glm::mat4* out, size_t count )
+    {
+        __m128 vp[4];
+        loadMatrixSSE( viewProjection, vp );
+        for ( size_t i = 0; i < count; i++ )
+        {
+            for ( int c = 0; c < 4; c++ )
+                _mm_storeu_ps( &out[i][c][0], mulColumnSSE( vp, _mm_loadu_ps( &models[i][c][0] ) ) );
+        }
+    }
+
+    void transformSSE2( const glm::mat4& m, const glm::vec4* in, glm::vec4* out, size_t count )
+    {
+        __m128 mat[4];
+        loadMatrixSSE( m, mat );
+        for ( size_t i = 0; i < count; i++ )
+            _mm_storeu_ps( &out[i][0], mulColumnSSE( mat, _mm_loadu_ps( &in[i][0] ) ) );
+    }
+
+    // the inverse transpose of A is its cofactor matrix divided by det( A ), and the
+    // cofactor columns are just cross products of the columns of A
+    inline void normalMatrixSSE( const glm::mat4& model, glm::mat4& out )
+    {
+        const __m128 xyzMask = _mm_castsi128_ps( _mm_set_epi32( 0, -1, -1, -1 ) );
+        __m128 c0 = _mm_and_ps( _mm_loadu_ps( &model[0][0] ), xyzMask );
+        __m128 c1 = _mm_and_ps( _mm_loadu_ps( &model[1][0] ), xyzMask );
+        __m128 c2 = _mm_and_ps( _mm_loadu_ps( &model[2][0] ), xyzMask );
+
+        __m128 r0 = crossSSE( c1, c2 );
+        __m128 r1 = crossSSE( c2, c0 );
+        __m128 r2 = crossSSE( c0, c1 );
+        __m128 invDet = _mm_div_ps( _mm_set1_ps( 1.0f ), dotSSE( c0, r0 ) );
+
+        _mm_storeu_ps( &out[0][0], _mm_mul_ps( r0, invDet ) );
+        _mm_storeu_ps( &out[1][0], _mm_mul_ps( r1, invDet ) );
+        _mm_storeu_ps( &out[2][0], _mm_mul_ps( r2, invDet ) );
+        _mm_storeu_ps( &out[3][0], _mm_set_ps( 1.0f, 0.0f, 0.0f, 0.0f ) );
+    }
+
+    void normalMatricesSSE2( const glm::mat4* models, glm::mat4* out, size_t count )
+    {
+        for ( size_t i = 0; i < count; i++ )
+            normalMatrixSSE( models[i], out[i] );
+    }
+
+    // AVX2 + FMA, two columns/vectors/matrices per register (one per 128-bit lane)
+
+    __attribute__(( target( "avx2,fma" ) ))
+    inline __m256 mulColumnPairAVX2( const __m256 m[4], __m256 v )
+    {
+        __m256 r = _mm256_mul_ps( m[0], _mm256_permute_ps( v, 0x00 ) );
+        r = _mm256_fmadd_ps( m[1], _mm256_permute_ps( v, 0x55 ), r );
+        r = _mm256_fmadd_ps( m[2], _mm256_permute_ps( v, 0xAA ), r );
+        return _mm256_fmadd_ps( m[3], _mm256_permute_ps( v, 0xFF ), r );
+    }
+
+    // column c of m repeated in both lanes
+    __attribute__(( target( "avx2,fma" ) ))
+    inline __m256 broadcastColumnAVX2( const glm::mat4& m, int c )
+    {
+        __m128 column = _mm_loadu_ps( &m[c][0] );
+        return _mm256_insertf128_ps( _mm256_castps128_ps256( column ), column, 1 );
+    }
+
+    __attribute__(( target( "avx2,fma" ) ))
+    void multiplyMVPAVX2( const glm::mat4& viewProjection, const glm::mat4* models, glm::mat4* out, size_t count )
+    {
+        __m256 vp[4];
+        for ( int c = 0; c < 4; c++ )
+            vp[c] = broadcastColumnAVX2( viewProjection, c );
+        for ( size_t i = 0; i < count; i++ )
+        {
+            __m256 m01 = _mm256_loadu_ps( &models[i][0][0] );
+            __m256 m23 = _mm256_loadu_ps( &models[i][2][0] );
+            _mm256_storeu_ps( &out[i][0][0], mulColumnPairAVX2( vp, m01 ) );
+            _mm256_storeu_ps( &out[i][2][0], mulColumnPairAVX2( vp, m23 ) );
+        }
+    }
+
+    __attribute__(( target( "avx2,fma" ) ))
+    void transformAVX2( const glm::mat4& m, const glm::vec4* in, glm::vec4* out, size_t count )
+    {
+        __m256 mat[4];
+        for ( int c = 0; c < 4; c++ )
+            mat[c] = broadcastColumnAVX2( m, c );
+        size_t i = 0;
+        for ( ; i + 2 <= count; i += 2 )
+            _mm256_storeu_ps( &out[i][0], mulColumnPairAVX2( mat, _mm256_loadu_ps( &in[i][0] ) ) );
+        if ( i < count )
+            transformSSE2( m, in + i, out + i, count - i );
+    }
+
+    __attribute__(( target( "avx2,fma" ) ))
+    inline __m256 crossAVX2( __m256 a, __m256 b )
+    {
+        __m256 aYZX = _mm256_shuffle_ps( a, a, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+        __m256 bYZX = _mm256_shuffle_ps( b, b, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+        __m256 c = _mm256_fmsub_ps( a, bYZX, _mm256_mul_ps( aYZX, b ) );
+        return _mm256_shuffle_ps( c, c, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+    }
+
+    __attribute__(( target( "avx2,fma" ) ))
+    inline __m256 dotAVX2( __m256 a, __m256 b )
+    {
+        __m256 m = _mm256_mul_ps( a, b );
+        m = _mm256_add_ps( m, _mm256_shuffle_ps( m, m, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+        return _mm256_add_ps( m, _mm256_shuffle_ps( m, m, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    }
+
+    // column c of two consecutive matrices, one per lane
+    __attribute__(( target( "avx2,fma" ) ))
+    inline __m256 loadColumnPairAVX2( const glm::mat4* m, int c )
+    {
+        __m256 r = _mm256_castps128_ps256( _mm_loadu_ps( &m[0][c][0] ) );
+        return _mm256_insertf128_ps( r, _mm_loadu_ps( &m[1][c][0] ), 1 );
+    }
+
+    __attribute__(( target( "avx2,fma" ) ))
+    inline void storeColumnPairAVX2( glm::mat4* m, int c, __m256 v )
+    {
+        _mm_storeu_ps( &m[0][c][0], _mm256_castps256_ps128( v ) );
+        _mm_storeu_ps( &m[1][c][0], _mm256_extractf128_ps( v, 1 ) );
+    }
+
+    __attribute__(( target( "avx2,fma" ) ))
+    void normalMatricesAVX2( const glm::mat4* models, glm::mat4* out, size_t count )
+    {
+        const __m256 xyzMask = _mm256_castsi256_ps( _mm256_set_epi32( 0, -1, -1, -1, 0, -1, -1, -1 ) );
+        const __m256 lastColumn = _mm256_set_ps( 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f );
+        size_t i = 0;
+        for ( ; i + 2 <= count; i += 2 )
+        {
+            __m256 c0 = _mm256_and_ps( loadColumnPairAVX2( models + i, 0 ), xyzMask );
+            __m256 c1 = _mm256_and_ps( loadColumnPairAVX2( models + i, 1 ), xyzMask );
+            __m256 c2 = _mm256_and_ps( loadColumnPairAVX2( models + i, 2 ), xyzMask );
+
+            __m256 r0 = crossAVX2( c1, c2 );
+            __m256 r1 = crossAVX2( c2, c0 );
+            __m256 r2 = crossAVX2( c0, c1 );
+            __m256 invDet = _mm256_div_ps( _mm256_set1_ps( 1.0f ), dotAVX2( c0, r0 ) );
+
+            storeColumnPairAVX2( out + i, 0, _mm256_mul_ps( r0, invDet ) );
+            storeColumnPairAVX2( out + i, 1, _mm256_mul_ps( r1, invDet ) );
+            storeColumnPairAVX2( out + i, 2, _mm256_mul_ps( r2, invDet ) );
+            storeColumnPairAVX2( out + i, 3, lastColumn );
+        }
+        if ( i < count )
+            normalMatricesSSE2( models + i, out + i, count - i );
+    }
+
+    // AVX-512, four columns/vectors/matrices per register
+
+    __attribute__(( target( "avx512f" ) ))
+    inline __m512 mulColumnQuadAVX512( const __m512 m[4], __m512 v )
+    {
+        __m512 r = _mm512_mul_ps( m[0], _mm512_permute_ps( v, 0x00 ) );
+        r = _mm512_fmadd_ps( m[1], _mm512_permute_ps( v, 0x55 ), r );
+        r = _mm512_fmadd_ps( m[2], _mm512_permute_ps( v, 0xAA ), r );
+        return _mm512_fmadd_ps( m[3], _mm512_permute_ps( v, 0xFF ), r );
+    }
+
+    // column c of m repeated in all four lanes
+    __attribute__(( target( "avx512f" ) ))
+    inline __m512 broadcastColumnAVX512( const glm::mat4& m, int c )
+    {
+        __m512 column = _mm512_castps128_ps512( _mm_loadu_ps( &m[c][0] ) );
+        return _mm512_shuffle_f32x4( column, column, 0x00 );
+    }
+
+    __attribute__(( target( "avx512f" ) ))
+    void multiplyMVPAVX512( const glm::mat4& viewProjection, const glm::mat4* models, glm::mat4* out, size_t count )
+    {
+        __m512 vp[4];
+        for ( int c = 0; c < 4; c++ )
+            vp[c] = broadcastColumnAVX512( viewProjection, c );
+        for ( size_t i = 0; i < count; i++ )
+            _mm512_storeu_ps( &out[i][0][0], mulColumnQuadAVX512( vp, _mm512_loadu_ps( &models[i][0][0] ) ) );
+    }
+
+    __attribute__(( target( "avx512f" ) ))
+    void transformAVX512( const glm::mat4& m, const glm::vec4* in, glm::vec4* out, size_t count )
+    {
+        __m512 mat[4];
+        for ( int c = 0; c < 4; c++ )
+            mat[c] = broadcastColumnAVX512( m, c );
+        size_t i = 0;
+        for ( ; i + 4 <= count; i += 4 )
+            _mm512_storeu_ps( &out[i][0], mulColumnQuadAVX512( mat, _mm512_loadu_ps( &in[i][0] ) ) );
+        if ( i < count )
+            transformSSE2( m, in + i, out + i, count - i );
+    }
+
+    __attribute__(( target( "avx512f" ) ))
+    inline __m512 crossAVX512( __m512 a, __m512 b )
+    {
+        __m512 aYZX = _mm512_shuffle_ps( a, a, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+        __m512 bYZX = _mm512_shuffle_ps( b, b, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+        __m512 c = _mm512_fmsub_ps( a, bYZX, _mm512_mul_ps( aYZX, b ) );
+        return _mm512_shuffle_ps( c, c, _MM_SHUFFLE( 3, 0, 2, 1 ) );
+    }
+
+    __attribute__(( target( "avx512f" ) ))
+    inline __m512 dotAVX512( __m512 a, __m512 b )
+    {
+        __m512 m = _mm512_mul_ps( a, b );
+        m = _mm512_add_ps( m, _mm512_shuffle_ps( m, m, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+        return _mm512_add_ps( m, _mm512_shuffle_ps( m, m, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+    }
+
+    // column c of four consecutive matrices, one per lane
+    __attribute__(( target( "avx512f" ) ))
+    inline __m512 loadColumnQuadAVX512( const glm::mat4* m, int c )
+    {
+        __m512 r = _mm512_castps128_ps512( _mm_loadu_ps( &m[0][c][0] ) );
+        r = _mm512_insertf32x4( r, _mm_loadu_ps( &m[1][c][0] ), 1 );
+        r = _mm512_insertf32x4( r, _mm_loadu_ps( &m[2][c][0] ), 2 );
+        return _mm512_insertf32x4( r, _mm_loadu_ps( &m[3][c][0] ), 3 );
+    }
+
+    __attribute__(( target( "avx512f" ) ))
+    inline void storeColumnQuadAVX512( glm::mat4* m, int c, __m512 v )
+    {
+        _mm_storeu_ps( &m[0][c][0], _mm512_castps512_ps128( v ) );
+        _mm_storeu_ps( &m[1][c][0], _mm512_extractf32x4_ps( v, 1 ) );
+        _mm_storeu_ps( &m[2][c][0], _mm512_extractf32x4_ps( v, 2 ) );
+        _mm_storeu_ps( &m[3][c][0], _mm512_extractf32x4_ps( v, 3 ) );
+    }
+
+    __attribute__(( target( "avx512f" ) ))
+    void normalMatricesAVX512( const glm::mat4* models, glm::mat4* out, size_t count )
+    {
+        // keeps x, y and z of every lane (plain AVX-512F has no _mm512_and_ps)
+        const __mmask16 xyzMask = 0x7777;
+        const __m512 lastColumn = _mm512_set4_ps( 1.0f, 0.0f, 0.0f, 0.0f );
+        size_t i = 0;
+        for ( ; i + 4 <= count; i += 4 )
+        {
+            __m512 c0 = _mm512_maskz_mov_ps( xyzMask, loadColumnQuadAVX512( models + i, 0 ) );
+            __m512 c1 = _mm512_maskz_mov_ps( xyzMask, loadColumnQuadAVX512( models + i, 1 ) );
+            __m512 c2 = _mm512_maskz_mov_ps( xyzMask, loadColumnQuadAVX512( models + i, 2 ) );
+
+            __m512 r0 = crossAVX512( c1, c2 );
+            __m512 r1 = crossAVX512( c2, c0 );
+            __m512 r2 = crossAVX512( c0, c1 );
+            __m512 invDet = _mm512_div_ps( _mm512_set1_ps( 1.0f ), dotAVX512( c0, r0 ) );
+
+            storeColumnQuadAVX512( out + i, 0, _mm512_mul_ps( r0, invDet ) );
+            storeColumnQuadAVX512( out + i, 1, _mm512_mul_ps( r1, invDet ) );
+            storeColumnQuadAVX512( out + i, 2, _mm512_mul_ps( r2, invDet ) );
+            storeColumnQuadAVX512( out + i, 3, lastColumn );
+        }
+        if ( i < count )
+            normalMatricesSSE2( models + i, out + i, count - i );
+    }
+
+#endif
+
+    KernelTable tableFor( MatrixKernels::Level level )
+    {
+        switch ( level )
+        {
+#if MATRIX_KERNELS_X86
+        case MatrixKernels::Level::AVX512:
+            return { level, multiplyMVPAVX512, transformAVX512, normalMatricesAVX512 };
+        case MatrixKernels::Level::AVX2:
+            return { level, multiplyMVPAVX2, transformAVX2, normalMatricesAVX2 };
+        case MatrixKernels::Level::SSE2:
+            return { level, multiplyMVPSSE2, transformSSE2, normalMatricesSSE2 };
+#endif
+        default:
+            return { MatrixKernels::Level::SCALAR, multiplyMVPScalar, transformScalar, normalMatricesScalar };
+        }
+    }
+
+    // filled during static initialization, before main runs
+    KernelTable table = tableFor( MatrixKernels::detect( ) );
+}
+
+MatrixKernels::Level MatrixKernels::detect( )
+{
+#if MATRIX_KERNELS_X86
+    __builtin_cpu_init( );
+    if ( __builtin_cpu_supports( "avx512f" ) )
+        return Level::AVX512;
+    if ( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) )
+        return Level::AVX2;
+    if ( __builtin_cpu_supports( "sse2" ) )
+        return Level::SSE2;
+#endif
+    return Level::SCALAR;
+}
+
+void MatrixKernels::select( Level level )
+{
+    Level supported = detect( );
+    table = tableFor( level > supported ? supported : level );
+}
+
+MatrixKernels::Level MatrixKernels::current( )
+{
+    return table.level;
+}
+
+const char* MatrixKernels::name( Level level )
+{
+    switch ( level )
+    {
+    case Level::AVX512:
+        return "AVX-512";
+    case Level::AVX2:
+        return "AVX2";
+    case Level::SSE2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
+
+void MatrixKernels::multiplyMVP( const glm::mat4& viewProjection, const glm::mat4* models, glm::mat4* out, size_t count )
+{
+    table.multiplyMVP( viewProjection, models, out, count );
+}
+
+void MatrixKernels::transform( const glm::mat4& m, const glm::vec4* in, glm::vec4* out, size_t count )
+{
+    table.transform( m, in, out, count );
+}
+
+void MatrixKernels::normalMatrices( const glm::mat4* models, glm::mat4* out, size_t count )
+{
+    table.normalMatrices( models, out, count );
+}
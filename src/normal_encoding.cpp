@@ -0,0 +1,62 @@
+#include "learnopengl-implementation/normal_encoding.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // the sign of 0 counts as positive, so that both halves fold the same way
+    glm::vec2 signNotZero( const glm::vec2& v )
+    {
+        return glm::vec2( v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f );
+    }
+}
+
+namespace NormalEncoding
+{
+    glm::uint packOctahedral( const glm::vec3& normal )
+    {
+        glm::vec3 n = normal / ( std::fabs( normal.x ) + std::fabs( normal.y ) + std::fabs( normal.z ) );
+        glm::vec2 folded = n.z >= 0.0f ? glm::vec2( n.x, n.y ) : ( 1.0f - glm::abs( glm::vec2( n.y, n.x ) ) ) * signNotZero( glm::vec2( n.x, n.y ) );
+        return glm::packSnorm2x16( folded );
+    }
+
+    glm::vec3 unpackOctahedral( glm::uint packed )
+    {
+        glm::vec2 e = glm::unpackSnorm2x16( packed );
+        glm::vec3 n( e.x, e.y, 1.0f - std::fabs( e.x ) - std::fabs( e.y ) );
+        float t = std::max( -n.z, 0.0f );
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return glm::normalize( n );
+    }
+
+    float maxErrorDegrees( unsigned int resolution )
+    {
+        // in double and through atan2: acos of a float cosine cannot resolve angles below
+        // about 0.02 degrees, more than the encoding loses
+        double worst = 0.0;
+        for ( unsigned int i = 0; i < resolution; i++ )
+        {
+            for ( unsigned int j = 0; j < resolution; j++ )
+            {
+                // the cell's center on the octahedral square, unfolded into a direction
+                double u = 2.0 * ( i + 0.5 ) / resolution - 1.0;
+                double v = 2.0 * ( j + 0.5 ) / resolution - 1.0;
+                glm::dvec3 direction( u, v, 1.0 - std::fabs( u ) - std::fabs( v ) );
+                if ( direction.z < 0.0 )
+                {
+                    direction.x = ( 1.0 - std::fabs( v ) ) * ( u >= 0.0 ? 1.0 : -1.0 );
+                    direction.y = ( 1.0 - std::fabs( u ) ) * ( v >= 0.0 ? 1.0 : -1.0 );
+                }
+                direction = glm::normalize( direction );
+
+                glm::dvec3 decoded( unpackOctahedral( packOctahedral( glm::vec3( direction ) ) ) );
+                worst = std::max( worst, std::atan2( glm::length( glm::cross( direction, decoded ) ), glm::dot( direction, decoded ) ) );
+            }
+        }
+        return (float) glm::degrees( worst );
+    }
+}
@@ -0,0 +1,484 @@
+#include "learnopengl-implementation/render_graph.h"
+
+#include <algorithm>
+#include <iostream>
+
+RenderGraph::RenderGraph( GLResources& resources )
+    : resources( resources )
+{
+}
+
+void RenderGraph::clear( )
+{
+    textures.clear( );
+    versions.clear( );
+    passes.clear( );
+    schedule.clear( );
+    compiled = false;
+}
+
+RenderGraph::Resource RenderGraph::importTexture( const char* name, TextureHandle texture, GLenum internalFormat )
+{
+    TextureNode node;
+    node.name = name;
+    node.kind = Kind::IMPORTED;
+    node.imported = texture;
+    node.description.internalFormat = internalFormat;
+    textures.push_back( node );
+    return addVersion( (unsigned int) textures.size( ) - 1 );
+}
+
+RenderGraph::Resource RenderGraph::importBackbuffer( const char* name )
+{
+    TextureNode node;
+    node.name = name;
+    node.kind = Kind::BACKBUFFER;
+    textures.push_back( node );
+    return addVersion( (unsigned int) textures.size( ) - 1 );
+}
+
+RenderGraph::Resource RenderGraph::createTexture( const char* name, const TextureDescription& description )
+{
+    TextureNode node;
+    node.name = name;
+    node.kind = Kind::TRANSIENT;
+    node.description = description;
+    textures.push_back( node );
+    return addVersion( (unsigned int) textures.size( ) - 1 );
+}
+
+RenderGraph::Resource RenderGraph::createMarker( const char* name )
+{
+    TextureNode node;
+    node.name = name;
+    node.kind = Kind::MARKER;
+    textures.push_back( node );
+    return addVersion( (unsigned int) textures.size( ) - 1 );
+}
+
+RenderGraph::Resource RenderGraph::addVersion( unsigned int texture )
+{
+    ResourceNode node;
+    node.texture = texture;
+    versions.push_back( node );
+    return (Resource) versions.size( ) - 1;
+}
+
+RenderGraph::Pass RenderGraph::addPass( const char* name, std::function<void( )> execute )
+{
+    PassNode node;
+    node.name = name;
+    node.execute = std::move( execute );
+    passes.push_back( std::move( node ) );
+    compiled = false;
+    return (Pass) passes.size( ) - 1;
+}
+
+void RenderGraph::read( Pass pass, Resource resource )
+{
+    passes[pass].reads.push_back( resource );
+    versions[resource].readers.push_back( pass );
+}
+
+RenderGraph::Resource RenderGraph::addWrite( Pass pass, Resource resource )
+{
+    if ( versions[resource].next != NONE )
+        std::cerr << "ERROR::RENDER_GRAPH::VERSION_WRITTEN_TWICE " << textures[versions[resource].texture].name << std::endl;
+
+    // the new version starts from the earlier one, so a pass that wrote it runs first
+    if ( versions[resource].writer != NONE )
+        read( pass, resource );
+    unsigned int texture = versions[resource].texture;
+    textures[texture].versions++;
+    Resource written = addVersion( texture );
+    versions[resource].next = (int) written;
+    versions[written].writer = (int) pass;
+    passes[pass].writes.push_back( written );
+    return written;
+}
+
+RenderGraph::Resource RenderGraph::write( Pass pass, Resource resource )
+{
+    return addWrite( pass, resource );
+}
+
+RenderGraph::Resource RenderGraph::writeColor( Pass pass, Resource resource )
+{
+    Resource written = addWrite( pass, resource );
+    PassNode& node = passes[pass];
+    if ( node.colorCount < MAX_COLOR_ATTACHMENTS )
+        node.colors[node.colorCount++] = written;
+    else
+        std::cerr << "ERROR::RENDER_GRAPH::TOO_MANY_COLOR_ATTACHMENTS " << node.name << std::endl;
+    return written;
+}
+
+RenderGraph::Resource RenderGraph::writeDepth( Pass pass, Resource resource )
+{
+    Resource written = addWrite( pass, resource );
+    passes[pass].depth = (int) written;
+    return written;
+}
+
+void RenderGraph::setSideEffects( Pass pass )
+{
+    passes[pass].sideEffects = true;
+}
+
+void RenderGraph::markOutput( Resource resource )
+{
+    versions[resource].output = true;
+}
+
+void RenderGraph::compile( )
+{
+    cull( );
+    order( );
+    placeTransients( );
+    compiled = true;
+    compiles++;
+}
+
+void RenderGraph::cull( )
+{
+    // counting who needs each version and each pass, then dropping whatever nobody needs,
+    // which may leave what the dropped passes read unneeded in turn
+    std::vector<Resource> unneeded;
+    for ( ResourceNode& version : versions )
+        version.references = (unsigned int) version.readers.size( ) + ( version.output ? 1 : 0 );
+    for ( PassNode& pass : passes )
+    {
+        pass.references = (unsigned int) pass.writes.size( );
+        pass.culled = false;
+    }
+    for ( Resource resource = 0; resource < versions.size( ); resource++ )
+        if ( versions[resource].references == 0 )
+            unneeded.push_back( resource );
+
+    auto drop = [&]( PassNode& pass )
+    {
+        pass.culled = true;
+        for ( Resource read : pass.reads )
+            if ( --versions[read].references == 0 )
+                unneeded.push_back( read );
+    };
+    for ( PassNode& pass : passes )
+        if ( pass.writes.empty( ) && !pass.sideEffects )
+            drop( pass );
+    while ( !unneeded.empty( ) )
+    {
+        Resource resource = unneeded.back( );
+        unneeded.pop_back( );
+        int writer = versions[resource].writer;
+        if ( writer == NONE || passes[writer].sideEffects || passes[writer].culled )
+            continue;
+        if ( --passes[writer].references == 0 )
+            drop( passes[writer] );
+    }
+}
+
+void RenderGraph::order( )
+{
+    // a pass comes after the writers of what it reads and before the writers of the
+    // versions that follow them
+    std::vector<std::vector<Pass>> successors( passes.size( ) );
+    std::vector<unsigned int> predecessors( passes.size( ), 0 );
+    auto depend = [&]( int before, Pass after )
+    {
+        if ( before == NONE || (Pass) before == after || passes[before].culled )
+            return;
+        successors[before].push_back( after );
+        predecessors[after]++;
+    };
+    for ( Pass pass = 0; pass < passes.size( ); pass++ )
+    {
+        if ( passes[pass].culled )
+            continue;
+        for ( Resource read : passes[pass].reads )
+        {
+            depend( versions[read].writer, pass );
+            if ( versions[read].next != NONE )
+            {
+                int overwriter = versions[versions[read].next].writer;
+                if ( overwriter != NONE && (Pass) overwriter != pass && !passes[overwriter].culled )
+                {
+                    successors[pass].push_back( (Pass) overwriter );
+                    predecessors[overwriter]++;
+                }
+            }
+        }
+    }
+
+    // the earliest declared pass whose dependencies ran goes next
+    schedule.clear( );
+    std::vector<bool> scheduled( passes.size( ), false );
+    unsigned int kept = 0;
+    for ( const PassNode& pass : passes )
+        kept += pass.culled ? 0 : 1;
+    while ( schedule.size( ) < kept )
+    {
+        int next = NONE;
+        for ( Pass pass = 0; pass < passes.size( ) && next == NONE; pass++ )
+            if ( !passes[pass].culled && !scheduled[pass] && predecessors[pass] == 0 )
+                next = (int) pass;
+        if ( next == NONE )
+        {
+            // a cycle, the rest keeps the declaration order
+            std::cerr << "ERROR::RENDER_GRAPH::CYCLE" << std::endl;
+            for ( Pass pass = 0; pass < passes.size( ); pass++ )
+                if ( !passes[pass].culled && !scheduled[pass] )
+                    schedule.push_back( pass );
+            break;
+        }
+        scheduled[next] = true;
+        schedule.push_back( (Pass) next );
+        for ( Pass successor : successors[next] )
+            predecessors[successor]--;
+    }
+}
+
+void RenderGraph::placeTransients( )
+{
+    // the lifetime of every texture over the schedule
+    for ( TextureNode& texture : textures )
+    {
+        texture.firstUse = NONE;
+        texture.lastUse = NONE;
+        texture.pooled = NONE;
+    }
+    for ( unsigned int position = 0; position < schedule.size( ); position++ )
+    {
+        const PassNode& pass = passes[schedule[position]];
+        for ( const std::vector<Resource>* list : { &pass.reads, &pass.writes } )
+            for ( Resource resource : *list )
+            {
+                TextureNode& texture = textures[versions[resource].texture];
+                if ( texture.firstUse == NONE )
+                    texture.firstUse = (int) position;
+                texture.lastUse = (int) position;
+            }
+    }
+
+    // in order of their first use, each transient takes a pooled texture of its
+    // description that is free by then, or a new one
+    std::vector<unsigned int> transients;
+    for ( unsigned int texture = 0; texture < textures.size( ); texture++ )
+        if ( textures[texture].kind == Kind::TRANSIENT && textures[texture].firstUse != NONE )
+            transients.push_back( texture );
+    std::sort( transients.begin( ), transients.end( ), [&]( unsigned int a, unsigned int b )
+    {
+        return textures[a].firstUse < textures[b].firstUse;
+    } );
+    for ( PooledTexture& pooled : pool )
+    {
+        pooled.busyUntil = NONE;
+        pooled.used = false;
+    }
+
+    transientBytes = 0;
+    for ( unsigned int index : transients )
+    {
+        TextureNode& texture = textures[index];
+        const TextureDescription& description = texture.description;
+        size_t bytes = (size_t) description.width * description.height * bytesPerPixel( description.internalFormat ) *
+                       std::max( description.samples, 1 );
+        transientBytes += bytes;
+        for ( unsigned int candidate = 0; candidate < pool.size( ) && texture.pooled == NONE; candidate++ )
+            if ( pool[candidate].busyUntil < texture.firstUse && sameDescription( pool[candidate].description, description ) )
+                texture.pooled = (int) candidate;
+        if ( texture.pooled == NONE )
+        {
+            PooledTexture pooled;
+            pooled.texture = ScopedTexture( resources, resources.createTexture( "render graph transient" ) );
+            pooled.description = description;
+            pooled.bytes = bytes;
+            if ( description.samples > 0 )
+            {
+                // multisampled textures have no filtering of their own, they are resolved or fetched
+                glBindTexture( GL_TEXTURE_2D_MULTISAMPLE, pooled.texture.name( ) );
+                glTexImage2DMultisample( GL_TEXTURE_2D_MULTISAMPLE, description.samples, description.internalFormat,
+                                         description.width, description.height, GL_TRUE );
+                glBindTexture( GL_TEXTURE_2D_MULTISAMPLE, 0 );
+            }
+            else
+            {
+                glBindTexture( GL_TEXTURE_2D, pooled.texture.name( ) );
+                glTexImage2D( GL_TEXTURE_2D, 0, description.internalFormat, description.width, description.height, 0,
+                              description.format, description.type, nullptr );
+                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, description.filter );
+                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, description.filter );
+                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+                glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+                glBindTexture( GL_TEXTURE_2D, 0 );
+            }
+            resources.setSize( pooled.texture.get( ), bytes );
+            pool.push_back( std::move( pooled ) );
+            texture.pooled = (int) pool.size( ) - 1;
+        }
+        pool[texture.pooled].busyUntil = texture.lastUse;
+        pool[texture.pooled].used = true;
+    }
+
+    // releasing the pooled textures this graph does not use
+    std::vector<int> moved( pool.size( ), NONE );
+    std::vector<PooledTexture> kept;
+    for ( unsigned int index = 0; index < pool.size( ); index++ )
+        if ( pool[index].used )
+        {
+            moved[index] = (int) kept.size( );
+            kept.push_back( std::move( pool[index] ) );
+        }
+    pool = std::move( kept );
+    for ( unsigned int index : transients )
+        textures[index].pooled = moved[textures[index].pooled];
+    // the cached framebuffers may hold released textures
+    framebuffers.clear( );
+
+    pooledBytes = 0;
+    for ( const PooledTexture& pooled : pool )
+        pooledBytes += pooled.bytes;
+    peakLiveBytes = 0;
+    for ( unsigned int position = 0; position < schedule.size( ); position++ )
+    {
+        size_t live = 0;
+        for ( unsigned int index : transients )
+            if ( textures[index].firstUse <= (int) position && textures[index].lastUse >= (int) position )
+                live += pool[textures[index].pooled].bytes;
+        peakLiveBytes = std::max( peakLiveBytes, live );
+    }
+    transientCount = (unsigned int) transients.size( );
+    pooledCount = (unsigned int) pool.size( );
+}
+
+void RenderGraph::execute( )
+{
+    if ( !compiled )
+        compile( );
+    executions++;
+    for ( Pass index : schedule )
+    {
+        const PassNode& pass = passes[index];
+        if ( pass.colorCount > 0 || pass.depth != NONE )
+            bindAttachments( pass );
+        if ( pass.execute )
+            pass.execute( );
+    }
+}
+
+void RenderGraph::bindAttachments( const PassNode& pass )
+{
+    // the back buffer cannot share a framebuffer with textures
+    for ( unsigned int i = 0; i < pass.colorCount; i++ )
+        if ( textures[versions[pass.colors[i]].texture].kind == Kind::BACKBUFFER )
+        {
+            glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+            return;
+        }
+
+    GLuint colors[MAX_COLOR_ATTACHMENTS];
+    for ( unsigned int i = 0; i < pass.colorCount; i++ )
+        colors[i] = texture( pass.colors[i] );
+    GLuint depth = pass.depth != NONE ? texture( (Resource) pass.depth ) : 0;
+    for ( const Framebuffer& framebuffer : framebuffers )
+        if ( framebuffer.colorCount == pass.colorCount && framebuffer.depth == depth &&
+             std::equal( colors, colors + pass.colorCount, framebuffer.colors ) )
+        {
+            glBindFramebuffer( GL_FRAMEBUFFER, framebuffer.framebuffer.name( ) );
+            return;
+        }
+
+    Framebuffer framebuffer;
+    framebuffer.framebuffer = ScopedFramebuffer( resources, resources.createFramebuffer( "render graph pass" ) );
+    framebuffer.colorCount = pass.colorCount;
+    framebuffer.depth = depth;
+    std::copy( colors, colors + pass.colorCount, framebuffer.colors );
+    glBindFramebuffer( GL_FRAMEBUFFER, framebuffer.framebuffer.name( ) );
+    GLenum drawBuffers[MAX_COLOR_ATTACHMENTS];
+    for ( unsigned int i = 0; i < pass.colorCount; i++ )
+    {
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+        glFramebufferTexture2D( GL_FRAMEBUFFER, drawBuffers[i], textureTarget( pass.colors[i] ), colors[i], 0 );
+    }
+    if ( pass.depth != NONE )
+    {
+        GLenum internalFormat = textures[versions[pass.depth].texture].description.internalFormat;
+        GLenum attachment = hasStencil( internalFormat ) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+        glFramebufferTexture2D( GL_FRAMEBUFFER, attachment, textureTarget( (Resource) pass.depth ), depth, 0 );
+    }
+    if ( pass.colorCount > 0 )
+        glDrawBuffers( (GLsizei) pass.colorCount, drawBuffers );
+    else
+        glDrawBuffer( GL_NONE );
+    if ( glCheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE )
+        std::cerr << "ERROR::RENDER_GRAPH::FRAMEBUFFER_INCOMPLETE " << pass.name << std::endl;
+    framebuffers.push_back( std::move( framebuffer ) );
+}
+
+GLuint RenderGraph::texture( Resource resource ) const
+{
+    const TextureNode& node = textures[versions[resource].texture];
+    if ( node.kind == Kind::IMPORTED )
+        return resources.get( node.imported );
+    if ( node.kind == Kind::TRANSIENT && node.pooled != NONE )
+        return pool[node.pooled].texture.name( );
+    return 0;
+}
+
+GLenum RenderGraph::textureTarget( Resource resource ) const
+{
+    return textures[versions[resource].texture].description.samples > 0 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+}
+
+bool RenderGraph::sameDescription( const TextureDescription& a, const TextureDescription& b )
+{
+    return a.width == b.width && a.height == b.height && a.internalFormat == b.internalFormat &&
+           a.format == b.format && a.type == b.type && a.filter == b.filter && a.samples == b.samples;
+}
+
+size_t RenderGraph::bytesPerPixel( GLenum internalFormat )
+{
+    switch ( internalFormat )
+    {
+    case GL_R8:
+        return 1;
+    case GL_RG8:
+    case GL_R16F:
+        return 2;
+    case GL_RGBA16F:
+    case GL_RG32F:
+        return 8;
+    case GL_RGBA32F:
+        return 16;
+    default:
+        // RGBA8, RG16_SNORM, RG16F, R32F, the 24 and 32 bit depth formats
+        return 4;
+    }
+}
+
+bool RenderGraph::hasStencil( GLenum internalFormat )
+{
+    return internalFormat == GL_DEPTH24_STENCIL8 || internalFormat == GL_DEPTH32F_STENCIL8;
+}
+
+void RenderGraph::shutdown( )
+{
+    framebuffers.clear( );
+    pool.clear( );
+    clear( );
+}
+
+void RenderGraph::report( std::ostream& out ) const
+{
+    if ( compiles == 0 )
+        return;
+    out << "Render graph: " << compiles << " compiles over " << executions << " frames, schedule:";
+    for ( unsigned int position = 0; position < schedule.size( ); position++ )
+        out << ( position == 0 ? " " : ", " ) << passes[schedule[position]].name;
+    unsigned int culled = 0;
+    for ( const PassNode& pass : passes )
+        if ( pass.culled )
+            out << ( culled++ == 0 ? "; culled: " : ", " ) << pass.name;
+    out << "; " << transientCount << " transients in " << pooledCount << " pooled textures, "
+        << (double) pooledBytes / ( 1024 * 1024 ) << " MB ( " << (double) transientBytes / ( 1024 * 1024 )
+        << " MB without aliasing, " << (double) peakLiveBytes / ( 1024 * 1024 ) << " MB live at once at most )" << std::endl;
+}
@@ -0,0 +1,733 @@
+#include "learnopengl-implementation/renderer.h"
+#include "learnopengl-implementation/job_system.h"
+#include "learnopengl-implementation/image_decoder.h"
+#include "learnopengl-implementation/io_service.h"
+#include "learnopengl-implementation/texture_streamer.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+    // image read by the I/O service, decoded into a mip chain by a worker and then
+    // handed to the streamer by the GL thread
+    struct TextureLoad
+    {
+        IoRequest read;
+        std::vector<unsigned char> encoded;
+        TextureStreamer* streamer;
+        // takes the chain instead of the streamer when set and able to
+        VirtualTexture* virtualTexture;
+        TextureHandle texture;
+        const char* label;
+        GLenum format;
+        MipChain chain;
+    };
+
+    // triangle vertices in normalized device coordinates
+    // float vertices[] = {
+    //     // positions          // texture coords
+    //      0.5f,  0.5f, 0.0f,   1.0f, 1.0f,   // top right
+    //      0.5f, -0.5f, 0.0f,   1.0f, 0.0f,   // bottom right
+    //     -0.5f, -0.5f, 0.0f,   0.0f, 0.0f,   // bottom left 
+    //     -0.5f,  0.5f, 0.0f,   0.0f, 1.0f    // top left
+    // };
+
+    const float vertices[] = {
+        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
+        0.5f, -0.5f, -0.5f,  1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
+
+        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+
+        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+
+        0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+
+        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  1.0f, 0.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f,
+
+        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  1.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f
+    };
+
+    const unsigned int indices[] = {
+        0, 1, 3,    // first triangle
+        1, 2, 3     // second triangle
+    };
+
+    // a source mapped with the pack, a missing asset gives an empty one
+    Shader::Chunk sourceOf( const AssetView& view )
+    {
+        return Shader::Chunk{ view.isValid( ) ? (const GLchar*) view.data : "", (GLint) view.size };
+    }
+
+    // builds a shader from two mapped sources and the chunks its fragment shader uses
+    Shader* buildShader( const AssetView& vertex, const AssetView& fragment, const Shader::Chunk* chunks = nullptr, int chunkCount = 0 )
+    {
+        Shader::Chunk vertexSource = sourceOf( vertex );
+        Shader::Chunk fragmentSource = sourceOf( fragment );
+        return new Shader( vertexSource.source, vertexSource.length, fragmentSource.source, fragmentSource.length, chunks, chunkCount );
+    }
+
+    // points a read at the bytes of an asset, a missing asset fails with EBADF when read
+    void locateRead( IoRequest& request, const AssetLocation& location, void* destination )
+    {
+        request.file = location.file;
+        request.offset = location.offset;
+        request.size = location.size;
+        request.destination = destination;
+    }
+
+    // decodes the image of a TextureLoad once its read completed, runs on a worker thread
+    void decodeTexture( void* data, unsigned int, unsigned int )
+    {
+        TextureLoad* load = (TextureLoad*) data;
+        if ( load->read.result != (long long) load->encoded.size( ) || load->encoded.empty( ) )
+            return;
+
+        int width, height, nrChannels;
+        int channels = load->format == GL_RGBA ? 4 : 3;
+        unsigned char* pixels = ImageDecoder::loadFromMemory( load->encoded.data( ), load->encoded.size( ), &width, &height, &nrChannels, channels );
+        if ( pixels )
+            load->chain = buildMipChain( pixels, width, height, channels );
+        ImageDecoder::release( pixels );
+    }
+
+    // gives a decoded TextureLoad to the virtual texture or to the streamer, which uploads
+    // its smallest levels, runs on the GL thread
+    void uploadTexture( void* data, unsigned int, unsigned int )
+    {
+        TextureLoad* load = (TextureLoad*) data;
+        if ( load->chain.levels.empty( ) )
+            std::cerr << "Failed to load texture: " << ImageDecoder::failureReason( ) << std::endl;
+        else if ( !load->virtualTexture || !load->virtualTexture->initialize( std::move( load->chain ) ) )
+            load->streamer->add( load->texture, load->label, std::move( load->chain ) );
+    }
+}
+
+Renderer::Renderer( JobSystem& jobs, IoService& io, const AssetPack& assets, const Settings& settings )
+    : jobs( jobs ), io( io ), assets( assets ), streamer( resources, settings.streaming ),
+      virtualTexture( jobs, resources, settings.virtualTexturing ), readback( resources, settings.capture ),
+      video( jobs, resources, settings.video ), recording( settings.video.enabled ), resolution( resources, settings.resolution ),
+      depthPrepass( resources, settings.depthPrepass ), deferred( resources, settings.deferred ),
+      clustered( jobs, resources, settings.clustered ), shadows( resources, settings.shadows ),
+      antiAliasing( resources, settings.antiAliasing ), temporal( resources, settings.temporal ),
+      transparency( resources, settings.transparency ), graph( resources )
+{
+}
+
+void Renderer::initialize( )
+{
+    // enabling depth test
+    glEnable( GL_DEPTH_TEST );
+
+    // reading the images first so the reads overlap the setup below, each is decoded on the
+    // workers as soon as it arrives
+    const char* textureNames[] = { "textures/container.jpg", "textures/awesomeface.png" };
+    const char* textureLabels[] = { "container", "awesomeface" };
+    const GLenum textureFormats[] = { GL_RGB, GL_RGBA };
+    TextureLoad textureLoads[2];
+    JobCounter decoded, uploaded;
+    ImageDecoder::setFlipVertically( true );
+    for ( unsigned int i = 0; i < 2; i++ )
+    {
+        TextureLoad& load = textureLoads[i];
+        AssetLocation location = assets.locate( textureNames[i] );
+        load.encoded.resize( location.size );
+        load.format = textureFormats[i];
+        load.label = textureLabels[i];
+        load.streamer = &streamer;
+        load.virtualTexture = i == 0 ? &virtualTexture : nullptr;
+        locateRead( load.read, location, load.encoded.data( ) );
+        load.read.completion = decodeTexture;
+        load.read.data = &load;
+        if ( location.isValid( ) && location.size > 0 )
+            io.submit( &load.read, &decoded );
+    }
+
+    // generating a Vertex Array Object to store the states that were set
+    VAO = ScopedVertexArray( resources, resources.createVertexArray( "cube vertex array" ) );
+    // generating a Vertex Buffer Object to be able to send the vertices data do the GPU
+    VBO = ScopedBuffer( resources, resources.createBuffer( "cube vertices" ) );
+    // generating a Element Buffer Object to store the vertex indices to be part of a specified triangle
+    EBO = ScopedBuffer( resources, resources.createBuffer( "cube indices" ) );
+
+    // biding the Vertex Array Object (first)
+    glBindVertexArray( VAO.name( ) );
+
+    // binding the newly generated Vertex Buffer Object with the GL_ARRAY_BUFFER of OpenGL (second)
+    glBindBuffer( GL_ARRAY_BUFFER, VBO.name( ) );
+    // copying the previourly defined vertex data into the buffer's memory (third)
+    glBufferData( GL_ARRAY_BUFFER, sizeof( vertices ), vertices, GL_STATIC_DRAW );
+    resources.setSize( VBO.get( ), sizeof( vertices ) );
+
+    // binding the newly generated Element Buffer Object with the GL_ELEMENT_ARRAY_BUFFER of OpenGL
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, EBO.name( ) );
+    // copying the previously defined index data into the buffer's memory
+    glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( indices ), indices, GL_STATIC_DRAW );
+    resources.setSize( EBO.get( ), sizeof( indices ) );
+    
+    // teaching OpenGL how it should interpret the Vertex Data (fourth)
+    glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, 5*sizeof(float), (void*)0 );
+    glEnableVertexAttribArray( 0 );
+    glVertexAttribPointer( 1, 2, GL_FLOAT, GL_FALSE, 5*sizeof(float), (void*)(3*sizeof(float)) );
+    glEnableVertexAttribArray( 1 );
+    // unbiding the current Vertex Buffer Object
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+    // creating the shader objects straight from their views into the mapped pack, the virtual
+    // texture variants, the feedback and the G-buffer shaders share the vertex shader
+    const char* shaderNames[] = { "src/shader.vs", "src/shader.fs", "src/shader_vt.fs", "src/feedback.fs", "src/depth.vs", "src/depth.fs",
+                                  "src/gbuffer.fs", "src/gbuffer_vt.fs", "src/fullscreen.vs", "src/ambient.fs", "src/light.vs", "src/light.fs",
+                                  "src/fxaa.fs", "src/smaa_edges.fs", "src/smaa_weights.fs", "src/smaa_blend.fs", "src/taa.fs",
+                                  "src/transparent.vs", "src/transparent.fs", "src/transparent_composite.fs",
+                                  "src/shadows.glsl", "src/lighting.glsl", "src/wireframe.glsl" };
+    const unsigned int SHADER_FILES = sizeof( shaderNames ) / sizeof( shaderNames[0] );
+    AssetView shaderSources[SHADER_FILES];
+    for ( unsigned int i = 0; i < SHADER_FILES; i++ )
+        shaderSources[i] = assets.find( shaderNames[i] );
+
+    // the forward shaders get the shadows, the lighting and the wireframe, the G-buffer ones
+    // only the wireframe and the ambient pass only the shadows
+    const Shader::Chunk forwardChunks[] = { sourceOf( shaderSources[20] ), sourceOf( shaderSources[21] ), sourceOf( shaderSources[22] ) };
+    const Shader::Chunk gbufferChunks[] = { sourceOf( shaderSources[22] ) };
+    const Shader::Chunk ambientChunks[] = { sourceOf( shaderSources[20] ) };
+    shader.reset( buildShader( shaderSources[0], shaderSources[1], forwardChunks, 3 ) );
+    virtualShader.reset( buildShader( shaderSources[0], shaderSources[2], forwardChunks, 3 ) );
+    feedbackShader.reset( buildShader( shaderSources[0], shaderSources[3] ) );
+    depthShader.reset( buildShader( shaderSources[4], shaderSources[5] ) );
+    gbufferShader.reset( buildShader( shaderSources[0], shaderSources[6], gbufferChunks, 1 ) );
+    gbufferVirtualShader.reset( buildShader( shaderSources[0], shaderSources[7], gbufferChunks, 1 ) );
+    ambientShader.reset( buildShader( shaderSources[8], shaderSources[9], ambientChunks, 1 ) );
+    lightShader.reset( buildShader( shaderSources[10], shaderSources[11] ) );
+    fxaaShader.reset( buildShader( shaderSources[8], shaderSources[12] ) );
+    smaaEdgeShader.reset( buildShader( shaderSources[8], shaderSources[13] ) );
+    smaaWeightShader.reset( buildShader( shaderSources[8], shaderSources[14] ) );
+    smaaBlendShader.reset( buildShader( shaderSources[8], shaderSources[15] ) );
+    taaShader.reset( buildShader( shaderSources[8], shaderSources[16] ) );
+    transparentShader.reset( buildShader( shaderSources[17], shaderSources[18] ) );
+    transparentCompositeShader.reset( buildShader( shaderSources[8], shaderSources[19] ) );
+
+    // the programs now belong to the resource pools, which delete them at shutdown
+    program = ScopedProgram( resources, resources.adoptProgram( shader->ID, "cube shader" ) );
+    virtualProgram = ScopedProgram( resources, resources.adoptProgram( virtualShader->ID, "virtual texture cube shader" ) );
+    feedbackProgram = ScopedProgram( resources, resources.adoptProgram( feedbackShader->ID, "virtual texture feedback shader" ) );
+    depthProgram = ScopedProgram( resources, resources.adoptProgram( depthShader->ID, "depth pre-pass shader" ) );
+    gbufferProgram = ScopedProgram( resources, resources.adoptProgram( gbufferShader->ID, "G-buffer shader" ) );
+    gbufferVirtualProgram = ScopedProgram( resources, resources.adoptProgram( gbufferVirtualShader->ID, "virtual texture G-buffer shader" ) );
+    ambientProgram = ScopedProgram( resources, resources.adoptProgram( ambientShader->ID, "deferred ambient shader" ) );
+    lightProgram = ScopedProgram( resources, resources.adoptProgram( lightShader->ID, "deferred light shader" ) );
+    fxaaProgram = ScopedProgram( resources, resources.adoptProgram( fxaaShader->ID, "FXAA shader" ) );
+    smaaEdgeProgram = ScopedProgram( resources, resources.adoptProgram( smaaEdgeShader->ID, "SMAA edge shader" ) );
+    smaaWeightProgram = ScopedProgram( resources, resources.adoptProgram( smaaWeightShader->ID, "SMAA weight shader" ) );
+    smaaBlendProgram = ScopedProgram( resources, resources.adoptProgram( smaaBlendShader->ID, "SMAA blend shader" ) );
+    taaProgram = ScopedProgram( resources, resources.adoptProgram( taaShader->ID, "TAA resolve shader" ) );
+    transparentProgram = ScopedProgram( resources, resources.adoptProgram( transparentShader->ID, "transparent quad shader" ) );
+    transparentCompositeProgram = ScopedProgram( resources, resources.adoptProgram( transparentCompositeShader->ID,
+                                                                                    "transparency composite shader" ) );
+
+    // creating and biding multiple textures
+    texture1 = ScopedTexture( resources, resources.createTexture( textureLabels[0] ) );
+    texture2 = ScopedTexture( resources, resources.createTexture( textureLabels[1] ) );
+    textureLoads[0].texture = texture1.get( );
+    textureLoads[1].texture = texture2.get( );
+
+    // activating the first texture unit to bind to it
+    glBindTexture( GL_TEXTURE_2D, texture1.name( ) );
+    // setting texture wrap
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+    // setting texture scaling
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    // setting mipmap filtering method
+    // glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+    // glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+
+    // setting texture border color
+    float borderColor[] = { 1.0f, 1.0f, 0.0f, 1.0f };
+    glTexParameterfv( GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor );
+
+    // activating the second texture unit to bind to it
+    glBindTexture( GL_TEXTURE_2D, texture2.name( ) );
+    // setting texture wrap
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT );
+    // setting texture scaling
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    // setting mipmap filtering method
+    // glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+    // glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+
+    // setting texture border color
+    glTexParameterfv( GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor );
+
+    // uploading the images as soon as they are decoded, the uploads run on this thread
+    for ( TextureLoad& load : textureLoads )
+        jobs.runPinned( uploadTexture, &load, &uploaded, &decoded );
+    jobs.wait( &uploaded );
+
+    // telling to which texture unit each shader sampler belongs to
+    clustered.initialize( );
+    shadows.initialize( *depthShader );
+    shader->use( );
+    shader->setInt( "texture1", 0 );
+    shader->setInt( "texture2", 1 );
+    clustered.setSamplers( *shader );
+    shadows.setSamplers( *shader );
+    mvpLocation = glGetUniformLocation( shader->ID, "mvp" );
+    previousMvpLocation = glGetUniformLocation( shader->ID, "previousMvp" );
+    gbufferShader->use( );
+    gbufferShader->setInt( "texture1", 0 );
+    gbufferShader->setInt( "texture2", 1 );
+    gbufferMvpLocation = glGetUniformLocation( gbufferShader->ID, "mvp" );
+    gbufferPreviousMvpLocation = glGetUniformLocation( gbufferShader->ID, "previousMvp" );
+
+    // the page table and the tile cache take the first unit's place
+    virtualShader->use( );
+    virtualShader->setInt( "physicalCache", 0 );
+    virtualShader->setInt( "texture2", 1 );
+    virtualShader->setInt( "pageTable", 2 );
+    clustered.setSamplers( *virtualShader );
+    shadows.setSamplers( *virtualShader );
+    virtualMvpLocation = glGetUniformLocation( virtualShader->ID, "mvp" );
+    virtualPreviousMvpLocation = glGetUniformLocation( virtualShader->ID, "previousMvp" );
+    gbufferVirtualShader->use( );
+    gbufferVirtualShader->setInt( "physicalCache", 0 );
+    gbufferVirtualShader->setInt( "texture2", 1 );
+    gbufferVirtualShader->setInt( "pageTable", 2 );
+    gbufferVirtualMvpLocation = glGetUniformLocation( gbufferVirtualShader->ID, "mvp" );
+    gbufferVirtualPreviousMvpLocation = glGetUniformLocation( gbufferVirtualShader->ID, "previousMvp" );
+    feedbackMvpLocation = glGetUniformLocation( feedbackShader->ID, "mvp" );
+    depthMvpLocation = glGetUniformLocation( depthShader->ID, "mvp" );
+    if ( virtualTexture.isReady( ) )
+    {
+        virtualTexture.setUniforms( *virtualShader );
+        gbufferVirtualShader->use( );
+        virtualTexture.setUniforms( *gbufferVirtualShader );
+        feedbackShader->use( );
+        virtualTexture.setUniforms( *feedbackShader );
+    }
+    geometry.initialize( resources );
+    deferred.initialize( geometry, *ambientShader, *lightShader );
+    ambientShader->use( );
+    shadows.setSamplers( *ambientShader );
+    antiAliasing.initialize( geometry, *fxaaShader, *smaaEdgeShader, *smaaWeightShader, *smaaBlendShader );
+    temporal.initialize( geometry, *taaShader );
+    transparency.initialize( geometry, *transparentShader, *transparentCompositeShader );
+}
+
+void Renderer::render( const FramePacket& packet )
+{
+    // deleting whatever was released since the last frame
+    resources.flush( );
+    // handing the captures whose copy finished to the encoders
+    readback.update( );
+    // converting the recorded frames whose copy finished, and writing the converted ones
+    if ( recording )
+        video.update( );
+
+    // picking this frame's scene resolution from the GPU time of the last ones, everything
+    // up to the upscale is drawn at that size; TAA reconstructs the window size from less
+    GraphConfiguration configuration;
+    configuration.deferred = deferred.isEnabled( );
+    configuration.clustered = clustered.isEnabled( ) && !configuration.deferred;
+    configuration.shadows = shadows.isEnabled( );
+    configuration.antiAliasing = antiAliasing.supportedMode( packet.antiAliasing, configuration.deferred );
+    configuration.transparency = transparency.isEnabled( );
+    configuration.transparencyMode = transparency.supportedMode( packet.transparency, configuration.antiAliasing );
+    bool temporalAntiAliasing = configuration.antiAliasing == AntiAliasingMode::TAA;
+    resolution.beginFrame( packet.viewportWidth, packet.viewportHeight, temporalAntiAliasing ? temporal.renderScale( ) : 1.0f );
+    if ( temporalAntiAliasing )
+        temporal.beginFrame( resolution, packet.viewportWidth, packet.viewportHeight );
+    int height = resolution.renderHeight( );
+
+    // declaring the frame again only when the passes or the transient sizes change
+    configuration.width = resolution.targetWidth( );
+    configuration.height = resolution.targetHeight( );
+    if ( !( configuration == graphConfiguration ) )
+    {
+        graphConfiguration = configuration;
+        buildGraph( );
+    }
+    framePacket = &packet;
+    virtualTexturing = virtualTexture.isReady( );
+
+    // binning the lights of the forward path on the workers while the feedback pass is drawn
+    if ( configuration.clustered )
+        clustered.begin( packet );
+
+    // streaming in the mip levels the closest cube needs, one texel per pixel across a unit face:
+    // the clip w of a cube's center is its view depth
+    float closestFace = 0.0f;
+    for ( const DrawItem& draw : packet.draws )
+    {
+        float depth = draw.mvp[3][3];
+        if ( depth > 0.0f )
+            closestFace = std::max( closestFace, packet.projection[1][1] * 0.5f * height / depth );
+    }
+    if ( closestFace > 0.0f )
+    {
+        if ( !virtualTexturing )
+            streamer.request( texture1.get( ), closestFace );
+        streamer.request( texture2.get( ), closestFace );
+    }
+    streamer.update( );
+
+    // sorting the transparent quads when the mode needs it, with the scene's jitter
+    if ( configuration.transparency )
+    {
+        glm::mat4 projection = temporalAntiAliasing ? temporal.jitterMatrix( ) * packet.projection : packet.projection;
+        transparency.prepare( packet, configuration.transparencyMode, projection, texture2.name( ) );
+    }
+
+    graph.execute( );
+    framePacket = nullptr;
+}
+
+void Renderer::buildGraph( )
+{
+    graph.clear( );
+    RenderGraph::Resource sceneColor = graph.importTexture( "scene color", resolution.colorTexture( ), GL_RGBA8 );
+    RenderGraph::Resource sceneDepth = graph.importTexture( "scene depth", resolution.depthTexture( ), GL_DEPTH24_STENCIL8 );
+    RenderGraph::Resource shadowAtlas = graph.importTexture( "shadow atlas", shadows.atlasTexture( ), GL_DEPTH_COMPONENT24 );
+    RenderGraph::Resource window = graph.importBackbuffer( "window" );
+    RenderGraph::Resource multisampled = 0;
+    RenderGraph::Resource multisampledDepth = 0;
+    // the motion of every pixel the scene pass writes for TAA
+    bool temporalAntiAliasing = graphConfiguration.antiAliasing == AntiAliasingMode::TAA;
+    RenderGraph::Resource velocity = 0;
+    if ( temporalAntiAliasing )
+        velocity = graph.createTexture( "velocity", TemporalAntiAliasing::velocityDescription( resolution ) );
+
+    // rendering the pages the virtual texture needs into its feedback target, they are read
+    // back a few frames later and the missing ones loaded meanwhile
+    RenderGraph::Pass feedback = graph.addPass( "virtual texture feedback", [this]( )
+    {
+        if ( virtualTexturing && virtualTexture.beginFeedback( resolution.renderWidth( ), resolution.renderHeight( ) ) )
+        {
+            glBindVertexArray( VAO.name( ) );
+            feedbackShader->use( );
+            drawCubes( feedbackMvpLocation );
+            virtualTexture.endFeedback( );
+        }
+        virtualTexture.update( );
+    } );
+    graph.write( feedback, graph.createMarker( "page requests" ) );
+    graph.setSideEffects( feedback );
+
+    // drawing the dynamic shadow casters over the cached static ones, culled when nothing is lit
+    if ( graphConfiguration.shadows )
+    {
+        RenderGraph::Pass shadowMaps = graph.addPass( "shadow maps", [this]( )
+        {
+            glBindVertexArray( VAO.name( ) );
+            shadows.render( *framePacket );
+        } );
+        shadowAtlas = graph.write( shadowMaps, shadowAtlas );
+    }
+
+    if ( graphConfiguration.deferred )
+    {
+        // rendering the cubes into the G-buffer, then lighting it into the scene target
+        RenderGraph::Resource albedo = graph.createTexture( "G-buffer albedo", DeferredShading::albedoDescription( resolution ) );
+        RenderGraph::Resource normal = graph.createTexture( "G-buffer normal", DeferredShading::normalDescription( resolution ) );
+        RenderGraph::Pass geometry = graph.addPass( "G-buffer", [this]( )
+        {
+            antiAliasing.beginMeasurement( graphConfiguration.antiAliasing );
+            deferred.beginGeometry( resolution );
+            drawScene( );
+        } );
+        albedo = graph.writeColor( geometry, albedo );
+        normal = graph.writeColor( geometry, normal );
+        // cleared to no motion with the rest of the G-buffer
+        if ( temporalAntiAliasing )
+            velocity = graph.writeColor( geometry, velocity );
+        sceneDepth = graph.writeDepth( geometry, sceneDepth );
+
+        RenderGraph::Pass lighting = graph.addPass( "deferred lighting", [this, albedo, normal]( )
+        {
+            deferred.shade( *framePacket, resolution, shadows, graph.texture( albedo ), graph.texture( normal ) );
+        } );
+        graph.read( lighting, albedo );
+        graph.read( lighting, normal );
+        graph.read( lighting, sceneDepth );
+        if ( graphConfiguration.shadows )
+            graph.read( lighting, shadowAtlas );
+        sceneColor = graph.writeColor( lighting, sceneColor );
+    }
+    else
+    {
+        RenderGraph::Pass forward = graph.addPass( "forward", [this]( )
+        {
+            antiAliasing.beginMeasurement( graphConfiguration.antiAliasing );
+            glViewport( 0, 0, resolution.renderWidth( ), resolution.renderHeight( ) );
+            glClearColor( 0.2f, 0.3f, 0.3f, 1.0f );
+            glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+            if ( graphConfiguration.antiAliasing == AntiAliasingMode::TAA )
+                TemporalAntiAliasing::clearVelocity( 1 );
+            drawScene( );
+        } );
+        if ( graphConfiguration.antiAliasing == AntiAliasingMode::MSAA )
+        {
+            // drawn multisampled, then resolved into the scene color
+            multisampled = graph.writeColor( forward, graph.createTexture( "multisampled color", antiAliasing.multisampledColor( resolution ) ) );
+            multisampledDepth = graph.writeDepth( forward, graph.createTexture( "multisampled depth", antiAliasing.multisampledDepth( resolution ) ) );
+        }
+        else
+        {
+            sceneColor = graph.writeColor( forward, sceneColor );
+            if ( temporalAntiAliasing )
+                velocity = graph.writeColor( forward, velocity );
+            sceneDepth = graph.writeDepth( forward, sceneDepth );
+        }
+        if ( graphConfiguration.clustered )
+        {
+            // uploading the light lists binned meanwhile, ordered ahead of the pass reading them
+            RenderGraph::Pass lightLists = graph.addPass( "light lists", [this]( )
+            {
+                clustered.finish( );
+            } );
+            graph.read( forward, graph.write( lightLists, graph.createMarker( "light lists" ) ) );
+            if ( graphConfiguration.shadows )
+                graph.read( forward, shadowAtlas );
+        }
+    }
+
+    // blending the transparent quads over the opaque scene, into the multisampled targets for MSAA;
+    // they write no motion, so under TAA they follow the history of the surface behind them
+    if ( graphConfiguration.transparency )
+    {
+        if ( graphConfiguration.antiAliasing == AntiAliasingMode::MSAA )
+            transparency.addPasses( graph, graphConfiguration.transparencyMode, multisampled, multisampledDepth, resolution );
+        else
+            transparency.addPasses( graph, graphConfiguration.transparencyMode, sceneColor, sceneDepth, resolution );
+    }
+
+    // smoothing the edges at the scene resolution, or accumulating the frames at the window's
+    RenderGraph::Resource antiAliased;
+    if ( temporalAntiAliasing )
+    {
+        // only a timestamp, its version of the scene color keeps it between the scene and the resolve
+        RenderGraph::Pass mark = graph.addPass( "TAA start", [this]( )
+        {
+            antiAliasing.beginPost( );
+        } );
+        sceneColor = graph.write( mark, sceneColor );
+        antiAliased = temporal.addPasses( graph, sceneColor, sceneDepth, velocity, resolution );
+    }
+    else
+        antiAliased = antiAliasing.addPasses( graph, graphConfiguration.antiAliasing, sceneColor, multisampled, resolution );
+
+    // upscaling into the window ( copying for TAA, which already has its size ), the captures read the window
+    RenderGraph::Pass upscale = graph.addPass( "upscale", [this, antiAliased]( )
+    {
+        antiAliasing.endMeasurement( );
+        if ( graphConfiguration.antiAliasing == AntiAliasingMode::TAA )
+            resolution.endFrame( temporal.outputTexture( ), temporal.outputWidth( ), temporal.outputHeight( ) );
+        else
+            resolution.endFrame( graph.texture( antiAliased ) );
+    } );
+    graph.read( upscale, antiAliased );
+    window = graph.writeColor( upscale, window );
+    graph.markOutput( window );
+
+    RenderGraph::Pass captures = graph.addPass( "captures", [this]( )
+    {
+        if ( framePacket->capture )
+            readback.capture( framePacket->viewportWidth, framePacket->viewportHeight, framePacket->frameIndex );
+        if ( recording )
+            video.capture( framePacket->viewportWidth, framePacket->viewportHeight );
+    } );
+    graph.read( captures, window );
+    graph.write( captures, graph.createMarker( "captured frames" ) );
+    graph.setSideEffects( captures );
+
+    graph.compile( );
+}
+
+void Renderer::drawScene( )
+{
+    const FramePacket& packet = *framePacket;
+    bool deferredShading = graphConfiguration.deferred;
+    bool clusteredShading = graphConfiguration.clustered;
+
+    // laying down the depth of the front surfaces first when the shading it saves is worth it
+    glBindVertexArray( VAO.name( ) );
+    if ( depthPrepass.begin( ) )
+    {
+        depthShader->use( );
+        drawCubes( depthMvpLocation );
+    }
+
+    // activating the Shader Program
+    Shader* cubeShader = virtualTexturing ? virtualShader.get( ) : shader.get( );
+    int cubeMvpLocation = virtualTexturing ? virtualMvpLocation : mvpLocation;
+    if ( deferredShading )
+    {
+        cubeShader = virtualTexturing ? gbufferVirtualShader.get( ) : gbufferShader.get( );
+        cubeMvpLocation = virtualTexturing ? gbufferVirtualMvpLocation : gbufferMvpLocation;
+    }
+    cubeShader->use( );
+    cubeShader->setFloat( "mixValue", packet.mixValue );
+    // the edges come out of the shading itself, every pass keeps filling whole triangles
+    cubeShader->setInt( "wireframe", (int) packet.wireframe );
+    if ( deferredShading )
+        deferred.setGeometryUniforms( *cubeShader, packet, resolution );
+    else
+        cubeShader->setBool( "lighting", clusteredShading );
+    if ( clusteredShading )
+    {
+        clustered.bind( *cubeShader, packet, resolution.renderWidth( ), resolution.renderHeight( ) );
+        shadows.bind( *cubeShader );
+    }
+
+    // activating and binding each texture unit
+    if ( virtualTexturing )
+    {
+        virtualTexture.bind( 2, 0 );
+    }
+    else
+    {
+        glActiveTexture( GL_TEXTURE0 );
+        glBindTexture( GL_TEXTURE_2D, texture1.name( ) );
+    }
+    glActiveTexture( GL_TEXTURE1 );
+    glBindTexture( GL_TEXTURE_2D, texture2.name( ) );
+
+    // rendering the visible cubes
+    int cubePreviousMvpLocation = virtualTexturing ? virtualPreviousMvpLocation : previousMvpLocation;
+    if ( deferredShading )
+        cubePreviousMvpLocation = virtualTexturing ? gbufferVirtualPreviousMvpLocation : gbufferPreviousMvpLocation;
+    depthPrepass.beginShading( );
+    drawCubes( cubeMvpLocation, cubePreviousMvpLocation );
+    depthPrepass.end( );
+}
+
+void Renderer::drawCubes( int mvpLocation, int previousMvpLocation )
+{
+    const FramePacket& packet = *framePacket;
+    if ( graphConfiguration.antiAliasing != AntiAliasingMode::TAA )
+    {
+        for ( const DrawItem& draw : packet.draws )
+        {
+            glUniformMatrix4fv( mvpLocation, 1, GL_FALSE, glm::value_ptr( draw.mvp ) );
+            glDrawArrays( GL_TRIANGLES, 0, 36 );
+        }
+        return;
+    }
+
+    // the same offset on every pass of the frame, so the pre-pass depth still matches, and on
+    // the previous mvp too, so it cancels out of the motion
+    const glm::mat4& jitter = temporal.jitterMatrix( );
+    for ( size_t i = 0; i < packet.draws.size( ); i++ )
+    {
+        glm::mat4 mvp = jitter * packet.draws[i].mvp;
+        glUniformMatrix4fv( mvpLocation, 1, GL_FALSE, glm::value_ptr( mvp ) );
+        if ( previousMvpLocation >= 0 )
+        {
+            glm::mat4 previousMvp = i < packet.previousMvps.size( ) ? jitter * packet.previousMvps[i] : mvp;
+            glUniformMatrix4fv( previousMvpLocation, 1, GL_FALSE, glm::value_ptr( previousMvp ) );
+        }
+        glDrawArrays( GL_TRIANGLES, 0, 36 );
+    }
+}
+
+void Renderer::shutdown( )
+{
+    resources.report( std::cout );
+    streamer.report( std::cout );
+    virtualTexture.report( std::cout );
+    readback.shutdown( );
+    readback.report( std::cout );
+    video.shutdown( );
+    video.report( std::cout );
+    resolution.report( std::cout );
+    depthPrepass.report( std::cout );
+    deferred.report( std::cout );
+    clustered.report( std::cout );
+    shadows.report( std::cout );
+    antiAliasing.report( std::cout );
+    temporal.report( std::cout );
+    transparency.report( std::cout );
+    graph.report( std::cout );
+
+    // deallocating all the used resources, anything the pools still hold afterwards is a leak
+    texture1.reset( );
+    texture2.reset( );
+    EBO.reset( );
+    VBO.reset( );
+    VAO.reset( );
+    virtualTexture.shutdown( );
+    graph.shutdown( );
+    antiAliasing.shutdown( );
+    temporal.shutdown( );
+    transparency.shutdown( );
+    deferred.shutdown( );
+    clustered.shutdown( );
+    shadows.shutdown( );
+    resolution.shutdown( );
+    depthPrepass.shutdown( );
+    geometry.shutdown( );
+    program.reset( );
+    virtualProgram.reset( );
+    feedbackProgram.reset( );
+    depthProgram.reset( );
+    gbufferProgram.reset( );
+    gbufferVirtualProgram.reset( );
+    ambientProgram.reset( );
+    lightProgram.reset( );
+    fxaaProgram.reset( );
+    smaaEdgeProgram.reset( );
+    smaaWeightProgram.reset( );
+    smaaBlendProgram.reset( );
+    taaProgram.reset( );
+    transparentProgram.reset( );
+    transparentCompositeProgram.reset( );
+    shader.reset( );
+    virtualShader.reset( );
+    feedbackShader.reset( );
+    depthShader.reset( );
+    gbufferShader.reset( );
+    gbufferVirtualShader.reset( );
+    ambientShader.reset( );
+    lightShader.reset( );
+    fxaaShader.reset( );
+    smaaEdgeShader.reset( );
+    smaaWeightShader.reset( );
+    smaaBlendShader.reset( );
+    taaShader.reset( );
+    transparentShader.reset( );
+    transparentCompositeShader.reset( );
+    resources.shutdown( std::cerr );
+}
@@ -30,17 +30,26 @@ Shader::Shader( const char* vertexPath, const char* fragmentPath )
     {
         std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
     }    
-    const char* vShaderCode = vertexCode.c_str( );
-    const char* fShaderCode = fragmentCode.c_str( );
-    
-    // 2. compile shaders
+    build( vertexCode.c_str( ), (GLint) vertexCode.size( ), fragmentCode.c_str( ), (GLint) fragmentCode.size( ), nullptr, 0 );
+}
+
+Shader::Shader( const GLchar* vertexSource, GLint vertexLength, const GLchar* fragmentSource, GLint fragmentLength,
+                const Chunk* fragmentChunks, int chunkCount )
+{
+    build( vertexSource, vertexLength, fragmentSource, fragmentLength, fragmentChunks, chunkCount );
+}
+
+void Shader::build( const GLchar* vShaderCode, GLint vertexLength, const GLchar* fShaderCode, GLint fragmentLength,
+                    const Chunk* fragmentChunks, int chunkCount )
+{
+    // 2. compile shaders ( the lengths let the sources point into a mapped file without a terminator )
     unsigned int vertex, fragment;
     int success;
     char infoLog[512];
 
     // vertex shader
     vertex = glCreateShader( GL_VERTEX_SHADER );
-    glShaderSource( vertex, 1, &vShaderCode, NULL );    
+    glShaderSource( vertex, 1, &vShaderCode, &vertexLength );    
     glCompileShader( vertex );    
     // print compile errors if any
     glGetShaderiv( vertex, GL_COMPILE_STATUS, &success );
@@ -50,9 +59,42 @@ Shader::Shader( const char* vertexPath, const char* fragmentPath )
         std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
     }    
 
-    // fragment shader
+    // fragment shader, its #version line first, then the chunks and the rest of it; the #line
+    // directives keep error messages pointing at the right line, source string 0 being the
+    // shader itself and chunk i source string i + 1
+    GLint versionLength = 0;
+    if ( chunkCount > 0 && fragmentLength >= 8 && std::string( fShaderCode, 8 ) == "#version" )
+    {
+        while ( versionLength < fragmentLength && fShaderCode[versionLength] != '\n' )
+            versionLength++;
+        if ( versionLength < fragmentLength )
+            versionLength++;
+    }
+    std::vector<std::string> directives;
+    std::vector<const GLchar*> strings;
+    std::vector<GLint> lengths;
+    for ( int i = 0; i < chunkCount; i++ )
+        directives.push_back( "\n#line 1 " + std::to_string( i + 1 ) + "\n" );
+    directives.push_back( versionLength > 0 ? "\n#line 2 0\n" : "\n#line 1 0\n" );
+    strings.push_back( fShaderCode );
+    lengths.push_back( versionLength );
+    for ( int i = 0; i < chunkCount; i++ )
+    {
+        strings.push_back( directives[i].c_str( ) );
+        lengths.push_back( (GLint) directives[i].size( ) );
+        strings.push_back( fragmentChunks[i].source );
+        lengths.push_back( fragmentChunks[i].length );
+    }
+    if ( chunkCount > 0 )
+    {
+        strings.push_back( directives.back( ).c_str( ) );
+        lengths.push_back( (GLint) directives.back( ).size( ) );
+    }
+    strings.push_back( fShaderCode + versionLength );
+    lengths.push_back( fragmentLength - versionLength );
+
     fragment = glCreateShader( GL_FRAGMENT_SHADER );
-    glShaderSource( fragment, 1, &fShaderCode, NULL );
+    glShaderSource( fragment, (GLsizei) strings.size( ), strings.data( ), lengths.data( ) );
     glCompileShader( fragment );
     // print compile errors if any
     glGetShaderiv( fragment, GL_COMPILE_STATUS, &success );
@@ -85,17 +127,22 @@ void Shader::use( )
     glUseProgram( ID );
 }
 
-void Shader::setBool( const std::string name, bool value ) const
+void Shader::setBool( const char* name, bool value ) const
+{
+    glUniform1i( glGetUniformLocation( ID, name ), (int) value );
+}
+
+void Shader::setInt( const char* name, int value ) const
 {
-    glUniform1i( glGetUniformLocation( ID, name.c_str( ) ), (int) value );
+    glUniform1i( glGetUniformLocation( ID, name ), value );
 }
 
-void Shader::setInt( const std::string name, int value ) const
+void Shader::setFloat( const char* name, float value ) const
 {
-    glUniform1i( glGetUniformLocation( ID, name.c_str( ) ), value );
+    glUniform1f( glGetUniformLocation( ID, name ), value );
 }
 
-void Shader::setFloat( const std::string name, float value ) const
+void Shader::setVec2( const char* name, float x, float y ) const
 {
-    glUniform1f( glGetUniformLocation( ID, name.c_str( ) ), value );
+    glUniform2f( glGetUniformLocation( ID, name ), x, y );
 }
\ No newline at end of file
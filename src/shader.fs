@@ -1,14 +1,27 @@
 #version 330 core
 
-out vec4 FragColor;
+layout ( location = 0 ) out vec4 FragColor;
+// screen space motion since the last frame in texture coordinates, only kept by TAA
+layout ( location = 1 ) out vec2 velocity;
 
 in vec2 texCoord;
+in vec4 currentPosition;
+in vec4 previousPosition;
 
 uniform sampler2D texture1;
 uniform sampler2D texture2;
 uniform float mixValue;
 
+// shadows.glsl, lighting.glsl and wireframe.glsl are inserted after the #version line when
+// the renderer builds the shader, shade( ) and applyWireframe( ) come from them
+
 void main( )
 {
     FragColor = mix( texture( texture1, texCoord ), texture( texture2, texCoord ), mixValue );
+    // lit like the rest of the albedo, the dark lines stay dark
+    FragColor.rgb = applyWireframe( FragColor.rgb );
+    if ( lighting )
+        FragColor.rgb = shade( FragColor.rgb );
+    // both positions carry this frame's jitter, which cancels out
+    velocity = ( currentPosition.xy / currentPosition.w - previousPosition.xy / previousPosition.w ) * 0.5;
 }
\ No newline at end of file
@@ -4,14 +4,23 @@ layout ( location = 0 ) in vec3 aPos;
 layout ( location = 1 ) in vec2 aTexCoord;
 
 out vec2 texCoord;
+// clip space position of this frame and of the last one, for the motion vectors of TAA
+out vec4 currentPosition;
+out vec4 previousPosition;
+// the corner of the triangle as barycentric coordinates, for the wireframe: the cube is drawn
+// unindexed, so every three vertex IDs make a triangle, in any instance
+noperspective out vec3 barycentric;
+// the depth pre-pass ( depth.vs ) must produce the same depth
+invariant gl_Position;
 
-uniform mat4 transform;
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat4 mvp;
+uniform mat4 previousMvp;
 
 void main( )
 {
-    gl_Position = projection * view * model * vec4( aPos, 1.0f );
+    gl_Position = mvp * vec4( aPos, 1.0f );
     texCoord = aTexCoord;
+    currentPosition = gl_Position;
+    previousPosition = previousMvp * vec4( aPos, 1.0f );
+    barycentric = vec3( equal( ivec3( gl_VertexID % 3 ), ivec3( 0, 1, 2 ) ) );
 }
\ No newline at end of file
@@ -0,0 +1,46 @@
+#version 330 core
+
+layout ( location = 0 ) out vec4 FragColor;
+// screen space motion since the last frame in texture coordinates, only kept by TAA
+layout ( location = 1 ) out vec2 velocity;
+
+in vec2 texCoord;
+in vec4 currentPosition;
+in vec4 previousPosition;
+
+// the first texture is virtual: the page table holds, for every page of every level, the
+// tile ( rg ) and level ( b ) of the closest resident page, the tiles sit in the cache
+uniform sampler2D pageTable;
+uniform sampler2D physicalCache;
+uniform float virtualSize;
+uniform float tileSize;
+uniform float maxLevel;
+uniform sampler2D texture2;
+uniform float mixValue;
+// the lighting and the wireframe are shared with shader.fs
+
+vec4 sampleVirtual( vec2 uv )
+{
+    uv = clamp( uv, 0.0, 1.0 - 0.5 / virtualSize );
+    vec2 texels = uv * virtualSize;
+    float footprint = max( length( dFdx( texels ) ), length( dFdy( texels ) ) );
+    int level = int( clamp( floor( log2( max( footprint, 1.0 ) ) ), 0.0, maxLevel ) );
+
+    vec2 pages = vec2( virtualSize / tileSize ) / exp2( float( level ) );
+    vec4 entry = texelFetch( pageTable, ivec2( uv * pages ), level ) * 255.0;
+    ivec2 tile = ivec2( entry.rg + 0.5 );
+    float residentLevel = floor( entry.b + 0.5 );
+
+    vec2 inPage = fract( texels / ( tileSize * exp2( residentLevel ) ) ) * tileSize;
+    return texelFetch( physicalCache, tile * int( tileSize ) + ivec2( inPage ), 0 );
+}
+
+void main( )
+{
+    FragColor = mix( sampleVirtual( texCoord ), texture( texture2, texCoord ), mixValue );
+    FragColor.rgb = applyWireframe( FragColor.rgb );
+    if ( lighting )
+        FragColor.rgb = shade( FragColor.rgb );
+    // both positions carry this frame's jitter, which cancels out
+    velocity = ( currentPosition.xy / currentPosition.w - previousPosition.xy / previousPosition.w ) * 0.5;
+}
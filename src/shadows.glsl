@@ -0,0 +1,26 @@
+// sun shadows ( see CascadedShadows ): the cascade's matrix takes a view space position
+// to its place in the atlas
+uniform bool shadows;
+uniform sampler2DShadow shadowMap;
+uniform mat4 shadowMatrices[4];
+uniform vec4 cascadeSplits;
+uniform int cascadeCount;
+
+// part of the sun reaching a view space position, four bilinear comparisons
+float sunVisibility( vec3 position )
+{
+    if ( !shadows )
+        return 1.0;
+    int cascade = 0;
+    while ( cascade < cascadeCount && -position.z > cascadeSplits[cascade] )
+        cascade++;
+    if ( cascade == cascadeCount )
+        return 1.0;
+    vec4 coord = shadowMatrices[cascade] * vec4( position, 1.0 );
+    vec2 texel = 1.0 / vec2( textureSize( shadowMap, 0 ) );
+    float lit = texture( shadowMap, vec3( coord.xy + vec2( -0.5, -0.5 ) * texel, coord.z ) );
+    lit += texture( shadowMap, vec3( coord.xy + vec2( 0.5, -0.5 ) * texel, coord.z ) );
+    lit += texture( shadowMap, vec3( coord.xy + vec2( -0.5, 0.5 ) * texel, coord.z ) );
+    lit += texture( shadowMap, vec3( coord.xy + vec2( 0.5, 0.5 ) * texel, coord.z ) );
+    return lit * 0.25;
+}
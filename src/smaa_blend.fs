@@ -0,0 +1,39 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// last SMAA pass ( see AntiAliasing ): a pixel takes its neighbors' colors by the
+// weights of its sides and of the sides its lower and right neighbors share with
+// it, along whichever direction has the stronger ones
+uniform sampler2D color;
+uniform sampler2D weights;
+uniform ivec2 renderSize;
+
+vec3 colorAt( ivec2 pixel )
+{
+    return texelFetch( color, clamp( pixel, ivec2( 0 ), renderSize - 1 ), 0 ).rgb;
+}
+
+vec4 weightsAt( ivec2 pixel )
+{
+    if ( any( greaterThanEqual( pixel, renderSize ) ) || any( lessThan( pixel, ivec2( 0 ) ) ) )
+        return vec4( 0.0 );
+    return texelFetch( weights, pixel, 0 );
+}
+
+void main( )
+{
+    ivec2 pixel = ivec2( gl_FragCoord.xy );
+    vec4 own = weightsAt( pixel );
+    float up = own.x;
+    float down = weightsAt( pixel + ivec2( 0, -1 ) ).y;
+    float left = own.z;
+    float right = weightsAt( pixel + ivec2( 1, 0 ) ).w;
+    vec3 center = colorAt( pixel );
+
+    if ( max( up, down ) >= max( left, right ) )
+        center = center * ( 1.0 - up - down ) + colorAt( pixel + ivec2( 0, 1 ) ) * up + colorAt( pixel + ivec2( 0, -1 ) ) * down;
+    else
+        center = center * ( 1.0 - left - right ) + colorAt( pixel + ivec2( -1, 0 ) ) * left + colorAt( pixel + ivec2( 1, 0 ) ) * right;
+    FragColor = vec4( center, 1.0 );
+}
@@ -0,0 +1,40 @@
+#version 330 core
+
+out vec2 edges;
+
+// first SMAA pass ( see AntiAliasing ): whether a pixel's left ( x ) and upper ( y )
+// sides are edges, from the luma step across them. A step much weaker than the
+// strongest one around is dropped, so the blending follows the dominant edges
+uniform sampler2D color;
+uniform ivec2 renderSize;
+uniform float edgeThreshold;
+
+float lumaAt( ivec2 pixel )
+{
+    vec3 rgb = texelFetch( color, clamp( pixel, ivec2( 0 ), renderSize - 1 ), 0 ).rgb;
+    return dot( rgb, vec3( 0.2126, 0.7152, 0.0722 ) );
+}
+
+void main( )
+{
+    ivec2 pixel = ivec2( gl_FragCoord.xy );
+    float luma = lumaAt( pixel );
+    float left = lumaAt( pixel + ivec2( -1, 0 ) );
+    float up = lumaAt( pixel + ivec2( 0, 1 ) );
+    vec2 delta = abs( luma - vec2( left, up ) );
+    vec2 found = step( edgeThreshold, delta );
+    if ( found.x + found.y == 0.0 )
+    {
+        edges = vec2( 0.0 );
+        return;
+    }
+
+    // local contrast adaptation over the other steps next to the sides
+    float right = lumaAt( pixel + ivec2( 1, 0 ) );
+    float down = lumaAt( pixel + ivec2( 0, -1 ) );
+    float leftLeft = lumaAt( pixel + ivec2( -2, 0 ) );
+    float upUp = lumaAt( pixel + ivec2( 0, 2 ) );
+    vec4 around = abs( vec4( luma - right, luma - down, left - leftLeft, up - upUp ) );
+    float strongest = max( max( delta.x, delta.y ), max( max( around.x, around.y ), max( around.z, around.w ) ) );
+    edges = found * step( 0.5 * strongest, delta );
+}
@@ -0,0 +1,110 @@
+#version 330 core
+
+out vec4 weights;
+
+// second SMAA pass ( see AntiAliasing ): for the upper and the left side of a pixel,
+// when they are edges, the edge is followed both ways to its ends. A crossing edge at
+// an end shows on which side the silhouette steps, the line from the middle of that
+// step to the other end ( or to the middle of the edge when both ends step the same
+// way ) is the silhouette, and the area between it and the edge within the pixel is
+// how much of the pixel the neighbor across the edge covers, or the other way around.
+// x: this pixel toward the one above, y: the one above toward this one,
+// z: this pixel toward the left one, w: the left one toward this one
+uniform sampler2D edges;
+uniform ivec2 renderSize;
+uniform int searchSteps;
+
+vec2 edgesAt( ivec2 pixel )
+{
+    if ( any( lessThan( pixel, ivec2( 0 ) ) ) || any( greaterThanEqual( pixel, renderSize ) ) )
+        return vec2( 0.0 );
+    return texelFetch( edges, pixel, 0 ).rg;
+}
+
+// height of the silhouette at an edge's end from the crossing edges there, positive
+// when it steps on the neighbor's side
+float endHeight( float ownSide, float otherSide )
+{
+    if ( otherSide > 0.0 && ownSide == 0.0 )
+        return 0.5;
+    if ( ownSide > 0.0 && otherSide == 0.0 )
+        return -0.5;
+    return 0.0;
+}
+
+// positive and negative area of a line from h0 to h1 over a width
+vec2 lineArea( float h0, float h1, float width )
+{
+    if ( h0 * h1 >= 0.0 )
+    {
+        float area = 0.5 * ( h0 + h1 ) * width;
+        return vec2( max( area, 0.0 ), max( -area, 0.0 ) );
+    }
+    float crossing = h0 / ( h0 - h1 ) * width;
+    float area0 = 0.5 * h0 * crossing;
+    float area1 = 0.5 * h1 * ( width - crossing );
+    return vec2( max( area0, 0.0 ) + max( area1, 0.0 ), max( -area0, 0.0 ) + max( -area1, 0.0 ) );
+}
+
+float silhouette( float position, float edgeLength, float hStart, float hEnd )
+{
+    if ( hStart * hEnd > 0.0 )
+    {
+        float middle = 0.5 * edgeLength;
+        return position < middle ? hStart * ( 1.0 - position / middle ) : hEnd * ( position - middle ) / middle;
+    }
+    return mix( hStart, hEnd, position / edgeLength );
+}
+
+// area between the silhouette and an edge within the pixel distance pixels from its start
+vec2 pixelArea( float distance, float edgeLength, float hStart, float hEnd )
+{
+    float a = distance;
+    float b = distance + 1.0;
+    float middle = 0.5 * edgeLength;
+    if ( hStart * hEnd > 0.0 && a < middle && b > middle )
+        return lineArea( silhouette( a, edgeLength, hStart, hEnd ), 0.0, middle - a ) +
+               lineArea( 0.0, silhouette( b, edgeLength, hStart, hEnd ), b - middle );
+    return lineArea( silhouette( a, edgeLength, hStart, hEnd ), silhouette( b, edgeLength, hStart, hEnd ), 1.0 );
+}
+
+void main( )
+{
+    ivec2 pixel = ivec2( gl_FragCoord.xy );
+    vec2 here = edgesAt( pixel );
+    weights = vec4( 0.0 );
+
+    if ( here.y > 0.0 )
+    {
+        // the upper side: along x, the crossing edges are left sides in this row and the one above
+        int left = 0;
+        while ( left < searchSteps && edgesAt( pixel + ivec2( -left - 1, 0 ) ).y > 0.0 )
+            left++;
+        int right = 0;
+        while ( right < searchSteps && edgesAt( pixel + ivec2( right + 1, 0 ) ).y > 0.0 )
+            right++;
+        ivec2 start = pixel + ivec2( -left, 0 );
+        ivec2 end = pixel + ivec2( right + 1, 0 );
+        float hStart = left < searchSteps ? endHeight( edgesAt( start ).x, edgesAt( start + ivec2( 0, 1 ) ).x ) : 0.0;
+        float hEnd = right < searchSteps ? endHeight( edgesAt( end ).x, edgesAt( end + ivec2( 0, 1 ) ).x ) : 0.0;
+        vec2 area = pixelArea( float( left ), float( left + right + 1 ), hStart, hEnd );
+        weights.xy = area.yx;
+    }
+
+    if ( here.x > 0.0 )
+    {
+        // the left side: along y, the crossing edges are upper sides in this column and the left one
+        int down = 0;
+        while ( down < searchSteps && edgesAt( pixel + ivec2( 0, -down - 1 ) ).x > 0.0 )
+            down++;
+        int up = 0;
+        while ( up < searchSteps && edgesAt( pixel + ivec2( 0, up + 1 ) ).x > 0.0 )
+            up++;
+        ivec2 start = pixel + ivec2( 0, -down - 1 );
+        ivec2 end = pixel + ivec2( 0, up );
+        float hStart = down < searchSteps ? endHeight( edgesAt( start ).y, edgesAt( start + ivec2( -1, 0 ) ).y ) : 0.0;
+        float hEnd = up < searchSteps ? endHeight( edgesAt( end ).y, edgesAt( end + ivec2( -1, 0 ) ).y ) : 0.0;
+        vec2 area = pixelArea( float( down ), float( down + up + 1 ), hStart, hEnd );
+        weights.zw = area.yx;
+    }
+}
@@ -0,0 +1,132 @@
+#version 330 core
+
+// temporal anti-aliasing and upsampling ( see TemporalAntiAliasing ), drawn at the window
+// size: the current samples around the output pixel are reconstructed at its center,
+// the history is fetched where the pixel was last frame and clipped into the spread of
+// those samples, and the two are blended by how close a sample landed this frame
+out vec4 result;
+
+uniform sampler2D color;
+uniform sampler2D depth;
+// motion since the last frame in texture coordinates
+uniform sampler2D velocity;
+uniform sampler2D history;
+// part of the scene textures holding this frame
+uniform ivec2 renderSize;
+uniform vec2 outputSize;
+// offset of this frame's samples from the render pixel centers, in render pixels
+uniform vec2 jitter;
+uniform float currentWeight;
+uniform float clipSigma;
+uniform bool historyValid;
+
+// sharpness of the reconstruction filter, in output pixels: a Gaussian about as wide as one
+const float KERNEL = 6.0;
+
+// the clipping works on luma and chroma, whose box is tighter around the real colors than RGB's
+vec3 toYCoCg( vec3 c )
+{
+    return vec3( dot( c, vec3( 0.25, 0.5, 0.25 ) ), dot( c, vec3( 0.5, 0.0, -0.5 ) ), dot( c, vec3( -0.25, 0.5, -0.25 ) ) );
+}
+
+vec3 toRGB( vec3 c )
+{
+    return vec3( c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z );
+}
+
+// Catmull-Rom filtered history in five bilinear taps, sharper than a bilinear fetch so the
+// history does not blur a little more every frame it is reprojected
+vec3 sampleHistory( vec2 uv )
+{
+    vec2 size = vec2( textureSize( history, 0 ) );
+    vec2 position = uv * size;
+    vec2 center = floor( position - 0.5 ) + 0.5;
+    vec2 f = position - center;
+    vec2 w0 = f * ( -0.5 + f * ( 1.0 - 0.5 * f ) );
+    vec2 w1 = 1.0 + f * f * ( -2.5 + 1.5 * f );
+    vec2 w2 = f * ( 0.5 + f * ( 2.0 - 1.5 * f ) );
+    vec2 w3 = f * f * ( -0.5 + 0.5 * f );
+    vec2 w12 = w1 + w2;
+    vec2 uv0 = ( center - 1.0 ) / size;
+    vec2 uv3 = ( center + 2.0 ) / size;
+    vec2 uv12 = ( center + w2 / w12 ) / size;
+
+    vec3 sum = texture( history, vec2( uv12.x, uv0.y ) ).rgb * ( w12.x * w0.y );
+    sum += texture( history, vec2( uv0.x, uv12.y ) ).rgb * ( w0.x * w12.y );
+    sum += texture( history, uv12 ).rgb * ( w12.x * w12.y );
+    sum += texture( history, vec2( uv3.x, uv12.y ) ).rgb * ( w3.x * w12.y );
+    sum += texture( history, vec2( uv12.x, uv3.y ) ).rgb * ( w12.x * w3.y );
+    float weight = w12.x * w0.y + w0.x * w12.y + w12.x * w12.y + w3.x * w12.y + w12.x * w3.y;
+    return max( sum / weight, 0.0 );
+}
+
+// moves the history toward the box's center until it is inside
+vec3 clipToBox( vec3 c, vec3 low, vec3 high )
+{
+    vec3 center = 0.5 * ( low + high );
+    vec3 extent = 0.5 * ( high - low ) + 0.0001;
+    vec3 offset = c - center;
+    vec3 units = abs( offset / extent );
+    float outside = max( units.x, max( units.y, units.z ) );
+    return outside > 1.0 ? center + offset / outside : c;
+}
+
+void main( )
+{
+    vec2 uv = gl_FragCoord.xy / outputSize;
+    // the output pixel's center in render pixels; the sample of render pixel i shows the
+    // scene at i + 0.5 - jitter, so the closest one is at floor( position + jitter )
+    vec2 position = uv * vec2( renderSize );
+    ivec2 nearest = ivec2( floor( position + jitter ) );
+    vec2 toOutput = outputSize / vec2( renderSize );
+
+    vec3 sum = vec3( 0.0 );
+    float weightSum = 0.0;
+    vec3 moment1 = vec3( 0.0 );
+    vec3 moment2 = vec3( 0.0 );
+    float closestDepth = 1.0;
+    ivec2 closest = clamp( nearest, ivec2( 0 ), renderSize - 1 );
+    for ( int y = -1; y <= 1; y++ )
+    {
+        for ( int x = -1; x <= 1; x++ )
+        {
+            ivec2 texel = clamp( nearest + ivec2( x, y ), ivec2( 0 ), renderSize - 1 );
+            vec3 neighbor = toYCoCg( texelFetch( color, texel, 0 ).rgb );
+            vec2 offset = ( vec2( nearest + ivec2( x, y ) ) + 0.5 - jitter - position ) * toOutput;
+            float weight = exp( -KERNEL * dot( offset, offset ) );
+            sum += neighbor * weight;
+            weightSum += weight;
+            moment1 += neighbor;
+            moment2 += neighbor * neighbor;
+
+            // the motion of the closest surface around, so its edges carry their history along
+            float sampleDepth = texelFetch( depth, texel, 0 ).r;
+            if ( sampleDepth < closestDepth )
+            {
+                closestDepth = sampleDepth;
+                closest = texel;
+            }
+        }
+    }
+    vec3 current = sum / max( weightSum, 0.0001 );
+
+    // how far the closest sample landed from the pixel's center, in output pixels
+    vec2 landing = ( vec2( nearest ) + 0.5 - jitter - position ) * toOutput;
+    float alpha = currentWeight * exp( -KERNEL * dot( landing, landing ) );
+
+    vec2 previousUv = uv - texelFetch( velocity, closest, 0 ).rg;
+    if ( !historyValid || any( lessThan( previousUv, vec2( 0.0 ) ) ) || any( greaterThan( previousUv, vec2( 1.0 ) ) ) )
+    {
+        result = vec4( toRGB( current ), 1.0 );
+        return;
+    }
+
+    vec3 mean = moment1 / 9.0;
+    vec3 deviation = sqrt( max( moment2 / 9.0 - mean * mean, 0.0 ) );
+    vec3 previous = clipToBox( toYCoCg( sampleHistory( previousUv ) ), mean - clipSigma * deviation, mean + clipSigma * deviation );
+
+    // weighted by inverse luma, so a bright sample landing now and then does not flicker
+    float currentBlend = alpha / ( 1.0 + current.x );
+    float previousBlend = ( 1.0 - alpha ) / ( 1.0 + previous.x );
+    result = vec4( toRGB( ( current * currentBlend + previous * previousBlend ) / ( currentBlend + previousBlend ) ), 1.0 );
+}
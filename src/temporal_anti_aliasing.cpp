@@ -0,0 +1,216 @@
+#include "learnopengl-implementation/temporal_anti_aliasing.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+    // texture units of the resolve inputs
+    const int COLOR_UNIT = 0;
+    const int DEPTH_UNIT = 1;
+    const int VELOCITY_UNIT = 2;
+    const int HISTORY_UNIT = 3;
+
+    // radical inverse of index in the base, the Halton sequence's coordinate
+    float halton( unsigned int index, unsigned int base )
+    {
+        float fraction = 1.0f;
+        float result = 0.0f;
+        while ( index > 0 )
+        {
+            fraction /= base;
+            result += fraction * ( index % base );
+            index /= base;
+        }
+        return result;
+    }
+}
+
+TemporalAntiAliasing::TemporalAntiAliasing( GLResources& resources, const Settings& settings )
+    : resources( resources ), settings( settings )
+{
+    this->settings.renderScale = std::min( 1.0f, std::max( 0.25f, settings.renderScale ) );
+    this->settings.jitterPhases = std::max( 1u, settings.jitterPhases );
+    this->settings.currentWeight = std::min( 1.0f, std::max( 0.01f, settings.currentWeight ) );
+}
+
+void TemporalAntiAliasing::initialize( const SharedGeometry& geometry, Shader& resolveShader )
+{
+    this->geometry = &geometry;
+    this->resolveShader = &resolveShader;
+    resolveShader.use( );
+    resolveShader.setInt( "color", COLOR_UNIT );
+    resolveShader.setInt( "depth", DEPTH_UNIT );
+    resolveShader.setInt( "velocity", VELOCITY_UNIT );
+    resolveShader.setInt( "history", HISTORY_UNIT );
+    resolveShader.setFloat( "currentWeight", settings.currentWeight );
+    resolveShader.setFloat( "clipSigma", settings.clipSigma );
+    renderSizeLocation = glGetUniformLocation( resolveShader.ID, "renderSize" );
+    outputSizeLocation = glGetUniformLocation( resolveShader.ID, "outputSize" );
+    jitterLocation = glGetUniformLocation( resolveShader.ID, "jitter" );
+    historyValidLocation = glGetUniformLocation( resolveShader.ID, "historyValid" );
+}
+
+float TemporalAntiAliasing::renderScale( ) const
+{
+    return settings.renderScale;
+}
+
+void TemporalAntiAliasing::beginFrame( const DynamicResolution& target, int windowWidth, int windowHeight )
+{
+    frames++;
+    if ( windowWidth > 0 && windowHeight > 0 && ( windowWidth != width || windowHeight != height ) )
+        createHistory( windowWidth, windowHeight );
+
+    // the first index of the sequence is 0 in both bases, starting at 1 keeps it off the corner
+    unsigned int phase = (unsigned int) ( frames % settings.jitterPhases ) + 1;
+    jitter = glm::vec2( halton( phase, 2 ) - 0.5f, halton( phase, 3 ) - 0.5f );
+    glm::vec2 offset = 2.0f * jitter / glm::vec2( target.renderWidth( ), target.renderHeight( ) );
+    // moves the clip space x and y by the offset times w, so by the offset in NDC
+    jitterOffset = glm::translate( glm::mat4( 1.0f ), glm::vec3( offset, 0.0f ) );
+}
+
+const glm::mat4& TemporalAntiAliasing::jitterMatrix( ) const
+{
+    return jitterOffset;
+}
+
+RenderGraph::TextureDescription TemporalAntiAliasing::velocityDescription( const DynamicResolution& target )
+{
+    RenderGraph::TextureDescription description;
+    description.width = target.targetWidth( );
+    description.height = target.targetHeight( );
+    description.internalFormat = GL_RG16F;
+    description.format = GL_RG;
+    description.type = GL_FLOAT;
+    return description;
+}
+
+void TemporalAntiAliasing::clearVelocity( int drawBuffer )
+{
+    const GLfloat still[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glClearBufferfv( GL_COLOR, drawBuffer, still );
+}
+
+RenderGraph::Resource TemporalAntiAliasing::addPasses( RenderGraph& graph, RenderGraph::Resource sceneColor, RenderGraph::Resource sceneDepth,
+                                                       RenderGraph::Resource velocity, const DynamicResolution& target )
+{
+    // the frames since the last graph may have run another mode
+    resolvedFrame = 0;
+
+    // the history is not the graph's, it outlives the frame: a marker orders the upscale after it
+    RenderGraph::Pass pass = graph.addPass( "TAA resolve", [this, &graph, sceneColor, sceneDepth, velocity, &target]( )
+    {
+        resolve( graph.texture( sceneColor ), graph.texture( sceneDepth ), graph.texture( velocity ), target );
+    } );
+    graph.read( pass, sceneColor );
+    graph.read( pass, sceneDepth );
+    graph.read( pass, velocity );
+    return graph.write( pass, graph.createMarker( "TAA history" ) );
+}
+
+void TemporalAntiAliasing::createHistory( int width, int height )
+{
+    this->width = width;
+    this->height = height;
+    for ( unsigned int i = 0; i < HISTORY_COUNT; i++ )
+    {
+        if ( history[i].get( ).isNull( ) )
+        {
+            history[i] = ScopedTexture( resources, resources.createTexture( "TAA history" ) );
+            historyFramebuffers[i] = ScopedFramebuffer( resources, resources.createFramebuffer( "TAA history" ) );
+        }
+
+        // half floats keep the small steps of the blend, filtered for the Catmull-Rom taps
+        glBindTexture( GL_TEXTURE_2D, history[i].name( ) );
+        glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+        resources.setSize( history[i].get( ), (size_t) width * height * 8 );
+
+        glBindFramebuffer( GL_FRAMEBUFFER, historyFramebuffers[i].name( ) );
+        glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, history[i].name( ), 0 );
+        if ( glCheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE )
+            std::cerr << "ERROR::TEMPORAL_ANTI_ALIASING::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    }
+    glBindTexture( GL_TEXTURE_2D, 0 );
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    // what the histories held was for another size
+    resolvedFrame = 0;
+}
+
+void TemporalAntiAliasing::resolve( GLuint color, GLuint depth, GLuint velocity, const DynamicResolution& target )
+{
+    if ( history[0].get( ).isNull( ) )
+        return;
+    // a frame without a resolve ( another mode, a resize ) left the history behind
+    bool historyValid = resolvedFrame != 0 && resolvedFrame + 1 == frames;
+    if ( !historyValid )
+        historyResets++;
+    unsigned int next = ( current + 1 ) % HISTORY_COUNT;
+
+    glBindFramebuffer( GL_FRAMEBUFFER, historyFramebuffers[next].name( ) );
+    glViewport( 0, 0, width, height );
+    glUseProgram( resolveShader->ID );
+    glUniform2i( renderSizeLocation, target.renderWidth( ), target.renderHeight( ) );
+    glUniform2f( outputSizeLocation, (float) width, (float) height );
+    glUniform2f( jitterLocation, jitter.x, jitter.y );
+    glUniform1i( historyValidLocation, historyValid ? 1 : 0 );
+    glActiveTexture( GL_TEXTURE0 + COLOR_UNIT );
+    glBindTexture( GL_TEXTURE_2D, color );
+    glActiveTexture( GL_TEXTURE0 + DEPTH_UNIT );
+    glBindTexture( GL_TEXTURE_2D, depth );
+    glActiveTexture( GL_TEXTURE0 + VELOCITY_UNIT );
+    glBindTexture( GL_TEXTURE_2D, velocity );
+    glActiveTexture( GL_TEXTURE0 + HISTORY_UNIT );
+    glBindTexture( GL_TEXTURE_2D, history[current].name( ) );
+
+    // every pixel is written, the history needs no clear
+    glDisable( GL_DEPTH_TEST );
+    geometry->drawFullscreen( );
+    glActiveTexture( GL_TEXTURE0 );
+    glEnable( GL_DEPTH_TEST );
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
+    current = next;
+    resolvedFrame = frames;
+    resolves++;
+}
+
+GLuint TemporalAntiAliasing::outputTexture( ) const
+{
+    return history[current].name( );
+}
+
+int TemporalAntiAliasing::outputWidth( ) const
+{
+    return width;
+}
+
+int TemporalAntiAliasing::outputHeight( ) const
+{
+    return height;
+}
+
+void TemporalAntiAliasing::shutdown( )
+{
+    for ( unsigned int i = 0; i < HISTORY_COUNT; i++ )
+    {
+        historyFramebuffers[i].reset( );
+        history[i].reset( );
+    }
+}
+
+void TemporalAntiAliasing::report( std::ostream& out ) const
+{
+    if ( resolves == 0 )
+        return;
+    size_t bytes = (size_t) width * height * 8 * HISTORY_COUNT;
+    out << "Temporal anti-aliasing: " << resolves << " frames resolved, " << historyResets << " history resets, "
+        << settings.jitterPhases << " jitter phases, render scale up to " << settings.renderScale << ", history "
+        << (double) bytes / ( 1024 * 1024 ) << " MB at " << width << "x" << height << std::endl;
+}
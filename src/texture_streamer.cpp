@@ -0,0 +1,249 @@
+#include "learnopengl-implementation/texture_streamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    size_t levelBytes( const MipChain& chain, int level )
+    {
+        return (size_t) chain.widths[level] * chain.heights[level] * chain.channels;
+    }
+
+    void specifyLevel( const MipChain& chain, int level, const unsigned char* pixels )
+    {
+        int width = pixels ? chain.widths[level] : 0;
+        int height = pixels ? chain.heights[level] : 0;
+        // the alpha of four channel images is kept, the transparent quads cut their shape out with it
+        GLenum internalFormat = chain.channels == 4 ? GL_RGBA8 : GL_RGB8;
+        glTexImage2D( GL_TEXTURE_2D, level, internalFormat, width, height, 0, chain.format, GL_UNSIGNED_BYTE, pixels );
+    }
+}
+
+MipChain buildMipChain( const unsigned char* pixels, int width, int height, int channels )
+{
+    MipChain chain;
+    chain.format = channels == 4 ? GL_RGBA : GL_RGB;
+    chain.channels = channels;
+    chain.widths.push_back( width );
+    chain.heights.push_back( height );
+    chain.levels.push_back( std::vector<unsigned char>( pixels, pixels + (size_t) width * height * channels ) );
+
+    while ( width > 1 || height > 1 )
+    {
+        const std::vector<unsigned char>& source = chain.levels.back( );
+        int sourceWidth = width;
+        int sourceHeight = height;
+        width = std::max( 1, width / 2 );
+        height = std::max( 1, height / 2 );
+
+        // averaging 2x2 blocks, the odd last row or column of the source is clamped
+        std::vector<unsigned char> level( (size_t) width * height * channels );
+        for ( int y = 0; y < height; y++ )
+        {
+            int y0 = std::min( 2 * y, sourceHeight - 1 );
+            int y1 = std::min( 2 * y + 1, sourceHeight - 1 );
+            for ( int x = 0; x < width; x++ )
+            {
+                int x0 = std::min( 2 * x, sourceWidth - 1 );
+                int x1 = std::min( 2 * x + 1, sourceWidth - 1 );
+                for ( int c = 0; c < channels; c++ )
+                {
+                    int sum = source[( (size_t) y0 * sourceWidth + x0 ) * channels + c] + source[( (size_t) y0 * sourceWidth + x1 ) * channels + c] +
+                              source[( (size_t) y1 * sourceWidth + x0 ) * channels + c] + source[( (size_t) y1 * sourceWidth + x1 ) * channels + c];
+                    level[( (size_t) y * width + x ) * channels + c] = (unsigned char) ( ( sum + 2 ) / 4 );
+                }
+            }
+        }
+        chain.widths.push_back( width );
+        chain.heights.push_back( height );
+        chain.levels.push_back( std::move( level ) );
+    }
+    return chain;
+}
+
+TextureStreamer::TextureStreamer( GLResources& resources, const Settings& settings ) : resources( resources ), settings( settings )
+{
+}
+
+void TextureStreamer::add( TextureHandle texture, const char* label, MipChain&& chain )
+{
+    if ( chain.levels.empty( ) )
+        return;
+
+    textures.push_back( StreamedTexture( ) );
+    StreamedTexture& streamed = textures.back( );
+    streamed.handle = texture;
+    streamed.label = label;
+    streamed.chain = std::move( chain );
+    int levels = (int) streamed.chain.levels.size( );
+    streamed.lastNeeded.assign( levels, 0 );
+
+    streamed.tailLevel = levels - 1;
+    while ( streamed.tailLevel > 0 && std::max( streamed.chain.widths[streamed.tailLevel - 1], streamed.chain.heights[streamed.tailLevel - 1] ) <= settings.residentTailSize )
+        streamed.tailLevel--;
+    streamed.wantedLevel = -1;
+
+    // the smallest levels first, everything finer is streamed in by update( )
+    glBindTexture( GL_TEXTURE_2D, resources.get( texture ) );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    for ( int level = levels - 1; level >= streamed.tailLevel; level-- )
+    {
+        specifyLevel( streamed.chain, level, streamed.chain.levels[level].data( ) );
+        streamed.residentBytes += levelBytes( streamed.chain, level );
+    }
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1 );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, streamed.tailLevel );
+    streamed.baseLevel = streamed.tailLevel;
+
+    resident += streamed.residentBytes;
+    resources.setSize( texture, streamed.residentBytes );
+}
+
+void TextureStreamer::request( TextureHandle texture, float screenSize )
+{
+    StreamedTexture* streamed = find( texture );
+    if ( !streamed || screenSize <= 0.0f )
+        return;
+
+    // one texel per pixel: every halving of the on screen size drops a level
+    int size = std::max( streamed->chain.widths[0], streamed->chain.heights[0] );
+    int level = (int) std::floor( std::log2( size / screenSize ) );
+    level = std::max( 0, std::min( level, streamed->tailLevel ) );
+    if ( streamed->wantedLevel < 0 || level < streamed->wantedLevel )
+        streamed->wantedLevel = level;
+}
+
+void TextureStreamer::update( )
+{
+    frame++;
+
+    for ( StreamedTexture& texture : textures )
+    {
+        int wanted = texture.wantedLevel < 0 ? texture.tailLevel : texture.wantedLevel;
+        for ( int level = wanted; level < (int) texture.lastNeeded.size( ); level++ )
+            texture.lastNeeded[level] = frame;
+    }
+
+    // one level per texture and pass, so the textures furthest behind do not starve the rest
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+    size_t uploaded = 0;
+    bool progress = true;
+    while ( progress )
+    {
+        progress = false;
+        for ( StreamedTexture& texture : textures )
+        {
+            if ( texture.wantedLevel < 0 || texture.baseLevel <= texture.wantedLevel )
+                continue;
+            size_t bytes = levelBytes( texture.chain, texture.baseLevel - 1 );
+            if ( uploaded > 0 && uploaded + bytes > settings.uploadBytesPerFrame )
+                continue;
+            // only levels that were not needed this frame make room for new ones
+            if ( !makeRoom( bytes, frame ) || !upload( texture ) )
+                continue;
+            uploaded += bytes;
+            progress = true;
+        }
+    }
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+
+    // a lowered budget can leave more resident than allowed even with nothing uploaded
+    makeRoom( 0, frame + 1 );
+
+    for ( StreamedTexture& texture : textures )
+    {
+        if ( texture.wantedLevel >= 0 )
+        {
+            texture.requestedFrames++;
+            if ( texture.baseLevel <= texture.wantedLevel )
+                texture.satisfiedFrames++;
+        }
+        texture.wantedLevel = -1;
+    }
+}
+
+bool TextureStreamer::makeRoom( size_t bytes, unsigned long long neededBefore )
+{
+    while ( resident + bytes > settings.budget )
+    {
+        // the least recently needed evictable level, which is always a texture's finest one
+        StreamedTexture* victim = nullptr;
+        for ( StreamedTexture& texture : textures )
+        {
+            if ( texture.baseLevel >= texture.tailLevel || texture.lastNeeded[texture.baseLevel] >= neededBefore )
+                continue;
+            if ( !victim || texture.lastNeeded[texture.baseLevel] < victim->lastNeeded[victim->baseLevel] )
+                victim = &texture;
+        }
+        if ( !victim )
+            return false;
+        evict( *victim );
+    }
+    return true;
+}
+
+bool TextureStreamer::upload( StreamedTexture& texture )
+{
+    GLuint name = resources.get( texture.handle );
+    if ( name == 0 )
+        return false;
+
+    int level = texture.baseLevel - 1;
+    glBindTexture( GL_TEXTURE_2D, name );
+    specifyLevel( texture.chain, level, texture.chain.levels[level].data( ) );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level );
+    texture.baseLevel = level;
+
+    size_t bytes = levelBytes( texture.chain, level );
+    texture.residentBytes += bytes;
+    resident += bytes;
+    texture.uploads++;
+    resources.setSize( texture.handle, texture.residentBytes );
+    return true;
+}
+
+void TextureStreamer::evict( StreamedTexture& texture )
+{
+    int level = texture.baseLevel;
+    glBindTexture( GL_TEXTURE_2D, resources.get( texture.handle ) );
+    // sampling moves to the next level before this one is released as an empty image
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1 );
+    specifyLevel( texture.chain, level, nullptr );
+    texture.baseLevel = level + 1;
+
+    size_t bytes = levelBytes( texture.chain, level );
+    texture.residentBytes -= bytes;
+    resident -= bytes;
+    texture.evictions++;
+    resources.setSize( texture.handle, texture.residentBytes );
+}
+
+TextureStreamer::StreamedTexture* TextureStreamer::find( TextureHandle texture )
+{
+    for ( StreamedTexture& streamed : textures )
+    {
+        if ( streamed.handle.value == texture.value )
+            return &streamed;
+    }
+    return nullptr;
+}
+
+size_t TextureStreamer::residentBytes( ) const
+{
+    return resident;
+}
+
+void TextureStreamer::report( std::ostream& out ) const
+{
+    out << "Texture streaming: " << resident / 1024 << " KB resident of a " << settings.budget / 1024 << " KB budget" << std::endl;
+    for ( const StreamedTexture& texture : textures )
+    {
+        out << "  " << ( texture.label ? texture.label : "unnamed" ) << ": levels " << texture.baseLevel << "-" << texture.chain.levels.size( ) - 1
+            << " resident (" << texture.residentBytes / 1024 << " KB), " << texture.uploads << " uploads, " << texture.evictions << " evictions";
+        if ( texture.requestedFrames > 0 )
+            out << ", wanted level resident " << 100.0 * texture.satisfiedFrames / texture.requestedFrames << "% of frames";
+        out << std::endl;
+    }
+}
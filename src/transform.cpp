@@ -0,0 +1,242 @@
+#include "learnopengl-implementation/transform.h"
+#include "learnopengl-implementation/job_system.h"
+
+#include <glm/simd/matrix.h>
+
+#include <algorithm>
+
+namespace
+{
+    // levels narrower than this are not worth splitting into jobs
+    const unsigned int PARALLEL_LEVEL_SIZE = 512;
+
+    // world = parent * local, using glm's SSE kernel when the intrinsics are enabled
+    inline void multiply( const glm::mat4& parent, const glm::mat4& local, glm::mat4& world )
+    {
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+        // the matrices live in plain std::vectors, so they are moved through unaligned loads/stores
+        glm_vec4 a[4], b[4], c[4];
+        for ( int i = 0; i < 4; i++ )
+        {
+            a[i] = _mm_loadu_ps( &parent[i][0] );
+            b[i] = _mm_loadu_ps( &local[i][0] );
+        }
+        glm_mat4_mul( a, b, c );
+        for ( int i = 0; i < 4; i++ )
+            _mm_storeu_ps( &world[i][0], c[i] );
+#else
+        world = parent * local;
+#endif
+    }
+
+    // builds translate * rotate * scale without going through three matrix products
+    inline glm::mat4 compose( const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale )
+    {
+        glm::mat3 r = glm::mat3_cast( rotation );
+        glm::mat4 m;
+        m[0] = glm::vec4( r[0] * scale.x, 0.0f );
+        m[1] = glm::vec4( r[1] * scale.y, 0.0f );
+        m[2] = glm::vec4( r[2] * scale.z, 0.0f );
+        m[3] = glm::vec4( position, 1.0f );
+        return m;
+    }
+
+    // values[i] = old values[order[i]]
+    template <typename T>
+    void permute( std::vector<T>& values, const std::vector<unsigned int>& order )
+    {
+        std::vector<T> sorted( values.size( ) );
+        for ( size_t i = 0; i < order.size( ); i++ )
+            sorted[i] = values[order[i]];
+        values.swap( sorted );
+    }
+}
+
+unsigned int TransformSystem::create( unsigned int parent )
+{
+    unsigned int node = (unsigned int) slotOf.size( );
+    unsigned int slot = (unsigned int) nodeAt.size( );
+    unsigned int parentSlot = parent == NONE ? NONE : slotOf[parent];
+
+    slotOf.push_back( slot );
+    nodeAt.push_back( node );
+    positions.push_back( glm::vec3( 0.0f ) );
+    rotations.push_back( glm::quat( 1.0f, 0.0f, 0.0f, 0.0f ) );
+    scales.push_back( glm::vec3( 1.0f ) );
+    parents.push_back( parentSlot );
+    depths.push_back( parentSlot == NONE ? 0 : depths[parentSlot] + 1 );
+    dirty.push_back( LOCAL_DIRTY );
+    firstDirty = std::min( firstDirty, slot );
+    localMatrices.push_back( glm::mat4( 1.0f ) );
+    worldMatrices.push_back( glm::mat4( 1.0f ) );
+
+    // appending keeps parents before children, but a shallow node created after a
+    // deeper one breaks the depth order the update pass relies on
+    if ( slot > 0 && depths[slot] < depths[slot - 1] )
+        needsSort = true;
+    else if ( slot == 0 || depths[slot] > depths[slot - 1] )
+        levelStarts.push_back( slot );
+
+    return node;
+}
+
+void TransformSystem::setPosition( unsigned int node, const glm::vec3& position )
+{
+    unsigned int slot = slotOf[node];
+    positions[slot] = position;
+    dirty[slot] |= LOCAL_DIRTY;
+    firstDirty = std::min( firstDirty, slot );
+}
+
+void TransformSystem::setRotation( unsigned int node, const glm::quat& rotation )
+{
+    unsigned int slot = slotOf[node];
+    rotations[slot] = rotation;
+    dirty[slot] |= LOCAL_DIRTY;
+    firstDirty = std::min( firstDirty, slot );
+}
+
+void TransformSystem::setScale( unsigned int node, const glm::vec3& scale )
+{
+    unsigned int slot = slotOf[node];
+    scales[slot] = scale;
+    dirty[slot] |= LOCAL_DIRTY;
+    firstDirty = std::min( firstDirty, slot );
+}
+
+const glm::vec3& TransformSystem::getPosition( unsigned int node ) const
+{
+    return positions[slotOf[node]];
+}
+
+const glm::quat& TransformSystem::getRotation( unsigned int node ) const
+{
+    return rotations[slotOf[node]];
+}
+
+const glm::vec3& TransformSystem::getScale( unsigned int node ) const
+{
+    return scales[slotOf[node]];
+}
+
+const glm::mat4& TransformSystem::getWorldMatrix( unsigned int node ) const
+{
+    return worldMatrices[slotOf[node]];
+}
+
+unsigned int TransformSystem::size( ) const
+{
+    return (unsigned int) nodeAt.size( );
+}
+
+unsigned int TransformSystem::lastUpdateCount( ) const
+{
+    return updateCount;
+}
+
+void TransformSystem::update( JobSystem* jobs )
+{
+    if ( needsSort )
+        sortByDepth( );
+
+    // nothing was touched since the last update, static scenery costs nothing
+    updateCount = 0;
+    if ( firstDirty == NONE )
+        return;
+
+    // every slot before the first dirty one is clean and so are its ancestors,
+    // each level only reads the world matrices of the levels above it
+    unsigned int count = size( );
+    for ( unsigned int level = 0; level < levelStarts.size( ); level++ )
+    {
+        unsigned int end = level + 1 < levelStarts.size( ) ? levelStarts[level + 1] : count;
+        unsigned int begin = std::max( levelStarts[level], firstDirty );
+        if ( begin >= end )
+            continue;
+
+        if ( jobs && end - begin >= PARALLEL_LEVEL_SIZE )
+        {
+            std::atomic<unsigned int> levelCount{ 0 };
+            jobs->parallelFor( end - begin, 64, [this, begin, &levelCount]( unsigned int first, unsigned int last )
+            {
+                unsigned int updated = 0;
+                for ( unsigned int i = begin + first; i < begin + last; i++ )
+                    updated += updateSlot( i );
+                levelCount += updated;
+            } );
+            updateCount += levelCount;
+        }
+        else
+        {
+            for ( unsigned int i = begin; i < end; i++ )
+                updateCount += updateSlot( i );
+        }
+    }
+
+    // the world flags are only needed while walking down the hierarchy
+    std::fill( dirty.begin( ) + firstDirty, dirty.end( ), 0 );
+    firstDirty = NONE;
+}
+
+bool TransformSystem::updateSlot( unsigned int i )
+{
+    unsigned char flags = dirty[i];
+    unsigned int parent = parents[i];
+
+    // a recomputed parent world matrix invalidates the whole subtree below it,
+    // the depth order guarantees the parent has already been visited
+    if ( parent != NONE && ( dirty[parent] & WORLD_DIRTY ) )
+        flags |= WORLD_DIRTY;
+    if ( !flags )
+        return false;
+
+    if ( flags & LOCAL_DIRTY )
+        localMatrices[i] = compose( positions[i], rotations[i], scales[i] );
+
+    if ( parent == NONE )
+        worldMatrices[i] = localMatrices[i];
+    else
+        multiply( worldMatrices[parent], localMatrices[i], worldMatrices[i] );
+
+    dirty[i] = WORLD_DIRTY;
+    return true;
+}
+
+void TransformSystem::sortByDepth( )
+{
+    unsigned int count = size( );
+    std::vector<unsigned int> order( count );
+    for ( unsigned int i = 0; i < count; i++ )
+        order[i] = i;
+    std::stable_sort( order.begin( ), order.end( ),
+                      [this]( unsigned int a, unsigned int b ) { return depths[a] < depths[b]; } );
+
+    // old slot -> new slot, needed to remap the parent links
+    std::vector<unsigned int> newSlot( count );
+    for ( unsigned int i = 0; i < count; i++ )
+        newSlot[order[i]] = i;
+
+    permute( nodeAt, order );
+    permute( positions, order );
+    permute( rotations, order );
+    permute( scales, order );
+    permute( parents, order );
+    permute( depths, order );
+    permute( dirty, order );
+    permute( localMatrices, order );
+    permute( worldMatrices, order );
+
+    levelStarts.clear( );
+    for ( unsigned int i = 0; i < count; i++ )
+    {
+        if ( parents[i] != NONE )
+            parents[i] = newSlot[parents[i]];
+        slotOf[nodeAt[i]] = i;
+        if ( i == 0 || depths[i] > depths[i - 1] )
+            levelStarts.push_back( i );
+    }
+    needsSort = false;
+    // the dirty flags moved along with their nodes
+    if ( firstDirty != NONE )
+        firstDirty = 0;
+}
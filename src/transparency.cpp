@@ -0,0 +1,324 @@
+#include "learnopengl-implementation/transparency.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+    // texture units of the composite inputs
+    const int ACCUMULATION_UNIT = 0;
+    const int WEIGHT_UNIT = 1;
+
+    // three passes of 11 bits cover the 32 bit keys
+    const unsigned int RADIX_BITS = 11;
+    const unsigned int RADIX_BUCKETS = 1u << RADIX_BITS;
+    const unsigned int RADIX_PASSES = 3;
+
+    // timestamps of a measured frame
+    const unsigned int START_QUERY = 0;
+    const unsigned int FINISH_QUERY = 1;
+
+    const char* modeName( TransparencyMode mode )
+    {
+        return mode == TransparencyMode::SORTED ? "sorted" : "weighted blended";
+    }
+
+    // the float's bits reordered so that the unsigned integers compare like the floats
+    uint32_t sortableKey( float value )
+    {
+        uint32_t bits;
+        std::memcpy( &bits, &value, sizeof( bits ) );
+        return bits ^ ( ( bits >> 31 ) ? 0xFFFFFFFFu : 0x80000000u );
+    }
+}
+
+Transparency::Transparency( GLResources& resources, const Settings& settings )
+    : resources( resources ), settings( settings ), timers( resources, "transparency timestamp", 2 )
+{
+}
+
+void Transparency::initialize( const SharedGeometry& geometry, Shader& quadShader, Shader& compositeShader )
+{
+    this->geometry = &geometry;
+    this->quadShader = &quadShader;
+    this->compositeShader = &compositeShader;
+
+    quadShader.use( );
+    quadShader.setInt( "image", 0 );
+    viewLocation = glGetUniformLocation( quadShader.ID, "view" );
+    projectionLocation = glGetUniformLocation( quadShader.ID, "projection" );
+    weightedBlendedLocation = glGetUniformLocation( quadShader.ID, "weightedBlended" );
+
+    compositeShader.use( );
+    compositeShader.setInt( "accumulation", ACCUMULATION_UNIT );
+    compositeShader.setInt( "weights", WEIGHT_UNIT );
+
+    // the unit quad shared by the instances, the rest comes per instance
+    quadArray = ScopedVertexArray( resources, resources.createVertexArray( "transparent quads" ) );
+    instanceBuffer = StreamBuffer( resources, GL_ARRAY_BUFFER, "transparent instances" );
+    glBindVertexArray( quadArray.name( ) );
+    geometry.bindQuadCorners( 0 );
+
+    glBindBuffer( GL_ARRAY_BUFFER, instanceBuffer.name( ) );
+    glVertexAttribPointer( 1, 4, GL_FLOAT, GL_FALSE, sizeof( TransparentQuad ), (void*) offsetof( TransparentQuad, positionSize ) );
+    glVertexAttribPointer( 2, 4, GL_FLOAT, GL_FALSE, sizeof( TransparentQuad ), (void*) offsetof( TransparentQuad, color ) );
+    for ( GLuint attribute = 1; attribute <= 2; attribute++ )
+    {
+        glEnableVertexAttribArray( attribute );
+        glVertexAttribDivisor( attribute, 1 );
+    }
+    glBindVertexArray( 0 );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+}
+
+bool Transparency::isEnabled( ) const
+{
+    return settings.enabled && quadShader;
+}
+
+TransparencyMode Transparency::supportedMode( TransparencyMode requested, AntiAliasingMode antiAliasing ) const
+{
+    if ( requested >= TransparencyMode::COUNT )
+        return TransparencyMode::WEIGHTED_BLENDED;
+    // the accumulation targets would have to be multisampled like the scene's and resolved per sample
+    if ( requested == TransparencyMode::WEIGHTED_BLENDED && antiAliasing == AntiAliasingMode::MSAA )
+        return TransparencyMode::SORTED;
+    return requested;
+}
+
+void Transparency::prepare( const FramePacket& packet, TransparencyMode mode, const glm::mat4& projection, GLuint texture )
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now( );
+    this->view = packet.view;
+    this->projection = projection;
+    this->texture = texture;
+    this->mode = mode;
+    quadCount = packet.transparents.size( );
+    if ( mode == TransparencyMode::SORTED )
+    {
+        sortBackToFront( packet );
+        instanceBuffer.upload( sorted.data( ), quadCount * sizeof( TransparentQuad ) );
+    }
+    else
+    {
+        // any order does, the packet's goes up as it is
+        instanceBuffer.upload( packet.transparents.data( ), quadCount * sizeof( TransparentQuad ) );
+    }
+
+    ModeStatistics& current = statistics[(unsigned int) mode];
+    current.frames++;
+    current.cpuMilliseconds += std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now( ) - start ).count( );
+    quadsDrawn += quadCount;
+}
+
+void Transparency::sortBackToFront( const FramePacket& packet )
+{
+    size_t count = packet.transparents.size( );
+    keys.resize( count );
+    sortedKeys.resize( count );
+    indices.resize( count );
+    sortedIndices.resize( count );
+
+    // the view space z of every center, lowest for the farthest, and the digit counts of all passes at once
+    glm::vec4 depthRow = glm::vec4( view[0][2], view[1][2], view[2][2], view[3][2] );
+    uint32_t offsets[RADIX_PASSES][RADIX_BUCKETS] = {};
+    for ( size_t i = 0; i < count; i++ )
+    {
+        uint32_t key = sortableKey( glm::dot( depthRow, glm::vec4( glm::vec3( packet.transparents[i].positionSize ), 1.0f ) ) );
+        keys[i] = key;
+        indices[i] = (uint32_t) i;
+        for ( unsigned int pass = 0; pass < RADIX_PASSES; pass++ )
+            offsets[pass][( key >> ( pass * RADIX_BITS ) ) & ( RADIX_BUCKETS - 1 )]++;
+    }
+
+    // least significant digit first, every pass is stable so the last one leaves all of them in order
+    for ( unsigned int pass = 0; pass < RADIX_PASSES; pass++ )
+    {
+        uint32_t offset = 0;
+        for ( uint32_t& bucket : offsets[pass] )
+        {
+            uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+        unsigned int shift = pass * RADIX_BITS;
+        for ( size_t i = 0; i < count; i++ )
+        {
+            uint32_t destination = offsets[pass][( keys[i] >> shift ) & ( RADIX_BUCKETS - 1 )]++;
+            sortedKeys[destination] = keys[i];
+            sortedIndices[destination] = indices[i];
+        }
+        keys.swap( sortedKeys );
+        indices.swap( sortedIndices );
+    }
+
+    sorted.resize( count );
+    for ( size_t i = 0; i < count; i++ )
+        sorted[i] = packet.transparents[indices[i]];
+}
+
+RenderGraph::TextureDescription Transparency::accumulationDescription( const DynamicResolution& target, GLenum internalFormat,
+                                                                       GLenum format )
+{
+    RenderGraph::TextureDescription description;
+    description.width = target.targetWidth( );
+    description.height = target.targetHeight( );
+    description.internalFormat = internalFormat;
+    description.format = format;
+    description.type = GL_FLOAT;
+    return description;
+}
+
+void Transparency::addPasses( RenderGraph& graph, TransparencyMode mode, RenderGraph::Resource& color, RenderGraph::Resource& depth,
+                              const DynamicResolution& target )
+{
+    width = target.targetWidth( );
+    height = target.targetHeight( );
+    if ( mode == TransparencyMode::SORTED )
+    {
+        RenderGraph::Pass pass = graph.addPass( "sorted transparency", [this, &target]( )
+        {
+            if ( quadCount == 0 )
+                return;
+            beginMeasurement( );
+            drawQuads( false, target );
+            endMeasurement( );
+        } );
+        color = graph.writeColor( pass, color );
+        depth = graph.writeDepth( pass, depth );
+        return;
+    }
+
+    RenderGraph::Resource accumulation = graph.createTexture( "transparency accumulation",
+                                                              accumulationDescription( target, GL_RGBA16F, GL_RGBA ) );
+    RenderGraph::Resource weights = graph.createTexture( "transparency weights", accumulationDescription( target, GL_R16F, GL_RED ) );
+    RenderGraph::Pass accumulate = graph.addPass( "transparency accumulation", [this, &target]( )
+    {
+        if ( quadCount == 0 )
+            return;
+        beginMeasurement( );
+        // nothing added yet and all of the scene revealed
+        const GLfloat empty[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        const GLfloat zero[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv( GL_COLOR, 0, empty );
+        glClearBufferfv( GL_COLOR, 1, zero );
+        drawQuads( true, target );
+    } );
+    accumulation = graph.writeColor( accumulate, accumulation );
+    weights = graph.writeColor( accumulate, weights );
+    depth = graph.writeDepth( accumulate, depth );
+
+    RenderGraph::Pass resolve = graph.addPass( "transparency composite", [this, &graph, accumulation, weights, &target]( )
+    {
+        if ( quadCount == 0 )
+            return;
+        composite( graph.texture( accumulation ), graph.texture( weights ), target );
+        endMeasurement( );
+    } );
+    graph.read( resolve, accumulation );
+    graph.read( resolve, weights );
+    color = graph.writeColor( resolve, color );
+}
+
+void Transparency::drawQuads( bool weightedBlended, const DynamicResolution& target )
+{
+    glViewport( 0, 0, target.renderWidth( ), target.renderHeight( ) );
+    glUseProgram( quadShader->ID );
+    glUniformMatrix4fv( viewLocation, 1, GL_FALSE, glm::value_ptr( view ) );
+    glUniformMatrix4fv( projectionLocation, 1, GL_FALSE, glm::value_ptr( projection ) );
+    glUniform1i( weightedBlendedLocation, weightedBlended ? 1 : 0 );
+    glActiveTexture( GL_TEXTURE0 );
+    glBindTexture( GL_TEXTURE_2D, texture );
+
+    // hidden by the scene, but never by each other
+    glDepthMask( GL_FALSE );
+    glEnable( GL_BLEND );
+    if ( weightedBlended )
+        // colors and weights added, the alpha multiplied by one minus the quad's: the revealage
+        glBlendFuncSeparate( GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA );
+    else
+        glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    glBindVertexArray( quadArray.name( ) );
+    glDrawArraysInstanced( GL_TRIANGLE_STRIP, 0, 4, (GLsizei) quadCount );
+    glBindVertexArray( 0 );
+    glDisable( GL_BLEND );
+    glDepthMask( GL_TRUE );
+}
+
+void Transparency::composite( GLuint accumulation, GLuint weights, const DynamicResolution& target )
+{
+    glViewport( 0, 0, target.renderWidth( ), target.renderHeight( ) );
+    glUseProgram( compositeShader->ID );
+    glActiveTexture( GL_TEXTURE0 + ACCUMULATION_UNIT );
+    glBindTexture( GL_TEXTURE_2D, accumulation );
+    glActiveTexture( GL_TEXTURE0 + WEIGHT_UNIT );
+    glBindTexture( GL_TEXTURE_2D, weights );
+
+    // the layers' average color over the scene by their coverage, one minus the revealage
+    glDisable( GL_DEPTH_TEST );
+    glEnable( GL_BLEND );
+    glBlendFunc( GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA );
+    geometry->drawFullscreen( );
+    glDisable( GL_BLEND );
+    glActiveTexture( GL_TEXTURE0 );
+    glEnable( GL_DEPTH_TEST );
+}
+
+void Transparency::beginMeasurement( )
+{
+    collect( );
+    if ( !timers.begin( ) )
+        return;
+    measuredModes[timers.slot( )] = mode;
+    timers.timestamp( START_QUERY );
+}
+
+void Transparency::endMeasurement( )
+{
+    timers.timestamp( FINISH_QUERY );
+    timers.end( );
+}
+
+void Transparency::collect( )
+{
+    timers.collect( [this]( unsigned int slot, const GLuint64* results )
+    {
+        if ( results[FINISH_QUERY] < results[START_QUERY] )
+            return;
+        ModeStatistics& current = statistics[(unsigned int) measuredModes[slot]];
+        current.measured++;
+        current.gpuMilliseconds += ( results[FINISH_QUERY] - results[START_QUERY] ) / 1.0e6;
+    } );
+}
+
+void Transparency::shutdown( )
+{
+    timers.reset( );
+    quadArray.reset( );
+    instanceBuffer.reset( );
+}
+
+void Transparency::report( std::ostream& out ) const
+{
+    unsigned long long frames = statistics[0].frames + statistics[1].frames;
+    if ( frames == 0 )
+        return;
+    out << "Transparency: " << quadsDrawn / frames << " quads per frame";
+    for ( unsigned int index = 0; index < MODE_COUNT; index++ )
+    {
+        const ModeStatistics& current = statistics[index];
+        out << ", " << modeName( (TransparencyMode) index ) << " " << current.frames << " frames";
+        if ( current.frames > 0 )
+            out << " ( " << current.cpuMilliseconds / current.frames << " ms CPU";
+        if ( current.measured > 0 )
+            out << ", " << current.gpuMilliseconds / current.measured << " ms GPU";
+        if ( current.frames > 0 )
+            out << " )";
+    }
+    // RGBA16F accumulation and R16F weights
+    size_t bytes = (size_t) width * height * 10;
+    out << ", accumulation targets " << (double) bytes / ( 1024 * 1024 ) << " MB at " << width << "x" << height << std::endl;
+}
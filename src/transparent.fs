@@ -0,0 +1,34 @@
+#version 330 core
+
+// transparent quads ( see Transparency ). Weighted blended: the premultiplied colors are
+// added up weighted by depth and alpha, and the revealage, how much of the scene still
+// shows through, is multiplied into the accumulation's alpha by the blend state. Sorted:
+// the colors are blended over the scene as they come
+layout ( location = 0 ) out vec4 accumulation;
+layout ( location = 1 ) out float weights;
+
+in vec2 texCoord;
+in vec4 tint;
+in float viewDepth;
+
+uniform sampler2D image;
+uniform bool weightedBlended;
+
+void main( )
+{
+    vec4 color = texture( image, texCoord ) * tint;
+    // adds nothing either way, and skips the blend
+    if ( color.a < 1.0 / 255.0 )
+        discard;
+    if ( !weightedBlended )
+    {
+        accumulation = color;
+        return;
+    }
+
+    // McGuire and Bavoil's weight ( their equation 7 ): where the layers overlap the closer
+    // ones dominate, which is what sorting would have shown in front
+    float weight = color.a * clamp( 10.0 / ( 1e-5 + pow( viewDepth / 5.0, 2.0 ) + pow( viewDepth / 200.0, 6.0 ) ), 1e-2, 3e3 );
+    accumulation = vec4( color.rgb * color.a * weight, color.a );
+    weights = color.a * weight;
+}
@@ -0,0 +1,24 @@
+#version 330 core
+
+// one camera facing quad per transparent instance
+layout ( location = 0 ) in vec2 aCorner;
+layout ( location = 1 ) in vec4 aPositionSize;
+layout ( location = 2 ) in vec4 aColor;
+
+out vec2 texCoord;
+out vec4 tint;
+out float viewDepth;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main( )
+{
+    // spread around the center in view space, so the quad always faces the camera
+    vec4 position = view * vec4( aPositionSize.xyz, 1.0f );
+    position.xy += ( aCorner - 0.5f ) * aPositionSize.w;
+    gl_Position = projection * position;
+    texCoord = aCorner;
+    tint = aColor;
+    viewDepth = -position.z;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+// weighted blended transparency resolved over the scene: the weighted average color of the
+// layers covers the pixel by one minus the revealage, the blend state keeps the rest
+out vec4 result;
+
+uniform sampler2D accumulation;
+uniform sampler2D weights;
+
+void main( )
+{
+    ivec2 texel = ivec2( gl_FragCoord.xy );
+    vec4 sum = texelFetch( accumulation, texel, 0 );
+    float revealage = sum.a;
+    // no transparent layer, the scene stays as it is
+    if ( revealage >= 1.0 )
+        discard;
+
+    float weight = texelFetch( weights, texel, 0 ).r;
+    vec3 average = sum.rgb / max( weight, 1e-5 );
+    // a sum past the half float range lost the color, not the coverage
+    if ( isinf( weight ) || any( isinf( sum.rgb ) ) )
+        average = vec3( 1.0 );
+    result = vec4( average, revealage );
+}
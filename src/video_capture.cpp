@@ -0,0 +1,330 @@
+#include "learnopengl-implementation/video_capture.h"
+#include "learnopengl-implementation/yuv_convert.h"
+#include "learnopengl-implementation/gl_helpers.h"
+
+#include <csignal>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    // row pairs converted per job
+    const unsigned int ROW_PAIRS_PER_JOB = 16;
+}
+
+VideoCapture::VideoCapture( JobSystem& jobs, GLResources& resources, const Settings& settings )
+    : jobs( jobs ), resources( resources ), settings( settings )
+{
+    this->settings.queueLength = std::max( 1u, settings.queueLength );
+    slots.reset( new Slot[this->settings.queueLength] );
+    for ( unsigned int i = 0; i < this->settings.queueLength; i++ )
+        slots[i].owner = this;
+    queue.reserve( this->settings.queueLength );
+}
+
+VideoCapture::~VideoCapture( )
+{
+    // the conversion jobs point into the slots
+    for ( unsigned int i = 0; i < settings.queueLength; i++ )
+        jobs.wait( &slots[i].converted );
+    stopWriter( );
+}
+
+bool VideoCapture::open( )
+{
+    if ( !settings.output.empty( ) && settings.output[0] == '|' )
+    {
+        // a reader that goes away must end the recording, not the process
+        signal( SIGPIPE, SIG_IGN );
+        stream = popen( settings.output.c_str( ) + 1, "w" );
+        pipe = true;
+    }
+    else
+    {
+        stream = fopen( settings.output.c_str( ), "wb" );
+        pipe = false;
+    }
+    if ( !stream )
+    {
+        std::cerr << "ERROR::VIDEO_CAPTURE::OPEN_FAILED " << settings.output << std::endl;
+        return false;
+    }
+    writer = std::thread( &VideoCapture::writerLoop, this );
+    return true;
+}
+
+bool VideoCapture::capture( int width, int height )
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now( );
+    // 4:2:0 needs even sizes, the odd last row or column is cut
+    width &= ~1;
+    height &= ~1;
+    if ( width <= 0 || height <= 0 || failed.load( std::memory_order_relaxed ) )
+        return false;
+    if ( this->width == 0 )
+    {
+        this->width = width;
+        this->height = height;
+        if ( !open( ) )
+        {
+            failed = true;
+            return false;
+        }
+    }
+    if ( width != this->width || height != this->height )
+    {
+        droppedSize++;
+        return false;
+    }
+
+    Slot& slot = slots[next];
+    if ( slot.state.load( std::memory_order_acquire ) != FREE )
+    {
+        if ( settings.policy == Policy::DROP )
+        {
+            droppedFull++;
+            return false;
+        }
+
+        // helping the frame along instead of only waiting, the conversion may be
+        // queued behind jobs nobody else is running right now
+        std::chrono::steady_clock::time_point blockStart = std::chrono::steady_clock::now( );
+        while ( true )
+        {
+            int state = slot.state.load( std::memory_order_acquire );
+            if ( state == FREE )
+                break;
+            if ( state == READING )
+                glClientWaitSync( slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000 );
+            else if ( state == CONVERTING )
+                jobs.wait( &slot.converted );
+            advance( );
+            if ( slot.state.load( std::memory_order_acquire ) == WRITING )
+                std::this_thread::yield( );
+        }
+        blockedNanoseconds += nanosecondsSince( blockStart );
+    }
+
+    size_t size = (size_t) width * height * 4;
+    if ( slot.buffer.get( ).isNull( ) )
+        slot.buffer = ScopedBuffer( resources, resources.createBuffer( "video capture readback" ) );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, slot.buffer.name( ) );
+    if ( slot.capacity < size )
+    {
+        glBufferData( GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ );
+        slot.capacity = size;
+        resources.setSize( slot.buffer.get( ), size );
+        slot.planes.resize( (size_t) width * height * 3 / 2 );
+    }
+
+    glBindFramebuffer( GL_READ_FRAMEBUFFER, 0 );
+    glReadBuffer( GL_BACK );
+    glPixelStorei( GL_PACK_ALIGNMENT, 4 );
+    glReadPixels( 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+    slot.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+    slot.state.store( READING, std::memory_order_relaxed );
+    next = ( next + 1 ) % settings.queueLength;
+    captured++;
+
+    unsigned long long elapsed = nanosecondsSince( start );
+    glThreadNanoseconds += elapsed;
+    frameNanoseconds += elapsed;
+    return true;
+}
+
+void VideoCapture::update( )
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now( );
+    // the previous frame's capture( ) and update( ) together
+    maxFrameNanoseconds = std::max( maxFrameNanoseconds, frameNanoseconds );
+    frameNanoseconds = 0;
+    frames++;
+
+    advance( );
+
+    unsigned long long elapsed = nanosecondsSince( start );
+    glThreadNanoseconds += elapsed;
+    frameNanoseconds += elapsed;
+}
+
+void VideoCapture::advance( )
+{
+    for ( unsigned int i = 0; i < settings.queueLength; i++ )
+    {
+        Slot& slot = slots[i];
+        if ( slot.state.load( std::memory_order_relaxed ) != READING )
+            continue;
+        GLenum status = glClientWaitSync( slot.fence, 0, 0 );
+        if ( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED )
+            continue;
+        glDeleteSync( slot.fence );
+        slot.fence = nullptr;
+
+        // the workers read the mapped buffer in place
+        glBindBuffer( GL_PIXEL_PACK_BUFFER, slot.buffer.name( ) );
+        slot.pixels = (const unsigned char*) glMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, (size_t) width * height * 4, GL_MAP_READ_BIT );
+        glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+        slot.state.store( CONVERTING, std::memory_order_relaxed );
+        if ( !slot.pixels )
+            continue;
+
+        unsigned int rowPairs = height / 2;
+        for ( unsigned int begin = 0; begin < rowPairs; begin += ROW_PAIRS_PER_JOB )
+            jobs.run( convertRows, &slot, begin, std::min( begin + ROW_PAIRS_PER_JOB, rowPairs ), &slot.converted );
+    }
+
+    // the stream needs the frames in order, a converted frame waits for the ones before it
+    bool handedOver = false;
+    while ( true )
+    {
+        Slot& slot = slots[nextWrite];
+        if ( slot.state.load( std::memory_order_relaxed ) != CONVERTING || !jobs.isDone( &slot.converted ) )
+            break;
+
+        bool converted = slot.pixels != nullptr;
+        if ( converted )
+        {
+            glBindBuffer( GL_PIXEL_PACK_BUFFER, slot.buffer.name( ) );
+            glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+            glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+            slot.pixels = nullptr;
+        }
+        nextWrite = ( nextWrite + 1 ) % settings.queueLength;
+        if ( !converted )
+        {
+            droppedFull++;
+            slot.state.store( FREE, std::memory_order_release );
+            continue;
+        }
+
+        slot.state.store( WRITING, std::memory_order_relaxed );
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            queue.push_back( &slot );
+        }
+        handedOver = true;
+    }
+    if ( handedOver )
+        wake.notify_one( );
+}
+
+void VideoCapture::convertRows( void* data, unsigned int begin, unsigned int end )
+{
+    Slot* slot = (Slot*) data;
+    int width = slot->owner->width;
+    int height = slot->owner->height;
+    unsigned char* y = slot->planes.data( );
+    unsigned char* u = y + (size_t) width * height;
+    unsigned char* v = u + (size_t) width * height / 4;
+
+    // GL returns the bottom row first, the stream starts with the top one
+    for ( unsigned int pair = begin; pair < end; pair++ )
+    {
+        int row = 2 * pair;
+        const unsigned char* top = slot->pixels + (size_t) ( height - 1 - row ) * width * 4;
+        const unsigned char* bottom = slot->pixels + (size_t) ( height - 2 - row ) * width * 4;
+        YuvConvert::convertRowPair( top, bottom, width, y + (size_t) row * width, y + (size_t) ( row + 1 ) * width,
+                                    u + (size_t) pair * width / 2, v + (size_t) pair * width / 2 );
+    }
+}
+
+void VideoCapture::writerLoop( )
+{
+    bool headerWritten = false;
+    while ( true )
+    {
+        Slot* slot;
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            wake.wait( lock, [this]( ) { return stopping || !queue.empty( ); } );
+            if ( queue.empty( ) )
+                return;
+            slot = queue.front( );
+            queue.erase( queue.begin( ) );
+        }
+
+        if ( !failed.load( std::memory_order_relaxed ) )
+        {
+            if ( !headerWritten )
+            {
+                // C420jpeg: chroma sited in the middle of each 2x2 block, as averaged by the conversion
+                fprintf( stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, settings.frameRate );
+                headerWritten = true;
+            }
+            if ( fwrite( "FRAME\n", 1, 6, stream ) != 6 || fwrite( slot->planes.data( ), 1, slot->planes.size( ), stream ) != slot->planes.size( ) )
+                failed = true;
+            else
+                written.fetch_add( 1, std::memory_order_relaxed );
+        }
+        slot->state.store( FREE, std::memory_order_release );
+    }
+}
+
+void VideoCapture::shutdown( )
+{
+    // flushing so the fences of the last frames can signal, then draining the queue
+    glFlush( );
+    bool busy = true;
+    while ( busy )
+    {
+        busy = false;
+        for ( unsigned int i = 0; i < settings.queueLength; i++ )
+        {
+            Slot& slot = slots[i];
+            int state = slot.state.load( std::memory_order_acquire );
+            if ( state == READING )
+                glClientWaitSync( slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000 );
+            else if ( state == CONVERTING )
+                jobs.wait( &slot.converted );
+            busy = busy || state != FREE;
+        }
+        advance( );
+        if ( busy )
+            std::this_thread::yield( );
+    }
+
+    stopWriter( );
+    for ( unsigned int i = 0; i < settings.queueLength; i++ )
+        slots[i].buffer.reset( );
+}
+
+void VideoCapture::stopWriter( )
+{
+    if ( writer.joinable( ) )
+    {
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            stopping = true;
+        }
+        wake.notify_all( );
+        writer.join( );
+    }
+    if ( stream )
+    {
+        if ( pipe )
+            pclose( stream );
+        else
+            fclose( stream );
+        stream = nullptr;
+    }
+}
+
+void VideoCapture::report( std::ostream& out ) const
+{
+    if ( captured == 0 && droppedFull == 0 && droppedSize == 0 )
+        return;
+    out << "Video capture: " << written.load( ) << " of " << captured + droppedFull + droppedSize << " frames written to " << settings.output
+        << " ( " << width << "x" << height << ", " << YuvConvert::name( ) << " conversion, "
+        << ( settings.policy == Policy::DROP ? "dropping" : "blocking" ) << " when " << settings.queueLength << " frames are queued )";
+    if ( failed.load( ) )
+        out << " [stream failed]";
+    out << std::endl;
+    out << "  " << droppedFull << " dropped with the queue full, " << droppedSize << " dropped for their size";
+    if ( frames > 0 )
+        out << ", GL thread " << glThreadNanoseconds / 1000.0 / frames << " us per frame ( " << maxFrameNanoseconds / 1000.0 << " us max, "
+            << blockedNanoseconds / 1000000.0 << " ms blocked in total )";
+    out << std::endl;
+}
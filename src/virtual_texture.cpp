@@ -0,0 +1,551 @@
+#include "learnopengl-implementation/virtual_texture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    bool isPowerOfTwo( int value )
+    {
+        return value > 0 && ( value & ( value - 1 ) ) == 0;
+    }
+
+    // page table entries and tiles are RGBA8
+    const int TEXEL_BYTES = 4;
+}
+
+VirtualTexture::VirtualTexture( JobSystem& jobs, GLResources& resources, const Settings& settings )
+    : jobs( jobs ), resources( resources ), settings( settings )
+{
+}
+
+VirtualTexture::~VirtualTexture( )
+{
+    // the jobs point into this object
+    jobs.wait( &sorted );
+    jobs.wait( &copied );
+}
+
+bool VirtualTexture::initialize( MipChain&& chain )
+{
+    if ( !settings.enabled || chain.levels.empty( ) || ( chain.channels != 3 && chain.channels != 4 ) )
+        return false;
+    int size = chain.widths[0];
+    int tileSize = settings.tileSize;
+    // page and tile coordinates are stored in 8 bit channels
+    if ( chain.heights[0] != size || !isPowerOfTwo( size ) || !isPowerOfTwo( tileSize ) || size < tileSize ||
+         size / tileSize > 256 || settings.cacheTiles < 1 || settings.cacheTiles > 256 )
+        return false;
+
+    source = std::move( chain );
+    levels = 0;
+    levelOffsets.clear( );
+    pageCount = 0;
+    for ( int pages = size / tileSize; pages >= 1; pages /= 2 )
+    {
+        levelOffsets.push_back( pageCount );
+        pageCount += pages * pages;
+        levels++;
+    }
+    rootPage = levelOffsets[levels - 1];
+
+    int slotCount = settings.cacheTiles * settings.cacheTiles;
+    pageSlots.assign( pageCount, -1 );
+    slotPages.assign( slotCount, -1 );
+    slotLastUsed.assign( slotCount, 0 );
+    pageTableData.assign( (size_t) pageCount * TEXEL_BYTES, 0 );
+    pageHits.assign( pageCount, 0 );
+
+    // one texel per page, sampled with texelFetch so the filtering never mixes entries
+    pageTable = ScopedTexture( resources, resources.createTexture( "virtual page table" ) );
+    glBindTexture( GL_TEXTURE_2D, pageTable.name( ) );
+    for ( int level = 0; level < levels; level++ )
+        glTexImage2D( GL_TEXTURE_2D, level, GL_RGBA8, pagesPerSide( level ), pagesPerSide( level ), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1 );
+    resources.setSize( pageTable.get( ), pageTableData.size( ) );
+
+    int cacheSize = settings.cacheTiles * tileSize;
+    cache = ScopedTexture( resources, resources.createTexture( "virtual tile cache" ) );
+    glBindTexture( GL_TEXTURE_2D, cache.name( ) );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, cacheSize, cacheSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0 );
+    resources.setSize( cache.get( ), (size_t) cacheSize * cacheSize * TEXEL_BYTES );
+
+    size_t tileBytes = (size_t) tileSize * tileSize * TEXEL_BYTES;
+    uploadBuffer = ScopedBuffer( resources, resources.createBuffer( "virtual tile uploads" ) );
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, uploadBuffer.name( ) );
+    glBufferData( GL_PIXEL_UNPACK_BUFFER, tileBytes * settings.tilesPerBatch, nullptr, GL_STREAM_DRAW );
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+    resources.setSize( uploadBuffer.get( ), tileBytes * settings.tilesPerBatch );
+
+    feedbackFramebuffer = ScopedFramebuffer( resources, resources.createFramebuffer( "virtual feedback" ) );
+    feedbackColor = ScopedTexture( resources, resources.createTexture( "virtual feedback color" ) );
+    feedbackDepth = ScopedTexture( resources, resources.createTexture( "virtual feedback depth" ) );
+    for ( Readback& readback : readbacks )
+        readback.buffer = ScopedBuffer( resources, resources.createBuffer( "virtual feedback readback" ) );
+
+    // the coarsest page covers the whole image and stays resident, every other page falls back to it
+    std::vector<unsigned char> root( tileBytes );
+    TileCopy copy = { this, rootPage, 0, root.data( ) };
+    copyTile( &copy, 0, 0 );
+    glBindTexture( GL_TEXTURE_2D, cache.name( ) );
+    glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, tileSize, tileSize, GL_RGBA, GL_UNSIGNED_BYTE, root.data( ) );
+    pageSlots[rootPage] = 0;
+    slotPages[0] = rootPage;
+    tilesUploaded++;
+    updatePageTable( );
+    return true;
+}
+
+bool VirtualTexture::isReady( ) const
+{
+    return rootPage >= 0;
+}
+
+bool VirtualTexture::beginFeedback( int viewportWidth, int viewportHeight )
+{
+    if ( !isReady( ) )
+        return false;
+    if ( readbacks[nextReadback].fence )
+    {
+        readbacksSkipped++;
+        return false;
+    }
+
+    this->viewportWidth = viewportWidth;
+    this->viewportHeight = viewportHeight;
+    int width = std::max( 1, viewportWidth / settings.feedbackDivisor );
+    int height = std::max( 1, viewportHeight / settings.feedbackDivisor );
+    if ( width != feedbackWidth || height != feedbackHeight )
+        createFeedbackTarget( width, height );
+
+    glBindFramebuffer( GL_FRAMEBUFFER, feedbackFramebuffer.name( ) );
+    glViewport( 0, 0, feedbackWidth, feedbackHeight );
+    // a zero alpha marks the texels that request nothing
+    glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
+    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+    return true;
+}
+
+void VirtualTexture::endFeedback( )
+{
+    Readback& readback = readbacks[nextReadback];
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, readback.buffer.name( ) );
+    glPixelStorei( GL_PACK_ALIGNMENT, 4 );
+    glReadPixels( 0, 0, feedbackWidth, feedbackHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+    readback.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+    readback.width = feedbackWidth;
+    readback.height = feedbackHeight;
+    readback.frame = frame;
+    nextReadback = ( nextReadback + 1 ) % READBACK_COUNT;
+    readbacksIssued++;
+
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    glViewport( 0, 0, viewportWidth, viewportHeight );
+}
+
+void VirtualTexture::createFeedbackTarget( int width, int height )
+{
+    // readbacks of the old size are dropped, their buffers are respecified below
+    for ( Readback& readback : readbacks )
+    {
+        if ( readback.fence )
+            glDeleteSync( readback.fence );
+        readback.fence = nullptr;
+        glBindBuffer( GL_PIXEL_PACK_BUFFER, readback.buffer.name( ) );
+        glBufferData( GL_PIXEL_PACK_BUFFER, (size_t) width * height * TEXEL_BYTES, nullptr, GL_STREAM_READ );
+        resources.setSize( readback.buffer.get( ), (size_t) width * height * TEXEL_BYTES );
+    }
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+    glBindTexture( GL_TEXTURE_2D, feedbackColor.name( ) );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    resources.setSize( feedbackColor.get( ), (size_t) width * height * TEXEL_BYTES );
+
+    glBindTexture( GL_TEXTURE_2D, feedbackDepth.name( ) );
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+    resources.setSize( feedbackDepth.get( ), (size_t) width * height * TEXEL_BYTES );
+
+    glBindFramebuffer( GL_FRAMEBUFFER, feedbackFramebuffer.name( ) );
+    glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, feedbackColor.name( ), 0 );
+    glFramebufferTexture2D( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, feedbackDepth.name( ), 0 );
+    if ( glCheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE )
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::FEEDBACK_TARGET_INCOMPLETE" << std::endl;
+    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+
+    feedbackWidth = width;
+    feedbackHeight = height;
+}
+
+void VirtualTexture::update( )
+{
+    frame++;
+    if ( !isReady( ) )
+        return;
+
+    if ( stage == Stage::IDLE )
+        collectFeedback( );
+    if ( stage == Stage::SORTING && jobs.isDone( &sorted ) )
+        scheduleCopies( );
+    if ( stage == Stage::COPYING && jobs.isDone( &copied ) )
+        uploadTiles( );
+}
+
+void VirtualTexture::collectFeedback( )
+{
+    // the GPU finishes the readbacks in order, so the newest finished one is
+    // the last signaled one counting from the oldest, the older ones are stale
+    Readback* newest = nullptr;
+    for ( int i = 0; i < READBACK_COUNT; i++ )
+    {
+        Readback& readback = readbacks[( nextReadback + i ) % READBACK_COUNT];
+        if ( !readback.fence )
+            continue;
+        GLenum status = glClientWaitSync( readback.fence, 0, 0 );
+        if ( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED )
+            break;
+        if ( newest )
+        {
+            glDeleteSync( newest->fence );
+            newest->fence = nullptr;
+        }
+        newest = &readback;
+    }
+    if ( !newest )
+        return;
+
+    size_t bytes = (size_t) newest->width * newest->height * TEXEL_BYTES;
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, newest->buffer.name( ) );
+    const void* pixels = glMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT );
+    if ( pixels )
+    {
+        feedback.assign( (const unsigned char*) pixels, (const unsigned char*) pixels + bytes );
+        glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+    }
+    glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+    glDeleteSync( newest->fence );
+    newest->fence = nullptr;
+    if ( !pixels )
+        return;
+
+    readbackLatency += frame - newest->frame;
+    stage = Stage::SORTING;
+    jobs.run( sortRequests, this, 0, 0, &sorted );
+}
+
+void VirtualTexture::sortRequests( void* data, unsigned int, unsigned int )
+{
+    VirtualTexture* texture = (VirtualTexture*) data;
+    std::vector<unsigned int>& hits = texture->pageHits;
+    std::fill( hits.begin( ), hits.end( ), 0 );
+
+    // each texel holds the page x, y and level it samples
+    const std::vector<unsigned char>& feedback = texture->feedback;
+    for ( size_t i = 0; i + 3 < feedback.size( ); i += TEXEL_BYTES )
+    {
+        if ( feedback[i + 3] == 0 )
+            continue;
+        int level = std::min( (int) feedback[i + 2], texture->levels - 1 );
+        int pages = texture->pagesPerSide( level );
+        int x = std::min( (int) feedback[i], pages - 1 );
+        int y = std::min( (int) feedback[i + 1], pages - 1 );
+        hits[texture->levelOffsets[level] + y * pages + x]++;
+    }
+
+    // a page's ancestors are requested along with it, they are what it falls back to until it is loaded
+    for ( int level = 0; level + 1 < texture->levels; level++ )
+    {
+        int pages = texture->pagesPerSide( level );
+        for ( int y = 0; y < pages; y++ )
+        {
+            for ( int x = 0; x < pages; x++ )
+            {
+                unsigned int pageHits = hits[texture->levelOffsets[level] + y * pages + x];
+                if ( pageHits > 0 )
+                    hits[texture->levelOffsets[level + 1] + ( y / 2 ) * ( pages / 2 ) + x / 2] += pageHits;
+            }
+        }
+    }
+
+    // coarse levels first so there is always something close to fall back to, then the most covered pages
+    std::vector<int>& requests = texture->requests;
+    requests.clear( );
+    for ( int page = 0; page < texture->pageCount; page++ )
+    {
+        if ( hits[page] > 0 )
+            requests.push_back( page );
+    }
+    std::sort( requests.begin( ), requests.end( ), [texture, &hits]( int a, int b ) {
+        int levelA = texture->pageLevel( a );
+        int levelB = texture->pageLevel( b );
+        if ( levelA != levelB )
+            return levelA > levelB;
+        return hits[a] > hits[b];
+    } );
+}
+
+void VirtualTexture::scheduleCopies( )
+{
+    readbacksSorted++;
+    pagesRequested += requests.size( );
+
+    // every requested page is in use, so none of them makes room for the others
+    for ( int page : requests )
+    {
+        if ( pageSlots[page] >= 0 )
+            slotLastUsed[pageSlots[page]] = frame;
+    }
+
+    copies.clear( );
+    for ( int page : requests )
+    {
+        if ( (int) copies.size( ) >= settings.tilesPerBatch )
+            break;
+        if ( pageSlots[page] >= 0 )
+            continue;
+        int slot = allocateSlot( );
+        if ( slot < 0 )
+            break;
+        // the page table keeps pointing at the old page until the new tile replaces it
+        if ( slotPages[slot] >= 0 )
+        {
+            pageSlots[slotPages[slot]] = -1;
+            tilesEvicted++;
+        }
+        slotPages[slot] = page;
+        slotLastUsed[slot] = frame;
+        copies.push_back( TileCopy{ this, page, slot, nullptr } );
+    }
+    if ( copies.empty( ) )
+    {
+        stage = Stage::IDLE;
+        return;
+    }
+
+    // the workers write straight into the upload buffer
+    size_t tileBytes = (size_t) settings.tileSize * settings.tileSize * TEXEL_BYTES;
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, uploadBuffer.name( ) );
+    unsigned char* mapped = (unsigned char*) glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, tileBytes * copies.size( ),
+                                                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+    if ( !mapped )
+    {
+        for ( const TileCopy& copy : copies )
+            slotPages[copy.slot] = -1;
+        copies.clear( );
+        updatePageTable( );
+        stage = Stage::IDLE;
+        return;
+    }
+
+    stage = Stage::COPYING;
+    for ( size_t i = 0; i < copies.size( ); i++ )
+    {
+        copies[i].destination = mapped + i * tileBytes;
+        jobs.run( copyTile, &copies[i], 0, 0, &copied );
+    }
+}
+
+void VirtualTexture::copyTile( void* data, unsigned int, unsigned int )
+{
+    const TileCopy* copy = (const TileCopy*) data;
+    const VirtualTexture* texture = copy->owner;
+    const MipChain& source = texture->source;
+
+    int level = texture->pageLevel( copy->page );
+    int pages = texture->pagesPerSide( level );
+    int index = copy->page - texture->levelOffsets[level];
+    int tileSize = texture->settings.tileSize;
+    int x0 = ( index % pages ) * tileSize;
+    int y0 = ( index / pages ) * tileSize;
+    int width = source.widths[level];
+    int channels = source.channels;
+
+    // tiles are always RGBA, RGB sources get an opaque alpha
+    const unsigned char* pixels = source.levels[level].data( );
+    unsigned char* destination = copy->destination;
+    for ( int y = 0; y < tileSize; y++ )
+    {
+        const unsigned char* row = pixels + ( (size_t) ( y0 + y ) * width + x0 ) * channels;
+        if ( channels == 4 )
+        {
+            memcpy( destination, row, (size_t) tileSize * 4 );
+            destination += tileSize * 4;
+            continue;
+        }
+        for ( int x = 0; x < tileSize; x++ )
+        {
+            destination[0] = row[0];
+            destination[1] = row[1];
+            destination[2] = row[2];
+            destination[3] = 255;
+            destination += 4;
+            row += 3;
+        }
+    }
+}
+
+void VirtualTexture::uploadTiles( )
+{
+    size_t tileBytes = (size_t) settings.tileSize * settings.tileSize * TEXEL_BYTES;
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, uploadBuffer.name( ) );
+    // the buffer contents are undefined when the unmap fails, the slots are handed back then
+    bool intact = glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER ) == GL_TRUE;
+
+    glBindTexture( GL_TEXTURE_2D, cache.name( ) );
+    for ( size_t i = 0; i < copies.size( ); i++ )
+    {
+        const TileCopy& copy = copies[i];
+        if ( !intact )
+        {
+            slotPages[copy.slot] = -1;
+            continue;
+        }
+        int x = ( copy.slot % settings.cacheTiles ) * settings.tileSize;
+        int y = ( copy.slot / settings.cacheTiles ) * settings.tileSize;
+        glTexSubImage2D( GL_TEXTURE_2D, 0, x, y, settings.tileSize, settings.tileSize, GL_RGBA, GL_UNSIGNED_BYTE,
+                         (const void*) ( i * tileBytes ) );
+        pageSlots[copy.page] = copy.slot;
+        tilesUploaded++;
+    }
+    glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+    copies.clear( );
+    updatePageTable( );
+    stage = Stage::IDLE;
+}
+
+int VirtualTexture::allocateSlot( )
+{
+    int victim = -1;
+    for ( int slot = 0; slot < (int) slotPages.size( ); slot++ )
+    {
+        int page = slotPages[slot];
+        if ( page < 0 )
+            return slot;
+        // pages requested by this batch and the root stay
+        if ( page == rootPage || slotLastUsed[slot] >= frame )
+            continue;
+        if ( victim < 0 || slotLastUsed[slot] < slotLastUsed[victim] )
+            victim = slot;
+    }
+    return victim;
+}
+
+void VirtualTexture::updatePageTable( )
+{
+    // coarsest level first, a missing page takes over the entry of its parent
+    for ( int level = levels - 1; level >= 0; level-- )
+    {
+        int pages = pagesPerSide( level );
+        for ( int y = 0; y < pages; y++ )
+        {
+            for ( int x = 0; x < pages; x++ )
+            {
+                int page = levelOffsets[level] + y * pages + x;
+                unsigned char* entry = &pageTableData[(size_t) page * TEXEL_BYTES];
+                int slot = pageSlots[page];
+                if ( slot >= 0 )
+                {
+                    entry[0] = (unsigned char) ( slot % settings.cacheTiles );
+                    entry[1] = (unsigned char) ( slot / settings.cacheTiles );
+                    entry[2] = (unsigned char) level;
+                    entry[3] = 255;
+                }
+                else
+                {
+                    int parent = levelOffsets[level + 1] + ( y / 2 ) * ( pages / 2 ) + x / 2;
+                    memcpy( entry, &pageTableData[(size_t) parent * TEXEL_BYTES], TEXEL_BYTES );
+                }
+            }
+        }
+    }
+
+    glBindTexture( GL_TEXTURE_2D, pageTable.name( ) );
+    for ( int level = 0; level < levels; level++ )
+        glTexSubImage2D( GL_TEXTURE_2D, level, 0, 0, pagesPerSide( level ), pagesPerSide( level ), GL_RGBA, GL_UNSIGNED_BYTE,
+                         &pageTableData[(size_t) levelOffsets[level] * TEXEL_BYTES] );
+}
+
+int VirtualTexture::pageLevel( int page ) const
+{
+    int level = 0;
+    while ( level + 1 < levels && page >= levelOffsets[level + 1] )
+        level++;
+    return level;
+}
+
+int VirtualTexture::pagesPerSide( int level ) const
+{
+    return ( source.widths[0] / settings.tileSize ) >> level;
+}
+
+void VirtualTexture::bind( int pageTableUnit, int cacheUnit ) const
+{
+    glActiveTexture( GL_TEXTURE0 + pageTableUnit );
+    glBindTexture( GL_TEXTURE_2D, pageTable.name( ) );
+    glActiveTexture( GL_TEXTURE0 + cacheUnit );
+    glBindTexture( GL_TEXTURE_2D, cache.name( ) );
+}
+
+void VirtualTexture::setUniforms( const Shader& shader ) const
+{
+    shader.setFloat( "virtualSize", (float) source.widths[0] );
+    shader.setFloat( "tileSize", (float) settings.tileSize );
+    shader.setFloat( "maxLevel", (float) ( levels - 1 ) );
+    // the feedback target's texels are this many levels coarser than the screen's
+    shader.setFloat( "feedbackBias", std::log2( (float) settings.feedbackDivisor ) );
+}
+
+void VirtualTexture::shutdown( )
+{
+    jobs.wait( &sorted );
+    jobs.wait( &copied );
+    if ( stage == Stage::COPYING )
+    {
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, uploadBuffer.name( ) );
+        glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+    }
+    stage = Stage::IDLE;
+
+    for ( Readback& readback : readbacks )
+    {
+        if ( readback.fence )
+            glDeleteSync( readback.fence );
+        readback.fence = nullptr;
+        readback.buffer.reset( );
+    }
+    pageTable.reset( );
+    cache.reset( );
+    feedbackColor.reset( );
+    feedbackDepth.reset( );
+    feedbackFramebuffer.reset( );
+    uploadBuffer.reset( );
+}
+
+void VirtualTexture::report( std::ostream& out ) const
+{
+    if ( !isReady( ) )
+        return;
+    int resident = (int) std::count_if( pageSlots.begin( ), pageSlots.end( ), []( int slot ) { return slot >= 0; } );
+    out << "Virtual texture: " << resident << " of " << pageCount << " pages resident in " << slotPages.size( ) << " tiles, "
+        << tilesUploaded << " uploads, " << tilesEvicted << " evictions" << std::endl;
+    out << "  feedback: " << readbacksIssued << " readbacks, " << readbacksSkipped << " skipped with the ring full, " << readbacksSorted
+        << " sorted";
+    if ( readbacksSorted > 0 )
+        out << " ( " << (double) readbackLatency / readbacksSorted << " frames late, " << (double) pagesRequested / readbacksSorted
+            << " pages requested on average )";
+    out << std::endl;
+}
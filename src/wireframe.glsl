@@ -0,0 +1,27 @@
+// the triangle edges the scene shaders draw themselves ( see WireframeMode ), from the
+// barycentrics shader.vs gives every triangle
+noperspective in vec3 barycentric;
+// 0 off, 1 over the shading, 2 over a flat fill
+uniform int wireframe;
+
+// width in pixels and color of the wireframe lines, and the fill behind them in hidden line mode
+const float WIRE_WIDTH = 1.5;
+const vec3 WIRE_COLOR = vec3( 0.05 );
+const vec3 WIRE_FILL = vec3( 0.85 );
+
+// the wireframe over a color, the lines antialiased by the part of the pixel they cover; each
+// face of the cube is two triangles whose shared diagonal lies opposite their second corner,
+// which is left out so the faces show as the quads they are
+vec3 applyWireframe( vec3 color )
+{
+    if ( wireframe == 0 )
+        return color;
+    // distance to each edge in pixels, the barycentrics are linear across the screen ( the
+    // length of their gradient, fwidth( ) would thicken diagonal lines ); every triangle draws
+    // its half of the line
+    vec3 dx = dFdx( barycentric );
+    vec3 dy = dFdy( barycentric );
+    vec3 pixels = barycentric / max( sqrt( dx * dx + dy * dy ), vec3( 1e-6 ) );
+    float coverage = clamp( 0.5 * WIRE_WIDTH + 0.5 - min( pixels.x, pixels.z ), 0.0, 1.0 );
+    return mix( wireframe == 2 ? WIRE_FILL : color, WIRE_COLOR, coverage );
+}
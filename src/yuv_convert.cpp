@@ -0,0 +1,140 @@
+#include "learnopengl-implementation/yuv_convert.h"
+
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) ) && defined( __SSE2__ )
+#define YUV_CONVERT_SSE2 1
+#include <emmintrin.h>
+#else
+#define YUV_CONVERT_SSE2 0
+#endif
+
+namespace
+{
+    // the integer BT.601 approximations, the same in both variants so they match exactly
+    inline unsigned char luma( int r, int g, int b )
+    {
+        return (unsigned char) ( ( ( 66 * r + 129 * g + 25 * b + 128 ) >> 8 ) + 16 );
+    }
+
+    inline unsigned char chromaU( int r, int g, int b )
+    {
+        return (unsigned char) ( ( ( -38 * r - 74 * g + 112 * b + 128 ) >> 8 ) + 128 );
+    }
+
+    inline unsigned char chromaV( int r, int g, int b )
+    {
+        return (unsigned char) ( ( ( 112 * r - 94 * g - 18 * b + 128 ) >> 8 ) + 128 );
+    }
+
+    void convertPixels( const unsigned char* top, const unsigned char* bottom, int begin, int end,
+                        unsigned char* yTop, unsigned char* yBottom, unsigned char* u, unsigned char* v )
+    {
+        for ( int x = begin; x < end; x += 2 )
+        {
+            const unsigned char* a = top + x * 4;
+            const unsigned char* b = bottom + x * 4;
+            yTop[x] = luma( a[0], a[1], a[2] );
+            yTop[x + 1] = luma( a[4], a[5], a[6] );
+            yBottom[x] = luma( b[0], b[1], b[2] );
+            yBottom[x + 1] = luma( b[4], b[5], b[6] );
+
+            int r = ( a[0] + a[4] + b[0] + b[4] + 2 ) >> 2;
+            int g = ( a[1] + a[5] + b[1] + b[5] + 2 ) >> 2;
+            int blue = ( a[2] + a[6] + b[2] + b[6] + 2 ) >> 2;
+            u[x / 2] = chromaU( r, g, blue );
+            v[x / 2] = chromaV( r, g, blue );
+        }
+    }
+
+#if YUV_CONVERT_SSE2
+
+    // splits 8 RGBA pixels into 16 bit R, G and B lanes
+    inline void deinterleave( const unsigned char* pixels, __m128i& r, __m128i& g, __m128i& b )
+    {
+        const __m128i mask = _mm_set1_epi32( 0xff );
+        __m128i low = _mm_loadu_si128( (const __m128i*) pixels );
+        __m128i high = _mm_loadu_si128( (const __m128i*) ( pixels + 16 ) );
+        r = _mm_packs_epi32( _mm_and_si128( low, mask ), _mm_and_si128( high, mask ) );
+        g = _mm_packs_epi32( _mm_and_si128( _mm_srli_epi32( low, 8 ), mask ), _mm_and_si128( _mm_srli_epi32( high, 8 ), mask ) );
+        b = _mm_packs_epi32( _mm_and_si128( _mm_srli_epi32( low, 16 ), mask ), _mm_and_si128( _mm_srli_epi32( high, 16 ), mask ) );
+    }
+
+    // the weighted sum is at most 56100 + 128, it wraps into the unsigned range of the lanes
+    inline __m128i lumaSSE2( __m128i r, __m128i g, __m128i b )
+    {
+        __m128i sum = _mm_add_epi16( _mm_mullo_epi16( r, _mm_set1_epi16( 66 ) ), _mm_mullo_epi16( g, _mm_set1_epi16( 129 ) ) );
+        sum = _mm_add_epi16( sum, _mm_mullo_epi16( b, _mm_set1_epi16( 25 ) ) );
+        sum = _mm_add_epi16( sum, _mm_set1_epi16( 128 ) );
+        return _mm_add_epi16( _mm_srli_epi16( sum, 8 ), _mm_set1_epi16( 16 ) );
+    }
+
+    // rounded mean of the 2x2 blocks, 4 lanes out of 8 pixels of two rows
+    inline __m128i blockMean( __m128i top, __m128i bottom )
+    {
+        __m128i pairs = _mm_madd_epi16( _mm_add_epi16( top, bottom ), _mm_set1_epi16( 1 ) );
+        pairs = _mm_srli_epi32( _mm_add_epi32( pairs, _mm_set1_epi32( 2 ) ), 2 );
+        return _mm_packs_epi32( pairs, pairs );
+    }
+
+    // the weighted sums stay within +-28560, signed 16 bit lanes hold them
+    inline __m128i chromaSSE2( __m128i r, __m128i g, __m128i b, short wr, short wg, short wb )
+    {
+        __m128i sum = _mm_add_epi16( _mm_mullo_epi16( r, _mm_set1_epi16( wr ) ), _mm_mullo_epi16( g, _mm_set1_epi16( wg ) ) );
+        sum = _mm_add_epi16( sum, _mm_mullo_epi16( b, _mm_set1_epi16( wb ) ) );
+        sum = _mm_add_epi16( sum, _mm_set1_epi16( 128 ) );
+        return _mm_add_epi16( _mm_srai_epi16( sum, 8 ), _mm_set1_epi16( 128 ) );
+    }
+
+    void convertRowPairSSE2( const unsigned char* top, const unsigned char* bottom, int width,
+                             unsigned char* yTop, unsigned char* yBottom, unsigned char* u, unsigned char* v )
+    {
+        int x = 0;
+        for ( ; x + 8 <= width; x += 8 )
+        {
+            __m128i r0, g0, b0, r1, g1, b1;
+            deinterleave( top + x * 4, r0, g0, b0 );
+            deinterleave( bottom + x * 4, r1, g1, b1 );
+
+            __m128i y0 = lumaSSE2( r0, g0, b0 );
+            __m128i y1 = lumaSSE2( r1, g1, b1 );
+            _mm_storel_epi64( (__m128i*) ( yTop + x ), _mm_packus_epi16( y0, y0 ) );
+            _mm_storel_epi64( (__m128i*) ( yBottom + x ), _mm_packus_epi16( y1, y1 ) );
+
+            __m128i r = blockMean( r0, r1 );
+            __m128i g = blockMean( g0, g1 );
+            __m128i b = blockMean( b0, b1 );
+            __m128i cu = chromaSSE2( r, g, b, -38, -74, 112 );
+            __m128i cv = chromaSSE2( r, g, b, 112, -94, -18 );
+            int packedU = _mm_cvtsi128_si32( _mm_packus_epi16( cu, cu ) );
+            int packedV = _mm_cvtsi128_si32( _mm_packus_epi16( cv, cv ) );
+            __builtin_memcpy( u + x / 2, &packedU, 4 );
+            __builtin_memcpy( v + x / 2, &packedV, 4 );
+        }
+        convertPixels( top, bottom, x, width, yTop, yBottom, u, v );
+    }
+
+#endif
+}
+
+namespace YuvConvert
+{
+    void convertRowPair( const unsigned char* top, const unsigned char* bottom, int width,
+                         unsigned char* yTop, unsigned char* yBottom, unsigned char* u, unsigned char* v )
+    {
+#if YUV_CONVERT_SSE2
+        convertRowPairSSE2( top, bottom, width, yTop, yBottom, u, v );
+#else
+        convertPixels( top, bottom, 0, width, yTop, yBottom, u, v );
+#endif
+    }
+
+    void convertRowPairScalar( const unsigned char* top, const unsigned char* bottom, int width,
+                               unsigned char* yTop, unsigned char* yBottom, unsigned char* u, unsigned char* v )
+    {
+        convertPixels( top, bottom, 0, width, yTop, yBottom, u, v );
+    }
+
+    const char* name( )
+    {
+        return YUV_CONVERT_SSE2 ? "SSE2" : "scalar";
+    }
+}
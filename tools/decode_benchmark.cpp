@@ -0,0 +1,136 @@
+// measures parallel image decoding with and without the scratch arenas:
+// decode_benchmark [threads] [decodes per thread] [image]...
+// every thread decodes the images from memory over and over, once with stb_image's
+// allocations going to the heap and once through the per-thread arenas; the images
+// default to the repository's textures, the threads to the hardware concurrency
+
+#include "learnopengl-implementation/image_decoder.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef ASSET_ROOT
+#define ASSET_ROOT "."
+#endif
+
+namespace
+{
+    struct Image
+    {
+        std::string path;
+        std::vector<unsigned char> encoded;
+    };
+
+    // checksum of every decoded pixel, so both modes can be checked against each other
+    struct Result
+    {
+        double seconds = 0.0;
+        unsigned long long bytes = 0;
+        unsigned long long checksum = 0;
+        bool failed = false;
+    };
+
+    void decodeLoop( const std::vector<Image>* images, unsigned int decodes, Result* result )
+    {
+        for ( unsigned int i = 0; i < decodes; i++ )
+        {
+            const Image& image = ( *images )[i % images->size( )];
+            int width, height, channels;
+            unsigned char* pixels = ImageDecoder::loadFromMemory( image.encoded.data( ), image.encoded.size( ), &width, &height, &channels, 0 );
+            if ( !pixels )
+            {
+                result->failed = true;
+                return;
+            }
+            size_t size = (size_t) width * height * channels;
+            for ( size_t j = 0; j < size; j += 61 )
+                result->checksum += pixels[j];
+            result->bytes += size;
+            ImageDecoder::release( pixels );
+        }
+    }
+
+    Result run( const std::vector<Image>& images, unsigned int threads, unsigned int decodes, bool scratchArena )
+    {
+        ImageDecoder::setScratchArena( scratchArena );
+        std::vector<Result> results( threads );
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now( );
+        for ( unsigned int i = 0; i < threads; i++ )
+            workers.emplace_back( decodeLoop, &images, decodes, &results[i] );
+        for ( std::thread& worker : workers )
+            worker.join( );
+
+        Result total;
+        total.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now( ) - start ).count( );
+        for ( const Result& result : results )
+        {
+            total.bytes += result.bytes;
+            total.checksum += result.checksum;
+            total.failed = total.failed || result.failed;
+        }
+        return total;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    unsigned int threads = argc > 1 ? (unsigned int) std::atoi( argv[1] ) : std::thread::hardware_concurrency( );
+    unsigned int decodes = argc > 2 ? (unsigned int) std::atoi( argv[2] ) : 100;
+    if ( threads == 0 )
+        threads = 1;
+
+    std::vector<Image> images;
+    for ( int i = 3; i < argc; i++ )
+        images.push_back( Image{ argv[i], { } } );
+    if ( images.empty( ) )
+    {
+        images.push_back( Image{ std::string( ASSET_ROOT ) + "/textures/container.jpg", { } } );
+        images.push_back( Image{ std::string( ASSET_ROOT ) + "/textures/awesomeface.png", { } } );
+    }
+    for ( Image& image : images )
+    {
+        std::ifstream file( image.path, std::ios::binary );
+        image.encoded.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>( ) );
+        if ( image.encoded.empty( ) )
+        {
+            std::cerr << "Failed to read " << image.path << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Parallel decoding: " << threads << " threads, " << decodes << " decodes each, " << images.size( ) << " images"
+              << std::endl;
+    // one round each to warm up the caches and grow the arenas
+    run( images, threads, (unsigned int) images.size( ), false );
+    run( images, threads, (unsigned int) images.size( ), true );
+
+    Result heap = run( images, threads, decodes, false );
+    Result arena = run( images, threads, decodes, true );
+    if ( heap.failed || arena.failed )
+    {
+        std::cerr << "Decoding failed: " << ImageDecoder::failureReason( ) << std::endl;
+        return 1;
+    }
+    if ( heap.checksum != arena.checksum )
+    {
+        std::cerr << "The scratch arena decodes differ from the heap ones" << std::endl;
+        return 1;
+    }
+
+    double decodeCount = (double) threads * decodes;
+    std::cout << std::fixed << std::setprecision( 1 );
+    std::cout << "heap:          " << decodeCount / heap.seconds << " images/s, " << heap.bytes / heap.seconds / ( 1024.0 * 1024.0 )
+              << " MB/s of pixels" << std::endl;
+    std::cout << "scratch arena: " << decodeCount / arena.seconds << " images/s, " << arena.bytes / arena.seconds / ( 1024.0 * 1024.0 )
+              << " MB/s of pixels, " << std::setprecision( 2 ) << heap.seconds / arena.seconds << "x" << std::endl;
+    ImageDecoder::report( std::cout );
+    return 0;
+}
@@ -0,0 +1,191 @@
+// measures asset set load times through the I/O service: io_benchmark [files] [KB per file] [directory]
+// writes the asset set into a temporary directory, then loads it through io_uring and the
+// pread fallback, each with a cold page cache ( the files' pages dropped with
+// POSIX_FADV_DONTNEED first ) and a warm one; every tenth file is read in staging-buffer
+// sized pieces through the registered buffers, the rest straight into their destinations
+
+#include "learnopengl-implementation/io_service.h"
+#include "learnopengl-implementation/job_system.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const size_t STAGING_SIZE = 256 * 1024;
+
+    struct Load
+    {
+        IoService* io;
+        IoRequest request;
+        // set by the completion, checked after the wait
+        bool failed = false;
+    };
+
+    void completeDirect( void* data, unsigned int, unsigned int )
+    {
+        Load* load = static_cast<Load*>( data );
+        load->failed = load->request.result != (long long) load->request.size;
+    }
+
+    void completeStaged( void* data, unsigned int, unsigned int )
+    {
+        Load* load = static_cast<Load*>( data );
+        load->failed = load->request.result != (long long) load->request.size;
+        load->io->releaseBuffer( &load->request );
+    }
+
+    void dropCache( const std::vector<int>& files )
+    {
+        for ( int file : files )
+        {
+            fdatasync( file );
+            posix_fadvise( file, 0, 0, POSIX_FADV_DONTNEED );
+        }
+    }
+
+    // milliseconds to read every file, or a negative value when a read failed
+    double loadAll( JobSystem& jobs, IoService& io, const std::vector<int>& files, size_t fileSize, std::vector<unsigned char>& memory )
+    {
+        size_t staged = ( fileSize + STAGING_SIZE - 1 ) / STAGING_SIZE;
+        std::vector<Load> loads;
+        loads.reserve( files.size( ) * staged );
+
+        JobCounter counter;
+        auto start = std::chrono::steady_clock::now( );
+        for ( size_t i = 0; i < files.size( ); i++ )
+        {
+            if ( i % 10 == 9 )
+            {
+                for ( size_t piece = 0; piece < staged; piece++ )
+                {
+                    loads.emplace_back( );
+                    Load& load = loads.back( );
+                    load.io = &io;
+                    load.request.file = files[i];
+                    load.request.offset = piece * STAGING_SIZE;
+                    load.request.size = std::min( STAGING_SIZE, fileSize - piece * STAGING_SIZE );
+                    load.request.completion = completeStaged;
+                    load.request.data = &load;
+                    io.submit( &load.request, &counter );
+                }
+                continue;
+            }
+
+            loads.emplace_back( );
+            Load& load = loads.back( );
+            load.io = &io;
+            load.request.file = files[i];
+            load.request.size = fileSize;
+            load.request.destination = memory.data( ) + i * fileSize;
+            load.request.completion = completeDirect;
+            load.request.data = &load;
+            io.submit( &load.request, &counter );
+        }
+        jobs.wait( &counter );
+        double milliseconds = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now( ) - start ).count( );
+
+        for ( const Load& load : loads )
+            if ( load.failed )
+                return -1.0;
+        return milliseconds;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    unsigned int fileCount = argc > 1 ? (unsigned int) std::atoi( argv[1] ) : 200;
+    size_t fileSize = ( argc > 2 ? (size_t) std::atoi( argv[2] ) : 1024 ) * 1024;
+    std::string directory = argc > 3 ? argv[3] : "/tmp";
+    if ( fileCount == 0 || fileSize == 0 )
+    {
+        std::cerr << "usage: io_benchmark [files] [KB per file] [directory]" << std::endl;
+        return 1;
+    }
+
+    std::string root = directory + "/io_benchmark_XXXXXX";
+    if ( !mkdtemp( &root[0] ) )
+    {
+        std::cerr << "Failed to create a directory in " << directory << std::endl;
+        return 1;
+    }
+
+    // the asset set, every file filled with its own pattern
+    std::vector<std::string> paths;
+    std::vector<int> files;
+    std::vector<unsigned char> contents( fileSize );
+    bool written = true;
+    for ( unsigned int i = 0; i < fileCount && written; i++ )
+    {
+        paths.push_back( root + "/asset" + std::to_string( i ) );
+        int file = open( paths.back( ).c_str( ), O_RDWR | O_CREAT | O_TRUNC, 0600 );
+        if ( file < 0 )
+        {
+            written = false;
+            break;
+        }
+        files.push_back( file );
+        for ( size_t j = 0; j < fileSize; j++ )
+            contents[j] = (unsigned char) ( i * 7 + j );
+        written = write( file, contents.data( ), fileSize ) == (ssize_t) fileSize;
+    }
+
+    int status = 0;
+    if ( !written )
+    {
+        std::cerr << "Failed to write the asset set to " << root << std::endl;
+        status = 1;
+    }
+    else
+    {
+        JobSystem jobs;
+        std::vector<unsigned char> memory( fileCount * fileSize );
+        std::cout << "Asset set: " << fileCount << " files of " << fileSize / 1024 << " KB, " << jobs.threadCount( ) << " job threads"
+                  << std::endl;
+        std::cout << std::fixed << std::setprecision( 1 );
+
+        for ( int fallback = 0; fallback < 2 && status == 0; fallback++ )
+        {
+            IoService::Settings settings;
+            settings.bufferSize = STAGING_SIZE;
+            settings.forceFallback = fallback == 1;
+            IoService io( jobs, settings );
+            const char* name = io.usesIoUring( ) ? "io_uring" : "pread threads";
+            if ( fallback == 0 && !io.usesIoUring( ) )
+            {
+                std::cout << "io_uring: not available, skipped" << std::endl;
+                continue;
+            }
+
+            dropCache( files );
+            double cold = loadAll( jobs, io, files, fileSize, memory );
+            double warm = loadAll( jobs, io, files, fileSize, memory );
+            if ( cold < 0.0 || warm < 0.0 )
+            {
+                std::cerr << name << ": a read failed" << std::endl;
+                status = 1;
+                break;
+            }
+            double megabytes = (double) fileCount * fileSize / ( 1024.0 * 1024.0 );
+            std::cout << std::setw( 14 ) << std::left << name << std::right << " cold " << std::setw( 8 ) << cold << " ms ( "
+                      << megabytes / cold * 1000.0 << " MB/s ), warm " << std::setw( 8 ) << warm << " ms ( " << megabytes / warm * 1000.0
+                      << " MB/s )" << std::endl;
+            io.report( std::cout );
+        }
+    }
+
+    for ( int file : files )
+        close( file );
+    for ( const std::string& path : paths )
+        unlink( path.c_str( ) );
+    rmdir( root.c_str( ) );
+    return status;
+}
@@ -0,0 +1,131 @@
+// measures how the job system scales with its thread count: job_benchmark [threads]
+// a coarse workload ( matrix products split by parallelFor, like the transform update )
+// and a fine one ( bursts of tiny jobs behind a dependency, like the culling batches )
+// run on 1 to threads threads, the default being the hardware concurrency; the speedup
+// is against the same work run serially on the calling thread
+
+#include "learnopengl-implementation/job_system.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    const unsigned int MATRIX_COUNT = 1 << 18;
+    const unsigned int BURST_JOBS = 2000;
+    const unsigned int BURST_WORK = 2000;
+    const int ROUNDS = 7;
+
+    struct Workload
+    {
+        std::vector<glm::mat4> models;
+        std::vector<glm::mat4> out;
+        std::vector<float> sums;
+    };
+
+    void multiplyRange( Workload& work, unsigned int begin, unsigned int end )
+    {
+        glm::mat4 viewProjection = glm::perspective( 0.8f, 1.3f, 0.1f, 100.0f );
+        for ( unsigned int i = begin; i < end; i++ )
+        {
+            glm::mat4 mvp = viewProjection * work.models[i];
+            // a few rounds so the work per matrix is not just memory traffic
+            for ( int round = 0; round < 4; round++ )
+                mvp = mvp * work.models[i];
+            work.out[i] = mvp;
+        }
+    }
+
+    void burstJob( void* data, unsigned int begin, unsigned int /*end*/ )
+    {
+        Workload& work = *static_cast<Workload*>( data );
+        float sum = 0.0f;
+        for ( unsigned int i = 0; i < BURST_WORK; i++ )
+            sum += (float) ( ( begin * 31u + i ) % 97u );
+        work.sums[begin] = sum;
+    }
+
+    void emptyJob( void*, unsigned int, unsigned int )
+    {
+    }
+
+    // median of the rounds, in milliseconds
+    template <typename Function>
+    double measure( const Function& fn )
+    {
+        std::vector<double> times;
+        for ( int round = 0; round < ROUNDS; round++ )
+        {
+            auto start = std::chrono::steady_clock::now( );
+            fn( );
+            times.push_back( std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now( ) - start ).count( ) );
+        }
+        std::sort( times.begin( ), times.end( ) );
+        return times[times.size( ) / 2];
+    }
+
+    void runCoarse( JobSystem& jobs, Workload& work )
+    {
+        jobs.parallelFor( MATRIX_COUNT, 0, [&work]( unsigned int begin, unsigned int end ) { multiplyRange( work, begin, end ); } );
+    }
+
+    void runBurst( JobSystem& jobs, Workload& work )
+    {
+        // the burst only starts once its gate job ran, so it goes through the continuations
+        JobCounter gate, burst;
+        for ( unsigned int i = 0; i < BURST_JOBS; i++ )
+            jobs.run( &burstJob, &work, i, i + 1, &burst, &gate );
+        jobs.run( &emptyJob, nullptr, 0, 0, &gate );
+        jobs.wait( &burst );
+    }
+
+    void print( unsigned int threads, double coarse, double burst, double serialCoarse, double serialBurst )
+    {
+        std::cout << std::setw( 7 ) << threads << std::fixed << std::setprecision( 2 ) << std::setw( 12 ) << coarse << std::setw( 9 )
+                  << serialCoarse / coarse << "x" << std::setw( 12 ) << burst << std::setw( 9 ) << serialBurst / burst << "x" << std::endl;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    unsigned int maxThreads = argc > 1 ? (unsigned int) std::atoi( argv[1] ) : std::thread::hardware_concurrency( );
+    if ( maxThreads == 0 )
+        maxThreads = 1;
+
+    Workload work;
+    work.models.resize( MATRIX_COUNT );
+    work.out.resize( MATRIX_COUNT );
+    work.sums.resize( BURST_JOBS );
+    for ( unsigned int i = 0; i < MATRIX_COUNT; i++ )
+        work.models[i] = glm::rotate( glm::translate( glm::mat4( 1.0f ), glm::vec3( (float) ( i % 100 ), 0.0f, 1.0f ) ), 0.001f * i,
+                                      glm::vec3( 0.0f, 1.0f, 0.0f ) );
+
+    double serialCoarse = measure( [&work]( ) { multiplyRange( work, 0, MATRIX_COUNT ); } );
+    double serialBurst = measure( [&work]( )
+    {
+        for ( unsigned int i = 0; i < BURST_JOBS; i++ )
+            burstJob( &work, i, i + 1 );
+    } );
+
+    std::cout << "Job system scalability: " << MATRIX_COUNT << " matrices, " << BURST_JOBS << " jobs per burst, median of " << ROUNDS
+              << " rounds" << std::endl;
+    std::cout << "threads   coarse ms  speedup    burst ms  speedup" << std::endl;
+    print( 1, serialCoarse, serialBurst, serialCoarse, serialBurst );
+
+    // the job system always has at least one worker thread next to the calling one
+    for ( unsigned int threads = 2; threads <= maxThreads; threads++ )
+    {
+        JobSystem jobs( threads - 1 );
+        double coarse = measure( [&jobs, &work]( ) { runCoarse( jobs, work ); } );
+        double burst = measure( [&jobs, &work]( ) { runBurst( jobs, work ); } );
+        print( threads, coarse, burst, serialCoarse, serialBurst );
+    }
+    return 0;
+}
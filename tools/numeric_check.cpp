@@ -0,0 +1,170 @@
+// checks the numeric kernels against their scalar references: numeric_check
+// every matrix kernel level the CPU supports is run on random inputs, at counts that
+// cover the vector widths and their remainders, and compared with glm; the G-buffer's
+// normal encoding is swept over a 4096^2 grid of directions and held to the error bound
+// the renderer reports; exits non-zero when a check fails
+
+#include "learnopengl-implementation/matrix_kernels.h"
+#include "learnopengl-implementation/normal_encoding.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    std::mt19937 random( 12345 );
+
+    float uniform( float low, float high )
+    {
+        return std::uniform_real_distribution<float>( low, high )( random );
+    }
+
+    // an affine model matrix, invertible so that its normal matrix exists
+    glm::mat4 randomModel( )
+    {
+        glm::vec3 axis = glm::normalize( glm::vec3( uniform( -1.0f, 1.0f ), uniform( -1.0f, 1.0f ), uniform( 0.1f, 1.0f ) ) );
+        glm::mat4 model = glm::translate( glm::mat4( 1.0f ), glm::vec3( uniform( -50.0f, 50.0f ), uniform( -50.0f, 50.0f ), uniform( -50.0f, 50.0f ) ) );
+        model = glm::rotate( model, uniform( -3.14f, 3.14f ), axis );
+        return glm::scale( model, glm::vec3( uniform( 0.2f, 4.0f ), uniform( 0.2f, 4.0f ), uniform( 0.2f, 4.0f ) ) );
+    }
+
+    // the sums of the absolute terms of m * v, what the rounding error of each row scales with
+    // ( a result near zero can come from large terms cancelling, FMA rounds those differently )
+    glm::vec4 termMagnitudes( const glm::mat4& m, const glm::vec4& v )
+    {
+        glm::vec4 sum( 0.0f );
+        for ( int column = 0; column < 4; column++ )
+            for ( int row = 0; row < 4; row++ )
+                sum[row] += std::fabs( m[column][row] * v[column] );
+        return sum;
+    }
+
+    bool close( float value, float expected, float magnitude, float tolerance )
+    {
+        return std::fabs( value - expected ) <= tolerance * std::max( 1.0f, magnitude );
+    }
+
+    // values[i] against expected[i] = a[i] * b[i], a being the same for every i when aStride is 0
+    bool matricesMatch( const glm::mat4* values, const glm::mat4* expected, const glm::mat4* a, size_t aStride, const glm::mat4* b,
+                        size_t count, float tolerance )
+    {
+        for ( size_t i = 0; i < count; i++ )
+            for ( int column = 0; column < 4; column++ )
+            {
+                glm::vec4 magnitude = termMagnitudes( a[i * aStride], b[i][column] );
+                for ( int row = 0; row < 4; row++ )
+                    if ( !close( values[i][column][row], expected[i][column][row], magnitude[row], tolerance ) )
+                        return false;
+            }
+        return true;
+    }
+
+    bool vectorsMatch( const glm::vec4* values, const glm::vec4* expected, const glm::mat4& m, const glm::vec4* in, size_t count,
+                       float tolerance )
+    {
+        for ( size_t i = 0; i < count; i++ )
+        {
+            glm::vec4 magnitude = termMagnitudes( m, in[i] );
+            for ( int row = 0; row < 4; row++ )
+                if ( !close( values[i][row], expected[i][row], magnitude[row], tolerance ) )
+                    return false;
+        }
+        return true;
+    }
+
+    // the normal matrices against their inverse property, inverse( m3 ) * m3 = identity, which
+    // does not depend on how the inverse was rounded
+    bool normalMatricesMatch( const glm::mat4* values, const glm::mat4* models, size_t count, float tolerance )
+    {
+        for ( size_t i = 0; i < count; i++ )
+        {
+            glm::mat3 inverse = glm::transpose( glm::mat3( values[i] ) );
+            glm::mat3 identity = inverse * glm::mat3( models[i] );
+            for ( int column = 0; column < 3; column++ )
+                for ( int row = 0; row < 3; row++ )
+                    if ( std::fabs( identity[column][row] - ( column == row ? 1.0f : 0.0f ) ) > tolerance )
+                        return false;
+            if ( values[i][3] != glm::vec4( 0.0f, 0.0f, 0.0f, 1.0f ) || values[i][0][3] != 0.0f || values[i][1][3] != 0.0f ||
+                 values[i][2][3] != 0.0f )
+                return false;
+        }
+        return true;
+    }
+
+    // every kernel of the selected level on one batch, against the glm results
+    bool checkMatrixKernels( size_t count )
+    {
+        glm::mat4 viewProjection = glm::perspective( 0.8f, 1.3f, 0.1f, 100.0f ) * randomModel( );
+        std::vector<glm::mat4> models( count ), out( count ), expected( count );
+        std::vector<glm::vec4> points( count ), transformed( count ), expectedPoints( count );
+        for ( size_t i = 0; i < count; i++ )
+        {
+            models[i] = randomModel( );
+            points[i] = glm::vec4( uniform( -100.0f, 100.0f ), uniform( -100.0f, 100.0f ), uniform( -100.0f, 100.0f ), uniform( 0.0f, 2.0f ) );
+        }
+
+        for ( size_t i = 0; i < count; i++ )
+            expected[i] = viewProjection * models[i];
+        MatrixKernels::multiplyMVP( viewProjection, models.data( ), out.data( ), count );
+        if ( !matricesMatch( out.data( ), expected.data( ), &viewProjection, 0, models.data( ), count, 1e-5f ) )
+        {
+            std::cerr << "multiplyMVP mismatch at " << count << std::endl;
+            return false;
+        }
+
+        for ( size_t i = 0; i < count; i++ )
+            expectedPoints[i] = viewProjection * points[i];
+        MatrixKernels::transform( viewProjection, points.data( ), transformed.data( ), count );
+        if ( !vectorsMatch( transformed.data( ), expectedPoints.data( ), viewProjection, points.data( ), count, 1e-5f ) )
+        {
+            std::cerr << "transform mismatch at " << count << std::endl;
+            return false;
+        }
+
+        MatrixKernels::normalMatrices( models.data( ), out.data( ), count );
+        if ( !normalMatricesMatch( out.data( ), models.data( ), count, 1e-4f ) )
+        {
+            std::cerr << "normalMatrices mismatch at " << count << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+int main( )
+{
+    const MatrixKernels::Level levels[] = { MatrixKernels::Level::SCALAR, MatrixKernels::Level::SSE2, MatrixKernels::Level::AVX2,
+                                            MatrixKernels::Level::AVX512 };
+    // below, at and past every vector width, and a batch large enough for the unrolled loops
+    const size_t counts[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 1000 };
+
+    bool passed = true;
+    MatrixKernels::Level supported = MatrixKernels::detect( );
+    for ( MatrixKernels::Level level : levels )
+    {
+        if ( level > supported )
+        {
+            std::cout << "Matrix kernels " << MatrixKernels::name( level ) << ": not supported by this CPU, skipped" << std::endl;
+            continue;
+        }
+        MatrixKernels::select( level );
+        bool levelPassed = true;
+        for ( size_t count : counts )
+            for ( int round = 0; round < 4 && levelPassed; round++ )
+                levelPassed = checkMatrixKernels( count );
+        std::cout << "Matrix kernels " << MatrixKernels::name( level ) << ": " << ( levelPassed ? "passed" : "FAILED" ) << std::endl;
+        passed = passed && levelPassed;
+    }
+
+    float normalError = NormalEncoding::maxErrorDegrees( 4096 );
+    bool normalsPassed = normalError <= NormalEncoding::MAX_ERROR_DEGREES;
+    std::cout << "Normal encoding: " << normalError << " degrees max, bound " << NormalEncoding::MAX_ERROR_DEGREES << ": "
+              << ( normalsPassed ? "passed" : "FAILED" ) << std::endl;
+    passed = passed && normalsPassed;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+// builds an asset pack: pack_builder <output> <root> <asset>...
+// every asset is a path relative to root and is stored under that name
+
+#include "learnopengl-implementation/asset_pack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Asset
+    {
+        std::string name;
+        std::vector<char> contents;
+        PackEntry entry;
+    };
+
+    uint64_t alignUp( uint64_t value, uint64_t alignment )
+    {
+        return ( value + alignment - 1 ) & ~( alignment - 1 );
+    }
+}
+
+int main( int argc, char** argv )
+{
+    if ( argc < 3 )
+    {
+        std::cerr << "usage: pack_builder <output> <root> <asset>..." << std::endl;
+        return 1;
+    }
+
+    std::string root = argv[2];
+    std::vector<Asset> assets;
+    for ( int i = 3; i < argc; i++ )
+    {
+        Asset asset;
+        asset.name = argv[i];
+        std::ifstream file( root + "/" + asset.name, std::ios::binary );
+        if ( !file )
+        {
+            std::cerr << "pack_builder: cannot read " << root << "/" << asset.name << std::endl;
+            return 1;
+        }
+        asset.contents.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>( ) );
+        memset( &asset.entry, 0, sizeof( asset.entry ) );
+        asset.entry.nameHash = fnv1a( asset.name.data( ), asset.name.size( ) );
+        asset.entry.contentHash = fnv1a( asset.contents.data( ), asset.contents.size( ) );
+        asset.entry.size = asset.contents.size( );
+        assets.push_back( std::move( asset ) );
+    }
+
+    // the reader binary searches the table by name hash
+    std::sort( assets.begin( ), assets.end( ), []( const Asset& a, const Asset& b ) {
+        return a.entry.nameHash != b.entry.nameHash ? a.entry.nameHash < b.entry.nameHash : a.name < b.name;
+    } );
+
+    // laying out the names after the table, then the payloads
+    uint64_t namesStart = sizeof( PackHeader ) + assets.size( ) * sizeof( PackEntry );
+    uint64_t position = 0;
+    for ( Asset& asset : assets )
+    {
+        asset.entry.nameOffset = (uint32_t) position;
+        asset.entry.nameLength = (uint32_t) asset.name.size( );
+        position += asset.name.size( );
+    }
+    position += namesStart;
+    for ( Asset& asset : assets )
+    {
+        position = alignUp( position, PACK_ALIGNMENT );
+        asset.entry.offset = position;
+        position += asset.entry.size;
+    }
+
+    std::ofstream out( argv[1], std::ios::binary | std::ios::trunc );
+    if ( !out )
+    {
+        std::cerr << "pack_builder: cannot write " << argv[1] << std::endl;
+        return 1;
+    }
+
+    PackHeader header;
+    memcpy( header.magic, PACK_MAGIC, sizeof( PACK_MAGIC ) );
+    header.version = PACK_VERSION;
+    header.entryCount = (uint32_t) assets.size( );
+    out.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    for ( const Asset& asset : assets )
+        out.write( reinterpret_cast<const char*>( &asset.entry ), sizeof( asset.entry ) );
+    for ( const Asset& asset : assets )
+        out.write( asset.name.data( ), asset.name.size( ) );
+
+    const char padding[PACK_ALIGNMENT] = { };
+    for ( const Asset& asset : assets )
+    {
+        out.write( padding, asset.entry.offset - (uint64_t) out.tellp( ) );
+        out.write( asset.contents.data( ), asset.contents.size( ) );
+    }
+
+    if ( !out )
+    {
+        std::cerr << "pack_builder: failed writing " << argv[1] << std::endl;
+        return 1;
+    }
+    std::cout << "pack_builder: " << assets.size( ) << " assets, " << position << " bytes" << std::endl;
+    return 0;
+}
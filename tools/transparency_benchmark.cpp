@@ -0,0 +1,173 @@
+// measures both transparency modes over many quads: transparency_benchmark [quads] [frames]
+// the quads fill the same box as the ones of the demo scene ( 100000 of them by default ), and
+// every frame runs the mode's CPU work ( the upload, after the radix sort for the sorted mode )
+// and its passes over a cleared scene target in a hidden window; Transparency's own report
+// gives the CPU and GPU time per frame, the wall time includes waiting for the GPU to finish
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "learnopengl-implementation/gl_resources.h"
+#include "learnopengl-implementation/gl_helpers.h"
+#include "learnopengl-implementation/shader.h"
+#include "learnopengl-implementation/frame_packet.h"
+#include "learnopengl-implementation/render_graph.h"
+#include "learnopengl-implementation/dynamic_resolution.h"
+#include "learnopengl-implementation/transparency.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+#ifndef ASSET_ROOT
+#define ASSET_ROOT "."
+#endif
+
+namespace
+{
+    const int WIDTH = 1280;
+    const int HEIGHT = 720;
+
+    // declares the frame of a mode: the scene target cleared, then the mode's passes over it;
+    // returns the finished scene color
+    RenderGraph::Resource buildGraph( RenderGraph& graph, Transparency& transparency, TransparencyMode mode, const DynamicResolution& resolution )
+    {
+        graph.clear( );
+        RenderGraph::Resource color = graph.importTexture( "scene color", resolution.colorTexture( ), GL_RGBA8 );
+        RenderGraph::Resource depth = graph.importTexture( "scene depth", resolution.depthTexture( ), GL_DEPTH24_STENCIL8 );
+        RenderGraph::Pass scene = graph.addPass( "scene", [&resolution]( )
+        {
+            glViewport( 0, 0, resolution.renderWidth( ), resolution.renderHeight( ) );
+            glClearColor( 0.2f, 0.3f, 0.3f, 1.0f );
+            glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+        } );
+        color = graph.writeColor( scene, color );
+        depth = graph.writeDepth( scene, depth );
+        transparency.addPasses( graph, mode, color, depth, resolution );
+        graph.markOutput( color );
+        graph.compile( );
+        return color;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    unsigned int quadCount = argc > 1 ? (unsigned int) std::atoi( argv[1] ) : 100000;
+    unsigned int frames = argc > 2 ? (unsigned int) std::atoi( argv[2] ) : 100;
+    if ( frames == 0 )
+    {
+        std::cerr << "usage: transparency_benchmark [quads] [frames]" << std::endl;
+        return 1;
+    }
+
+    glfwInit( );
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 3 );
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 3 );
+    glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+    glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+    GLFWwindow* window = glfwCreateWindow( WIDTH, HEIGHT, "transparency_benchmark", NULL, NULL );
+    if ( window == NULL )
+    {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate( );
+        return 1;
+    }
+    glfwMakeContextCurrent( window );
+    if ( !gladLoadGLLoader( (GLADloadproc)glfwGetProcAddress ) )
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate( );
+        return 1;
+    }
+
+    // the demo scene's camera and quads, tinted and faded by a random amount
+    FramePacket packet;
+    packet.view = glm::lookAt( glm::vec3( 0.0f, 0.0f, 3.0f ), glm::vec3( 0.0f, 0.0f, 0.0f ), glm::vec3( 0.0f, 1.0f, 0.0f ) );
+    packet.projection = glm::perspective( glm::radians( 45.0f ), (float) WIDTH / (float) HEIGHT, 0.1f, 100.0f );
+    std::minstd_rand random( 7 );
+    std::uniform_real_distribution<float> unit( 0.0f, 1.0f );
+    for ( unsigned int i = 0; i < quadCount; i++ )
+    {
+        TransparentQuad quad;
+        quad.positionSize = glm::vec4( -4.0f + 8.0f * unit( random ), -3.0f + 6.0f * unit( random ), -14.0f + 15.0f * unit( random ),
+                                       0.15f + 0.35f * unit( random ) );
+        quad.color = glm::vec4( 0.4f + 0.6f * unit( random ), 0.4f + 0.6f * unit( random ), 0.4f + 0.6f * unit( random ),
+                                0.35f + 0.4f * unit( random ) );
+        packet.transparents.push_back( quad );
+    }
+
+    int status = 0;
+    {
+        GLResources resources;
+        DynamicResolution::Settings resolutionSettings;
+        resolutionSettings.enabled = false;
+        DynamicResolution resolution( resources, resolutionSettings );
+        RenderGraph graph( resources );
+        Transparency transparency( resources, Transparency::Settings( ) );
+        SharedGeometry geometry;
+        geometry.initialize( resources );
+
+        std::string root = ASSET_ROOT;
+        Shader quadShader( ( root + "/src/transparent.vs" ).c_str( ), ( root + "/src/transparent.fs" ).c_str( ) );
+        Shader compositeShader( ( root + "/src/fullscreen.vs" ).c_str( ), ( root + "/src/transparent_composite.fs" ).c_str( ) );
+        transparency.initialize( geometry, quadShader, compositeShader );
+
+        // the quads' image, white so only their tint shows
+        ScopedTexture image( resources, resources.createTexture( "white" ) );
+        const unsigned char white[] = { 255, 255, 255, 255 };
+        glBindTexture( GL_TEXTURE_2D, image.name( ) );
+        glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+        resources.setSize( image.get( ), sizeof( white ) );
+
+        std::cout << "Transparency: " << quadCount << " quads, " << frames << " frames per mode at " << WIDTH << "x" << HEIGHT << std::endl;
+        std::cout << std::fixed << std::setprecision( 2 );
+        const TransparencyMode modes[] = { TransparencyMode::WEIGHTED_BLENDED, TransparencyMode::SORTED };
+        const char* modeNames[] = { "weighted blended", "sorted" };
+        for ( unsigned int index = 0; index < 2; index++ )
+        {
+            // the target is sized by the first frame, the graph declared over it
+            resolution.beginFrame( WIDTH, HEIGHT );
+            RenderGraph::Resource color = buildGraph( graph, transparency, modes[index], resolution );
+            resolution.endFrame( graph.texture( color ) );
+            glFinish( );
+
+            auto start = std::chrono::steady_clock::now( );
+            for ( unsigned int frame = 0; frame < frames; frame++ )
+            {
+                resources.flush( );
+                resolution.beginFrame( WIDTH, HEIGHT );
+                transparency.prepare( packet, modes[index], packet.projection, image.name( ) );
+                graph.execute( );
+                resolution.endFrame( graph.texture( color ) );
+            }
+            glFinish( );
+            double milliseconds = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now( ) - start ).count( );
+            std::cout << std::setw( 17 ) << std::left << modeNames[index] << std::right << std::setw( 9 ) << milliseconds / frames
+                      << " ms per frame, wall time" << std::endl;
+        }
+        if ( glGetError( ) != GL_NO_ERROR )
+        {
+            std::cerr << "The passes raised a GL error" << std::endl;
+            status = 1;
+        }
+        transparency.report( std::cout );
+
+        transparency.shutdown( );
+        geometry.shutdown( );
+        graph.shutdown( );
+        resolution.shutdown( );
+        image.reset( );
+        resources.shutdown( std::cerr );
+    }
+
+    glfwTerminate( );
+    return status;
+}